@@ -50,12 +50,17 @@ public class OnlineSubsystemEOS : ModuleRules
                 "AudioMixer",
                 "OnlineSubsystem",
                 "Json",
+                "HTTP",
                 "PacketHandler",
+                "Networking",
                 "Projects",
             }
             );
 
 
+        // Used to verify the signatures of client ID tokens.
+        AddEngineThirdPartyPrivateStaticDependencies( Target, "OpenSSL" );
+
         DynamicallyLoadedModuleNames.AddRange(
             new string[]
             {
@@ -0,0 +1,229 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineBulkLoginHarnessEOS.h"
+
+// Engine Includes
+#include "OnlineSubsystem.h"
+#include "HAL/PlatformTime.h"
+#include "Interfaces/OnlineIdentityInterface.h"
+
+// OSS EOS Includes
+#include "OnlineIdentityInterfaceEOS.h"
+#include "OnlineSubsystemEOSCommon.h"
+
+
+FBulkLoginHarnessEOS::FBulkLoginHarnessEOS( FOnlineIdentityEOS* InIdentity, EOS_HPlatform InPlatformHandle, const FBulkLoginConfigEOS& InConfig )
+	: Identity( InIdentity )
+	, PlatformHandle( InPlatformHandle )
+	, Config( InConfig )
+	, Random( FPlatformTime::Cycles() )
+	, NextLoginIndex( 0 )
+	, NumInFlight( 0 )
+	, NumCompleted( 0 )
+	, RunStartTime( 0.0 )
+	, RunEndTime( 0.0 )
+{
+	Config.NumLogins = FMath::Max( Config.NumLogins, 0 );
+	Config.MaxConcurrent = FMath::Max( Config.MaxConcurrent, 1 );
+	Config.MockFailureRate = FMath::Clamp( Config.MockFailureRate, 0.0f, 1.0f );
+}
+
+void FBulkLoginHarnessEOS::Start()
+{
+	StartTimes.SetNumZeroed( Config.NumLogins );
+	LatenciesMs.Reset( Config.NumLogins );
+	LoggedInAccounts.Reset( Config.NumLogins );
+
+	UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS Bulk Login: Starting %d %s logins, %d concurrent." ),
+							Config.NumLogins, Config.Mode == EEOSBulkLoginMode::DevAuth ? TEXT( "DevAuth" ) : TEXT( "Mock" ), Config.MaxConcurrent );
+
+	RunStartTime = FPlatformTime::Seconds();
+	StartPendingLogins();
+}
+
+bool FBulkLoginHarnessEOS::Tick( float DeltaTime )
+{
+	if( MockLogins.Num() > 0 )
+	{
+		const double Now = FPlatformTime::Seconds();
+
+		for( int32 MockIdx = MockLogins.Num() - 1; MockIdx >= 0; --MockIdx )
+		{
+			if( MockLogins[MockIdx].CompleteTime <= Now )
+			{
+				const FMockLogin Completed = MockLogins[MockIdx];
+				MockLogins.RemoveAtSwap( MockIdx );
+				OnLoginComplete( Completed.LoginIndex, Completed.ResultCode, nullptr );
+			}
+		}
+	}
+
+	StartPendingLogins();
+
+	return IsComplete() == false;
+}
+
+bool FBulkLoginHarnessEOS::IsComplete() const
+{
+	return NumCompleted >= Config.NumLogins;
+}
+
+void FBulkLoginHarnessEOS::StartPendingLogins()
+{
+	while( NumInFlight < Config.MaxConcurrent && NextLoginIndex < Config.NumLogins )
+	{
+		StartLogin( NextLoginIndex++ );
+	}
+}
+
+void FBulkLoginHarnessEOS::StartLogin( int32 LoginIndex )
+{
+	StartTimes[LoginIndex] = FPlatformTime::Seconds();
+	NumInFlight++;
+
+	if( Config.Mode == EEOSBulkLoginMode::Mock )
+	{
+		FMockLogin MockLogin;
+		MockLogin.LoginIndex = LoginIndex;
+		// Uniform jitter of +/-50% around the configured mean.
+		MockLogin.CompleteTime = StartTimes[LoginIndex] + ( Config.MockLatencyMs * ( 0.5f + Random.FRand() ) ) / 1000.0;
+		MockLogin.ResultCode = ( Random.FRand() < Config.MockFailureRate ) ? EOS_EResult::EOS_TooManyRequests : EOS_EResult::EOS_Success;
+		MockLogins.Add( MockLogin );
+		return;
+	}
+
+	FOnlineAccountCredentials Credentials( TEXT( "developer" ), Config.DevAuthHost, FString::Printf( TEXT( "%s%d" ), *Config.CredentialPrefix, LoginIndex ) );
+
+	TWeakPtr<FBulkLoginHarnessEOS> WeakThis( AsShared() );
+	EOS_HPlatform LogoutPlatformHandle = PlatformHandle;
+	FOnEOSAuthLoginComplete CompletionCallback = [WeakThis, LogoutPlatformHandle, LoginIndex]( EOS_EResult ResultCode, EOS_EpicAccountId AccountId )
+	{
+		TSharedPtr<FBulkLoginHarnessEOS> StrongThis = WeakThis.Pin();
+
+		if( StrongThis.IsValid() )
+		{
+			StrongThis->OnLoginComplete( LoginIndex, ResultCode, AccountId );
+		}
+		else if( ResultCode == EOS_EResult::EOS_Success && AccountId != nullptr )
+		{
+			// Completed after the run was cancelled, so nothing else will log it out.
+			LogoutAccount( LogoutPlatformHandle, AccountId );
+		}
+	};
+
+	FString ErrorStr;
+	if( Identity == nullptr || Identity->StartAuthLogin( Credentials, CompletionCallback, ErrorStr ) == false )
+	{
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS Bulk Login: Login %d could not be issued. %s" ), LoginIndex, *ErrorStr );
+		OnLoginComplete( LoginIndex, EOS_EResult::EOS_NotConfigured, nullptr );
+	}
+}
+
+void FBulkLoginHarnessEOS::OnLoginComplete( int32 LoginIndex, EOS_EResult ResultCode, EOS_EpicAccountId AccountId )
+{
+	const double Now = FPlatformTime::Seconds();
+
+	LatenciesMs.Add( ( Now - StartTimes[LoginIndex] ) * 1000.0 );
+	ResultCounts.FindOrAdd( (int32)ResultCode )++;
+
+	if( ResultCode == EOS_EResult::EOS_Success && AccountId != nullptr )
+	{
+		LoggedInAccounts.Add( AccountId );
+	}
+
+	NumInFlight--;
+	NumCompleted++;
+
+	if( IsComplete() == true )
+	{
+		RunEndTime = Now;
+
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *GetReport() );
+
+		if( Config.bLogoutWhenDone == true )
+		{
+			LogoutAccounts();
+		}
+	}
+}
+
+void FBulkLoginHarnessEOS::Cancel()
+{
+	MockLogins.Reset();
+	NextLoginIndex = Config.NumLogins;
+
+	LogoutAccounts();
+}
+
+void FBulkLoginHarnessEOS::LogoutAccounts()
+{
+	for( EOS_EpicAccountId AccountId : LoggedInAccounts )
+	{
+		LogoutAccount( PlatformHandle, AccountId );
+	}
+
+	LoggedInAccounts.Reset();
+}
+
+void FBulkLoginHarnessEOS::LogoutAccount( EOS_HPlatform InPlatformHandle, EOS_EpicAccountId AccountId )
+{
+	EOS_HAuth AuthHandle = InPlatformHandle != nullptr ? EOS_Platform_GetAuthInterface( InPlatformHandle ) : nullptr;
+
+	if( AuthHandle == nullptr )
+	{
+		return;
+	}
+
+	EOS_Auth_LogoutOptions LogoutOptions;
+	LogoutOptions.ApiVersion = EOS_AUTH_LOGOUT_API_LATEST;
+	LogoutOptions.LocalUserId = AccountId;
+
+	EOS_Auth_Logout( AuthHandle, &LogoutOptions, NULL, LogoutCompleteCallback );
+}
+
+void FBulkLoginHarnessEOS::LogoutCompleteCallback( const EOS_Auth_LogoutCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	if( Data->ResultCode != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS Bulk Login: Logout failed with Status: %s" ), *UEOSCommon::EOSResultToString( Data->ResultCode ) );
+	}
+}
+
+double FBulkLoginHarnessEOS::GetPercentile( const TArray<double>& SortedValues, double Percentile )
+{
+	if( SortedValues.Num() == 0 )
+	{
+		return 0.0;
+	}
+
+	const int32 Rank = FMath::CeilToInt( ( Percentile / 100.0 ) * SortedValues.Num() );
+	return SortedValues[FMath::Clamp( Rank - 1, 0, SortedValues.Num() - 1 )];
+}
+
+FString FBulkLoginHarnessEOS::GetReport() const
+{
+	TArray<double> SortedLatencies = LatenciesMs;
+	SortedLatencies.Sort();
+
+	const double EndTime = ( IsComplete() == true ) ? RunEndTime : FPlatformTime::Seconds();
+	const double WallTime = FMath::Max( EndTime - RunStartTime, SMALL_NUMBER );
+
+	FString Report = FString::Printf( TEXT( "EOS Bulk Login: %d/%d complete, %d concurrent, %s mode.\n" ),
+									  NumCompleted, Config.NumLogins, Config.MaxConcurrent, Config.Mode == EEOSBulkLoginMode::DevAuth ? TEXT( "DevAuth" ) : TEXT( "Mock" ) );
+
+	Report += FString::Printf( TEXT( "  Wall time: %.2fs | Throughput: %.2f logins/s\n" ), WallTime, NumCompleted / WallTime );
+
+	Report += FString::Printf( TEXT( "  Latency (ms): p50 %.1f | p90 %.1f | p99 %.1f | max %.1f\n" ),
+							   GetPercentile( SortedLatencies, 50.0 ), GetPercentile( SortedLatencies, 90.0 ),
+							   GetPercentile( SortedLatencies, 99.0 ), GetPercentile( SortedLatencies, 100.0 ) );
+
+	Report += TEXT( "  Results:" );
+	for( const TPair<int32, int32>& ResultCount : ResultCounts )
+	{
+		Report += FString::Printf( TEXT( " %s x%d" ), *UEOSCommon::EOSResultToString( (EOS_EResult)ResultCount.Key ), ResultCount.Value );
+	}
+
+	return Report;
+}
@@ -0,0 +1,161 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+// EOS SDK Includes
+#include "eos_sdk.h"
+#include "eos_auth.h"
+
+// Forward Declarations
+class FOnlineIdentityEOS;
+
+
+/** How the bulk login harness produces its identities */
+enum class EEOSBulkLoginMode : uint8
+{
+	/** Logs in through the SDK, using Dev Auth Tool credentials. */
+	DevAuth,
+	/** Simulates logins locally, so the harness can be exercised without a backend. */
+	Mock
+};
+
+/**
+ * Options for a single bulk login run.
+ */
+struct FBulkLoginConfigEOS
+{
+	/** Where the identities come from. */
+	EEOSBulkLoginMode								Mode;
+
+	/** Total number of logins to perform. */
+	int32											NumLogins;
+
+	/** Maximum number of logins in flight at any one time. */
+	int32											MaxConcurrent;
+
+	/** The host:port of the Dev Auth Tool (DevAuth mode only). */
+	FString											DevAuthHost;
+
+	/** Credential names are CredentialPrefix + Index (DevAuth mode only). */
+	FString											CredentialPrefix;
+
+	/** Mean simulated login latency (Mock mode only). */
+	float											MockLatencyMs;
+
+	/** Fraction [0,1] of simulated logins that fail (Mock mode only). */
+	float											MockFailureRate;
+
+	/** Whether successfully logged in accounts are logged out again once the run completes. */
+	bool											bLogoutWhenDone;
+
+	FBulkLoginConfigEOS()
+		: Mode( EEOSBulkLoginMode::Mock )
+		, NumLogins( 100 )
+		, MaxConcurrent( 8 )
+		, DevAuthHost( TEXT( "localhost:6547" ) )
+		, CredentialPrefix( TEXT( "Bot" ) )
+		, MockLatencyMs( 250.0f )
+		, MockFailureRate( 0.0f )
+		, bLogoutWhenDone( true )
+	{}
+};
+
+/**
+ * Capacity test harness that logs in many identities concurrently, with a bounded number in flight,
+ * and reports percentile login latency and a breakdown of results by EOS result code.
+ *
+ * Driven from the "EOS BULKLOGIN" console command and ticked by the owning subsystem.
+ */
+class FBulkLoginHarnessEOS : public TSharedFromThis<FBulkLoginHarnessEOS>
+{
+
+public:
+
+	FBulkLoginHarnessEOS( FOnlineIdentityEOS* InIdentity, EOS_HPlatform InPlatformHandle, const FBulkLoginConfigEOS& InConfig );
+
+	/** Begins the run, issuing the first window of logins. */
+	void											Start();
+
+	/**
+	* Tops up the in-flight window and completes any simulated logins.
+	*
+	* @return bool False once every login has completed and the run is finished.
+	*/
+	bool											Tick( float DeltaTime );
+
+	/** @return bool True once every login has completed. */
+	bool											IsComplete() const;
+
+	/** Stops the run, logging out every account it logged in. Logins still in flight are logged out as they complete. */
+	void											Cancel();
+
+	/** @return FString Human readable summary of the run so far. */
+	FString											GetReport() const;
+
+private:
+
+	/** A simulated login waiting for its completion time (Mock mode only). */
+	struct FMockLogin
+	{
+		int32										LoginIndex;
+		double										CompleteTime;
+		EOS_EResult									ResultCode;
+	};
+
+	/** Issues logins until the in-flight window is full, or none remain. */
+	void											StartPendingLogins();
+
+	/** Issues a single login. */
+	void											StartLogin( int32 LoginIndex );
+
+	/** Records the outcome of a single login. */
+	void											OnLoginComplete( int32 LoginIndex, EOS_EResult ResultCode, EOS_EpicAccountId AccountId );
+
+	/** Logs out every account this run logged in. */
+	void											LogoutAccounts();
+
+	/** Logs a single account out. */
+	static void										LogoutAccount( EOS_HPlatform InPlatformHandle, EOS_EpicAccountId AccountId );
+
+	static void										LogoutCompleteCallback( const EOS_Auth_LogoutCallbackInfo* Data );
+
+	/** Nearest-rank percentile of an already sorted array. */
+	static double									GetPercentile( const TArray<double>& SortedValues, double Percentile );
+
+	/** Identity used to issue DevAuth logins. */
+	FOnlineIdentityEOS*								Identity;
+
+	/** Platform used to log the accounts back out. */
+	EOS_HPlatform									PlatformHandle;
+
+	/** The options for this run. */
+	FBulkLoginConfigEOS								Config;
+
+	/** Time each login was issued, indexed by login. */
+	TArray<double>									StartTimes;
+
+	/** Latency of every completed login, in milliseconds. */
+	TArray<double>									LatenciesMs;
+
+	/** Number of completions per EOS_EResult. */
+	TMap<int32, int32>								ResultCounts;
+
+	/** Accounts successfully logged in by this run. */
+	TArray<EOS_EpicAccountId>						LoggedInAccounts;
+
+	/** Simulated logins currently in flight. */
+	TArray<FMockLogin>								MockLogins;
+
+	FRandomStream									Random;
+
+	int32											NextLoginIndex;
+	int32											NumInFlight;
+	int32											NumCompleted;
+
+	double											RunStartTime;
+	double											RunEndTime;
+};
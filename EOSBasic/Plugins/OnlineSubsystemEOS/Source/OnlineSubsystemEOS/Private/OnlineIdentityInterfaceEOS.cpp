@@ -4,63 +4,90 @@
 #include "OnlineSubsystem.h"
 #include "OnlineSubsystemEOS.h"
 #include "OnlineSubsystemEOSCommon.h"
+#include "OnlineSubsystemEOSArena.h"
+#include "OnlineIdentityTokenVerifierEOS.h"
 // @todo: create helper classes/functions for converting between more BP/dev friendly types
 //			to more generic elements for the OSS. Such as EOS Login Mode(s).
 //#include "OnlineSubsystemSteamTypes.h"
 #include "OnlineError.h"
 
-#include <string>
-
 FOnlineIdentityEOS::FOnlineIdentityEOS( FOnlineSubsystemEOS* InSubsystem )
 	: EpicAccountId()
+	, LoginStatusChangedId( EOS_INVALID_NOTIFICATIONID )
+	, KnownIdsPruneThreshold( 256 )
 	, EOSSubsystem( InSubsystem )
 {
-	
+	if( EOSSubsystem->IsEOSInitialized() == true )
+	{
+		EOS_HAuth AuthHandle = EOS_Platform_GetAuthInterface( EOSSubsystem->GetPlatformHandle() );
+
+		if( AuthHandle != nullptr )
+		{
+			EOS_Auth_AddNotifyLoginStatusChangedOptions NotifyOptions;
+			NotifyOptions.ApiVersion = EOS_AUTH_ADDNOTIFYLOGINSTATUSCHANGED_API_LATEST;
+
+			LoginStatusChangedId = EOS_Auth_AddNotifyLoginStatusChanged( AuthHandle, &NotifyOptions, this, LoginStatusChangedCallback );
+		}
+	}
 }
 
-bool FOnlineIdentityEOS::Login( int32 LocalUserNum, const FOnlineAccountCredentials& AccountCredentials )
+FOnlineIdentityEOS::~FOnlineIdentityEOS()
 {
-	FString ErrorStr;
-	if( LocalUserNum < MAX_LOCAL_PLAYERS )
+	if( LoginStatusChangedId != EOS_INVALID_NOTIFICATIONID && EOSSubsystem->IsEOSInitialized() == true )
 	{
-		if( EOSSubsystem->IsEOSInitialized() == true )
-		{
-			EOS_HAuth AuthHandle = EOS_Platform_GetAuthInterface( EOSSubsystem->GetPlatformHandle() );
+		EOS_HAuth AuthHandle = EOS_Platform_GetAuthInterface( EOSSubsystem->GetPlatformHandle() );
 
-			if( AuthHandle != nullptr )
-			{
-				EOS_Auth_Credentials Credentials;
-				Credentials.ApiVersion = EOS_AUTH_CREDENTIALS_API_LATEST;
+		if( AuthHandle != nullptr )
+		{
+			EOS_Auth_RemoveNotifyLoginStatusChanged( AuthHandle, LoginStatusChangedId );
+		}
+	}
+}
 
-				EOS_Auth_LoginOptions LoginOptions;
-				memset( &LoginOptions, 0, sizeof( LoginOptions ) );
-				LoginOptions.ApiVersion = EOS_AUTH_LOGIN_API_LATEST;
+void FOnlineIdentityEOS::Tick( float DeltaTime )
+{
+	if( IdTokenVerifier.IsValid() )
+	{
+		IdTokenVerifier->Tick( DeltaTime );
+	}
+}
 
-				// Use AccountCredentials.Type then:
-				// @todo: support ALL Login types
-				FString MessageText = FString::Printf( TEXT( "Logging In with Dev Auth Tool | ID: %s | Token: %s." ), *AccountCredentials.Id, *AccountCredentials.Token );
-				UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
+TSharedPtr<FIdTokenVerifierEOS, ESPMode::ThreadSafe> FOnlineIdentityEOS::GetIdTokenVerifier()
+{
+	if( IdTokenVerifier.IsValid() == false )
+	{
+		IdTokenVerifier = MakeShared<FIdTokenVerifierEOS, ESPMode::ThreadSafe>();
+		IdTokenVerifier->Init();
+	}
 
-				std::string IdUTF8( TCHAR_TO_UTF8( *AccountCredentials.Id ) );
-				std::string TokenUTF8( TCHAR_TO_UTF8( *AccountCredentials.Token ) );
-				Credentials.Id = IdUTF8.c_str();
-				Credentials.Token = TokenUTF8.c_str();
-				Credentials.Type = EOS_ELoginCredentialType::EOS_LCT_Developer;
+	return IdTokenVerifier;
+}
 
-				LoginOptions.Credentials = &Credentials;
+bool FOnlineIdentityEOS::Login( int32 LocalUserNum, const FOnlineAccountCredentials& AccountCredentials )
+{
+	FString ErrorStr;
+	if( LocalUserNum < MAX_LOCAL_PLAYERS )
+	{
+		// Use AccountCredentials.Type then:
+		// @todo: support ALL Login types
+		FString MessageText = FString::Printf( TEXT( "Logging In with Dev Auth Tool | ID: %s | Token: %s." ), *AccountCredentials.Id, *AccountCredentials.Token );
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
 
-				EOS_Auth_Login( AuthHandle, &LoginOptions, NULL, LoginCompleteCallback );
+		// The SDK may complete the login after this interface is gone.
+		TWeakPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> WeakThis( AsShared() );
+		FOnEOSAuthLoginComplete CompletionCallback = [WeakThis, LocalUserNum]( EOS_EResult ResultCode, EOS_EpicAccountId AccountId )
+		{
+			TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> StrongThis = WeakThis.Pin();
 
-				return true;
-			}
-			else
+			if( StrongThis.IsValid() )
 			{
-				ErrorStr = TEXT( "Failed to get AuthHandle." );
+				StrongThis->HandleLoginComplete( LocalUserNum, ResultCode, AccountId );
 			}
-		}
-		else
+		};
+
+		if( StartAuthLogin( AccountCredentials, CompletionCallback, ErrorStr ) == true )
 		{
-			ErrorStr = TEXT( "EOS SDK Is not Initialized." );
+			return true;
 		}
 	}
 	else
@@ -78,6 +105,44 @@ bool FOnlineIdentityEOS::Login( int32 LocalUserNum, const FOnlineAccountCredenti
 	return false;
 }
 
+bool FOnlineIdentityEOS::StartAuthLogin( const FOnlineAccountCredentials& AccountCredentials, const FOnEOSAuthLoginComplete& CompletionCallback, FString& OutError )
+{
+	if( EOSSubsystem->IsEOSInitialized() == false )
+	{
+		OutError = TEXT( "EOS SDK Is not Initialized." );
+		return false;
+	}
+
+	EOS_HAuth AuthHandle = EOS_Platform_GetAuthInterface( EOSSubsystem->GetPlatformHandle() );
+
+	if( AuthHandle == nullptr )
+	{
+		OutError = TEXT( "Failed to get AuthHandle." );
+		return false;
+	}
+
+	// Everything handed to the SDK is marshalled into the arena, and released once EOS_Auth_Login returns.
+	FEOSScratchArena Arena;
+
+	EOS_Auth_Credentials* Credentials = Arena.Alloc<EOS_Auth_Credentials>();
+	Credentials->ApiVersion = EOS_AUTH_CREDENTIALS_API_LATEST;
+	Credentials->Id = Arena.ToUTF8( AccountCredentials.Id );
+	Credentials->Token = Arena.ToUTF8( AccountCredentials.Token );
+	Credentials->Type = EOS_ELoginCredentialType::EOS_LCT_Developer;
+
+	EOS_Auth_LoginOptions* LoginOptions = Arena.Alloc<EOS_Auth_LoginOptions>();
+	LoginOptions->ApiVersion = EOS_AUTH_LOGIN_API_LATEST;
+	LoginOptions->Credentials = Credentials;
+
+	// Ownership of the context passes to the SDK, and is reclaimed in LoginCompleteCallback.
+	FLoginRequestContext* RequestContext = new FLoginRequestContext();
+	RequestContext->CompletionCallback = CompletionCallback;
+
+	EOS_Auth_Login( AuthHandle, LoginOptions, RequestContext, LoginCompleteCallback );
+
+	return true;
+}
+
 bool FOnlineIdentityEOS::Logout( int32 LocalUserNum )
 {
 	FString ErrorStr;
@@ -87,11 +152,14 @@ bool FOnlineIdentityEOS::Logout( int32 LocalUserNum )
 
 		if( AuthHandle != nullptr )
 		{
+			const TSharedRef<const FUniqueNetIdEOS>* LocalUserId = LocalUserIds.Find( LocalUserNum );
+
 			EOS_Auth_LogoutOptions LogoutOptions;
 			LogoutOptions.ApiVersion = EOS_AUTH_LOGOUT_API_LATEST;
-			LogoutOptions.LocalUserId = EpicAccountId;
+			LogoutOptions.LocalUserId = ( LocalUserId != nullptr ) ? ( *LocalUserId )->EpicAccountId : EpicAccountId.EpicAccountId;
 
-			EOS_Auth_Logout( AuthHandle, &LogoutOptions, NULL, LogoutCompleteCallback );
+			// The Local User Num travels through the SDK as the ClientData.
+			EOS_Auth_Logout( AuthHandle, &LogoutOptions, (void*)(PTRINT)LocalUserNum, LogoutCompleteCallback );
 
 			return true;
 		}
@@ -133,27 +201,66 @@ TArray<TSharedPtr<FUserOnlineAccount>> FOnlineIdentityEOS::GetAllUserAccounts()
 
 TSharedPtr<const FUniqueNetId> FOnlineIdentityEOS::GetUniquePlayerId( int32 LocalUserNum ) const
 {
+	const TSharedRef<const FUniqueNetIdEOS>* LocalUserId = LocalUserIds.Find( LocalUserNum );
+
+	if( LocalUserId != nullptr )
+	{
+		return *LocalUserId;
+	}
+
 	return NULL;
 }
 
 TSharedPtr<const FUniqueNetId> FOnlineIdentityEOS::CreateUniquePlayerId( uint8* Bytes, int32 Size )
 {
+	if( Bytes != nullptr && Size == EOS_EPICACCOUNTID_BINARY_SIZE )
+	{
+		return FindOrAddKnownId( Bytes );
+	}
+
 	return NULL;
 }
 
 TSharedPtr<const FUniqueNetId> FOnlineIdentityEOS::CreateUniquePlayerId( const FString& Str )
 {
+	uint8 Bytes[EOS_EPICACCOUNTID_BINARY_SIZE];
+
+	if( EOSAccountIdHex::Decode( *Str, Str.Len(), Bytes, EOS_EPICACCOUNTID_BINARY_SIZE ) == true )
+	{
+		return FindOrAddKnownId( Bytes );
+	}
+
 	return NULL;
 }
 
 ELoginStatus::Type FOnlineIdentityEOS::GetLoginStatus( int32 LocalUserNum ) const
 {
+	const TSharedRef<const FUniqueNetIdEOS>* LocalUserId = LocalUserIds.Find( LocalUserNum );
+
+	if( LocalUserId != nullptr )
+	{
+		return GetLoginStatus( **LocalUserId );
+	}
+
 	return ELoginStatus::Type::NotLoggedIn;
 }
 
 ELoginStatus::Type FOnlineIdentityEOS::GetLoginStatus( const FUniqueNetId& UserId ) const
 {
-	return ELoginStatus::Type::NotLoggedIn;
+	if( UserId.GetType() != EOS_SUBSYSTEM || UserId.IsValid() == false || EOSSubsystem->IsEOSInitialized() == false )
+	{
+		return ELoginStatus::Type::NotLoggedIn;
+	}
+
+	EOS_HAuth AuthHandle = EOS_Platform_GetAuthInterface( EOSSubsystem->GetPlatformHandle() );
+
+	if( AuthHandle == nullptr )
+	{
+		return ELoginStatus::Type::NotLoggedIn;
+	}
+
+	const FUniqueNetIdEOS& EOSUserId = (const FUniqueNetIdEOS&)UserId;
+	return ToLoginStatus( EOS_Auth_GetLoginStatus( AuthHandle, EOSUserId.EpicAccountId ) );
 }
 
 FString FOnlineIdentityEOS::GetPlayerNickname( int32 LocalUserNum ) const
@@ -178,7 +285,70 @@ void FOnlineIdentityEOS::RevokeAuthToken( const FUniqueNetId& UserId, const FOnR
 
 void FOnlineIdentityEOS::GetUserPrivilege( const FUniqueNetId& UserId, EUserPrivileges::Type Privilege, const FOnGetUserPrivilegeCompleteDelegate& Delegate )
 {
+	// Privileges only depend on state the SDK already holds locally, so the delegate always completes
+	// on this frame; memoizing just avoids re-evaluating for callers that poll every frame.
+	const FPrivilegeCacheKey CacheKey( UserId.ToString(), Privilege );
+	const uint32* CachedResult = PrivilegeCache.Find( CacheKey );
 
+	uint32 PrivilegeResult;
+	if( CachedResult != nullptr )
+	{
+		PrivilegeResult = *CachedResult;
+	}
+	else
+	{
+		PrivilegeResult = EvaluateUserPrivilege( UserId, Privilege );
+		PrivilegeCache.Add( CacheKey, PrivilegeResult );
+	}
+
+	Delegate.ExecuteIfBound( UserId, Privilege, PrivilegeResult );
+}
+
+uint32 FOnlineIdentityEOS::EvaluateUserPrivilege( const FUniqueNetId& UserId, EUserPrivileges::Type Privilege ) const
+{
+	if( UserId.GetType() != EOS_SUBSYSTEM || UserId.IsValid() == false )
+	{
+		return (uint32)IOnlineIdentity::EPrivilegeResults::UserNotFound;
+	}
+
+	const ELoginStatus::Type LoginStatus = GetLoginStatus( UserId );
+
+	if( LoginStatus == ELoginStatus::NotLoggedIn )
+	{
+		return (uint32)IOnlineIdentity::EPrivilegeResults::UserNotLoggedIn;
+	}
+
+	switch( Privilege )
+	{
+	case EUserPrivileges::CanPlay:
+		// A local profile is enough to play offline.
+		return (uint32)IOnlineIdentity::EPrivilegeResults::NoFailures;
+
+	case EUserPrivileges::CanPlayOnline:
+	case EUserPrivileges::CanCommunicateOnline:
+	case EUserPrivileges::CanUseUserGeneratedContent:
+	case EUserPrivileges::CanUserCrossPlay:
+		if( LoginStatus != ELoginStatus::LoggedIn )
+		{
+			return (uint32)IOnlineIdentity::EPrivilegeResults::NetworkConnectionUnavailable;
+		}
+		return (uint32)IOnlineIdentity::EPrivilegeResults::NoFailures;
+	}
+
+	return (uint32)IOnlineIdentity::EPrivilegeResults::GenericFailure;
+}
+
+void FOnlineIdentityEOS::InvalidatePrivilegeCache( const FUniqueNetId& UserId )
+{
+	const FString UserIdStr = UserId.ToString();
+
+	for( auto It = PrivilegeCache.CreateIterator(); It; ++It )
+	{
+		if( It.Key().UserId == UserIdStr )
+		{
+			It.RemoveCurrent();
+		}
+	}
 }
 
 FPlatformUserId FOnlineIdentityEOS::GetPlatformUserIdFromUniqueNetId( const FUniqueNetId& UniqueNetId ) const
@@ -195,72 +365,353 @@ void FOnlineIdentityEOS::LoginCompleteCallback( const EOS_Auth_LoginCallbackInfo
 {
 	check( Data != NULL );
 
-	FUniqueNetIdEOS EpicId( Data->LocalUserId );
+	FLoginRequestContext* RequestContext = (FLoginRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	if( RequestContext->CompletionCallback )
+	{
+		RequestContext->CompletionCallback( Data->ResultCode, Data->LocalUserId );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineIdentityEOS::HandleLoginComplete( int32 LocalUserNum, EOS_EResult ResultCode, EOS_EpicAccountId AccountId )
+{
+	FUniqueNetIdEOS EpicId( AccountId );
 	FString MessageText = FString::Printf( TEXT( "EOS Login Complete - User ID: %s" ), *EpicId.ToString() );
 	UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
 
-	IOnlineSubsystem* SubSystem = IOnlineSubsystem::Get( EOS_SUBSYSTEM );
-	FOnlineSubsystemEOS* EOSSubsystem = (FOnlineSubsystemEOS*)SubSystem;
-	
-	if( EOSSubsystem != nullptr )
-	{
-		IOnlineIdentityPtr OnlineIdentity = EOSSubsystem->GetIdentityInterface();
+	EOS_HAuth AuthHandle = EOS_Platform_GetAuthInterface( EOSSubsystem->GetPlatformHandle() );
 
-		if( OnlineIdentity != nullptr )
+	if( AuthHandle != nullptr )
+	{
+		if( ResultCode == EOS_EResult::EOS_Success )
 		{
-			EOS_HAuth AuthHandle = EOS_Platform_GetAuthInterface( EOSSubsystem->GetPlatformHandle() );
-
-			if( AuthHandle != nullptr )
+			const int32_t AccountsCount = EOS_Auth_GetLoggedInAccountsCount( AuthHandle );
+			for( int32_t AccountIdx = 0; AccountIdx < AccountsCount; ++AccountIdx )
 			{
-				if( Data->ResultCode == EOS_EResult::EOS_Success )
-				{
-					const int32_t AccountsCount = EOS_Auth_GetLoggedInAccountsCount( AuthHandle );
-					for( int32_t AccountIdx = 0; AccountIdx < AccountsCount; ++AccountIdx )
-					{
-						FUniqueNetIdEOS EpicAccountId( EOS_Auth_GetLoggedInAccountByIndex( AuthHandle, AccountIdx ) );
-
-						EOS_ELoginStatus LoginStatus;
-						LoginStatus = EOS_Auth_GetLoginStatus( AuthHandle, EpicAccountId.EpicAccountId );
-
-						MessageText = FString::Printf( TEXT( "EOS Login: AccountIdx: %d Status: %d" ), AccountIdx, (int32_t)LoginStatus );
-						UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
-					}
-
-					// @todo: Match the returned User with some Local User Num.
-					OnlineIdentity->TriggerOnLoginChangedDelegates( 0 );
-					// @todo: Match the returned User with some Local User Num.
-					OnlineIdentity->TriggerOnLoginCompleteDelegates( 0, true, EpicId, TEXT( "" ) );
-				}
-				else
-				{
-					MessageText = FString::Printf( TEXT( "EOS Login: Failed with Status: %s" ), *UEOSCommon::EOSResultToString( Data->ResultCode ) );
-					UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
-					// @todo: Match the returned User with some Local User Num.
-					int32 LocalUserNum = 0;
-					OnlineIdentity->TriggerOnLoginCompleteDelegates( LocalUserNum, false, FUniqueNetIdEOS(), MessageText );
-				}
-			}
-			else
-			{
-				MessageText = FString::Printf( TEXT( "EOS Login: Failed to retrieve EOS Auth Handle." ) );
-				UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
+				FUniqueNetIdEOS LoggedInAccountId( EOS_Auth_GetLoggedInAccountByIndex( AuthHandle, AccountIdx ) );
+
+				EOS_ELoginStatus LoginStatus;
+				LoginStatus = EOS_Auth_GetLoginStatus( AuthHandle, LoggedInAccountId.EpicAccountId );
 
-				// @todo: Match the returned User with some Local User Num.
-				int32 LocalUserNum = 0;
-				OnlineIdentity->TriggerOnLoginCompleteDelegates( LocalUserNum, false, FUniqueNetIdEOS(), MessageText );
+				MessageText = FString::Printf( TEXT( "EOS Login: AccountIdx: %d Status: %d" ), AccountIdx, (int32_t)LoginStatus );
+				UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
 			}
+
+			EpicAccountId.SetAccountId( AccountId );
+
+			const TSharedRef<const FUniqueNetIdEOS> LocalUserId = FindOrAddKnownId( EpicId.GetBytes() );
+			LocalUserIds.Add( LocalUserNum, LocalUserId );
+			InvalidatePrivilegeCache( *LocalUserId );
+
+			// The login completes once EOS Connect has been logged in as well.
+			StartConnectLogin( LocalUserNum, AccountId );
 		}
 		else
 		{
-			MessageText = FString::Printf( TEXT( "EOS Login: Failed to retrieve EOS Online Identity Interface." ) );
+			MessageText = FString::Printf( TEXT( "EOS Login: Failed with Status: %s" ), *UEOSCommon::EOSResultToString( ResultCode ) );
 			UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
+			TriggerOnLoginCompleteDelegates( LocalUserNum, false, FUniqueNetIdEOS(), MessageText );
 		}
 	}
 	else
 	{
-		MessageText = FString::Printf( TEXT( "EOS Login: Cannot retrieve EOS Subsystem." ) );
+		MessageText = FString::Printf( TEXT( "EOS Login: Failed to retrieve EOS Auth Handle." ) );
 		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
+		TriggerOnLoginCompleteDelegates( LocalUserNum, false, FUniqueNetIdEOS(), MessageText );
+	}
+}
+
+bool FOnlineIdentityEOS::StartConnectLogin( int32 LocalUserNum, EOS_EpicAccountId AccountId )
+{
+	EOS_HAuth AuthHandle = EOS_Platform_GetAuthInterface( EOSSubsystem->GetPlatformHandle() );
+	EOS_HConnect ConnectHandle = EOS_Platform_GetConnectInterface( EOSSubsystem->GetPlatformHandle() );
+
+	if( AuthHandle == nullptr || ConnectHandle == nullptr )
+	{
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS Connect Login: Failed to retrieve EOS Auth/Connect Handles." ) );
+		HandleConnectLoginComplete( LocalUserNum, EOS_EResult::EOS_NotConfigured, nullptr );
+		return false;
+	}
+
+	// EOS Connect accepts the Epic Account's access token as an external credential.
+	EOS_Auth_CopyUserAuthTokenOptions CopyOptions;
+	CopyOptions.ApiVersion = EOS_AUTH_COPYUSERAUTHTOKEN_API_LATEST;
+
+	EOS_Auth_Token* AuthToken = nullptr;
+	const EOS_EResult CopyResult = EOS_Auth_CopyUserAuthToken( AuthHandle, &CopyOptions, AccountId, &AuthToken );
+
+	if( CopyResult != EOS_EResult::EOS_Success || AuthToken == nullptr )
+	{
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS Connect Login: Failed to copy Auth Token. %s" ), *UEOSCommon::EOSResultToString( CopyResult ) );
+		HandleConnectLoginComplete( LocalUserNum, CopyResult, nullptr );
+		return false;
+	}
+
+	EOS_Connect_Credentials Credentials;
+	Credentials.ApiVersion = EOS_CONNECT_CREDENTIALS_API_LATEST;
+	Credentials.Token = AuthToken->AccessToken;
+	Credentials.Type = EOS_EExternalCredentialType::EOS_ECT_EPIC;
+
+	EOS_Connect_LoginOptions LoginOptions;
+	LoginOptions.ApiVersion = EOS_CONNECT_LOGIN_API_LATEST;
+	LoginOptions.Credentials = &Credentials;
+	LoginOptions.UserLoginInfo = nullptr;
+
+	// Ownership of the context passes to the SDK, and is reclaimed once the login (and any user creation) completes.
+	FConnectLoginContext* RequestContext = new FConnectLoginContext();
+	RequestContext->Identity = AsShared();
+	RequestContext->LocalUserNum = LocalUserNum;
+
+	EOS_Connect_Login( ConnectHandle, &LoginOptions, RequestContext, ConnectLoginCompleteCallback );
+
+	// The SDK has copied the token by now.
+	EOS_Auth_Token_Release( AuthToken );
+
+	return true;
+}
+
+void FOnlineIdentityEOS::ConnectLoginCompleteCallback( const EOS_Connect_LoginCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FConnectLoginContext* RequestContext = (FConnectLoginContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = RequestContext->Identity.Pin();
+
+	if( Identity.IsValid() == false )
+	{
+		delete RequestContext;
+		return;
+	}
+
+	if( Data->ResultCode == EOS_EResult::EOS_InvalidUser && Data->ContinuanceToken != nullptr )
+	{
+		// First time this account has played: create its Product User, reusing the context.
+		EOS_HConnect ConnectHandle = EOS_Platform_GetConnectInterface( Identity->EOSSubsystem->GetPlatformHandle() );
+
+		if( ConnectHandle != nullptr )
+		{
+			EOS_Connect_CreateUserOptions CreateUserOptions;
+			CreateUserOptions.ApiVersion = EOS_CONNECT_CREATEUSER_API_LATEST;
+			CreateUserOptions.ContinuanceToken = Data->ContinuanceToken;
+
+			EOS_Connect_CreateUser( ConnectHandle, &CreateUserOptions, RequestContext, ConnectCreateUserCompleteCallback );
+			return;
+		}
 	}
+
+	Identity->HandleConnectLoginComplete( RequestContext->LocalUserNum, Data->ResultCode, Data->LocalUserId );
+
+	delete RequestContext;
+}
+
+void FOnlineIdentityEOS::ConnectCreateUserCompleteCallback( const EOS_Connect_CreateUserCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FConnectLoginContext* RequestContext = (FConnectLoginContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = RequestContext->Identity.Pin();
+
+	if( Identity.IsValid() )
+	{
+		Identity->HandleConnectLoginComplete( RequestContext->LocalUserNum, Data->ResultCode, Data->LocalUserId );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineIdentityEOS::HandleConnectLoginComplete( int32 LocalUserNum, EOS_EResult ResultCode, EOS_ProductUserId ProductUserId )
+{
+	const TSharedRef<const FUniqueNetIdEOS>* LocalUserId = LocalUserIds.Find( LocalUserNum );
+
+	if( LocalUserId == nullptr )
+	{
+		// Logged out again while EOS Connect was responding.
+		return;
+	}
+
+	if( ResultCode == EOS_EResult::EOS_Success && EOS_ProductUserId_IsValid( ProductUserId ) == EOS_TRUE )
+	{
+		LocalProductUserIds.Add( LocalUserNum, ProductUserId );
+	}
+	else
+	{
+		// The Epic Account is still logged in, only the game services that need a Product User are unavailable.
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS Connect Login: Failed with Status: %s" ), *UEOSCommon::EOSResultToString( ResultCode ) );
+	}
+
+	const TSharedRef<const FUniqueNetIdEOS> CompletedUserId = *LocalUserId;
+
+	TriggerOnLoginChangedDelegates( LocalUserNum );
+	TriggerOnLoginCompleteDelegates( LocalUserNum, true, *CompletedUserId, TEXT( "" ) );
+}
+
+EOS_ProductUserId FOnlineIdentityEOS::GetProductUserId( int32 LocalUserNum ) const
+{
+	const EOS_ProductUserId* ProductUserId = LocalProductUserIds.Find( LocalUserNum );
+	return ( ProductUserId != nullptr ) ? *ProductUserId : nullptr;
+}
+
+EOS_ProductUserId FOnlineIdentityEOS::GetProductUserId( const FUniqueNetId& UserId ) const
+{
+	for( const TPair<int32, TSharedRef<const FUniqueNetIdEOS>>& LocalUser : LocalUserIds )
+	{
+		if( *LocalUser.Value == UserId )
+		{
+			return GetProductUserId( LocalUser.Key );
+		}
+	}
+
+	const EOS_ProductUserId* ProductUserId = ProductUserIdMappings.Find( UserId.ToString() );
+	return ( ProductUserId != nullptr ) ? *ProductUserId : nullptr;
+}
+
+TSharedPtr<const FUniqueNetId> FOnlineIdentityEOS::FindUniquePlayerId( EOS_ProductUserId ProductUserId )
+{
+	if( ProductUserId == nullptr )
+	{
+		return nullptr;
+	}
+
+	// Handles for the same Product User aren't guaranteed to be the same pointer, so they are compared as strings.
+	const FString ProductUserKey = UEOSCommon::ProductUserIdToString( ProductUserId );
+
+	for( const TPair<int32, EOS_ProductUserId>& LocalProductUserId : LocalProductUserIds )
+	{
+		if( UEOSCommon::ProductUserIdToString( LocalProductUserId.Value ) == ProductUserKey )
+		{
+			const TSharedRef<const FUniqueNetIdEOS>* LocalUserId = LocalUserIds.Find( LocalProductUserId.Key );
+			return ( LocalUserId != nullptr ) ? TSharedPtr<const FUniqueNetId>( *LocalUserId ) : nullptr;
+		}
+	}
+
+	for( const TPair<FString, EOS_ProductUserId>& Mapping : ProductUserIdMappings )
+	{
+		if( UEOSCommon::ProductUserIdToString( Mapping.Value ) == ProductUserKey )
+		{
+			return CreateUniquePlayerId( Mapping.Key );
+		}
+	}
+
+	return nullptr;
+}
+
+int32 FOnlineIdentityEOS::GetLocalUserNum( const FUniqueNetId& UserId ) const
+{
+	for( const TPair<int32, TSharedRef<const FUniqueNetIdEOS>>& LocalUser : LocalUserIds )
+	{
+		if( *LocalUser.Value == UserId )
+		{
+			return LocalUser.Key;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+void FOnlineIdentityEOS::QueryProductUserIds( const TArray<TSharedRef<const FUniqueNetId>>& UserIds, const FOnEOSQueryProductUserIdsComplete& CompletionCallback )
+{
+	check( UserIds.Num() <= EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS );
+
+	EOS_HConnect ConnectHandle = EOS_Platform_GetConnectInterface( EOSSubsystem->GetPlatformHandle() );
+
+	// Any of our Product Users may ask on behalf of the others.
+	EOS_ProductUserId LocalUserId = nullptr;
+	for( const TPair<int32, EOS_ProductUserId>& LocalProductUserId : LocalProductUserIds )
+	{
+		LocalUserId = LocalProductUserId.Value;
+		break;
+	}
+
+	if( ConnectHandle == nullptr || LocalUserId == nullptr )
+	{
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS Connect: Cannot look up Product Users without a Local User logged into EOS Connect." ) );
+		CompletionCallback( false );
+		return;
+	}
+
+	FEOSLargeScratchArena Arena;
+
+	FQueryMappingsContext* RequestContext = new FQueryMappingsContext();
+	RequestContext->Identity = AsShared();
+	RequestContext->LocalUserId = LocalUserId;
+	RequestContext->CompletionCallback = CompletionCallback;
+	RequestContext->AccountIds.Reserve( UserIds.Num() );
+
+	const char** ExternalAccountIds = Arena.Alloc<const char*>( UserIds.Num() );
+	for( int32 UserIdx = 0; UserIdx < UserIds.Num(); ++UserIdx )
+	{
+		RequestContext->AccountIds.Add( UserIds[UserIdx]->ToString() );
+		ExternalAccountIds[UserIdx] = Arena.ToUTF8( RequestContext->AccountIds.Last() );
+	}
+
+	EOS_Connect_QueryExternalAccountMappingsOptions QueryOptions;
+	QueryOptions.ApiVersion = EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_API_LATEST;
+	QueryOptions.LocalUserId = LocalUserId;
+	QueryOptions.AccountIdType = EOS_EExternalAccountType::EOS_EAT_EPIC;
+	QueryOptions.ExternalAccountIds = ExternalAccountIds;
+	QueryOptions.ExternalAccountIdCount = (uint32_t)UserIds.Num();
+
+	EOS_Connect_QueryExternalAccountMappings( ConnectHandle, &QueryOptions, RequestContext, QueryExternalAccountMappingsCompleteCallback );
+}
+
+void FOnlineIdentityEOS::QueryExternalAccountMappingsCompleteCallback( const EOS_Connect_QueryExternalAccountMappingsCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FQueryMappingsContext* RequestContext = (FQueryMappingsContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = RequestContext->Identity.Pin();
+
+	if( Identity.IsValid() == false )
+	{
+		// Nowhere left to keep the mappings.
+		RequestContext->CompletionCallback( false );
+		delete RequestContext;
+		return;
+	}
+
+	const bool bWasSuccessful = ( Data->ResultCode == EOS_EResult::EOS_Success );
+
+	EOS_HConnect ConnectHandle = EOS_Platform_GetConnectInterface( Identity->EOSSubsystem->GetPlatformHandle() );
+
+	if( bWasSuccessful == true && ConnectHandle != nullptr )
+	{
+		FEOSScratchArena Arena;
+
+		EOS_Connect_GetExternalAccountMappingsOptions MappingOptions;
+		MappingOptions.ApiVersion = EOS_CONNECT_GETEXTERNALACCOUNTMAPPINGS_API_LATEST;
+		MappingOptions.LocalUserId = RequestContext->LocalUserId;
+		MappingOptions.AccountIdType = EOS_EExternalAccountType::EOS_EAT_EPIC;
+
+		for( const FString& AccountId : RequestContext->AccountIds )
+		{
+			MappingOptions.TargetExternalUserId = Arena.ToUTF8( AccountId );
+
+			EOS_ProductUserId ProductUserId = EOS_Connect_GetExternalAccountMapping( ConnectHandle, &MappingOptions );
+			if( EOS_ProductUserId_IsValid( ProductUserId ) == EOS_TRUE )
+			{
+				Identity->ProductUserIdMappings.Add( AccountId, ProductUserId );
+			}
+
+			Arena.Reset();
+		}
+	}
+	else
+	{
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS Connect: Product User lookup failed. %s" ), *UEOSCommon::EOSResultToString( Data->ResultCode ) );
+	}
+
+	RequestContext->CompletionCallback( bWasSuccessful );
+
+	delete RequestContext;
 }
 
 void FOnlineIdentityEOS::LogoutCompleteCallback( const EOS_Auth_LogoutCallbackInfo* Data )
@@ -274,11 +725,11 @@ void FOnlineIdentityEOS::LogoutCompleteCallback( const EOS_Auth_LogoutCallbackIn
 
 	if( SubSystem != nullptr )
 	{
-		IOnlineIdentityPtr OnlineIdentity = SubSystem->GetIdentityInterface();
+		FOnlineIdentityEOS* OnlineIdentity = (FOnlineIdentityEOS*)SubSystem->GetIdentityInterface().Get();
 
 		if( OnlineIdentity != nullptr )
 		{
-			OnlineIdentity->TriggerOnLogoutCompleteDelegates( 0, false );
+			OnlineIdentity->HandleLogoutComplete( (int32)(PTRINT)Data->ClientData, Data->ResultCode );
 		}
 	}
 	else
@@ -287,3 +738,107 @@ void FOnlineIdentityEOS::LogoutCompleteCallback( const EOS_Auth_LogoutCallbackIn
 		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "%s" ), *MessageText );
 	}
 }
+
+void FOnlineIdentityEOS::HandleLogoutComplete( int32 LocalUserNum, EOS_EResult ResultCode )
+{
+	const bool bWasSuccessful = ( ResultCode == EOS_EResult::EOS_Success );
+
+	if( bWasSuccessful == true )
+	{
+		const TSharedRef<const FUniqueNetIdEOS>* LocalUserId = LocalUserIds.Find( LocalUserNum );
+
+		if( LocalUserId != nullptr )
+		{
+			InvalidatePrivilegeCache( **LocalUserId );
+			LocalUserIds.Remove( LocalUserNum );
+			LocalProductUserIds.Remove( LocalUserNum );
+		}
+
+		TriggerOnLoginChangedDelegates( LocalUserNum );
+	}
+
+	TriggerOnLogoutCompleteDelegates( LocalUserNum, bWasSuccessful );
+}
+
+void FOnlineIdentityEOS::LoginStatusChangedCallback( const EOS_Auth_LoginStatusChangedCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FOnlineIdentityEOS* OnlineIdentity = (FOnlineIdentityEOS*)Data->ClientData;
+
+	if( OnlineIdentity != nullptr )
+	{
+		OnlineIdentity->HandleLoginStatusChanged( Data->LocalUserId, Data->PrevStatus, Data->CurrentStatus );
+	}
+}
+
+void FOnlineIdentityEOS::HandleLoginStatusChanged( EOS_EpicAccountId AccountId, EOS_ELoginStatus PrevStatus, EOS_ELoginStatus CurrentStatus )
+{
+	const FUniqueNetIdEOS ChangedUserId( AccountId );
+	InvalidatePrivilegeCache( ChangedUserId );
+
+	const int32 LocalUserNum = GetLocalUserNumFromAccountId( AccountId );
+
+	if( LocalUserNum != INDEX_NONE )
+	{
+		TriggerOnLoginStatusChangedDelegates( LocalUserNum, ToLoginStatus( PrevStatus ), ToLoginStatus( CurrentStatus ), ChangedUserId );
+	}
+}
+
+TSharedRef<const FUniqueNetIdEOS> FOnlineIdentityEOS::FindOrAddKnownId( const uint8* Bytes )
+{
+	check( IsInGameThread() );
+
+	const FKnownIdKey Key( Bytes );
+
+	if( const TSharedRef<const FUniqueNetIdEOS>* KnownId = KnownIds.Find( Key ) )
+	{
+		return *KnownId;
+	}
+
+	if( KnownIds.Num() >= KnownIdsPruneThreshold )
+	{
+		// Drop ids nobody else holds any more, e.g. players that have since left.
+		for( auto It = KnownIds.CreateIterator(); It; ++It )
+		{
+			if( It.Value().IsUnique() )
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		KnownIdsPruneThreshold = FMath::Max( 256, KnownIds.Num() * 2 );
+	}
+
+	const TSharedRef<const FUniqueNetIdEOS> NewId = MakeShareable( new FUniqueNetIdEOS( Bytes ) );
+	KnownIds.Add( Key, NewId );
+
+	return NewId;
+}
+
+int32 FOnlineIdentityEOS::GetLocalUserNumFromAccountId( EOS_EpicAccountId AccountId ) const
+{
+	for( const TPair<int32, TSharedRef<const FUniqueNetIdEOS>>& LocalUser : LocalUserIds )
+	{
+		if( LocalUser.Value->EpicAccountId == AccountId )
+		{
+			return LocalUser.Key;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+ELoginStatus::Type FOnlineIdentityEOS::ToLoginStatus( EOS_ELoginStatus LoginStatus )
+{
+	switch( LoginStatus )
+	{
+	case EOS_ELoginStatus::EOS_LS_LoggedIn:
+		return ELoginStatus::LoggedIn;
+	case EOS_ELoginStatus::EOS_LS_UsingLocalProfile:
+		return ELoginStatus::UsingLocalProfile;
+	case EOS_ELoginStatus::EOS_LS_NotLoggedIn:
+	default:
+		return ELoginStatus::NotLoggedIn;
+	}
+}
@@ -14,18 +14,34 @@
 // EOS SDK Includes
 #include "eos_sdk.h"
 #include "eos_auth.h"
+#include "eos_connect.h"
 
 // Forward Declarations
 class FOnlineSubsystemEOS;
+class FIdTokenVerifierEOS;
 
+/**
+ * Completion callback for a raw EOS Auth login.
+ *
+ * @param ResultCode The SDK result of the login attempt.
+ * @param AccountId The Epic Account Id that was logged in. Only valid on EOS_Success.
+ */
+typedef TFunction<void( EOS_EResult ResultCode, EOS_EpicAccountId AccountId )> FOnEOSAuthLoginComplete;
 
+/**
+ * Completion callback for a Product User Id lookup.
+ *
+ * @param bWasSuccessful Whether the backend answered. Accounts with no Product User still have none afterwards.
+ */
+typedef TFunction<void( bool bWasSuccessful )> FOnEOSQueryProductUserIdsComplete;
 
-class FOnlineIdentityEOS : public IOnlineIdentity
+
+class FOnlineIdentityEOS : public IOnlineIdentity, public TSharedFromThis<FOnlineIdentityEOS, ESPMode::ThreadSafe>
 {
 
 public:
 
-	virtual ~FOnlineIdentityEOS() {};
+	virtual ~FOnlineIdentityEOS();
 
 	// IOnlineIdentity
 
@@ -53,15 +69,192 @@ protected:
 
 	static void										LogoutCompleteCallback( const EOS_Auth_LogoutCallbackInfo* Data );
 
+	static void										LoginStatusChangedCallback( const EOS_Auth_LoginStatusChangedCallbackInfo* Data );
+
+	static void										ConnectLoginCompleteCallback( const EOS_Connect_LoginCallbackInfo* Data );
+
+	static void										ConnectCreateUserCompleteCallback( const EOS_Connect_CreateUserCallbackInfo* Data );
+
+	static void										QueryExternalAccountMappingsCompleteCallback( const EOS_Connect_QueryExternalAccountMappingsCallbackInfo* Data );
+
+	/** Completes a Login() for a Local User once the SDK has responded. */
+	void											HandleLoginComplete( int32 LocalUserNum, EOS_EResult ResultCode, EOS_EpicAccountId AccountId );
+
+	/**
+	* Logs a freshly authenticated Epic Account into EOS Connect, to obtain the Product User Id the game services
+	* (Sessions, Lobbies, ...) identify players by. Creates the Product User on the account's first login.
+	*
+	* @return bool True if the request was handed to the SDK, HandleConnectLoginComplete is called either way.
+	*/
+	bool											StartConnectLogin( int32 LocalUserNum, EOS_EpicAccountId AccountId );
+
+	/** Completes a Login() for a Local User once EOS Connect has responded. */
+	void											HandleConnectLoginComplete( int32 LocalUserNum, EOS_EResult ResultCode, EOS_ProductUserId ProductUserId );
+
+	/** Completes a Logout() for a Local User once the SDK has responded. */
+	void											HandleLogoutComplete( int32 LocalUserNum, EOS_EResult ResultCode );
+
+	/** Handles the SDK reporting a change in login status, for any logged in account. */
+	void											HandleLoginStatusChanged( EOS_EpicAccountId AccountId, EOS_ELoginStatus PrevStatus, EOS_ELoginStatus CurrentStatus );
+
+	/**
+	* Finds the Local User that an Epic Account is logged in as.
+	*
+	* @return int32 The Local User Num, or INDEX_NONE if the account is not bound to a Local User.
+	*/
+	int32											GetLocalUserNumFromAccountId( EOS_EpicAccountId AccountId ) const;
+
+	/** Evaluates a privilege from the current login state. Results are cached by GetUserPrivilege. */
+	uint32											EvaluateUserPrivilege( const FUniqueNetId& UserId, EUserPrivileges::Type Privilege ) const;
+
+	/** Drops every cached privilege result for a user, e.g. after their login status changes. */
+	void											InvalidatePrivilegeCache( const FUniqueNetId& UserId );
+
+	/** Converts between the SDK and OSS representations of login status. */
+	static ELoginStatus::Type						ToLoginStatus( EOS_ELoginStatus LoginStatus );
+
+	/**
+	* Returns the shared id for an account, creating and registering it the first time the account is seen.
+	* Game thread only: the ids are shared with the OSS as Fast-mode shared refs, whose reference counts are not atomic.
+	*
+	* @param Bytes The binary form of the id, EOS_EPICACCOUNTID_BINARY_SIZE bytes.
+	*/
+	TSharedRef<const FUniqueNetIdEOS>				FindOrAddKnownId( const uint8* Bytes );
+
+	/** Per-request data passed through the SDK as ClientData for EOS_Auth_Login. */
+	struct FLoginRequestContext
+	{
+		FOnEOSAuthLoginComplete						CompletionCallback;
+	};
+
 	/** The Epic Account ID for this Authentication session. */
 	FUniqueNetIdEOS									EpicAccountId;
 
+	/** The Epic Account each Local User is logged in as. */
+	TMap<int32, TSharedRef<const FUniqueNetIdEOS>>	LocalUserIds;
+
+	/** Per-request data passed through the SDK as ClientData for EOS_Connect_Login and EOS_Connect_CreateUser. */
+	struct FConnectLoginContext
+	{
+		TWeakPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity;
+		int32										LocalUserNum;
+	};
+
+	/** The Product User each Local User is logged into EOS Connect as. */
+	TMap<int32, EOS_ProductUserId>					LocalProductUserIds;
+
+	/** Per-request data passed through the SDK as ClientData for EOS_Connect_QueryExternalAccountMappings. */
+	struct FQueryMappingsContext
+	{
+		TWeakPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity;
+		EOS_ProductUserId							LocalUserId;
+		TArray<FString>								AccountIds;
+		FOnEOSQueryProductUserIdsComplete			CompletionCallback;
+	};
+
+	/** The Product User of each remote Epic Account looked up so far, by account id string. */
+	TMap<FString, EOS_ProductUserId>				ProductUserIdMappings;
+
+	/** Key for memoized privilege results. */
+	struct FPrivilegeCacheKey
+	{
+		FString										UserId;
+		EUserPrivileges::Type						Privilege;
+
+		FPrivilegeCacheKey( const FString& InUserId, EUserPrivileges::Type InPrivilege )
+			: UserId( InUserId )
+			, Privilege( InPrivilege )
+		{}
+
+		bool operator==( const FPrivilegeCacheKey& Other ) const
+		{
+			return Privilege == Other.Privilege && UserId == Other.UserId;
+		}
+
+		friend uint32 GetTypeHash( const FPrivilegeCacheKey& Key )
+		{
+			return HashCombine( GetTypeHash( Key.UserId ), (uint32)Key.Privilege );
+		}
+	};
+
+	/** Memoized GetUserPrivilege results (EPrivilegeResults flags), until the user's login status changes. */
+	TMap<FPrivilegeCacheKey, uint32>				PrivilegeCache;
+
+	/** Handle for the SDK login status notification. */
+	EOS_NotificationId								LoginStatusChangedId;
+
+	/** Key for the known id registry, the binary form of an account id. */
+	struct FKnownIdKey
+	{
+		uint64										Words[EOS_EPICACCOUNTID_BINARY_SIZE / sizeof( uint64 )];
+
+		explicit FKnownIdKey( const uint8* Bytes )
+		{
+			FMemory::Memcpy( Words, Bytes, sizeof( Words ) );
+		}
+
+		bool operator==( const FKnownIdKey& Other ) const
+		{
+			return Words[0] == Other.Words[0] && Words[1] == Other.Words[1];
+		}
+
+		friend uint32 GetTypeHash( const FKnownIdKey& Key )
+		{
+			return HashCombine( GetTypeHash( Key.Words[0] ), GetTypeHash( Key.Words[1] ) );
+		}
+	};
+
+	/** Every id handed out by CreateUniquePlayerId or a login, so each account shares a single id object. */
+	TMap<FKnownIdKey, TSharedRef<const FUniqueNetIdEOS>> KnownIds;
+
+	/** Size at which ids no longer referenced outside the registry are dropped. */
+	int32											KnownIdsPruneThreshold;
+
 private:
 
 PACKAGE_SCOPE :
 		
 	FOnlineIdentityEOS( FOnlineSubsystemEOS* InSubsystem );
 
+	/**
+	* Issues an EOS Auth login for the given credentials, without binding the result to a Local User.
+	* Used by Login() and by the bulk login harness, which needs far more accounts than MAX_LOCAL_PLAYERS.
+	*
+	* @param AccountCredentials Id/Token pair. For the Dev Auth Tool, Id is host:port and Token is the credential name.
+	* @param CompletionCallback Called from the SDK tick once the login completes (only if this returns true).
+	* @param OutError Populated with a reason when the request could not be issued.
+	*
+	* @return bool True if the request was handed to the SDK.
+	*/
+	bool											StartAuthLogin( const FOnlineAccountCredentials& AccountCredentials, const FOnEOSAuthLoginComplete& CompletionCallback, FString& OutError );
+
+	/** @return The Product User Id a Local User is logged into EOS Connect as, or nullptr. */
+	EOS_ProductUserId								GetProductUserId( int32 LocalUserNum ) const;
+
+	/** @return The Product User Id of a logged in Local User, or of an account looked up by QueryProductUserIds, or nullptr. */
+	EOS_ProductUserId								GetProductUserId( const FUniqueNetId& UserId ) const;
+
+	/** @return The Epic Account of a Local User, or of an account looked up by QueryProductUserIds, by Product User. Null for anyone else. */
+	TSharedPtr<const FUniqueNetId>					FindUniquePlayerId( EOS_ProductUserId ProductUserId );
+
+	/** @return int32 The Local User Num a player is logged in as, or INDEX_NONE if they are not a Local User. */
+	int32											GetLocalUserNum( const FUniqueNetId& UserId ) const;
+
+	/**
+	* Looks up the Product Users of Epic Accounts, so GetProductUserId can answer for players other than our own.
+	* Issued as a single request, on behalf of any logged in Local User.
+	*
+	* @param UserIds At most EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS accounts.
+	* @param CompletionCallback Called once the lookup completes, or straight away if it could not be issued.
+	*/
+	void											QueryProductUserIds( const TArray<TSharedRef<const FUniqueNetId>>& UserIds, const FOnEOSQueryProductUserIdsComplete& CompletionCallback );
+
+	/** Ticks anything the identity drives outside the SDK callbacks. Called from the owning subsystem. */
+	void											Tick( float DeltaTime );
+
+	/** @return The server-side ID token verifier, created and initialized on first use. */
+	TSharedPtr<FIdTokenVerifierEOS, ESPMode::ThreadSafe> GetIdTokenVerifier();
+
 	/** The steam user interface to use when interacting with steam */
 	//class ISteamUser* SteamUserPtr;
 	/** The steam friends interface to use when interacting with steam */
@@ -69,6 +262,9 @@ PACKAGE_SCOPE :
 
 	/** Cached pointer to owning subsystem */
 	FOnlineSubsystemEOS*							EOSSubsystem;
+
+	/** Verifies client ID tokens locally. Only created on servers that ask for it. */
+	TSharedPtr<FIdTokenVerifierEOS, ESPMode::ThreadSafe> IdTokenVerifier;
 };
 
 typedef TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> FOnlineIdentityEOSPtr;
\ No newline at end of file
@@ -0,0 +1,562 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineIdentityTokenVerifierEOS.h"
+
+// Engine Includes
+#include "OnlineSubsystem.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "HttpModule.h"
+#include "Misc/Base64.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Containers/StringConv.h"
+
+// OpenSSL Includes
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#endif
+THIRD_PARTY_INCLUDES_START
+#include <openssl/bn.h>
+#include <openssl/objects.h>
+#include <openssl/rsa.h>
+#include <openssl/sha.h>
+THIRD_PARTY_INCLUDES_END
+#if PLATFORM_WINDOWS
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+
+/**
+ * An immutable set of RSA signing keys, indexed by key id.
+ * Shared between the game thread and verification workers; replaced wholesale on refresh.
+ */
+class FSigningKeySetEOS
+{
+
+public:
+
+	~FSigningKeySetEOS()
+	{
+		for( const TPair<FString, RSA*>& Key : Keys )
+		{
+			RSA_free( Key.Value );
+		}
+	}
+
+	/** Takes ownership of the key. */
+	void AddKey( const FString& KeyId, RSA* Key )
+	{
+		if( RSA** Existing = Keys.Find( KeyId ) )
+		{
+			RSA_free( *Existing );
+		}
+		Keys.Add( KeyId, Key );
+	}
+
+	const RSA* FindKey( const FString& KeyId ) const
+	{
+		RSA* const* Key = Keys.Find( KeyId );
+		return ( Key != nullptr ) ? *Key : nullptr;
+	}
+
+	int32 Num() const
+	{
+		return Keys.Num();
+	}
+
+private:
+
+	TMap<FString, RSA*> Keys;
+};
+
+namespace IdTokenVerifierEOS
+{
+	/** The issuer of EOS Connect ID tokens. */
+	static const TCHAR* DefaultIssuer = TEXT( "https://api.epicgames.dev/auth/v1/oauth" );
+
+	/** Decodes a base64url (unpadded, URL-safe alphabet) segment, as used throughout JWT/JWK. */
+	static bool Base64UrlDecode( const FString& Source, TArray<uint8>& OutBytes )
+	{
+		FString Base64 = Source.Replace( TEXT( "-" ), TEXT( "+" ) ).Replace( TEXT( "_" ), TEXT( "/" ) );
+
+		while( Base64.Len() % 4 != 0 )
+		{
+			Base64.AppendChar( TEXT( '=' ) );
+		}
+
+		return FBase64::Decode( Base64, OutBytes );
+	}
+
+	/** Decodes a base64url segment holding a JSON object. */
+	static TSharedPtr<FJsonObject> DecodeJsonSegment( const FString& Segment )
+	{
+		TArray<uint8> Bytes;
+		if( Base64UrlDecode( Segment, Bytes ) == false || Bytes.Num() == 0 )
+		{
+			return nullptr;
+		}
+
+		FUTF8ToTCHAR Converted( (const ANSICHAR*)Bytes.GetData(), Bytes.Num() );
+		const FString Json( Converted.Length(), Converted.Get() );
+
+		TSharedPtr<FJsonObject> JsonObject;
+		TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create( Json );
+
+		if( FJsonSerializer::Deserialize( JsonReader, JsonObject ) == false )
+		{
+			return nullptr;
+		}
+
+		return JsonObject;
+	}
+
+	/** Builds an RSA public key from a JWK's base64url modulus and exponent. */
+	static RSA* CreateRSAKey( const FString& Modulus, const FString& Exponent )
+	{
+		TArray<uint8> ModulusBytes;
+		TArray<uint8> ExponentBytes;
+
+		if( Base64UrlDecode( Modulus, ModulusBytes ) == false || Base64UrlDecode( Exponent, ExponentBytes ) == false ||
+			ModulusBytes.Num() == 0 || ExponentBytes.Num() == 0 )
+		{
+			return nullptr;
+		}
+
+		BIGNUM* N = BN_bin2bn( ModulusBytes.GetData(), ModulusBytes.Num(), nullptr );
+		BIGNUM* E = BN_bin2bn( ExponentBytes.GetData(), ExponentBytes.Num(), nullptr );
+		RSA* Key = RSA_new();
+
+		if( N == nullptr || E == nullptr || Key == nullptr )
+		{
+			BN_free( N );
+			BN_free( E );
+			RSA_free( Key );
+			return nullptr;
+		}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+		RSA_set0_key( Key, N, E, nullptr );
+#else
+		Key->n = N;
+		Key->e = E;
+#endif
+
+		return Key;
+	}
+}
+
+const TCHAR* LexToString( EIdTokenResultEOS Result )
+{
+	switch( Result )
+	{
+	case EIdTokenResultEOS::Valid:
+		return TEXT( "Valid" );
+	case EIdTokenResultEOS::Malformed:
+		return TEXT( "Malformed" );
+	case EIdTokenResultEOS::NoKeys:
+		return TEXT( "NoKeys" );
+	case EIdTokenResultEOS::UnknownKey:
+		return TEXT( "UnknownKey" );
+	case EIdTokenResultEOS::BadSignature:
+		return TEXT( "BadSignature" );
+	case EIdTokenResultEOS::Expired:
+		return TEXT( "Expired" );
+	case EIdTokenResultEOS::NotYetValid:
+		return TEXT( "NotYetValid" );
+	case EIdTokenResultEOS::WrongIssuer:
+		return TEXT( "WrongIssuer" );
+	case EIdTokenResultEOS::WrongAudience:
+		return TEXT( "WrongAudience" );
+	}
+
+	return TEXT( "" );
+}
+
+FIdTokenVerifierEOS::FIdTokenVerifierEOS()
+	: KeyRefreshSeconds( 3600.0 )
+	, LastRefreshTime( 0.0 )
+	, bRefreshInFlight( false )
+	, bRefreshRequested( false )
+{
+}
+
+FIdTokenVerifierEOS::~FIdTokenVerifierEOS()
+{
+	// Workers only hold their own copies of the key set and tokens, so in-flight batches can safely outlive us.
+}
+
+void FIdTokenVerifierEOS::Init()
+{
+	GConfig->GetString( TEXT( "OnlineSubsystemEOS" ), TEXT( "IdTokenJwksUrl" ), JwksUrl, GEngineIni );
+	GConfig->GetString( TEXT( "OnlineSubsystemEOS" ), TEXT( "IdTokenJwksFile" ), JwksFile, GEngineIni );
+
+	// Tokens are issued by EOS Connect, for our client, so those are the natural defaults for issuer and audience.
+	if( GConfig->GetString( TEXT( "OnlineSubsystemEOS" ), TEXT( "IdTokenIssuer" ), Policy.Issuer, GEngineIni ) == false )
+	{
+		Policy.Issuer = IdTokenVerifierEOS::DefaultIssuer;
+	}
+
+	if( GConfig->GetString( TEXT( "OnlineSubsystemEOS" ), TEXT( "IdTokenAudience" ), Policy.Audience, GEngineIni ) == false )
+	{
+		GConfig->GetString( TEXT( "OnlineSubsystemEOS" ), TEXT( "ClientId" ), Policy.Audience, GEngineIni );
+	}
+
+	int32 ClockSkewSeconds = (int32)Policy.ClockSkewSeconds;
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "IdTokenClockSkewSeconds" ), ClockSkewSeconds, GEngineIni );
+	Policy.ClockSkewSeconds = ClockSkewSeconds;
+
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "IdTokenKeyRefreshSeconds" ), KeyRefreshSeconds, GEngineIni );
+
+	if( JwksFile.IsEmpty() == false )
+	{
+		FString ErrorStr;
+		if( LoadSigningKeysFromFile( JwksFile, ErrorStr ) == false )
+		{
+			UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS ID Token: Failed to load signing keys from %s. %s" ), *JwksFile, *ErrorStr );
+		}
+	}
+	else
+	{
+		RefreshSigningKeys();
+	}
+}
+
+void FIdTokenVerifierEOS::Tick( float DeltaTime )
+{
+	// Hand everything queued since the last tick to the thread pool as a single batch.
+	if( QueuedVerifications.Num() > 0 )
+	{
+		TArray<FString> Tokens;
+		Tokens.Reserve( QueuedVerifications.Num() );
+
+		FVerificationBatch& Batch = InFlightBatches.AddDefaulted_GetRef();
+		Batch.Delegates.Reserve( QueuedVerifications.Num() );
+
+		for( FQueuedVerification& Queued : QueuedVerifications )
+		{
+			Tokens.Add( MoveTemp( Queued.Token ) );
+			Batch.Delegates.Add( MoveTemp( Queued.Delegate ) );
+		}
+		QueuedVerifications.Reset();
+
+		TSharedPtr<const FSigningKeySetEOS, ESPMode::ThreadSafe> KeySet = GetSigningKeySet();
+		const FPolicy BatchPolicy = Policy;
+		const int64 Now = FDateTime::UtcNow().ToUnixTimestamp();
+
+		Batch.Results = Async( EAsyncExecution::ThreadPool, [Tokens = MoveTemp( Tokens ), KeySet, BatchPolicy, Now]()
+		{
+			TArray<FVerification> Results;
+			Results.SetNum( Tokens.Num() );
+
+			ParallelFor( Tokens.Num(), [&Tokens, &Results, &KeySet, &BatchPolicy, Now]( int32 TokenIdx )
+			{
+				FVerification& Verification = Results[TokenIdx];
+				Verification.Result = VerifyTokenWithKeys( Tokens[TokenIdx], KeySet.Get(), BatchPolicy, Now, Verification.Claims );
+			} );
+
+			return Results;
+		} );
+	}
+
+	// Deliver finished batches on the game thread, in submission order.
+	while( InFlightBatches.Num() > 0 && InFlightBatches[0].Results.IsReady() )
+	{
+		FVerificationBatch Batch = MoveTemp( InFlightBatches[0] );
+		InFlightBatches.RemoveAt( 0, 1, false );
+
+		const TArray<FVerification> Results = Batch.Results.Get();
+
+		for( int32 ResultIdx = 0; ResultIdx < Results.Num(); ++ResultIdx )
+		{
+			if( Results[ResultIdx].Result == EIdTokenResultEOS::UnknownKey )
+			{
+				bRefreshRequested = true;
+			}
+
+			Batch.Delegates[ResultIdx].ExecuteIfBound( Results[ResultIdx].Result, Results[ResultIdx].Claims );
+		}
+	}
+
+	if( JwksFile.IsEmpty() && JwksUrl.IsEmpty() == false )
+	{
+		const double Now = FPlatformTime::Seconds();
+
+		// Rotations are refreshed early, but never more than once a minute.
+		const bool bRefreshDue = ( Now - LastRefreshTime ) >= KeyRefreshSeconds;
+		const bool bRotationSuspected = bRefreshRequested && ( Now - LastRefreshTime ) >= 60.0;
+
+		if( bRefreshDue || bRotationSuspected )
+		{
+			RefreshSigningKeys();
+		}
+	}
+}
+
+bool FIdTokenVerifierEOS::SetSigningKeys( const FString& JwksJson, FString& OutError )
+{
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> JsonReader = TJsonReaderFactory<>::Create( JwksJson );
+
+	if( FJsonSerializer::Deserialize( JsonReader, JsonObject ) == false || JsonObject.IsValid() == false )
+	{
+		OutError = TEXT( "Key set is not valid JSON." );
+		return false;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* JsonKeys = nullptr;
+	if( JsonObject->TryGetArrayField( TEXT( "keys" ), JsonKeys ) == false )
+	{
+		OutError = TEXT( "Key set has no keys array." );
+		return false;
+	}
+
+	TSharedPtr<FSigningKeySetEOS, ESPMode::ThreadSafe> NewKeySet = MakeShared<FSigningKeySetEOS, ESPMode::ThreadSafe>();
+
+	for( const TSharedPtr<FJsonValue>& JsonKeyValue : *JsonKeys )
+	{
+		const TSharedPtr<FJsonObject>* JsonKey = nullptr;
+		if( JsonKeyValue.IsValid() == false || JsonKeyValue->TryGetObject( JsonKey ) == false )
+		{
+			continue;
+		}
+
+		FString KeyType, KeyId, Modulus, Exponent;
+		( *JsonKey )->TryGetStringField( TEXT( "kty" ), KeyType );
+		( *JsonKey )->TryGetStringField( TEXT( "kid" ), KeyId );
+		( *JsonKey )->TryGetStringField( TEXT( "n" ), Modulus );
+		( *JsonKey )->TryGetStringField( TEXT( "e" ), Exponent );
+
+		if( KeyType != TEXT( "RSA" ) )
+		{
+			continue;
+		}
+
+		RSA* Key = IdTokenVerifierEOS::CreateRSAKey( Modulus, Exponent );
+		if( Key == nullptr )
+		{
+			UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS ID Token: Skipping malformed signing key %s." ), *KeyId );
+			continue;
+		}
+
+		NewKeySet->AddKey( KeyId, Key );
+	}
+
+	if( NewKeySet->Num() == 0 )
+	{
+		OutError = TEXT( "Key set has no usable RSA keys." );
+		return false;
+	}
+
+	{
+		FScopeLock ScopeLock( &SigningKeyLock );
+		SigningKeySet = NewKeySet;
+	}
+
+	bRefreshRequested = false;
+
+	UE_LOG_ONLINE_IDENTITY( Log, TEXT( "EOS ID Token: Loaded %d signing keys." ), NewKeySet->Num() );
+	return true;
+}
+
+bool FIdTokenVerifierEOS::LoadSigningKeysFromFile( const FString& FilePath, FString& OutError )
+{
+	FString JwksJson;
+	if( FFileHelper::LoadFileToString( JwksJson, *FilePath ) == false )
+	{
+		OutError = FString::Printf( TEXT( "Could not read %s." ), *FilePath );
+		return false;
+	}
+
+	return SetSigningKeys( JwksJson, OutError );
+}
+
+void FIdTokenVerifierEOS::RefreshSigningKeys()
+{
+	LastRefreshTime = FPlatformTime::Seconds();
+
+	if( bRefreshInFlight == true || JwksUrl.IsEmpty() )
+	{
+		return;
+	}
+
+	bRefreshInFlight = true;
+
+	auto HttpRequest = FHttpModule::Get().CreateRequest();
+	HttpRequest->SetURL( JwksUrl );
+	HttpRequest->SetVerb( TEXT( "GET" ) );
+	HttpRequest->OnProcessRequestComplete().BindThreadSafeSP( this, &FIdTokenVerifierEOS::OnRefreshSigningKeysComplete );
+	HttpRequest->ProcessRequest();
+}
+
+void FIdTokenVerifierEOS::OnRefreshSigningKeysComplete( FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful )
+{
+	bRefreshInFlight = false;
+
+	if( bWasSuccessful == false || Response.IsValid() == false || EHttpResponseCodes::IsOk( Response->GetResponseCode() ) == false )
+	{
+		// Keep verifying against the keys we already have; the next refresh will try again.
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS ID Token: Failed to refresh signing keys from %s." ), *JwksUrl );
+		return;
+	}
+
+	FString ErrorStr;
+	if( SetSigningKeys( Response->GetContentAsString(), ErrorStr ) == false )
+	{
+		UE_LOG_ONLINE_IDENTITY( Warning, TEXT( "EOS ID Token: Rejected signing keys from %s. %s" ), *JwksUrl, *ErrorStr );
+	}
+}
+
+EIdTokenResultEOS FIdTokenVerifierEOS::VerifyToken( const FString& Token, FIdTokenClaimsEOS& OutClaims ) const
+{
+	TSharedPtr<const FSigningKeySetEOS, ESPMode::ThreadSafe> KeySet = GetSigningKeySet();
+	const EIdTokenResultEOS Result = VerifyTokenWithKeys( Token, KeySet.Get(), Policy, FDateTime::UtcNow().ToUnixTimestamp(), OutClaims );
+
+	if( Result == EIdTokenResultEOS::UnknownKey )
+	{
+		bRefreshRequested = true;
+	}
+
+	return Result;
+}
+
+void FIdTokenVerifierEOS::VerifyTokenAsync( const FString& Token, const FOnIdTokenVerifiedEOS& Delegate )
+{
+	FQueuedVerification& Queued = QueuedVerifications.AddDefaulted_GetRef();
+	Queued.Token = Token;
+	Queued.Delegate = Delegate;
+}
+
+int32 FIdTokenVerifierEOS::GetNumSigningKeys() const
+{
+	TSharedPtr<const FSigningKeySetEOS, ESPMode::ThreadSafe> KeySet = GetSigningKeySet();
+	return KeySet.IsValid() ? KeySet->Num() : 0;
+}
+
+TSharedPtr<const FSigningKeySetEOS, ESPMode::ThreadSafe> FIdTokenVerifierEOS::GetSigningKeySet() const
+{
+	FScopeLock ScopeLock( &SigningKeyLock );
+	return SigningKeySet;
+}
+
+EIdTokenResultEOS FIdTokenVerifierEOS::VerifyTokenWithKeys( const FString& Token, const FSigningKeySetEOS* KeySet, const FPolicy& Policy, int64 Now, FIdTokenClaimsEOS& OutClaims )
+{
+	// Compact serialization: header.payload.signature
+	int32 FirstDot = INDEX_NONE;
+	int32 LastDot = INDEX_NONE;
+	if( Token.FindChar( TEXT( '.' ), FirstDot ) == false || Token.FindLastChar( TEXT( '.' ), LastDot ) == false || FirstDot == LastDot )
+	{
+		return EIdTokenResultEOS::Malformed;
+	}
+
+	const FString HeaderSegment = Token.Left( FirstDot );
+	const FString PayloadSegment = Token.Mid( FirstDot + 1, LastDot - FirstDot - 1 );
+	const FString SignatureSegment = Token.Mid( LastDot + 1 );
+
+	TSharedPtr<FJsonObject> Header = IdTokenVerifierEOS::DecodeJsonSegment( HeaderSegment );
+	TSharedPtr<FJsonObject> Payload = IdTokenVerifierEOS::DecodeJsonSegment( PayloadSegment );
+
+	if( Header.IsValid() == false || Payload.IsValid() == false )
+	{
+		return EIdTokenResultEOS::Malformed;
+	}
+
+	FString Algorithm;
+	if( Header->TryGetStringField( TEXT( "alg" ), Algorithm ) == false || Algorithm != TEXT( "RS256" ) )
+	{
+		// Anything else (in particular "none" or HMAC) is never accepted.
+		return EIdTokenResultEOS::Malformed;
+	}
+
+	Header->TryGetStringField( TEXT( "kid" ), OutClaims.KeyId );
+	Payload->TryGetStringField( TEXT( "sub" ), OutClaims.Subject );
+	Payload->TryGetStringField( TEXT( "iss" ), OutClaims.Issuer );
+
+	double ExpiresAt = 0.0;
+	double NotBefore = 0.0;
+	double IssuedAt = 0.0;
+	const bool bHasExpiry = Payload->TryGetNumberField( TEXT( "exp" ), ExpiresAt );
+	Payload->TryGetNumberField( TEXT( "nbf" ), NotBefore );
+	Payload->TryGetNumberField( TEXT( "iat" ), IssuedAt );
+	OutClaims.ExpiresAt = (int64)ExpiresAt;
+	OutClaims.IssuedAt = (int64)IssuedAt;
+
+	// Signature first: nothing else in the token can be trusted until it checks out.
+	if( KeySet == nullptr || KeySet->Num() == 0 )
+	{
+		return EIdTokenResultEOS::NoKeys;
+	}
+
+	const RSA* Key = KeySet->FindKey( OutClaims.KeyId );
+	if( Key == nullptr )
+	{
+		return EIdTokenResultEOS::UnknownKey;
+	}
+
+	TArray<uint8> Signature;
+	if( IdTokenVerifierEOS::Base64UrlDecode( SignatureSegment, Signature ) == false || Signature.Num() == 0 )
+	{
+		return EIdTokenResultEOS::Malformed;
+	}
+
+	// The signing input is header.payload, exactly as it appears in the token. Hashed as the bytes of its UTF-8 form.
+	const FTCHARToUTF8 SigningInput( *Token, LastDot );
+
+	uint8 Digest[SHA256_DIGEST_LENGTH];
+	SHA256( (const unsigned char*)SigningInput.Get(), SigningInput.Length(), Digest );
+
+	if( RSA_verify( NID_sha256, Digest, SHA256_DIGEST_LENGTH, Signature.GetData(), Signature.Num(), const_cast<RSA*>( Key ) ) != 1 )
+	{
+		return EIdTokenResultEOS::BadSignature;
+	}
+
+	if( bHasExpiry == false || Now > OutClaims.ExpiresAt + Policy.ClockSkewSeconds )
+	{
+		return EIdTokenResultEOS::Expired;
+	}
+
+	if( NotBefore > 0.0 && Now + Policy.ClockSkewSeconds < (int64)NotBefore )
+	{
+		return EIdTokenResultEOS::NotYetValid;
+	}
+
+	if( Policy.Issuer.IsEmpty() == false && OutClaims.Issuer != Policy.Issuer )
+	{
+		return EIdTokenResultEOS::WrongIssuer;
+	}
+
+	if( Policy.Audience.IsEmpty() == false )
+	{
+		// "aud" may be a single string, or an array of them.
+		bool bAudienceMatches = false;
+
+		FString Audience;
+		const TArray<TSharedPtr<FJsonValue>>* Audiences = nullptr;
+
+		if( Payload->TryGetStringField( TEXT( "aud" ), Audience ) )
+		{
+			bAudienceMatches = ( Audience == Policy.Audience );
+		}
+		else if( Payload->TryGetArrayField( TEXT( "aud" ), Audiences ) )
+		{
+			for( const TSharedPtr<FJsonValue>& AudienceValue : *Audiences )
+			{
+				if( AudienceValue.IsValid() && AudienceValue->AsString() == Policy.Audience )
+				{
+					bAudienceMatches = true;
+					break;
+				}
+			}
+		}
+
+		if( bAudienceMatches == false )
+		{
+			return EIdTokenResultEOS::WrongAudience;
+		}
+	}
+
+	return EIdTokenResultEOS::Valid;
+}
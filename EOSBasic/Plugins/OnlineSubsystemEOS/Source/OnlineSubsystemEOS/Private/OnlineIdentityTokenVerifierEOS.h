@@ -0,0 +1,200 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+
+// Forward Declarations
+class FSigningKeySetEOS;
+
+
+/** Outcome of verifying an ID token */
+enum class EIdTokenResultEOS : uint8
+{
+	/** Signature and claims are valid. */
+	Valid,
+	/** Not a well formed RS256 JWT. */
+	Malformed,
+	/** No signing keys have been loaded yet. */
+	NoKeys,
+	/** Signed with a key id that is not in the current key set. */
+	UnknownKey,
+	/** The signature does not match. */
+	BadSignature,
+	/** The token has expired. */
+	Expired,
+	/** The token is not valid yet. */
+	NotYetValid,
+	/** Issued by someone other than the configured issuer. */
+	WrongIssuer,
+	/** Issued for a different client than the configured audience. */
+	WrongAudience
+};
+
+/** @return the stringified version of the enum passed in */
+const TCHAR* LexToString( EIdTokenResultEOS Result );
+
+/**
+ * The claims of a verified ID token that the server cares about.
+ */
+struct FIdTokenClaimsEOS
+{
+	/** The account the token was issued for. */
+	FString											Subject;
+
+	/** Who issued the token. */
+	FString											Issuer;
+
+	/** Which key signed the token. */
+	FString											KeyId;
+
+	/** Unix time the token was issued at. */
+	int64											IssuedAt;
+
+	/** Unix time the token expires at. */
+	int64											ExpiresAt;
+
+	FIdTokenClaimsEOS()
+		: IssuedAt( 0 )
+		, ExpiresAt( 0 )
+	{}
+};
+
+/** Delegate fired on the game thread once an asynchronous verification completes */
+DECLARE_DELEGATE_TwoParams( FOnIdTokenVerifiedEOS, EIdTokenResultEOS /*Result*/, const FIdTokenClaimsEOS& /*Claims*/ );
+
+/**
+ * Server-side verifier for the JWT ID tokens clients present when joining.
+ *
+ * Tokens are checked locally (RS256 signature, expiry, issuer and audience) against a cached JWKS key set,
+ * so admitting a player costs no backend round-trip. The key set is refreshed periodically over HTTP, or
+ * loaded from a local file for offline testing. Asynchronous verifications are batched once per tick and
+ * spread across the thread pool; completion delegates fire back on the game thread.
+ *
+ * Configured from [OnlineSubsystemEOS] in the Engine ini:
+ *   IdTokenJwksUrl, IdTokenJwksFile, IdTokenIssuer, IdTokenAudience,
+ *   IdTokenKeyRefreshSeconds, IdTokenClockSkewSeconds
+ */
+class FIdTokenVerifierEOS : public TSharedFromThis<FIdTokenVerifierEOS, ESPMode::ThreadSafe>
+{
+
+public:
+
+	FIdTokenVerifierEOS();
+	~FIdTokenVerifierEOS();
+
+	/** Reads the verifier options from config, and loads the initial key set. */
+	void											Init();
+
+	/** Dispatches queued verifications, delivers finished ones and refreshes the key set when due. */
+	void											Tick( float DeltaTime );
+
+	/**
+	* Replaces the signing key set.
+	*
+	* @param JwksJson A JSON Web Key Set, i.e. {"keys":[{"kty":"RSA","kid":..,"n":..,"e":..}]}.
+	* @param OutError Populated with a reason on failure.
+	* @return bool True if at least one usable RSA key was loaded.
+	*/
+	bool											SetSigningKeys( const FString& JwksJson, FString& OutError );
+
+	/** Loads the signing key set from a JWKS file on disk. */
+	bool											LoadSigningKeysFromFile( const FString& FilePath, FString& OutError );
+
+	/** Requests a fresh key set from IdTokenJwksUrl, unless one is already in flight. */
+	void											RefreshSigningKeys();
+
+	/**
+	* Verifies a token on the calling thread. Safe to call from any thread.
+	*
+	* @param Token The compact-serialized JWT.
+	* @param OutClaims Populated with the token's claims, when it could be parsed.
+	* @return EIdTokenResultEOS Valid if the token may be trusted.
+	*/
+	EIdTokenResultEOS								VerifyToken( const FString& Token, FIdTokenClaimsEOS& OutClaims ) const;
+
+	/**
+	* Queues a token for verification on the thread pool. The delegate fires on the game thread.
+	*/
+	void											VerifyTokenAsync( const FString& Token, const FOnIdTokenVerifiedEOS& Delegate );
+
+	/** @return int32 Number of keys in the current key set. */
+	int32											GetNumSigningKeys() const;
+
+private:
+
+	/** The claim checks applied to every token. Copied into each batch so workers never touch the verifier. */
+	struct FPolicy
+	{
+		FString										Issuer;
+		FString										Audience;
+		int64										ClockSkewSeconds;
+
+		FPolicy()
+			: ClockSkewSeconds( 60 )
+		{}
+	};
+
+	/** Result of one token, produced on a worker thread. */
+	struct FVerification
+	{
+		EIdTokenResultEOS							Result;
+		FIdTokenClaimsEOS							Claims;
+	};
+
+	/** A token waiting for the next batch. */
+	struct FQueuedVerification
+	{
+		FString										Token;
+		FOnIdTokenVerifiedEOS						Delegate;
+	};
+
+	/** A batch of tokens being verified on the thread pool. */
+	struct FVerificationBatch
+	{
+		TArray<FOnIdTokenVerifiedEOS>				Delegates;
+		TFuture<TArray<FVerification>>				Results;
+	};
+
+	/** Verifies a single token against a key set snapshot. Touches no shared state. */
+	static EIdTokenResultEOS						VerifyTokenWithKeys( const FString& Token, const FSigningKeySetEOS* KeySet, const FPolicy& Policy, int64 Now, FIdTokenClaimsEOS& OutClaims );
+
+	/** @return The current key set, shared so workers can keep using it across a refresh. */
+	TSharedPtr<const FSigningKeySetEOS, ESPMode::ThreadSafe> GetSigningKeySet() const;
+
+	void											OnRefreshSigningKeysComplete( FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful );
+
+	/** Guards SigningKeySet. Only held long enough to copy or swap the pointer. */
+	mutable FCriticalSection						SigningKeyLock;
+
+	/** The current, immutable, key set. */
+	TSharedPtr<const FSigningKeySetEOS, ESPMode::ThreadSafe> SigningKeySet;
+
+	FPolicy											Policy;
+
+	/** Where the key set is fetched from. */
+	FString											JwksUrl;
+
+	/** Local key set, used instead of JwksUrl when set. */
+	FString											JwksFile;
+
+	/** How often the key set is re-fetched. */
+	double											KeyRefreshSeconds;
+
+	/** When the key set was last requested. */
+	double											LastRefreshTime;
+
+	/** Whether a key set request is in flight. */
+	bool											bRefreshInFlight;
+
+	/** Set when a token named an unknown key, i.e. keys have probably rotated. Set from any thread VerifyToken is called on. */
+	mutable FThreadSafeBool							bRefreshRequested;
+
+	TArray<FQueuedVerification>						QueuedVerifications;
+	TArray<FVerificationBatch>						InFlightBatches;
+};
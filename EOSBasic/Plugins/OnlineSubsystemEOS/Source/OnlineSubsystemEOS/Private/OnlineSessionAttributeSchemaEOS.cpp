@@ -0,0 +1,55 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionAttributeSchemaEOS.h"
+
+// Engine Includes
+#include "OnlineSubsystem.h"
+
+
+FSessionAttributeSchemaEOS::FSessionAttributeSchemaEOS()
+{
+	FKnownSessionAttributesEOS::AddEntries( Entries );
+}
+
+const FSessionAttributeSchemaEOS& FSessionAttributeSchemaEOS::Get()
+{
+	static const FSessionAttributeSchemaEOS Schema;
+	return Schema;
+}
+
+const FSessionAttributeSchemaEntryEOS* FSessionAttributeSchemaEOS::Find( FName Key ) const
+{
+	return Entries.Find( Key );
+}
+
+bool FSessionAttributeSchemaEOS::ToAttribute( FName Key, const FVariantData& Data, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute, EOS_ESessionAttributeAdvertisementType& OutAdvertisementType ) const
+{
+	const FSessionAttributeSchemaEntryEOS* Entry = Entries.Find( Key );
+
+	if( Entry != nullptr && Entry->VariantType == Data.GetType() )
+	{
+		Entry->FillFromVariant( Data, Arena, OutAttribute );
+		OutAdvertisementType = Entry->AdvertisementType;
+		return true;
+	}
+
+#if !UE_BUILD_SHIPPING
+	bool bWasFlagged = false;
+	FlaggedKeys.Add( Key, &bWasFlagged );
+
+	if( bWasFlagged == false )
+	{
+		if( Entry == nullptr )
+		{
+			UE_LOG_ONLINE_SESSION( Log, TEXT( "Session attribute %s is not in the schema, converting it at runtime." ), *Key.ToString() );
+		}
+		else
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Session attribute %s holds %s, but the schema declares %s." ), *Key.ToString(),
+								   EOnlineKeyValuePairDataType::ToString( Data.GetType() ), EOnlineKeyValuePairDataType::ToString( Entry->VariantType ) );
+		}
+	}
+#endif
+
+	return false;
+}
@@ -0,0 +1,234 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "OnlineKeyValuePair.h"
+
+// EOS Includes
+#include "OnlineSubsystemEOSArena.h"
+
+// EOS SDK Includes
+#include "eos_sessions.h"
+
+
+/**
+ * How a C++ value is held in an EOS session attribute. Only the types specialised here can be given to a
+ * schema, anything else fails to compile.
+ */
+template<typename ValueType>
+struct TSessionAttributeTypeEOS;
+
+template<>
+struct TSessionAttributeTypeEOS<int32>
+{
+	static constexpr EOnlineKeyValuePairDataType::Type VariantType = EOnlineKeyValuePairDataType::Int32;
+	static constexpr EOS_ESessionAttributeType AttributeType = EOS_ESessionAttributeType::EOS_SAT_Int64;
+
+	static FORCEINLINE void Fill( int32 Value, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute )
+	{
+		OutAttribute.Value.AsInt64 = Value;
+	}
+};
+
+template<>
+struct TSessionAttributeTypeEOS<int64>
+{
+	static constexpr EOnlineKeyValuePairDataType::Type VariantType = EOnlineKeyValuePairDataType::Int64;
+	static constexpr EOS_ESessionAttributeType AttributeType = EOS_ESessionAttributeType::EOS_SAT_Int64;
+
+	static FORCEINLINE void Fill( int64 Value, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute )
+	{
+		OutAttribute.Value.AsInt64 = Value;
+	}
+};
+
+template<>
+struct TSessionAttributeTypeEOS<double>
+{
+	static constexpr EOnlineKeyValuePairDataType::Type VariantType = EOnlineKeyValuePairDataType::Double;
+	static constexpr EOS_ESessionAttributeType AttributeType = EOS_ESessionAttributeType::EOS_SAT_Double;
+
+	static FORCEINLINE void Fill( double Value, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute )
+	{
+		OutAttribute.Value.AsDouble = Value;
+	}
+};
+
+template<>
+struct TSessionAttributeTypeEOS<bool>
+{
+	static constexpr EOnlineKeyValuePairDataType::Type VariantType = EOnlineKeyValuePairDataType::Bool;
+	static constexpr EOS_ESessionAttributeType AttributeType = EOS_ESessionAttributeType::EOS_SAT_Boolean;
+
+	static FORCEINLINE void Fill( bool Value, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute )
+	{
+		OutAttribute.Value.AsBool = Value ? EOS_TRUE : EOS_FALSE;
+	}
+};
+
+template<>
+struct TSessionAttributeTypeEOS<FString>
+{
+	static constexpr EOnlineKeyValuePairDataType::Type VariantType = EOnlineKeyValuePairDataType::String;
+	static constexpr EOS_ESessionAttributeType AttributeType = EOS_ESessionAttributeType::EOS_SAT_String;
+
+	static FORCEINLINE void Fill( const FString& Value, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute )
+	{
+		OutAttribute.Value.AsUtf8 = Arena.ToUTF8( Value );
+	}
+};
+
+/**
+ * Declares a known session attribute: its key, the type of its value, and how it is advertised.
+ * The key is given as a plain string literal, so it reaches the SDK without being converted.
+ */
+#define DECLARE_EOS_SESSION_ATTRIBUTE( SchemaName, KeyString, ValueType, InAdvertisementType ) \
+	struct SchemaName \
+	{ \
+		typedef ValueType FValue; \
+		static constexpr EOS_ESessionAttributeAdvertisementType AdvertisementType = InAdvertisementType; \
+		static FORCEINLINE const char* GetKey() { return KeyString; } \
+	};
+
+/** SETTING_EOS_BUILDID */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributeBuildIdEOS, "EOS_BUILDID", int32, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+/** SETTING_EOS_P2PHOSTID */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributeP2PHostIdEOS, "EOS_P2PHOSTID", FString, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+/** SETTING_EOS_PARTNERADDR */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributePartnerAddrEOS, "EOS_PARTNERADDR", FString, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+/** SETTING_EOS_PARTNERQOSPORT */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributePartnerQosPortEOS, "EOS_PARTNERQOSPORT", int32, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+/** SETTING_EOS_QOSPORT */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributeQosPortEOS, "EOS_QOSPORT", int32, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+/** SETTING_EOS_MIGRATEDFROM */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributeMigratedFromEOS, "EOS_MIGRATEDFROM", FString, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+/** SETTING_EOS_SKILLBUCKET */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributeSkillBucketEOS, "EOS_SKILLBUCKET", int32, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+/** SETTING_MAPNAME */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributeMapNameEOS, "MAPNAME", FString, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+/** SETTING_GAMEMODE */
+DECLARE_EOS_SESSION_ATTRIBUTE( FSessionAttributeGameModeEOS, "GAMEMODE", FString, EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise )
+
+namespace EOSSessionAttributeSchema
+{
+	/** Fills an attribute for a known key, with no lookup, type switch or key conversion. */
+	template<typename SchemaType>
+	FORCEINLINE void ToAttribute( const typename SchemaType::FValue& Value, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute )
+	{
+		OutAttribute.ApiVersion = EOS_SESSIONS_SESSIONATTRIBUTEDATA_API_LATEST;
+		OutAttribute.Key = SchemaType::GetKey();
+		OutAttribute.ValueType = TSessionAttributeTypeEOS<typename SchemaType::FValue>::AttributeType;
+		TSessionAttributeTypeEOS<typename SchemaType::FValue>::Fill( Value, Arena, OutAttribute );
+	}
+}
+
+/**
+ * A known session attribute, as looked up by key at runtime.
+ */
+struct FSessionAttributeSchemaEntryEOS
+{
+	/** The key, in UTF8, as the SDK wants it. */
+	const char*										Key;
+
+	/** The only variant type the key is filled directly from. */
+	EOnlineKeyValuePairDataType::Type				VariantType;
+
+	EOS_ESessionAttributeAdvertisementType			AdvertisementType;
+
+	/** Fills the attribute from a variant holding VariantType. */
+	void											( *FillFromVariant )( const FVariantData& Data, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute );
+};
+
+/**
+ * A list of attribute schemas, turned into registry entries when the registry is built.
+ */
+template<typename... SchemaTypes>
+struct TSessionAttributeSchemaListEOS
+{
+	static void AddEntries( TMap<FName, FSessionAttributeSchemaEntryEOS>& OutEntries )
+	{
+		const int32 Unused[] = { 0, ( AddEntry<SchemaTypes>( OutEntries ), 0 )... };
+		( void )Unused;
+	}
+
+private:
+
+	template<typename SchemaType>
+	static void AddEntry( TMap<FName, FSessionAttributeSchemaEntryEOS>& OutEntries )
+	{
+		typedef typename SchemaType::FValue FValue;
+
+		FSessionAttributeSchemaEntryEOS Entry;
+		Entry.Key = SchemaType::GetKey();
+		Entry.VariantType = TSessionAttributeTypeEOS<FValue>::VariantType;
+		Entry.AdvertisementType = SchemaType::AdvertisementType;
+		Entry.FillFromVariant = []( const FVariantData& Data, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute )
+		{
+			FValue Value;
+			Data.GetValue( Value );
+			EOSSessionAttributeSchema::ToAttribute<SchemaType>( Value, Arena, OutAttribute );
+		};
+
+		OutEntries.Add( FName( SchemaType::GetKey() ), Entry );
+	}
+};
+
+/** Every attribute the registry knows of. Keys that are not listed still work, through the generic conversion. */
+typedef TSessionAttributeSchemaListEOS<
+	FSessionAttributeBuildIdEOS,
+	FSessionAttributeP2PHostIdEOS,
+	FSessionAttributePartnerAddrEOS,
+	FSessionAttributePartnerQosPortEOS,
+	FSessionAttributeQosPortEOS,
+	FSessionAttributeMigratedFromEOS,
+	FSessionAttributeSkillBucketEOS,
+	FSessionAttributeMapNameEOS,
+	FSessionAttributeGameModeEOS
+> FKnownSessionAttributesEOS;
+
+/**
+ * Registry of the attributes in FKnownSessionAttributesEOS, by key.
+ *
+ * A setting with a known key, holding the type declared for it, is filled straight into the SDK struct, with
+ * its key already in UTF8. Anything else is left to the generic conversion; outside shipping builds, unknown
+ * keys and known keys holding the wrong type are logged once each, so they can be added or fixed.
+ */
+class FSessionAttributeSchemaEOS
+{
+
+public:
+
+	static const FSessionAttributeSchemaEOS&		Get();
+
+	/** @return The entry for a key, nullptr if it is not in the schema. */
+	const FSessionAttributeSchemaEntryEOS*			Find( FName Key ) const;
+
+	/**
+	* Fills an attribute for a known key holding its declared type.
+	*
+	* @param OutAdvertisementType Set to the advertisement declared for the key.
+	* @return bool False if the key is unknown or holds another type, for the caller to convert generically.
+	*/
+	bool											ToAttribute( FName Key, const FVariantData& Data, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute, EOS_ESessionAttributeAdvertisementType& OutAdvertisementType ) const;
+
+private:
+
+	FSessionAttributeSchemaEOS();
+
+	TMap<FName, FSessionAttributeSchemaEntryEOS>	Entries;
+
+#if !UE_BUILD_SHIPPING
+	/** Keys already logged as unknown or mistyped. */
+	mutable TSet<FName>								FlaggedKeys;
+#endif
+};
@@ -2,275 +2,7024 @@
 
 #include "OnlineSessionInterfaceEOS.h"
 
+// Engine Includes
+#include "OnlineSubsystemUtils.h"
+#include "SocketSubsystem.h"
+#include "LANBeacon.h"
+#include "NboSerializer.h"
+#include "Misc/ConfigCacheIni.h"
 
-TSharedPtr<const FUniqueNetId> FOnlineSessionEOS::CreateSessionIdFromString( const FString& SessionIdStr )
-{
-	if( !SessionIdStr.IsEmpty() )
-	{
-		return MakeShared<FUniqueNetIdEOS>( SessionIdStr );
-	}
+// OSS EOS Includes
+#include "OnlineSubsystemEOS.h"
+#include "OnlineSubsystemEOSCommon.h"
+#include "OnlineIdentityInterfaceEOS.h"
+#include "OnlineSessionAttributeSchemaEOS.h"
 
-	return nullptr;
+
+FOnlineSessionInfoEOS::FOnlineSessionInfoEOS( EEOSSession::Type InSessionType )
+	: SessionType( InSessionType )
+	, HostAddr( nullptr )
+	, SteamP2PAddr( nullptr )
+	, SessionId( FString(), EOS_SUBSYSTEM )
+	, ConnectionMethod( FEOSConnectionMethod::None )
+{
 }
 
-FNamedOnlineSession* FOnlineSessionEOS::AddNamedSession( FName SessionName, const FOnlineSessionSettings& SessionSettings )
+FOnlineSessionInfoEOS::FOnlineSessionInfoEOS( EEOSSession::Type InSessionType, const FUniqueNetIdString& InSessionId )
+	: SessionType( InSessionType )
+	, HostAddr( nullptr )
+	, SteamP2PAddr( nullptr )
+	, SessionId( InSessionId )
+	, ConnectionMethod( FEOSConnectionMethod::Direct )
 {
-	FScopeLock ScopeLock( &SessionLock );
-	return new ( Sessions ) FNamedOnlineSession( SessionName, SessionSettings );
 }
 
-FNamedOnlineSession* FOnlineSessionEOS::AddNamedSession( FName SessionName, const FOnlineSession& Session )
+void FOnlineSessionInfoEOS::Init( const FOnlineSubsystemEOS& Subsystem )
 {
-	FScopeLock ScopeLock( &SessionLock );
-	return new ( Sessions ) FNamedOnlineSession( SessionName, Session );
+	bool bCanBindAll;
+	HostAddr = ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->GetLocalHostAddr( *GLog, bCanBindAll );
+	HostAddr->SetPort( GetPortFromNetDriver( Subsystem.GetInstanceName() ) );
+
+	ConnectionMethod = FEOSConnectionMethod::Direct;
 }
 
-FNamedOnlineSession* FOnlineSessionEOS::GetNamedSession( FName SessionName )
+void FOnlineSessionInfoEOS::InitLAN( const FOnlineSubsystemEOS& Subsystem )
 {
-	FScopeLock ScopeLock( &SessionLock );
-	for( int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++ )
-	{
-		if( Sessions[SearchIndex].SessionName == SessionName )
-		{
-			return &Sessions[SearchIndex];
-		}
-	}
+	SessionType = EEOSSession::LANSession;
 
-	return nullptr;
+	Init( Subsystem );
 }
 
-FNamedOnlineSession* FOnlineSessionEOS::GetNamedSessionFromLobbyId( FUniqueNetIdEOS& LobbyId )
+void FOnlineSessionInfoEOS::CopyConnectionInfo( const FOnlineSessionInfoEOS& Source )
 {
-	FScopeLock ScopeLock( &SessionLock );
-	for( int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++ )
-	{
-		FNamedOnlineSession& Session = Sessions[SearchIndex];
-		if( Session.SessionInfo.IsValid() )
-		{
-			FOnlineSessionInfoEOS* SessionInfo = (FOnlineSessionInfoEOS*)Session.SessionInfo.Get();
-			if( SessionInfo->SessionType == EEOSSession::LobbySession && SessionInfo->SessionId == LobbyId )
-			{
-				return &Sessions[SearchIndex];
-			}
-		}
-	}
-	return nullptr;
+	HostAddr = Source.HostAddr.IsValid() ? Source.HostAddr->Clone() : nullptr;
+	PartnerAddr = Source.PartnerAddr.IsValid() ? Source.PartnerAddr->Clone() : nullptr;
+	P2PHostId = Source.P2PHostId;
+	ConnectionMethod = Source.ConnectionMethod;
+	MethodPingsInMs = Source.MethodPingsInMs;
+	ConnectStrings = Source.ConnectStrings;
 }
 
-void FOnlineSessionEOS::RemoveNamedSession( FName SessionName )
+bool FOnlineSessionInfoEOS::HasConnectionMethod( FEOSConnectionMethod Method ) const
 {
-	FScopeLock ScopeLock( &SessionLock );
-	for( int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++ )
+	switch( Method )
 	{
-		if( Sessions[SearchIndex].SessionName == SessionName )
-		{
-			Sessions.RemoveAtSwap( SearchIndex );
-			return;
-		}
+	case FEOSConnectionMethod::Direct:
+		return HostAddr.IsValid() && HostAddr->IsValid();
+	case FEOSConnectionMethod::P2P:
+		// There is no P2P net driver to connect through, so a host id alone is no way in.
+		return false;
+	case FEOSConnectionMethod::PartnerHosted:
+		return PartnerAddr.IsValid() && PartnerAddr->IsValid();
+	default:
+		return false;
 	}
 }
 
-bool FOnlineSessionEOS::HasPresenceSession()
+void FOnlineSessionInfoEOS::SetConnectionMethod( FEOSConnectionMethod Method )
 {
-	FScopeLock ScopeLock( &SessionLock );
-	for( int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++ )
+	if( ConnectionMethod != Method )
 	{
-		if( Sessions[SearchIndex].SessionSettings.bUsesPresence )
-		{
-			return true;
-		}
+		ConnectionMethod = Method;
+		ConnectStrings.Empty();
 	}
-
-	return false;
 }
 
-EOnlineSessionState::Type FOnlineSessionEOS::GetSessionState( FName SessionName ) const
+FOnlineSessionEOS::~FOnlineSessionEOS()
 {
-	FScopeLock ScopeLock( &SessionLock );
-	for( int32 SearchIndex = 0; SearchIndex < Sessions.Num(); SearchIndex++ )
+	// The notifications hold a raw pointer to us.
+	UnregisterLobbyNotifications();
+
+	if( LANSession != nullptr )
 	{
-		if( Sessions[SearchIndex].SessionName == SessionName )
-		{
-			return Sessions[SearchIndex].SessionState;
-		}
+		LANSession->StopLANSession();
+		delete LANSession;
+		LANSession = nullptr;
 	}
-
-	return EOnlineSessionState::NoSession;
 }
 
-bool FOnlineSessionEOS::CreateSession( int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings )
+void FOnlineSessionEOS::LoadConfig()
 {
-	return false;
-}
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionWritesPerTick" ), SessionWritesPerTick, GEngineIni );
+	SessionWritesPerTick = FMath::Max( SessionWritesPerTick, 1 );
 
-bool FOnlineSessionEOS::CreateSession( const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings )
-{
-	return false;
-}
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionSearchResultsPerTick" ), SearchResultsPerTick, GEngineIni );
+	SearchResultsPerTick = FMath::Max( SearchResultsPerTick, 1 );
 
-bool FOnlineSessionEOS::StartSession( FName SessionName )
-{
-	return false;
-}
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "FriendSessionSearchConcurrency" ), FriendSearchConcurrency, GEngineIni );
+	FriendSearchConcurrency = FMath::Max( FriendSearchConcurrency, 1 );
 
-bool FOnlineSessionEOS::UpdateSession( FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData )
-{
-	return false;
-}
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "HostSnapshotIntervalSeconds" ), HostSnapshotInterval, GEngineIni );
 
-bool FOnlineSessionEOS::EndSession( FName SessionName )
-{
-	return false;
-}
+	GConfig->GetBool( TEXT( "OnlineSubsystemEOS" ), TEXT( "bSessionQosResponder" ), bQosResponder, GEngineIni );
+	GConfig->GetString( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionBucketId" ), DefaultBucketId, GEngineIni );
 
-bool FOnlineSessionEOS::DestroySession( FName SessionName, const FOnDestroySessionCompleteDelegate& CompletionDelegate )
-{
-	return false;
-}
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionSearchMaxResults" ), SearchMaxResults, GEngineIni );
+	SearchMaxResults = FMath::Clamp( SearchMaxResults, 1, EOS_SESSIONS_MAX_SEARCH_RESULTS );
 
-bool FOnlineSessionEOS::IsPlayerInSession( FName SessionName, const FUniqueNetId& UniqueId )
-{
-	return false;
-}
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionRegisterPlayersChunkSize" ), RegisterPlayersChunkSize, GEngineIni );
+	RegisterPlayersChunkSize = FMath::Clamp( RegisterPlayersChunkSize, 1, EOS_SESSIONS_MAXREGISTEREDPLAYERS );
 
-bool FOnlineSessionEOS::StartMatchmaking( const TArray< TSharedRef<const FUniqueNetId> >& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings )
-{
-	return false;
-}
+	GConfig->GetString( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionPartnerHostAddress" ), PartnerHostAddress, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionPartnerQosPort" ), PartnerQosPort, GEngineIni );
 
-bool FOnlineSessionEOS::CancelMatchmaking( int32 SearchingPlayerNum, FName SessionName )
-{
-	return false;
-}
+	GConfig->GetBool( TEXT( "OnlineSubsystemEOS" ), TEXT( "bSessionJoinQos" ), bJoinQos, GEngineIni );
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "RejoinTicketSeconds" ), RejoinTicketSeconds, GEngineIni );
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "HostMigrationTimeoutSeconds" ), HostMigrationTimeout, GEngineIni );
 
-bool FOnlineSessionEOS::CancelMatchmaking( const FUniqueNetId& SearchingPlayerId, FName SessionName )
-{
-	return false;
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionLANPort" ), LANAnnouncePort, GEngineIni );
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionLANQueryTimeout" ), LANQueryTimeout, GEngineIni );
 }
 
-bool FOnlineSessionEOS::FindSessions( int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings )
+TSharedPtr<const FUniqueNetId> FOnlineSessionEOS::CreateSessionIdFromString( const FString& SessionIdStr )
 {
-	return false;
-}
+	if( !SessionIdStr.IsEmpty() )
+	{
+		return MakeShared<FUniqueNetIdString>( SessionIdStr, EOS_SUBSYSTEM );
+	}
 
-bool FOnlineSessionEOS::FindSessions( const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings )
-{
-	return false;
+	return nullptr;
 }
 
-bool FOnlineSessionEOS::FindSessionById( const FUniqueNetId& SearchingUserId, const FUniqueNetId& SessionId, const FUniqueNetId& FriendId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate )
+FNamedOnlineSession* FOnlineSessionEOS::AddNamedSession( FName SessionName, const FOnlineSessionSettings& SessionSettings )
 {
-	return false;
+	return AddNamedSessionInternal( MakeUnique<FNamedOnlineSession>( SessionName, SessionSettings ) );
 }
 
-bool FOnlineSessionEOS::CancelFindSessions()
+FNamedOnlineSession* FOnlineSessionEOS::AddNamedSession( FName SessionName, const FOnlineSession& Session )
 {
-	return false;
+	return AddNamedSessionInternal( MakeUnique<FNamedOnlineSession>( SessionName, Session ) );
 }
 
-bool FOnlineSessionEOS::PingSearchResults( const FOnlineSessionSearchResult& SearchResult )
+FNamedOnlineSession* FOnlineSessionEOS::AddNamedSessionInternal( TUniquePtr<FNamedOnlineSession>&& NewSession )
 {
-	return false;
-}
+	check( IsInGameThread() );
 
-bool FOnlineSessionEOS::JoinSession( int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession )
-{
-	return false;
-}
+	// The live session may still be referenced, by pointer or through its SessionInfo, so it is never replaced.
+	if( Sessions.Contains( NewSession->SessionName ) )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot add session '%s': session already exists." ), *NewSession->SessionName.ToString() );
+		return nullptr;
+	}
 
-bool FOnlineSessionEOS::JoinSession( const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession )
-{
-	return false;
-}
+	TUniquePtr<FNamedOnlineSession>& Entry = Sessions.Add( NewSession->SessionName, MoveTemp( NewSession ) );
 
-bool FOnlineSessionEOS::FindFriendSession( int32 LocalUserNum, const FUniqueNetId& Friend )
-{
-	return false;
-}
+	IndexSessionId( *Entry );
+	NumPresenceSessions += Entry->SessionSettings.bUsesPresence ? 1 : 0;
 
-bool FOnlineSessionEOS::FindFriendSession( const FUniqueNetId& LocalUserId, const FUniqueNetId& Friend )
-{
-	return false;
+	SessionTracer.BeginSession( Entry->SessionName, FPlatformTime::Seconds() );
+
+	return Entry.Get();
 }
 
-bool FOnlineSessionEOS::FindFriendSession( const FUniqueNetId& LocalUserId, const TArray<TSharedRef<const FUniqueNetId>>& FriendList )
+FNamedOnlineSession* FOnlineSessionEOS::GetNamedSession( FName SessionName )
 {
-	return false;
+	const TUniquePtr<FNamedOnlineSession>* Entry = Sessions.Find( SessionName );
+	return ( Entry != nullptr ) ? Entry->Get() : nullptr;
 }
 
-bool FOnlineSessionEOS::SendSessionInviteToFriend( int32 LocalUserNum, FName SessionName, const FUniqueNetId& Friend )
+FNamedOnlineSession* FOnlineSessionEOS::GetNamedSessionFromLobbyId( const FUniqueNetId& LobbyId )
 {
-	return false;
+	FNamedOnlineSession* const* Session = SessionsById.Find( LobbyId.ToString() );
+
+	if( Session != nullptr )
+	{
+		const FOnlineSessionInfoEOS* SessionInfo = (const FOnlineSessionInfoEOS*)( *Session )->SessionInfo.Get();
+		if( SessionInfo->SessionType == EEOSSession::LobbySession )
+		{
+			return *Session;
+		}
+	}
+
+	return nullptr;
 }
 
-bool FOnlineSessionEOS::SendSessionInviteToFriend( const FUniqueNetId& LocalUserId, FName SessionName, const FUniqueNetId& Friend )
+void FOnlineSessionEOS::RemoveNamedSession( FName SessionName )
 {
-	return false;
+	check( IsInGameThread() );
+
+	TUniquePtr<FNamedOnlineSession> Removed;
+	if( Sessions.RemoveAndCopyValue( SessionName, Removed ) && Removed.IsValid() )
+	{
+		UnindexSessionId( *Removed );
+		NumPresenceSessions -= Removed->SessionSettings.bUsesPresence ? 1 : 0;
+
+		SessionTracer.EndSession( SessionName, Removed->SessionInfo.IsValid() ? Removed->SessionInfo->GetSessionId().ToString() : FString(), FPlatformTime::Seconds() );
+	}
 }
 
-bool FOnlineSessionEOS::SendSessionInviteToFriends( int32 LocalUserNum, FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Friends )
+bool FOnlineSessionEOS::HasPresenceSession()
 {
-	return false;
+	return NumPresenceSessions > 0;
 }
 
-bool FOnlineSessionEOS::SendSessionInviteToFriends( const FUniqueNetId& LocalUserId, FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Friends )
+EOnlineSessionState::Type FOnlineSessionEOS::GetSessionState( FName SessionName ) const
 {
-	return false;
+	const TUniquePtr<FNamedOnlineSession>* Entry = Sessions.Find( SessionName );
+	return ( Entry != nullptr ) ? ( *Entry )->SessionState : EOnlineSessionState::NoSession;
 }
 
-bool FOnlineSessionEOS::GetResolvedConnectString( FName SessionName, FString& ConnectInfo, FName PortType )
+void FOnlineSessionEOS::IndexSessionId( FNamedOnlineSession& Session )
 {
-	return false;
+	if( Session.SessionInfo.IsValid() && Session.SessionInfo->GetSessionId().IsValid() )
+	{
+		SessionsById.Add( Session.SessionInfo->GetSessionId().ToString(), &Session );
+	}
 }
 
-bool FOnlineSessionEOS::GetResolvedConnectString( const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo )
+void FOnlineSessionEOS::UnindexSessionId( FNamedOnlineSession& Session )
 {
-	return false;
+	if( Session.SessionInfo.IsValid() && Session.SessionInfo->GetSessionId().IsValid() )
+	{
+		const FString SessionId = Session.SessionInfo->GetSessionId().ToString();
+
+		// Only drop the entry if it is ours, a replacement session may have claimed the id since.
+		FNamedOnlineSession* const* Indexed = SessionsById.Find( SessionId );
+		if( Indexed != nullptr && *Indexed == &Session )
+		{
+			SessionsById.Remove( SessionId );
+		}
+	}
 }
 
-FOnlineSessionSettings* FOnlineSessionEOS::GetSessionSettings( FName SessionName )
+void FOnlineSessionEOS::SetSessionId( FName SessionName, const FUniqueNetIdString& SessionId )
 {
-	return nullptr;
+	TUniquePtr<FNamedOnlineSession>* Entry = Sessions.Find( SessionName );
+
+	if( Entry != nullptr && ( *Entry )->SessionInfo.IsValid() )
+	{
+		UnindexSessionId( **Entry );
+
+		FOnlineSessionInfoEOS* SessionInfo = (FOnlineSessionInfoEOS*)( *Entry )->SessionInfo.Get();
+		SessionInfo->SessionId = SessionId;
+
+		IndexSessionId( **Entry );
+	}
 }
 
-bool FOnlineSessionEOS::RegisterPlayer( FName SessionName, const FUniqueNetId& PlayerId, bool bWasInvited )
+void FOnlineSessionEOS::SetSessionSettings( FNamedOnlineSession& Session, const FOnlineSessionSettings& SessionSettings )
 {
-	return false;
+	NumPresenceSessions += ( SessionSettings.bUsesPresence ? 1 : 0 ) - ( Session.SessionSettings.bUsesPresence ? 1 : 0 );
+	Session.SessionSettings = SessionSettings;
 }
 
-bool FOnlineSessionEOS::RegisterPlayers( FName SessionName, const TArray< TSharedRef<const FUniqueNetId> >& Players, bool bWasInvited )
+void FOnlineSessionEOS::SetSessionState( FNamedOnlineSession& Session, EOnlineSessionState::Type NewState )
 {
-	return false;
+	SessionTracer.RecordTransition( Session.SessionName, NewState, FPlatformTime::Seconds() );
+	Session.SessionState = NewState;
 }
 
-bool FOnlineSessionEOS::UnregisterPlayer( FName SessionName, const FUniqueNetId& PlayerId )
+bool FOnlineSessionEOS::CreateSession( int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings )
 {
-	return false;
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	TSharedPtr<const FUniqueNetId> HostingPlayerId = Identity.IsValid() ? Identity->GetUniquePlayerId( HostingPlayerNum ) : nullptr;
+	EOS_ProductUserId HostingProductUserId = Identity.IsValid() ? Identity->GetProductUserId( HostingPlayerNum ) : nullptr;
+
+	return CreateSessionInternal( HostingPlayerNum, HostingPlayerId, HostingProductUserId, SessionName, NewSessionSettings );
 }
 
-bool FOnlineSessionEOS::UnregisterPlayers( FName SessionName, const TArray< TSharedRef<const FUniqueNetId> >& Players )
+bool FOnlineSessionEOS::CreateSession( const FUniqueNetId& HostingPlayerId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings )
 {
-	return false;
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	const int32 HostingPlayerNum = Identity.IsValid() ? Identity->GetLocalUserNum( HostingPlayerId ) : INDEX_NONE;
+
+	if( HostingPlayerNum == INDEX_NONE )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot create session '%s': %s is not a Local User." ), *SessionName.ToString(), *HostingPlayerId.ToString() );
+		TriggerOnCreateSessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	return CreateSessionInternal( HostingPlayerNum, HostingPlayerId.AsShared(), Identity->GetProductUserId( HostingPlayerNum ), SessionName, NewSessionSettings );
 }
 
-void FOnlineSessionEOS::RegisterLocalPlayer( const FUniqueNetId& PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate& Delegate )
+bool FOnlineSessionEOS::CreateSessionInternal( int32 HostingPlayerNum, const TSharedPtr<const FUniqueNetId>& HostingPlayerId, EOS_ProductUserId HostingProductUserId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings )
 {
+	if( GetNamedSession( SessionName ) != nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot create session '%s': session already exists." ), *SessionName.ToString() );
+		NotifyCreateSessionComplete( SessionName, false );
+		return false;
+	}
+
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	bool bUseLobby = false;
+	NewSessionSettings.Get( SETTING_EOS_USELOBBY, bUseLobby );
+
+	if( NewSessionSettings.bIsLANMatch == false && bUseLobby == false && SessionsHandle == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot create session '%s': EOS Sessions are not available." ), *SessionName.ToString() );
+		NotifyCreateSessionComplete( SessionName, false );
+		return false;
+	}
+
+	FNamedOnlineSession* Session = AddNamedSession( SessionName, NewSessionSettings );
+	check( Session != nullptr );
+
+	SetSessionState( *Session, EOnlineSessionState::Creating );
+	Session->HostingPlayerNum = HostingPlayerNum;
+	Session->OwningUserId = HostingPlayerId;
+	Session->NumOpenPrivateConnections = NewSessionSettings.NumPrivateConnections;
+	Session->NumOpenPublicConnections = NewSessionSettings.NumPublicConnections;
+	Session->SessionSettings.BuildUniqueId = GetBuildUniqueId();
+
+	FOnlineSessionInfoEOS* NewSessionInfo = new FOnlineSessionInfoEOS();
+	Session->SessionInfo = MakeShareable( NewSessionInfo );
+
+	if( NewSessionSettings.bIsLANMatch == true )
+	{
+		// LAN sessions never touch the backend, our own beacon advertises them. The id tells them apart on the LAN.
+		NewSessionInfo->InitLAN( *EOSSubsystem );
+		SetSessionId( SessionName, FUniqueNetIdString( FGuid::NewGuid().ToString(), EOS_SUBSYSTEM ) );
+
+		Session->bHosting = true;
+
+		if( UpdateLANBeacon() == false )
+		{
+			RemoveNamedSession( SessionName );
+			NotifyCreateSessionComplete( SessionName, false );
+			return false;
+		}
+
+		SetSessionState( *Session, EOnlineSessionState::Pending );
+		NotifyCreateSessionComplete( SessionName, true );
+		return true;
+	}
+
+	if( bUseLobby == true )
+	{
+		NewSessionInfo->SessionType = EEOSSession::LobbySession;
+		NewSessionInfo->Init( *EOSSubsystem );
+		AdvertiseConnectionMethods( *Session, HostingProductUserId );
+
+		return CreateLobbyInternal( *Session, HostingProductUserId );
+	}
+
+	NewSessionInfo->SessionType = EEOSSession::AdvertisedSessionHost;
+	NewSessionInfo->Init( *EOSSubsystem );
+	AdvertiseConnectionMethods( *Session, HostingProductUserId );
+
+	// Answer QoS probes for as long as we host, so searching clients can sort us by latency.
+	if( bQosResponder == true && StartQosResponder( FSessionQosResponderEOS::GetConfiguredPort() ) == true )
+	{
+		Session->SessionSettings.Set( SETTING_EOS_QOSPORT, QosResponder->GetPort(), EOnlineDataAdvertisementType::ViaOnlineService );
+	}
+
+	FEOSLargeScratchArena Arena;
+
+	FString BucketId;
+	if( NewSessionSettings.Get( SETTING_EOS_BUCKETID, BucketId ) == false || BucketId.IsEmpty() )
+	{
+		BucketId = DefaultBucketId;
+	}
+
+	EOS_Sessions_CreateSessionModificationOptions CreateOptions;
+	CreateOptions.ApiVersion = EOS_SESSIONS_CREATESESSIONMODIFICATION_API_LATEST;
+	CreateOptions.SessionName = Arena.ToUTF8( SessionName.ToString() );
+	CreateOptions.BucketId = Arena.ToUTF8( BucketId );
+	CreateOptions.MaxPlayers = NewSessionSettings.NumPublicConnections + NewSessionSettings.NumPrivateConnections;
+	CreateOptions.LocalUserId = HostingProductUserId;
+	CreateOptions.bPresenceEnabled = NewSessionSettings.bUsesPresence ? EOS_TRUE : EOS_FALSE;
+
+	EOS_HSessionModification ModificationHandle = nullptr;
+	const EOS_EResult CreateResult = EOS_Sessions_CreateSessionModification( SessionsHandle, &CreateOptions, &ModificationHandle );
+
+	FSessionUpdateState& UpdateState = SessionUpdateStates.Add( SessionName );
+
+	FSessionSettingsDeltaEOS Delta;
+	UpdateState.PushedSettings.Diff( Session->SessionSettings, Delta );
+
+	if( CreateResult != EOS_EResult::EOS_Success || ApplySessionSettings( ModificationHandle, *Session, Delta, true ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot create session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( CreateResult ) );
+
+		if( ModificationHandle != nullptr )
+		{
+			EOS_SessionModification_Release( ModificationHandle );
+		}
+
+		RemoveSessionUpdateState( SessionName );
+		RemoveNamedSession( SessionName );
+		StopIdleQosResponder();
+		NotifyCreateSessionComplete( SessionName, false );
+		return false;
+	}
+
+	// Updates made before the backend has the session are held back until it does.
+	UpdateState.PushedSettings.Commit( Session->SessionSettings, Delta );
+	UpdateState.bUpdateInFlight = true;
+	UpdateState.Stats.NumWrites++;
+
+	EOS_Sessions_UpdateSessionOptions UpdateOptions;
+	UpdateOptions.ApiVersion = EOS_SESSIONS_UPDATESESSION_API_LATEST;
+	UpdateOptions.SessionModificationHandle = ModificationHandle;
 
+	FSessionRequestContext* RequestContext = new FSessionRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+
+	EOS_Sessions_UpdateSession( SessionsHandle, &UpdateOptions, RequestContext, CreateSessionCompleteCallback );
+	EOS_SessionModification_Release( ModificationHandle );
+
+	return true;
 }
 
-void FOnlineSessionEOS::UnregisterLocalPlayer( const FUniqueNetId& PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate& Delegate )
+bool FOnlineSessionEOS::StartSession( FName SessionName )
 {
+	if( ShouldQueueSessionOp( SessionName ) == true )
+	{
+		QueueSessionOp( SessionName, FQueuedSessionOp::EType::Start );
+		return true;
+	}
 
+	return StartSessionInternal( SessionName );
 }
 
-int32 FOnlineSessionEOS::GetNumSessions()
+bool FOnlineSessionEOS::StartSessionInternal( FName SessionName )
 {
-	return -1;
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( Session == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot start session '%s': session does not exist." ), *SessionName.ToString() );
+		TriggerOnStartSessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	if( Session->SessionState != EOnlineSessionState::Pending && Session->SessionState != EOnlineSessionState::Ended )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot start session '%s' in state %s." ), *SessionName.ToString(), EOnlineSessionState::ToString( Session->SessionState ) );
+		TriggerOnStartSessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	// Only sessions hosted through EOS_Sessions have backend state, everything else changes state locally.
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	if( SessionUpdateStates.Contains( SessionName ) == false || SessionsHandle == nullptr )
+	{
+		SetSessionState( *Session, EOnlineSessionState::InProgress );
+		TriggerOnStartSessionCompleteDelegates( SessionName, true );
+		return true;
+	}
+
+	SetSessionState( *Session, EOnlineSessionState::Starting );
+	SessionUpdateStates.FindChecked( SessionName ).Stats.NumStateRequests++;
+
+	FEOSScratchArena Arena;
+
+	EOS_Sessions_StartSessionOptions StartOptions;
+	StartOptions.ApiVersion = EOS_SESSIONS_STARTSESSION_API_LATEST;
+	StartOptions.SessionName = Arena.ToUTF8( SessionName.ToString() );
+
+	FSessionRequestContext* RequestContext = new FSessionRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+
+	EOS_Sessions_StartSession( SessionsHandle, &StartOptions, RequestContext, StartSessionCompleteCallback );
+
+	return true;
 }
 
-void FOnlineSessionEOS::DumpSessionState()
+bool FOnlineSessionEOS::UpdateSession( FName SessionName, FOnlineSessionSettings& UpdatedSessionSettings, bool bShouldRefreshOnlineData )
 {
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( Session == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot update session '%s': session does not exist." ), *SessionName.ToString() );
+		TriggerOnUpdateSessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	// The local copy always reflects the latest settings, even while the backend write is pending.
+	const int32 BuildUniqueId = Session->SessionSettings.BuildUniqueId;
+	SetSessionSettings( *Session, UpdatedSessionSettings );
+	Session->SessionSettings.BuildUniqueId = BuildUniqueId;
+
+	if( FLobbyState* LobbyState = LobbyStates.Find( SessionName ) )
+	{
+		if( bShouldRefreshOnlineData == false )
+		{
+			TriggerOnUpdateSessionCompleteDelegates( SessionName, true );
+			return true;
+		}
+
+		LobbyState->NumPendingUpdates++;
+		return true;
+	}
+
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+
+	if( bShouldRefreshOnlineData == false || UpdateState == nullptr )
+	{
+		TriggerOnUpdateSessionCompleteDelegates( SessionName, true );
+		return true;
+	}
+
+	// Merged with every other update this frame, and written on the next Tick.
+	UpdateState->NumPendingUpdates++;
+	MarkSessionDirty( SessionName );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::EndSession( FName SessionName )
+{
+	if( ShouldQueueSessionOp( SessionName ) == true )
+	{
+		QueueSessionOp( SessionName, FQueuedSessionOp::EType::End );
+		return true;
+	}
+
+	return EndSessionInternal( SessionName );
+}
+
+bool FOnlineSessionEOS::EndSessionInternal( FName SessionName )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( Session == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot end session '%s': session does not exist." ), *SessionName.ToString() );
+		TriggerOnEndSessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	if( Session->SessionState != EOnlineSessionState::InProgress )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot end session '%s' in state %s." ), *SessionName.ToString(), EOnlineSessionState::ToString( Session->SessionState ) );
+		TriggerOnEndSessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	if( SessionUpdateStates.Contains( SessionName ) == false || SessionsHandle == nullptr )
+	{
+		SetSessionState( *Session, EOnlineSessionState::Ended );
+		TriggerOnEndSessionCompleteDelegates( SessionName, true );
+		return true;
+	}
+
+	SetSessionState( *Session, EOnlineSessionState::Ending );
+	SessionUpdateStates.FindChecked( SessionName ).Stats.NumStateRequests++;
+
+	FEOSScratchArena Arena;
+
+	EOS_Sessions_EndSessionOptions EndOptions;
+	EndOptions.ApiVersion = EOS_SESSIONS_ENDSESSION_API_LATEST;
+	EndOptions.SessionName = Arena.ToUTF8( SessionName.ToString() );
+
+	FSessionRequestContext* RequestContext = new FSessionRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+
+	EOS_Sessions_EndSession( SessionsHandle, &EndOptions, RequestContext, EndSessionCompleteCallback );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::DestroySession( FName SessionName, const FOnDestroySessionCompleteDelegate& CompletionDelegate )
+{
+	if( ShouldQueueSessionOp( SessionName ) == true )
+	{
+		QueueSessionOp( SessionName, FQueuedSessionOp::EType::Destroy, CompletionDelegate );
+		return true;
+	}
+
+	return DestroySessionInternal( SessionName, CompletionDelegate );
+}
+
+bool FOnlineSessionEOS::DestroySessionInternal( FName SessionName, const FOnDestroySessionCompleteDelegate& CompletionDelegate )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( Session == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot destroy session '%s': session does not exist." ), *SessionName.ToString() );
+		CompletionDelegate.ExecuteIfBound( SessionName, false );
+		TriggerOnDestroySessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	if( Session->SessionState == EOnlineSessionState::Destroying )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Already in process of destroying session '%s'." ), *SessionName.ToString() );
+		return false;
+	}
+
+	// Kept for a while, so a client that dropped out can go straight back in.
+	KeepRejoinTicket( *Session );
+
+	if( FLobbyState* LobbyState = LobbyStates.Find( SessionName ) )
+	{
+		return DestroyLobbyInternal( *Session, *LobbyState, CompletionDelegate );
+	}
+
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	// Hosted sessions are destroyed on the backend, joined ones are left. LAN sessions only exist locally.
+	const FOnlineSessionInfoEOS* SessionInfo = static_cast<const FOnlineSessionInfoEOS*>( Session->SessionInfo.Get() );
+	const bool bIsJoinedSession = ( SessionInfo != nullptr && SessionInfo->SessionType == EEOSSession::AdvertisedSessionClient );
+
+	if( ( SessionUpdateStates.Contains( SessionName ) == false && bIsJoinedSession == false ) || SessionsHandle == nullptr )
+	{
+		HandleDestroySessionComplete( SessionName, EOS_EResult::EOS_Success, CompletionDelegate );
+		return true;
+	}
+
+	SetSessionState( *Session, EOnlineSessionState::Destroying );
+
+	FEOSScratchArena Arena;
+
+	EOS_Sessions_DestroySessionOptions DestroyOptions;
+	DestroyOptions.ApiVersion = EOS_SESSIONS_DESTROYSESSION_API_LATEST;
+	DestroyOptions.SessionName = Arena.ToUTF8( SessionName.ToString() );
+
+	FSessionRequestContext* RequestContext = new FSessionRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+	RequestContext->DestroyDelegate = CompletionDelegate;
+
+	EOS_Sessions_DestroySession( SessionsHandle, &DestroyOptions, RequestContext, DestroySessionCompleteCallback );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::IsSessionBusy( FName SessionName )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( Session == nullptr )
+	{
+		return false;
+	}
+
+	switch( Session->SessionState )
+	{
+	case EOnlineSessionState::Creating:
+	case EOnlineSessionState::Starting:
+	case EOnlineSessionState::Ending:
+	case EOnlineSessionState::Destroying:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool FOnlineSessionEOS::ShouldQueueSessionOp( FName SessionName )
+{
+	// Calls already queued go first, so a session that just became idle still runs them in order.
+	if( QueuedSessionOps.Contains( SessionName ) )
+	{
+		return true;
+	}
+
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	// A second Destroy fails as it always has, rather than waiting on the first.
+	return Session != nullptr && Session->SessionState != EOnlineSessionState::Destroying && IsSessionBusy( SessionName );
+}
+
+void FOnlineSessionEOS::QueueSessionOp( FName SessionName, FQueuedSessionOp::EType Type, const FOnDestroySessionCompleteDelegate& CompletionDelegate )
+{
+	TArray<FQueuedSessionOp>& Queue = QueuedSessionOps.FindOrAdd( SessionName );
+
+	if( Type != FQueuedSessionOp::EType::Destroy )
+	{
+		Queue.Emplace( Type );
+		return;
+	}
+
+	if( Queue.Num() > 0 && Queue.Last().Type == FQueuedSessionOp::EType::Destroy )
+	{
+		Queue.Last().DestroyDelegates.Add( CompletionDelegate );
+		return;
+	}
+
+	// Nothing a Start or End would change outlives the Destroy, so they are dropped rather than sent.
+	TArray<FQueuedSessionOp::EType, TInlineAllocator<4>> Dropped;
+
+	for( int32 OpIdx = Queue.Num() - 1; OpIdx >= 0 && Queue[OpIdx].Type != FQueuedSessionOp::EType::Destroy; --OpIdx )
+	{
+		Dropped.Insert( Queue[OpIdx].Type, 0 );
+		Queue.RemoveAt( OpIdx );
+	}
+
+	FQueuedSessionOp& Destroy = Queue.Emplace_GetRef( FQueuedSessionOp::EType::Destroy );
+	Destroy.DestroyDelegates.Add( CompletionDelegate );
+
+	for( const FQueuedSessionOp::EType DroppedType : Dropped )
+	{
+		UE_LOG_ONLINE_SESSION( Verbose, TEXT( "Dropped queued %s of session '%s', as it is about to be destroyed." ), DroppedType == FQueuedSessionOp::EType::Start ? TEXT( "start" ) : TEXT( "end" ), *SessionName.ToString() );
+
+		if( DroppedType == FQueuedSessionOp::EType::Start )
+		{
+			TriggerOnStartSessionCompleteDelegates( SessionName, true );
+		}
+		else
+		{
+			TriggerOnEndSessionCompleteDelegates( SessionName, true );
+		}
+	}
+}
+
+void FOnlineSessionEOS::RunQueuedSessionOps( FName SessionName )
+{
+	// Looked up again each time, as issuing a call may complete it, and run the rest of the queue, on the spot.
+	while( IsSessionBusy( SessionName ) == false )
+	{
+		TArray<FQueuedSessionOp>* Queue = QueuedSessionOps.Find( SessionName );
+
+		if( Queue == nullptr )
+		{
+			return;
+		}
+
+		FQueuedSessionOp Op = MoveTemp( ( *Queue )[0] );
+		Queue->RemoveAt( 0 );
+
+		if( Queue->Num() == 0 )
+		{
+			QueuedSessionOps.Remove( SessionName );
+		}
+
+		switch( Op.Type )
+		{
+		case FQueuedSessionOp::EType::Start:
+			StartSessionInternal( SessionName );
+			break;
+		case FQueuedSessionOp::EType::End:
+			EndSessionInternal( SessionName );
+			break;
+		case FQueuedSessionOp::EType::Destroy:
+		{
+			if( Op.DestroyDelegates.Num() == 1 )
+			{
+				DestroySessionInternal( SessionName, Op.DestroyDelegates[0] );
+				break;
+			}
+
+			// The folded calls share one backend destroy, and each hears back through its own delegate.
+			TArray<FOnDestroySessionCompleteDelegate> Delegates = MoveTemp( Op.DestroyDelegates );
+			DestroySessionInternal( SessionName, FOnDestroySessionCompleteDelegate::CreateLambda( [Delegates]( FName CompletedSessionName, bool bWasSuccessful )
+			{
+				for( const FOnDestroySessionCompleteDelegate& Delegate : Delegates )
+				{
+					Delegate.ExecuteIfBound( CompletedSessionName, bWasSuccessful );
+				}
+			} ) );
+			break;
+		}
+		}
+	}
+}
+
+bool FOnlineSessionEOS::IsPlayerInSession( FName SessionName, const FUniqueNetId& UniqueId )
+{
+	return false;
+}
+
+/**
+ * Runs the matchmaker's searches, joins and fallback creates through the session interface itself, on behalf
+ * of the first matchmaking player. Completion is picked up from the interface's own delegates.
+ */
+class FOnlineSessionEOS::FMatchmakingBackend : public IMatchmakingBackendEOS
+{
+
+public:
+
+	FMatchmakingBackend( FOnlineSessionEOS* InSessionInterface, FName InSessionName, const TSharedRef<const FUniqueNetId>& InPlayerId )
+		: SessionInterface( InSessionInterface )
+		, SessionName( InSessionName )
+		, PlayerId( InPlayerId )
+		, SearchSerial( 0 )
+		, bAbandoned( false )
+	{}
+
+	virtual ~FMatchmakingBackend()
+	{
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle( FindSessionsHandle );
+		SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle( JoinSessionHandle );
+		SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle( CreateSessionHandle );
+	}
+
+	virtual bool Search( const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnMatchmakingStepCompleteEOS& Delegate ) override
+	{
+		// Searches the game is waiting on take priority, the matchmaker tries again next interval.
+		if( SessionInterface->CurrentSessionSearch.IsValid() && SessionInterface->bCurrentSearchIsRevalidation == false )
+		{
+			return false;
+		}
+
+		ActiveSearch = SearchSettings;
+		SearchDelegate = Delegate;
+		SearchSerial++;
+
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle( FindSessionsHandle );
+		FindSessionsHandle = SessionInterface->AddOnFindSessionsCompleteDelegate_Handle( FOnFindSessionsCompleteDelegate::CreateSP( this, &FMatchmakingBackend::HandleFindSessionsComplete ) );
+
+		// Failures are reported through OnFindSessionsComplete as well.
+		SessionInterface->FindSessions( *PlayerId, SearchSettings );
+		return true;
+	}
+
+	virtual void CancelSearch() override
+	{
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle( FindSessionsHandle );
+
+		if( ActiveSearch.IsValid() && SessionInterface->CurrentSessionSearch == ActiveSearch )
+		{
+			ActiveSearch->SearchState = EOnlineAsyncTaskState::Failed;
+			SessionInterface->AbandonSessionSearch();
+		}
+
+		ActiveSearch = nullptr;
+		SearchDelegate.Unbind();
+		SearchSerial++;
+	}
+
+	virtual bool Join( const FOnlineSessionSearchResult& Candidate, const FOnMatchmakingStepCompleteEOS& Delegate ) override
+	{
+		JoinDelegate = Delegate;
+
+		SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle( JoinSessionHandle );
+		JoinSessionHandle = SessionInterface->AddOnJoinSessionCompleteDelegate_Handle( FOnJoinSessionCompleteDelegate::CreateSP( this, &FMatchmakingBackend::HandleJoinSessionComplete ) );
+
+		SessionInterface->JoinSession( *PlayerId, SessionName, Candidate );
+		return true;
+	}
+
+	virtual bool Create( const FOnlineSessionSettings& SessionSettings, const FOnMatchmakingStepCompleteEOS& Delegate ) override
+	{
+		CreateDelegate = Delegate;
+
+		SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle( CreateSessionHandle );
+		CreateSessionHandle = SessionInterface->AddOnCreateSessionCompleteDelegate_Handle( FOnCreateSessionCompleteDelegate::CreateSP( this, &FMatchmakingBackend::HandleCreateSessionComplete ) );
+
+		SessionInterface->CreateSession( *PlayerId, SessionName, SessionSettings );
+		return true;
+	}
+
+	virtual void Abandon() override
+	{
+		bAbandoned = true;
+		JoinDelegate.Unbind();
+		CreateDelegate.Unbind();
+
+		// Outlives the matchmaker, to leave whatever session the join or create ends up in.
+		SessionInterface->AbandonedMatchmakingBackends.AddUnique( AsShared() );
+	}
+
+private:
+
+	void HandleFindSessionsComplete( bool bWasSuccessful )
+	{
+		// Some other search completed, e.g. one served from the cache before ours was issued.
+		if( ActiveSearch.IsValid() == false || ActiveSearch->SearchState == EOnlineAsyncTaskState::InProgress )
+		{
+			return;
+		}
+
+		SessionInterface->ClearOnFindSessionsCompleteDelegate_Handle( FindSessionsHandle );
+
+		TArray<FSessionQosTargetEOS> Targets;
+		if( bWasSuccessful == true )
+		{
+			for( const FOnlineSessionSearchResult& SearchResult : ActiveSearch->SearchResults )
+			{
+				SessionInterface->AddQosTarget( SearchResult, Targets );
+			}
+		}
+
+		if( Targets.Num() == 0 )
+		{
+			CompleteSearch( bWasSuccessful );
+			return;
+		}
+
+		// Candidates are scored on latency, so every host is measured before the search counts as done.
+		SessionInterface->GetQosProber().Probe( Targets, FOnSessionQosCompleteEOS::CreateSP( this, &FMatchmakingBackend::HandlePingComplete, SearchSerial ) );
+	}
+
+	void HandlePingComplete( const TMap<FString, int32>& PingsInMs, uint32 Serial )
+	{
+		if( Serial != SearchSerial || ActiveSearch.IsValid() == false )
+		{
+			return;
+		}
+
+		for( FOnlineSessionSearchResult& SearchResult : ActiveSearch->SearchResults )
+		{
+			if( FOnlineSessionEOS::ApplyQosResults( PingsInMs, SearchResult ) == true )
+			{
+				SessionInterface->SearchCache.UpdatePing( SearchResult.Session.SessionInfo->GetSessionId().ToString(), SearchResult.PingInMs );
+			}
+		}
+
+		CompleteSearch( true );
+	}
+
+	void CompleteSearch( bool bWasSuccessful )
+	{
+		FOnMatchmakingStepCompleteEOS Delegate = MoveTemp( SearchDelegate );
+		SearchDelegate.Unbind();
+
+		Delegate.ExecuteIfBound( bWasSuccessful );
+	}
+
+	void HandleJoinSessionComplete( FName InSessionName, EOnJoinSessionCompleteResult::Type Result )
+	{
+		if( InSessionName != SessionName )
+		{
+			return;
+		}
+
+		SessionInterface->ClearOnJoinSessionCompleteDelegate_Handle( JoinSessionHandle );
+
+		if( bAbandoned == true )
+		{
+			CompleteAbandoned( Result == EOnJoinSessionCompleteResult::Success );
+			return;
+		}
+
+		FOnMatchmakingStepCompleteEOS Delegate = MoveTemp( JoinDelegate );
+		JoinDelegate.Unbind();
+
+		Delegate.ExecuteIfBound( Result == EOnJoinSessionCompleteResult::Success );
+	}
+
+	void HandleCreateSessionComplete( FName InSessionName, bool bWasSuccessful )
+	{
+		if( InSessionName != SessionName )
+		{
+			return;
+		}
+
+		SessionInterface->ClearOnCreateSessionCompleteDelegate_Handle( CreateSessionHandle );
+
+		if( bAbandoned == true )
+		{
+			CompleteAbandoned( bWasSuccessful );
+			return;
+		}
+
+		FOnMatchmakingStepCompleteEOS Delegate = MoveTemp( CreateDelegate );
+		CreateDelegate.Unbind();
+
+		Delegate.ExecuteIfBound( bWasSuccessful );
+	}
+
+	/** Leaves the session an abandoned join or create ended up in, and lets go of the backend. */
+	void CompleteAbandoned( bool bWasSuccessful )
+	{
+		if( bWasSuccessful == true )
+		{
+			UE_LOG_ONLINE_SESSION( Log, TEXT( "Leaving session '%s': matchmaking was cancelled while it was joined or created." ), *SessionName.ToString() );
+			SessionInterface->DestroySession( SessionName );
+		}
+
+		// Frees this, once the delegate calling in lets go of it.
+		SessionInterface->AbandonedMatchmakingBackends.Remove( AsShared() );
+	}
+
+	FOnlineSessionEOS*						SessionInterface;
+
+	FName									SessionName;
+
+	TSharedRef<const FUniqueNetId>			PlayerId;
+
+	TSharedPtr<FOnlineSessionSearch>		ActiveSearch;
+
+	/** Incremented per search, so pings of an abandoned search are ignored. */
+	uint32									SearchSerial;
+
+	/** Set once matchmaking is cancelled mid join or create. */
+	bool									bAbandoned;
+
+	FOnMatchmakingStepCompleteEOS			SearchDelegate;
+	FOnMatchmakingStepCompleteEOS			JoinDelegate;
+	FOnMatchmakingStepCompleteEOS			CreateDelegate;
+
+	FDelegateHandle							FindSessionsHandle;
+	FDelegateHandle							JoinSessionHandle;
+	FDelegateHandle							CreateSessionHandle;
+};
+
+bool FOnlineSessionEOS::StartMatchmaking( const TArray< TSharedRef<const FUniqueNetId> >& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings )
+{
+	if( LocalPlayers.Num() == 0 || Matchmakers.Contains( SessionName ) || GetNamedSession( SessionName ) != nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot matchmake for session '%s': %s" ), *SessionName.ToString(), LocalPlayers.Num() == 0 ? TEXT( "no players." ) : TEXT( "session already exists." ) );
+		TriggerOnMatchmakingCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	FMatchmakingParamsEOS Params;
+	Params.LoadConfig();
+
+	// The first player searches, joins or creates on behalf of the rest, who all need a slot.
+	TUniquePtr<FSessionMatchmakerEOS>& Matchmaker = Matchmakers.Add( SessionName, MakeUnique<FSessionMatchmakerEOS>( MakeShared<FMatchmakingBackend>( this, SessionName, LocalPlayers[0] ), Params, NewSessionSettings, *SearchSettings, LocalPlayers.Num() ) );
+	Matchmaker->Start( FPlatformTime::Seconds() );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::CancelMatchmaking( int32 SearchingPlayerNum, FName SessionName )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+	TSharedPtr<const FUniqueNetId> SearchingPlayerId = Identity.IsValid() ? Identity->GetUniquePlayerId( SearchingPlayerNum ) : nullptr;
+
+	if( SearchingPlayerId.IsValid() == false )
+	{
+		TriggerOnCancelMatchmakingCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	return CancelMatchmaking( *SearchingPlayerId, SessionName );
+}
+
+bool FOnlineSessionEOS::CancelMatchmaking( const FUniqueNetId& SearchingPlayerId, FName SessionName )
+{
+	TUniquePtr<FSessionMatchmakerEOS>* Matchmaker = Matchmakers.Find( SessionName );
+
+	if( Matchmaker == nullptr || ( *Matchmaker )->IsComplete() == true )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot cancel matchmaking for session '%s': not matchmaking." ), *SessionName.ToString() );
+		TriggerOnCancelMatchmakingCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	// Completed from Tick, along with any matchmaker that finished on its own.
+	( *Matchmaker )->Cancel();
+	return true;
+}
+
+bool FOnlineSessionEOS::FindSessions( int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	return FindSessionsInternal( Identity.IsValid() ? Identity->GetProductUserId( SearchingPlayerNum ) : nullptr, SearchSettings );
+}
+
+bool FOnlineSessionEOS::FindSessions( const FUniqueNetId& SearchingPlayerId, const TSharedRef<FOnlineSessionSearch>& SearchSettings )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	return FindSessionsInternal( Identity.IsValid() ? Identity->GetProductUserId( SearchingPlayerId ) : nullptr, SearchSettings );
+}
+
+bool FOnlineSessionEOS::FindSessionsInternal( EOS_ProductUserId SearchingProductUserId, const TSharedRef<FOnlineSessionSearch>& SearchSettings )
+{
+	if( CurrentSessionSearch.IsValid() )
+	{
+		if( bCurrentSearchIsRevalidation == false )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Ignoring FindSessions, a search is already in progress." ) );
+			return false;
+		}
+
+		// Background refreshes give way to searches someone is waiting on.
+		AbandonSessionSearch();
+	}
+
+	if( SearchSettings->bIsLanQuery == true )
+	{
+		// Only our beacon is involved, so LAN searches work without the backend, and are never cached.
+		if( StartLANSearch( SearchSettings ) == false )
+		{
+			SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+			TriggerOnFindSessionsCompleteDelegates( false );
+			return false;
+		}
+
+		LastSessionSearch = SearchSettings;
+		return true;
+	}
+
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	if( SessionsHandle == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot search for sessions: EOS Sessions are not available." ) );
+		SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+		TriggerOnFindSessionsCompleteDelegates( false );
+		return false;
+	}
+
+	LastSessionSearch = SearchSettings;
+
+	bool bSearchLobbies = false;
+	if( SearchSettings->QuerySettings.Get( SEARCH_LOBBIES, bSearchLobbies ) && bSearchLobbies == true )
+	{
+		if( StartLobbySearch( SearchingProductUserId, SearchSettings ) == false )
+		{
+			SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+			TriggerOnFindSessionsCompleteDelegates( false );
+			return false;
+		}
+
+		return true;
+	}
+
+	const FString CacheKey = SearchCache.IsEnabled() ? FSessionSearchCacheEOS::MakeKey( *SearchSettings ) : FString();
+
+	if( CacheKey.IsEmpty() == false )
+	{
+		const ESessionSearchCacheLookupEOS Lookup = SearchCache.Find( CacheKey, SearchSettings->SearchResults );
+
+		if( Lookup != ESessionSearchCacheLookupEOS::Miss )
+		{
+			SearchSettings->SearchState = EOnlineAsyncTaskState::Done;
+
+			// Stale results are shown straight away, and replaced once the backend has been asked again.
+			if( Lookup == ESessionSearchCacheLookupEOS::Stale && SearchCache.BeginRevalidation( CacheKey ) )
+			{
+				TSharedRef<FOnlineSessionSearch> Revalidation = MakeShared<FOnlineSessionSearch>();
+				Revalidation->QuerySettings = SearchSettings->QuerySettings;
+				Revalidation->MaxSearchResults = SearchSettings->MaxSearchResults;
+
+				if( StartSessionSearch( SearchingProductUserId, Revalidation, CacheKey, true ) == true )
+				{
+					RevalidatedSessionSearch = SearchSettings;
+				}
+				else
+				{
+					SearchCache.AbortRevalidation( CacheKey );
+				}
+			}
+
+			if( SearchSettings->SearchResults.Num() > 0 )
+			{
+				OnFindSessionsPartialResults.Broadcast( SearchSettings, 0 );
+			}
+
+			TriggerOnFindSessionsCompleteDelegates( true );
+			return true;
+		}
+	}
+
+	if( StartSessionSearch( SearchingProductUserId, SearchSettings, CacheKey, false ) == false )
+	{
+		SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+		TriggerOnFindSessionsCompleteDelegates( false );
+		return false;
+	}
+
+	return true;
+}
+
+bool FOnlineSessionEOS::StartSessionSearch( EOS_ProductUserId SearchingProductUserId, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FString& CacheKey, bool bIsRevalidation )
+{
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	const int32 MaxResults = FMath::Clamp( FMath::Min( SearchMaxResults, SearchSettings->MaxSearchResults ), 1, EOS_SESSIONS_MAX_SEARCH_RESULTS );
+
+	EOS_Sessions_CreateSessionSearchOptions SearchOptions;
+	SearchOptions.ApiVersion = EOS_SESSIONS_CREATESESSIONSEARCH_API_LATEST;
+	SearchOptions.MaxSearchResults = (uint32_t)MaxResults;
+
+	EOS_HSessionSearch SearchHandle = nullptr;
+	const EOS_EResult SearchResult = EOS_Sessions_CreateSessionSearch( SessionsHandle, &SearchOptions, &SearchHandle );
+
+	if( SearchResult != EOS_EResult::EOS_Success || ApplySearchParameters( SearchHandle, *SearchSettings ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot search for sessions: %s" ), *UEOSCommon::EOSResultToString( SearchResult ) );
+
+		if( SearchHandle != nullptr )
+		{
+			EOS_SessionSearch_Release( SearchHandle );
+		}
+
+		return false;
+	}
+
+	SearchSettings->SearchResults.Reset();
+	SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+
+	CurrentSessionSearch = SearchSettings;
+	CurrentSearchCacheKey = CacheKey;
+	bCurrentSearchIsRevalidation = bIsRevalidation;
+	CurrentSearchHandle = SearchHandle;
+	CurrentSearchId++;
+	bSearchFindInFlight = true;
+	NumSearchResults = 0;
+	NextSearchResultIndex = 0;
+
+	EOS_SessionSearch_FindOptions FindOptions;
+	FindOptions.ApiVersion = EOS_SESSIONSEARCH_FIND_API_LATEST;
+	FindOptions.LocalUserId = SearchingProductUserId;
+
+	FSessionSearchContext* SearchContext = new FSessionSearchContext();
+	SearchContext->SessionInterface = AsShared();
+	SearchContext->SearchId = CurrentSearchId;
+	SearchContext->SearchHandle = SearchHandle;
+
+	EOS_SessionSearch_Find( SearchHandle, &FindOptions, SearchContext, FindSessionsCompleteCallback );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::ApplySearchParameters( EOS_HSessionSearch SearchHandle, const FOnlineSessionSearch& SearchSettings )
+{
+	FEOSLargeScratchArena Arena;
+
+	EOS_Sessions_AttributeData Parameter;
+
+	EOS_SessionSearch_SetParameterOptions ParameterOptions;
+	ParameterOptions.ApiVersion = EOS_SESSIONSEARCH_SETPARAMETER_API_LATEST;
+	ParameterOptions.Parameter = &Parameter;
+
+	bool bHasBucket = false;
+	bool bHasBuildId = false;
+
+	for( const TPair<FName, FOnlineSessionSearchParam>& SearchParam : SearchSettings.QuerySettings.SearchParams )
+	{
+		// Presence is implied by the session permission level, it is not an attribute.
+		if( SearchParam.Key == SEARCH_PRESENCE )
+		{
+			continue;
+		}
+
+		switch( SearchParam.Value.ComparisonOp )
+		{
+		case EOnlineComparisonOp::Equals:				ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_EQUAL; break;
+		case EOnlineComparisonOp::NotEquals:			ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_NOTEQUAL; break;
+		case EOnlineComparisonOp::GreaterThan:			ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_GREATERTHAN; break;
+		case EOnlineComparisonOp::GreaterThanEquals:	ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_GREATERTHANOREQUAL; break;
+		case EOnlineComparisonOp::LessThan:				ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_LESSTHAN; break;
+		case EOnlineComparisonOp::LessThanEquals:		ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_LESSTHANOREQUAL; break;
+		case EOnlineComparisonOp::Near:					ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_DISTANCE; break;
+		case EOnlineComparisonOp::In:					ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_ANYOF; break;
+		case EOnlineComparisonOp::NotIn:				ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_NOTANYOF; break;
+		default:
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Search parameter %s has no EOS comparison, ignoring it." ), *SearchParam.Key.ToString() );
+			continue;
+		}
+
+		// The well known search keys map onto the backend's own parameters.
+		const char* Key = nullptr;
+		FVariantData Data = SearchParam.Value.Data;
+
+		if( SearchParam.Key == SETTING_EOS_BUCKETID )
+		{
+			Key = EOS_SESSIONS_SEARCH_BUCKET_ID;
+			bHasBucket = true;
+		}
+		else if( SearchParam.Key == SEARCH_EMPTY_SERVERS_ONLY )
+		{
+			Key = EOS_SESSIONS_SEARCH_EMPTY_SERVERS_ONLY;
+			Data.SetValue( true );
+		}
+		else if( SearchParam.Key == SEARCH_NONEMPTY_SERVERS_ONLY )
+		{
+			Key = EOS_SESSIONS_SEARCH_NONEMPTY_SERVERS_ONLY;
+			Data.SetValue( true );
+		}
+		else if( SearchParam.Key == SEARCH_EOS_MINSLOTSAVAILABLE )
+		{
+			Key = EOS_SESSIONS_SEARCH_MINSLOTSAVAILABLE;
+		}
+		else
+		{
+			Key = Arena.ToUTF8( SearchParam.Key.ToString() );
+			bHasBuildId |= ( SearchParam.Key == SETTING_EOS_BUILDID );
+		}
+
+		if( ToSessionAttribute( Key, Data, Arena, Parameter ) == false )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Search parameter %s has no EOS representation, ignoring it." ), *SearchParam.Key.ToString() );
+			continue;
+		}
+
+		const EOS_EResult Result = EOS_SessionSearch_SetParameter( SearchHandle, &ParameterOptions );
+		if( Result != EOS_EResult::EOS_Success )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Search parameter %s rejected: %s" ), *SearchParam.Key.ToString(), *UEOSCommon::EOSResultToString( Result ) );
+			return false;
+		}
+	}
+
+	ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_EQUAL;
+
+	// Sessions are always created in a bucket, so search the same default one CreateSession uses.
+	if( bHasBucket == false )
+	{
+		ToSessionAttribute( EOS_SESSIONS_SEARCH_BUCKET_ID, FVariantData( DefaultBucketId ), Arena, Parameter );
+		if( EOS_SessionSearch_SetParameter( SearchHandle, &ParameterOptions ) != EOS_EResult::EOS_Success )
+		{
+			return false;
+		}
+	}
+
+	// Incompatible builds are filtered by the backend, not after the results have been downloaded.
+	if( bHasBuildId == false )
+	{
+		EOSSessionAttributeSchema::ToAttribute<FSessionAttributeBuildIdEOS>( GetBuildUniqueId(), Arena, Parameter );
+		if( EOS_SessionSearch_SetParameter( SearchHandle, &ParameterOptions ) != EOS_EResult::EOS_Success )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FOnlineSessionEOS::FindSessionById( const FUniqueNetId& SearchingUserId, const FUniqueNetId& SessionId, const FUniqueNetId& FriendId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate )
+{
+	return false;
+}
+
+bool FOnlineSessionEOS::CancelFindSessions()
+{
+	if( CurrentSessionSearch.IsValid() == false || bCurrentSearchIsRevalidation == true )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Can't cancel a search that isn't in progress." ) );
+		TriggerOnCancelFindSessionsCompleteDelegates( false );
+		return false;
+	}
+
+	CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
+	AbandonSessionSearch();
+
+	TriggerOnCancelFindSessionsCompleteDelegates( true );
+	return true;
+}
+
+void FOnlineSessionEOS::AbandonSessionSearch()
+{
+	if( LANSession != nullptr && LANSession->GetBeaconState() == ELanBeaconState::Searching )
+	{
+		StopLANSearch();
+	}
+
+	// A search the backend is still running is released once its callback arrives.
+	if( bSearchFindInFlight == false && CurrentSearchHandle != nullptr )
+	{
+		EOS_SessionSearch_Release( CurrentSearchHandle );
+	}
+
+	if( bCurrentSearchIsRevalidation == true )
+	{
+		SearchCache.AbortRevalidation( CurrentSearchCacheKey );
+		RevalidatedSessionSearch = nullptr;
+	}
+
+	CurrentSessionSearch = nullptr;
+	CurrentSearchCacheKey.Empty();
+	bCurrentSearchIsRevalidation = false;
+	CurrentSearchHandle = nullptr;
+	CurrentSearchId++;
+	bSearchFindInFlight = false;
+	NumSearchResults = 0;
+	NextSearchResultIndex = 0;
+}
+
+void FOnlineSessionEOS::FlushSearchCache()
+{
+	SearchCache.Empty();
+}
+
+const FSessionSearchCacheStatsEOS& FOnlineSessionEOS::GetSearchCacheStats() const
+{
+	return SearchCache.GetStats();
+}
+
+bool FOnlineSessionEOS::GetSessionHostStats( FName SessionName, FSessionHostStatsEOS& OutStats )
+{
+	const FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+	const FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( UpdateState == nullptr || Session == nullptr )
+	{
+		return false;
+	}
+
+	OutStats = UpdateState->Stats;
+	OutStats.AllocatedSize = GetHostAllocatedSize( *Session, *UpdateState );
+
+	return true;
+}
+
+SIZE_T FOnlineSessionEOS::GetHostAllocatedSize( const FNamedOnlineSession& Session, const FSessionUpdateState& UpdateState )
+{
+	return sizeof( FNamedOnlineSession ) + sizeof( FOnlineSessionInfoEOS ) + sizeof( FSessionUpdateState )
+		+ Session.SessionSettings.Settings.GetAllocatedSize() + Session.SessionSettings.MemberSettings.GetAllocatedSize() + Session.RegisteredPlayers.GetAllocatedSize()
+		+ UpdateState.PushedSettings.GetAllocatedSize() + UpdateState.InFlightDelta.Changed.GetAllocatedSize() + UpdateState.InFlightDelta.Removed.GetAllocatedSize()
+		+ UpdateState.PendingRegistrations.GetAllocatedSize() + UpdateState.PendingUnregistrations.GetAllocatedSize()
+		+ UpdateState.BackendPlayers.GetAllocatedSize() + UpdateState.ResolvingPlayers.GetAllocatedSize()
+		+ UpdateState.RegistrationCalls.GetAllocatedSize() + UpdateState.PendingCalls.GetAllocatedSize() + UpdateState.InFlightCalls.GetAllocatedSize();
+}
+
+bool FOnlineSessionEOS::PingSearchResults( const FOnlineSessionSearchResult& SearchResult )
+{
+	TArray<FSessionQosTargetEOS> Targets;
+
+	if( AddQosTarget( SearchResult, Targets ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot ping a search result with no host address." ) );
+		return false;
+	}
+
+	GetQosProber().Probe( Targets, FOnSessionQosCompleteEOS::CreateRaw( this, &FOnlineSessionEOS::HandlePingSearchResultsComplete, LastSessionSearch, false ) );
+	return true;
+}
+
+bool FOnlineSessionEOS::PingSearchResults( const TSharedRef<FOnlineSessionSearch>& SearchSettings, bool bSortByPing )
+{
+	TArray<FSessionQosTargetEOS> Targets;
+	Targets.Reserve( SearchSettings->SearchResults.Num() );
+
+	for( const FOnlineSessionSearchResult& SearchResult : SearchSettings->SearchResults )
+	{
+		AddQosTarget( SearchResult, Targets );
+	}
+
+	if( Targets.Num() == 0 )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot ping search results, none have a host address." ) );
+		return false;
+	}
+
+	GetQosProber().Probe( Targets, FOnSessionQosCompleteEOS::CreateRaw( this, &FOnlineSessionEOS::HandlePingSearchResultsComplete, TWeakPtr<FOnlineSessionSearch>( SearchSettings ), bSortByPing ) );
+	return true;
+}
+
+void FOnlineSessionEOS::SortSearchResultsByPing( FOnlineSessionSearch& SearchSettings )
+{
+	SearchSettings.SearchResults.StableSort( []( const FOnlineSessionSearchResult& A, const FOnlineSessionSearchResult& B )
+	{
+		return A.PingInMs < B.PingInMs;
+	} );
+}
+
+bool FOnlineSessionEOS::AddQosTarget( const FOnlineSessionSearchResult& SearchResult, TArray<FSessionQosTargetEOS>& OutTargets ) const
+{
+	const FOnlineSessionInfoEOS* SessionInfo = static_cast<const FOnlineSessionInfoEOS*>( SearchResult.Session.SessionInfo.Get() );
+
+	if( SessionInfo == nullptr )
+	{
+		return false;
+	}
+
+	const int32 NumTargets = OutTargets.Num();
+	const FString SessionId = SessionInfo->SessionId.ToString();
+
+	if( SessionInfo->HasConnectionMethod( FEOSConnectionMethod::Direct ) )
+	{
+		// Hosts advertise where their responder listens, older ones are assumed to use the configured port.
+		int32 QosPort = 0;
+		if( SearchResult.Session.SessionSettings.Get( SETTING_EOS_QOSPORT, QosPort ) == false )
+		{
+			QosPort = FSessionQosResponderEOS::GetConfiguredPort();
+		}
+
+		TSharedRef<FInternetAddr> QosAddr = SessionInfo->HostAddr->Clone();
+		QosAddr->SetPort( QosPort );
+
+		OutTargets.Emplace( GetQosTargetId( SessionId, FEOSConnectionMethod::Direct ), QosAddr );
+	}
+
+	// Relays are only measured if they run a responder of their own, and say where.
+	int32 AdvertisedQosPort = 0;
+	if( SessionInfo->HasConnectionMethod( FEOSConnectionMethod::PartnerHosted ) && SearchResult.Session.SessionSettings.Get( SETTING_EOS_PARTNERQOSPORT, AdvertisedQosPort ) && AdvertisedQosPort > 0 )
+	{
+		TSharedRef<FInternetAddr> QosAddr = SessionInfo->PartnerAddr->Clone();
+		QosAddr->SetPort( AdvertisedQosPort );
+
+		OutTargets.Emplace( GetQosTargetId( SessionId, FEOSConnectionMethod::PartnerHosted ), QosAddr );
+	}
+
+	return OutTargets.Num() > NumTargets;
+}
+
+void FOnlineSessionEOS::HandlePingSearchResultsComplete( const TMap<FString, int32>& PingsInMs, TWeakPtr<FOnlineSessionSearch> SearchSettings, bool bSortByPing )
+{
+	// Direct probes are keyed by session id alone, so cached results not in the search still get a ping.
+	for( const TPair<FString, int32>& Ping : PingsInMs )
+	{
+		SearchCache.UpdatePing( Ping.Key, Ping.Value );
+	}
+
+	TSharedPtr<FOnlineSessionSearch> PinnedSearch = SearchSettings.Pin();
+
+	if( PinnedSearch.IsValid() )
+	{
+		for( FOnlineSessionSearchResult& SearchResult : PinnedSearch->SearchResults )
+		{
+			if( ApplyQosResults( PingsInMs, SearchResult ) == true )
+			{
+				SearchCache.UpdatePing( SearchResult.Session.SessionInfo->GetSessionId().ToString(), SearchResult.PingInMs );
+			}
+		}
+
+		if( bSortByPing == true )
+		{
+			SortSearchResultsByPing( *PinnedSearch );
+		}
+	}
+
+	TriggerOnPingSearchResultsCompleteDelegates( true );
+}
+
+FString FOnlineSessionEOS::GetQosTargetId( const FString& SessionId, FEOSConnectionMethod Method )
+{
+	return Method == FEOSConnectionMethod::Direct ? SessionId : FString::Printf( TEXT( "%s/%s" ), *SessionId, *LexToString( Method ) );
+}
+
+bool FOnlineSessionEOS::ApplyQosResults( const TMap<FString, int32>& PingsInMs, FOnlineSessionSearchResult& SearchResult )
+{
+	FOnlineSessionInfoEOS* SessionInfo = static_cast<FOnlineSessionInfoEOS*>( SearchResult.Session.SessionInfo.Get() );
+
+	if( SessionInfo == nullptr || ApplyMethodPings( PingsInMs, *SessionInfo ) == false )
+	{
+		return false;
+	}
+
+	// The result is as far away as the path that will actually be used.
+	const int32* PingInMs = SessionInfo->MethodPingsInMs.Find( SessionInfo->ConnectionMethod );
+	SearchResult.PingInMs = PingInMs != nullptr ? *PingInMs : MAX_QUERY_PING;
+
+	return true;
+}
+
+bool FOnlineSessionEOS::ApplyMethodPings( const TMap<FString, int32>& PingsInMs, FOnlineSessionInfoEOS& SessionInfo )
+{
+	const FString SessionId = SessionInfo.SessionId.ToString();
+	bool bMeasured = false;
+
+	for( const FEOSConnectionMethod Method : GetConnectionMethodOrder() )
+	{
+		if( const int32* PingInMs = PingsInMs.Find( GetQosTargetId( SessionId, Method ) ) )
+		{
+			SessionInfo.MethodPingsInMs.Add( Method, *PingInMs );
+			bMeasured = true;
+		}
+	}
+
+	if( bMeasured == true )
+	{
+		SessionInfo.SetConnectionMethod( SelectConnectionMethod( SessionInfo ) );
+	}
+
+	return bMeasured;
+}
+
+const TArray<FEOSConnectionMethod>& FOnlineSessionEOS::GetConnectionMethodOrder()
+{
+	static TArray<FEOSConnectionMethod> Order;
+
+	if( Order.Num() == 0 )
+	{
+		FString OrderString = TEXT( "Direct,PartnerHosted" );
+		GConfig->GetString( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionConnectionMethodOrder" ), OrderString, GEngineIni );
+
+		TArray<FString> MethodNames;
+		OrderString.ParseIntoArray( MethodNames, TEXT( "," ) );
+
+		// Methods left out are never used.
+		for( const FString& MethodName : MethodNames )
+		{
+			const FEOSConnectionMethod Method = ToConnectionMethod( MethodName.TrimStartAndEnd() );
+
+			if( Method == FEOSConnectionMethod::P2P )
+			{
+				UE_LOG_ONLINE_SESSION( Warning, TEXT( "SessionConnectionMethodOrder names P2P, which is not supported yet. Ignoring it." ) );
+			}
+			else if( Method != FEOSConnectionMethod::None )
+			{
+				Order.AddUnique( Method );
+			}
+		}
+
+		if( Order.Num() == 0 )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "SessionConnectionMethodOrder '%s' names no connection method, using Direct." ), *OrderString );
+			Order.Add( FEOSConnectionMethod::Direct );
+		}
+	}
+
+	return Order;
+}
+
+FEOSConnectionMethod FOnlineSessionEOS::SelectConnectionMethod( const FOnlineSessionInfoEOS& SessionInfo )
+{
+	FEOSConnectionMethod Fastest = FEOSConnectionMethod::None;
+	int32 FastestPingInMs = MAX_QUERY_PING;
+
+	FEOSConnectionMethod FirstUnmeasured = FEOSConnectionMethod::None;
+	FEOSConnectionMethod FirstAvailable = FEOSConnectionMethod::None;
+
+	for( const FEOSConnectionMethod Method : GetConnectionMethodOrder() )
+	{
+		if( SessionInfo.HasConnectionMethod( Method ) == false )
+		{
+			continue;
+		}
+
+		if( FirstAvailable == FEOSConnectionMethod::None )
+		{
+			FirstAvailable = Method;
+		}
+
+		const int32* PingInMs = SessionInfo.MethodPingsInMs.Find( Method );
+
+		if( PingInMs == nullptr )
+		{
+			if( FirstUnmeasured == FEOSConnectionMethod::None )
+			{
+				FirstUnmeasured = Method;
+			}
+		}
+		// Strictly less, so ties go to the method configured first.
+		else if( *PingInMs < FastestPingInMs )
+		{
+			Fastest = Method;
+			FastestPingInMs = *PingInMs;
+		}
+	}
+
+	if( Fastest != FEOSConnectionMethod::None )
+	{
+		return Fastest;
+	}
+
+	// Nothing answered. A method that couldn't be measured, e.g. a host with no QoS port, is a better bet than one that timed out.
+	return FirstUnmeasured != FEOSConnectionMethod::None ? FirstUnmeasured : FirstAvailable;
+}
+
+void FOnlineSessionEOS::AdvertiseConnectionMethods( FNamedOnlineSession& Session, EOS_ProductUserId HostingProductUserId ) const
+{
+	FOnlineSessionInfoEOS* SessionInfo = static_cast<FOnlineSessionInfoEOS*>( Session.SessionInfo.Get() );
+	check( SessionInfo != nullptr );
+
+	// P2P is not advertised, as there is no P2P net driver for clients to connect through.
+	if( PartnerHostAddress.IsEmpty() == false )
+	{
+		bool bIsValid = false;
+		TSharedRef<FInternetAddr> Addr = ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->CreateInternetAddr();
+		Addr->SetIp( *PartnerHostAddress, bIsValid );
+
+		if( bIsValid == false )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Not advertising SessionPartnerHostAddress '%s', expected ip:port." ), *PartnerHostAddress );
+			return;
+		}
+
+		SessionInfo->PartnerAddr = Addr;
+		Session.SessionSettings.Set( SETTING_EOS_PARTNERADDR, Addr->ToString( true ), EOnlineDataAdvertisementType::ViaOnlineService );
+
+		if( PartnerQosPort > 0 )
+		{
+			Session.SessionSettings.Set( SETTING_EOS_PARTNERQOSPORT, PartnerQosPort, EOnlineDataAdvertisementType::ViaOnlineService );
+		}
+	}
+}
+
+void FOnlineSessionEOS::ReadConnectionMethods( FOnlineSession& Session )
+{
+	FOnlineSessionInfoEOS* SessionInfo = static_cast<FOnlineSessionInfoEOS*>( Session.SessionInfo.Get() );
+	check( SessionInfo != nullptr );
+
+	Session.SessionSettings.Get( SETTING_EOS_P2PHOSTID, SessionInfo->P2PHostId );
+
+	FString PartnerAddress;
+	if( Session.SessionSettings.Get( SETTING_EOS_PARTNERADDR, PartnerAddress ) == true )
+	{
+		bool bIsValid = false;
+		SessionInfo->PartnerAddr = ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->CreateInternetAddr();
+		SessionInfo->PartnerAddr->SetIp( *PartnerAddress, bIsValid );
+
+		if( bIsValid == false )
+		{
+			SessionInfo->PartnerAddr = nullptr;
+		}
+	}
+
+	// Until something is measured, this is just the first method in the configured order.
+	SessionInfo->SetConnectionMethod( SelectConnectionMethod( *SessionInfo ) );
+}
+
+bool FOnlineSessionEOS::ResolveConnectString( FOnlineSessionInfoEOS& SessionInfo, const FOnlineSessionSettings& SessionSettings, FName PortType, FString& ConnectInfo )
+{
+	if( const FString* CachedConnectInfo = SessionInfo.ConnectStrings.Find( PortType ) )
+	{
+		ConnectInfo = *CachedConnectInfo;
+		return true;
+	}
+
+	if( PortType != NAME_GamePort && PortType != NAME_BeaconPort )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot resolve a connect string for port type %s." ), *PortType.ToString() );
+		return false;
+	}
+
+	if( SessionInfo.HasConnectionMethod( SessionInfo.ConnectionMethod ) == false )
+	{
+		SessionInfo.SetConnectionMethod( SelectConnectionMethod( SessionInfo ) );
+	}
+
+	// Beacons listen on a port of their own, on the same host.
+	int32 BeaconPort = 15000;
+	SessionSettings.Get( SETTING_BEACONPORT, BeaconPort );
+
+	FString NewConnectInfo;
+
+	switch( SessionInfo.ConnectionMethod )
+	{
+	case FEOSConnectionMethod::Direct:
+	case FEOSConnectionMethod::PartnerHosted:
+	{
+		TSharedRef<FInternetAddr> Addr = ( SessionInfo.ConnectionMethod == FEOSConnectionMethod::Direct ? SessionInfo.HostAddr : SessionInfo.PartnerAddr )->Clone();
+
+		if( PortType == NAME_BeaconPort )
+		{
+			Addr->SetPort( BeaconPort );
+		}
+
+		NewConnectInfo = Addr->ToString( true );
+		break;
+	}
+	case FEOSConnectionMethod::P2P:
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot resolve a connect string for session %s: P2P connections are not supported yet." ), *SessionInfo.SessionId.ToString() );
+		return false;
+	default:
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot resolve a connect string for session %s: it advertises no way to reach its host." ), *SessionInfo.SessionId.ToString() );
+		return false;
+	}
+
+	SessionInfo.ConnectStrings.Add( PortType, NewConnectInfo );
+	ConnectInfo = NewConnectInfo;
+	return true;
+}
+
+bool FOnlineSessionEOS::StartJoinQos( FName SessionName, const FOnlineSessionSearchResult& DesiredSession )
+{
+	const FOnlineSessionInfoEOS* SessionInfo = static_cast<const FOnlineSessionInfoEOS*>( DesiredSession.Session.SessionInfo.Get() );
+
+	if( bJoinQos == false || SessionInfo == nullptr || SessionInfo->MethodPingsInMs.Num() > 0 )
+	{
+		return false;
+	}
+
+	int32 NumMethods = 0;
+	for( const FEOSConnectionMethod Method : GetConnectionMethodOrder() )
+	{
+		NumMethods += SessionInfo->HasConnectionMethod( Method ) ? 1 : 0;
+	}
+
+	TArray<FSessionQosTargetEOS> Targets;
+	if( NumMethods < 2 || AddQosTarget( DesiredSession, Targets ) == false )
+	{
+		return false;
+	}
+
+	FJoinQosState& JoinQos = JoinsAwaitingQos.Add( SessionName );
+	JoinQos.SessionId = SessionInfo->SessionId.ToString();
+
+	// Added first, as the prober may complete before returning.
+	GetQosProber().Probe( Targets, FOnSessionQosCompleteEOS::CreateRaw( this, &FOnlineSessionEOS::HandleJoinQosComplete, SessionName, JoinQos.SessionId ) );
+	return true;
+}
+
+void FOnlineSessionEOS::HandleJoinQosComplete( const TMap<FString, int32>& PingsInMs, FName SessionName, FString SessionId )
+{
+	FJoinQosState* JoinQos = JoinsAwaitingQos.Find( SessionName );
+
+	if( JoinQos == nullptr || JoinQos->SessionId != SessionId )
+	{
+		// The join failed, or another session of this name is being joined now.
+		return;
+	}
+
+	const TOptional<EOnJoinSessionCompleteResult::Type> JoinResult = JoinQos->JoinResult;
+	JoinsAwaitingQos.Remove( SessionName );
+
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	FOnlineSessionInfoEOS* SessionInfo = Session != nullptr ? static_cast<FOnlineSessionInfoEOS*>( Session->SessionInfo.Get() ) : nullptr;
+
+	if( SessionInfo == nullptr )
+	{
+		// Destroyed while joining. The join still completes, as whatever the backend made of it.
+		NotifyJoinSessionComplete( SessionName, JoinResult.Get( EOnJoinSessionCompleteResult::UnknownError ) );
+		return;
+	}
+
+	ApplyMethodPings( PingsInMs, *SessionInfo );
+
+	if( JoinResult.IsSet() )
+	{
+		NotifyJoinSessionComplete( SessionName, JoinResult.GetValue() );
+	}
+}
+
+void FOnlineSessionEOS::CompleteJoinSession( FName SessionName, EOnJoinSessionCompleteResult::Type Result )
+{
+	// A follower is back in the migrated session once the backend has it, whatever the probe makes of it.
+	CompleteHostMigration( SessionName, Result == EOnJoinSessionCompleteResult::Success );
+	CompleteRejoin( SessionName, Result );
+
+	if( FJoinQosState* JoinQos = JoinsAwaitingQos.Find( SessionName ) )
+	{
+		if( Result == EOnJoinSessionCompleteResult::Success )
+		{
+			JoinQos->JoinResult = Result;
+			return;
+		}
+
+		JoinsAwaitingQos.Remove( SessionName );
+	}
+
+	NotifyJoinSessionComplete( SessionName, Result );
+}
+
+void FOnlineSessionEOS::NotifyCreateSessionComplete( FName SessionName, bool bWasSuccessful )
+{
+	if( MigrationSessionCalls.Remove( SessionName ) == 0 )
+	{
+		TriggerOnCreateSessionCompleteDelegates( SessionName, bWasSuccessful );
+	}
+}
+
+void FOnlineSessionEOS::NotifyJoinSessionComplete( FName SessionName, EOnJoinSessionCompleteResult::Type Result )
+{
+	if( MigrationSessionCalls.Remove( SessionName ) == 0 )
+	{
+		TriggerOnJoinSessionCompleteDelegates( SessionName, Result );
+	}
+}
+
+bool FOnlineSessionEOS::RejoinSession( FName SessionName )
+{
+	if( GetNamedSession( SessionName ) != nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot rejoin session '%s': session already exists." ), *SessionName.ToString() );
+		TriggerOnJoinSessionCompleteDelegates( SessionName, EOnJoinSessionCompleteResult::AlreadyInSession );
+		return false;
+	}
+
+	if( HasRejoinTicket( SessionName ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot rejoin session '%s': it wasn't left recently enough." ), *SessionName.ToString() );
+		TriggerOnJoinSessionCompleteDelegates( SessionName, EOnJoinSessionCompleteResult::SessionDoesNotExist );
+		return false;
+	}
+
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	// Copied, as the ticket is used up once the join completes, which may be before JoinSessionInternal returns.
+	const FOnlineSessionSearchResult SearchResult = RejoinTicket->SearchResult;
+	const int32 PlayerNum = RejoinTicket->PlayerNum;
+	const TSharedPtr<const FUniqueNetId> PlayerId = RejoinTicket->PlayerId;
+	EOS_ProductUserId ProductUserId = ( Identity.IsValid() && PlayerId.IsValid() ) ? Identity->GetProductUserId( *PlayerId ) : nullptr;
+
+	RejoinTicket->RejoinStartTime = FPlatformTime::Seconds();
+
+	const bool bWasStarted = JoinSessionInternal( PlayerNum, PlayerId, ProductUserId, SessionName, SearchResult );
+
+	// LAN sessions are joined on the spot, and joins that fail to start, never reach CompleteJoinSession.
+	if( bWasStarted == false || GetSessionState( SessionName ) == EOnlineSessionState::Pending )
+	{
+		CompleteRejoin( SessionName, bWasStarted ? EOnJoinSessionCompleteResult::Success : EOnJoinSessionCompleteResult::UnknownError );
+	}
+
+	return bWasStarted;
+}
+
+bool FOnlineSessionEOS::HasRejoinTicket( FName SessionName ) const
+{
+	return RejoinTicket.IsSet() && RejoinTicket->SessionName == SessionName && FPlatformTime::Seconds() < RejoinTicket->ExpiryTime;
+}
+
+const FSessionRejoinStatsEOS& FOnlineSessionEOS::GetRejoinStats() const
+{
+	return RejoinStats;
+}
+
+void FOnlineSessionEOS::KeepRejoinTicket( const FNamedOnlineSession& Session )
+{
+	const FOnlineSessionInfoEOS* SessionInfo = static_cast<const FOnlineSessionInfoEOS*>( Session.SessionInfo.Get() );
+
+	// Only sessions that were joined for good. Hosts have nothing to rejoin.
+	if( Session.bHosting == true || Session.SessionState == EOnlineSessionState::Creating || SessionInfo == nullptr || SessionInfo->SessionId.IsValid() == false )
+	{
+		return;
+	}
+
+	if( RejoinTicketSeconds <= 0.0f )
+	{
+		RejoinTicket.Reset();
+		return;
+	}
+
+	FRejoinTicket& Ticket = RejoinTicket.Emplace();
+	Ticket.SessionName = Session.SessionName;
+	Ticket.SearchResult.Session = Session;
+	Ticket.PlayerNum = Session.HostingPlayerNum;
+	Ticket.PlayerId = Session.LocalOwnerId;
+	Ticket.ExpiryTime = FPlatformTime::Seconds() + RejoinTicketSeconds;
+
+	// Lobby members are the backend's to list, so only session registrations are kept.
+	if( LobbyStates.Contains( Session.SessionName ) == false )
+	{
+		Ticket.RegisteredPlayers = Session.RegisteredPlayers;
+	}
+}
+
+void FOnlineSessionEOS::CompleteRejoin( FName SessionName, EOnJoinSessionCompleteResult::Type Result )
+{
+	if( RejoinTicket.IsSet() == false || RejoinTicket->SessionName != SessionName || RejoinTicket->RejoinStartTime <= 0.0 )
+	{
+		return;
+	}
+
+	const double Seconds = FPlatformTime::Seconds() - RejoinTicket->RejoinStartTime;
+	const TArray<TSharedRef<const FUniqueNetId>> RegisteredPlayers = MoveTemp( RejoinTicket->RegisteredPlayers );
+
+	RejoinTicket.Reset();
+
+	if( Result != EOnJoinSessionCompleteResult::Success )
+	{
+		RejoinStats.NumFailed++;
+		return;
+	}
+
+	RejoinStats.Latencies.Add( Seconds );
+	RejoinStats.LastSeconds = Seconds;
+
+	UE_LOG_ONLINE_SESSION( Verbose, TEXT( "Rejoined session '%s' in %.1fms." ), *SessionName.ToString(), Seconds * 1000.0 );
+
+	if( RegisteredPlayers.Num() > 0 )
+	{
+		RegisterPlayers( SessionName, RegisteredPlayers, false );
+	}
+}
+
+FSessionQosProberEOS& FOnlineSessionEOS::GetQosProber()
+{
+	if( QosProber.IsValid() == false )
+	{
+		QosProber = MakeUnique<FSessionQosProberEOS>();
+		QosProber->Init();
+	}
+
+	return *QosProber;
+}
+
+bool FOnlineSessionEOS::StartQosResponder( int32 Port )
+{
+	if( QosResponder.IsValid() == false )
+	{
+		TUniquePtr<FSessionQosResponderEOS> NewResponder = MakeUnique<FSessionQosResponderEOS>();
+
+		if( NewResponder->Init( Port ) == false )
+		{
+			return false;
+		}
+
+		QosResponder = MoveTemp( NewResponder );
+	}
+
+	return true;
+}
+
+void FOnlineSessionEOS::StopIdleQosResponder()
+{
+	// Only sessions hosted through EOS_Sessions advertise the responder.
+	if( SessionUpdateStates.Num() == 0 )
+	{
+		QosResponder.Reset();
+	}
+}
+
+bool FOnlineSessionEOS::JoinSession( int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	TSharedPtr<const FUniqueNetId> PlayerId = Identity.IsValid() ? Identity->GetUniquePlayerId( PlayerNum ) : nullptr;
+	EOS_ProductUserId ProductUserId = Identity.IsValid() ? Identity->GetProductUserId( PlayerNum ) : nullptr;
+
+	return JoinSessionInternal( PlayerNum, PlayerId, ProductUserId, SessionName, DesiredSession );
+}
+
+bool FOnlineSessionEOS::JoinSession( const FUniqueNetId& PlayerId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	const int32 PlayerNum = Identity.IsValid() ? Identity->GetLocalUserNum( PlayerId ) : INDEX_NONE;
+
+	if( PlayerNum == INDEX_NONE )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot join session '%s': %s is not a Local User." ), *SessionName.ToString(), *PlayerId.ToString() );
+		TriggerOnJoinSessionCompleteDelegates( SessionName, EOnJoinSessionCompleteResult::UnknownError );
+		return false;
+	}
+
+	return JoinSessionInternal( PlayerNum, PlayerId.AsShared(), Identity->GetProductUserId( PlayerNum ), SessionName, DesiredSession );
+}
+
+bool FOnlineSessionEOS::JoinSessionInternal( int32 PlayerNum, const TSharedPtr<const FUniqueNetId>& PlayerId, EOS_ProductUserId ProductUserId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession )
+{
+	if( GetNamedSession( SessionName ) != nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot join session '%s': session already exists." ), *SessionName.ToString() );
+		NotifyJoinSessionComplete( SessionName, EOnJoinSessionCompleteResult::AlreadyInSession );
+		return false;
+	}
+
+	const FOnlineSessionInfoEOS* SearchSessionInfo = static_cast<const FOnlineSessionInfoEOS*>( DesiredSession.Session.SessionInfo.Get() );
+
+	if( SearchSessionInfo != nullptr && SearchSessionInfo->SessionType == EEOSSession::LobbySession )
+	{
+		return JoinLobbyInternal( PlayerNum, PlayerId, ProductUserId, SessionName, DesiredSession );
+	}
+
+	if( SearchSessionInfo != nullptr && SearchSessionInfo->SessionType == EEOSSession::LANSession )
+	{
+		// Nothing to tell anyone, the host is connected to at the address it advertised.
+		FOnlineSessionInfoEOS* NewSessionInfo = new FOnlineSessionInfoEOS( EEOSSession::LANSession, SearchSessionInfo->SessionId );
+		NewSessionInfo->CopyConnectionInfo( *SearchSessionInfo );
+
+		FOnlineSession JoinedSession = DesiredSession.Session;
+		JoinedSession.SessionInfo = MakeShareable( NewSessionInfo );
+
+		FNamedOnlineSession* Session = AddNamedSession( SessionName, JoinedSession );
+		check( Session != nullptr );
+
+		SetSessionState( *Session, EOnlineSessionState::Pending );
+		Session->HostingPlayerNum = PlayerNum;
+		Session->LocalOwnerId = PlayerId;
+
+		NotifyJoinSessionComplete( SessionName, EOnJoinSessionCompleteResult::Success );
+		return true;
+	}
+
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	// The backend needs the details handle that came with the search result.
+	if( SearchSessionInfo == nullptr || SearchSessionInfo->SessionDetails.IsValid() == false || SessionsHandle == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot join session '%s': %s" ), *SessionName.ToString(), SessionsHandle == nullptr ? TEXT( "EOS Sessions are not available." ) : TEXT( "not an EOS search result." ) );
+		NotifyJoinSessionComplete( SessionName, EOnJoinSessionCompleteResult::SessionDoesNotExist );
+		return false;
+	}
+
+	FOnlineSessionInfoEOS* NewSessionInfo = new FOnlineSessionInfoEOS( EEOSSession::AdvertisedSessionClient, SearchSessionInfo->SessionId );
+	NewSessionInfo->CopyConnectionInfo( *SearchSessionInfo );
+	NewSessionInfo->SessionDetails = SearchSessionInfo->SessionDetails;
+
+	FOnlineSession JoinedSession = DesiredSession.Session;
+	JoinedSession.SessionInfo = MakeShareable( NewSessionInfo );
+
+	FNamedOnlineSession* Session = AddNamedSession( SessionName, JoinedSession );
+	check( Session != nullptr );
+
+	// Creating until the backend confirms the join, as with hosted sessions.
+	SetSessionState( *Session, EOnlineSessionState::Creating );
+	Session->HostingPlayerNum = PlayerNum;
+	Session->LocalOwnerId = PlayerId;
+
+	StartJoinQos( SessionName, DesiredSession );
+
+	FEOSScratchArena Arena;
+
+	EOS_Sessions_JoinSessionOptions JoinOptions;
+	JoinOptions.ApiVersion = EOS_SESSIONS_JOINSESSION_API_LATEST;
+	JoinOptions.SessionName = Arena.ToUTF8( SessionName.ToString() );
+	JoinOptions.SessionHandle = SearchSessionInfo->SessionDetails->GetHandle();
+	JoinOptions.LocalUserId = ProductUserId;
+	JoinOptions.bPresenceEnabled = DesiredSession.Session.SessionSettings.bUsesPresence ? EOS_TRUE : EOS_FALSE;
+
+	FSessionRequestContext* RequestContext = new FSessionRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+
+	EOS_Sessions_JoinSession( SessionsHandle, &JoinOptions, RequestContext, JoinSessionCompleteCallback );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::FindFriendSession( int32 LocalUserNum, const FUniqueNetId& Friend )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+	TSharedPtr<const FUniqueNetId> LocalUserId = Identity.IsValid() ? Identity->GetUniquePlayerId( LocalUserNum ) : nullptr;
+
+	if( LocalUserId.IsValid() == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot find friend sessions: Local User %d is not logged in." ), LocalUserNum );
+		TriggerOnFindFriendSessionCompleteDelegates( LocalUserNum, false, TArray<FOnlineSessionSearchResult>() );
+		return false;
+	}
+
+	return FindFriendSession( *LocalUserId, Friend );
+}
+
+bool FOnlineSessionEOS::FindFriendSession( const FUniqueNetId& LocalUserId, const FUniqueNetId& Friend )
+{
+	TArray<TSharedRef<const FUniqueNetId>> FriendList;
+	FriendList.Add( Friend.AsShared() );
+
+	return FindFriendSession( LocalUserId, FriendList );
+}
+
+bool FOnlineSessionEOS::FindFriendSession( const FUniqueNetId& LocalUserId, const TArray<TSharedRef<const FUniqueNetId>>& FriendList )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	int32 LocalUserNum = INDEX_NONE;
+	for( int32 UserNum = 0; Identity.IsValid() && UserNum < MAX_LOCAL_PLAYERS; ++UserNum )
+	{
+		TSharedPtr<const FUniqueNetId> UserId = Identity->GetUniquePlayerId( UserNum );
+		if( UserId.IsValid() && *UserId == LocalUserId )
+		{
+			LocalUserNum = UserNum;
+			break;
+		}
+	}
+
+	EOS_ProductUserId ProductUserId = ( LocalUserNum != INDEX_NONE ) ? Identity->GetProductUserId( LocalUserNum ) : nullptr;
+
+	if( ProductUserId == nullptr || GetSessionsHandle() == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot find friend sessions: %s" ), ProductUserId == nullptr ? TEXT( "no Local User." ) : TEXT( "EOS Sessions are not available." ) );
+		TriggerOnFindFriendSessionCompleteDelegates( FMath::Max( LocalUserNum, 0 ), false, TArray<FOnlineSessionSearchResult>() );
+		return false;
+	}
+
+	const uint32 FriendSearchId = NextFriendSearchId++;
+
+	FFriendSessionSearch& FriendSearch = FriendSessionSearches.Add( FriendSearchId );
+	FriendSearch.LocalUserNum = LocalUserNum;
+	FriendSearch.LocalUserId = ProductUserId;
+
+	// Friends already known are searched for straight away, while the rest are looked up.
+	TSet<FString> Seen;
+	TArray<TSharedRef<const FUniqueNetId>> Unresolved;
+
+	for( const TSharedRef<const FUniqueNetId>& Friend : FriendList )
+	{
+		bool bIsDuplicate = false;
+		Seen.Add( Friend->ToString(), &bIsDuplicate );
+
+		if( bIsDuplicate == true )
+		{
+			continue;
+		}
+
+		if( Identity->GetProductUserId( *Friend ) != nullptr )
+		{
+			FriendSearch.ReadyFriends.Add( Friend );
+		}
+		else
+		{
+			Unresolved.Add( Friend );
+		}
+	}
+
+	FriendSearch.NumResolving = Unresolved.Num();
+
+	// The lookups may complete after this interface is gone.
+	TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> WeakThis( AsShared() );
+
+	for( int32 ChunkStart = 0; ChunkStart < Unresolved.Num(); ChunkStart += EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS )
+	{
+		TArray<TSharedRef<const FUniqueNetId>> Chunk;
+		Chunk.Append( Unresolved.GetData() + ChunkStart, FMath::Min( (int32)EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS, Unresolved.Num() - ChunkStart ) );
+
+		Identity->QueryProductUserIds( Chunk, [WeakThis, FriendSearchId, Chunk]( bool bWasSuccessful )
+		{
+			TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> StrongThis = WeakThis.Pin();
+
+			if( StrongThis.IsValid() )
+			{
+				StrongThis->HandleResolveFriendsComplete( FriendSearchId, Chunk );
+			}
+		} );
+	}
+
+	PumpFriendSessionSearch( FriendSearchId );
+
+	return true;
+}
+
+void FOnlineSessionEOS::HandleResolveFriendsComplete( uint32 FriendSearchId, const TArray<TSharedRef<const FUniqueNetId>>& Friends )
+{
+	FFriendSessionSearch* PendingSearch = FriendSessionSearches.Find( FriendSearchId );
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	if( PendingSearch == nullptr || Identity.IsValid() == false )
+	{
+		return;
+	}
+
+	PendingSearch->NumResolving -= Friends.Num();
+
+	// Friends without a Product User have never played, so are in no session.
+	for( const TSharedRef<const FUniqueNetId>& Friend : Friends )
+	{
+		if( Identity->GetProductUserId( *Friend ) != nullptr )
+		{
+			PendingSearch->ReadyFriends.Add( Friend );
+		}
+	}
+
+	PumpFriendSessionSearch( FriendSearchId );
+}
+
+void FOnlineSessionEOS::PumpFriendSessionSearch( uint32 FriendSearchId )
+{
+	FFriendSessionSearch* FriendSearch = FriendSessionSearches.Find( FriendSearchId );
+
+	if( FriendSearch == nullptr )
+	{
+		return;
+	}
+
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	// Friends are searched for in the order given, so the top of a list fills in first.
+	int32 NumStarted = 0;
+
+	while( FriendSearch->NumInFlight < FriendSearchConcurrency && NumStarted < FriendSearch->ReadyFriends.Num() )
+	{
+		const TSharedRef<const FUniqueNetId> Friend = FriendSearch->ReadyFriends[NumStarted++];
+		EOS_ProductUserId FriendUserId = Identity.IsValid() ? Identity->GetProductUserId( *Friend ) : nullptr;
+
+		if( FriendUserId == nullptr )
+		{
+			continue;
+		}
+
+		FriendSearch->NumSearched++;
+
+		if( StartFriendSessionSearch( FriendSearchId, *FriendSearch, Friend, FriendUserId ) == true )
+		{
+			FriendSearch->NumInFlight++;
+		}
+	}
+
+	FriendSearch->ReadyFriends.RemoveAt( 0, NumStarted );
+
+	if( FriendSearch->NumInFlight > 0 || FriendSearch->NumResolving > 0 || FriendSearch->ReadyFriends.Num() > 0 )
+	{
+		return;
+	}
+
+	FFriendSessionSearch Completed;
+	FriendSessionSearches.RemoveAndCopyValue( FriendSearchId, Completed );
+
+	// No friends to search, or none that ever played, is no session found rather than a failure.
+	TriggerOnFindFriendSessionCompleteDelegates( Completed.LocalUserNum, Completed.bAnySucceeded == true || Completed.NumSearched == 0, Completed.Results );
+}
+
+bool FOnlineSessionEOS::StartFriendSessionSearch( uint32 FriendSearchId, FFriendSessionSearch& FriendSearch, const TSharedRef<const FUniqueNetId>& Friend, EOS_ProductUserId FriendUserId )
+{
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	if( SessionsHandle == nullptr )
+	{
+		return false;
+	}
+
+	// A friend is rarely in more than a couple of sessions at once.
+	EOS_Sessions_CreateSessionSearchOptions SearchOptions;
+	SearchOptions.ApiVersion = EOS_SESSIONS_CREATESESSIONSEARCH_API_LATEST;
+	SearchOptions.MaxSearchResults = 4;
+
+	EOS_HSessionSearch SearchHandle = nullptr;
+	EOS_EResult Result = EOS_Sessions_CreateSessionSearch( SessionsHandle, &SearchOptions, &SearchHandle );
+
+	if( Result == EOS_EResult::EOS_Success )
+	{
+		EOS_SessionSearch_SetTargetUserIdOptions TargetOptions;
+		TargetOptions.ApiVersion = EOS_SESSIONSEARCH_SETTARGETUSERID_API_LATEST;
+		TargetOptions.TargetUserId = FriendUserId;
+		Result = EOS_SessionSearch_SetTargetUserId( SearchHandle, &TargetOptions );
+	}
+
+	if( Result != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot search for sessions of %s: %s" ), *Friend->ToString(), *UEOSCommon::EOSResultToString( Result ) );
+
+		if( SearchHandle != nullptr )
+		{
+			EOS_SessionSearch_Release( SearchHandle );
+		}
+
+		return false;
+	}
+
+	EOS_SessionSearch_FindOptions FindOptions;
+	FindOptions.ApiVersion = EOS_SESSIONSEARCH_FIND_API_LATEST;
+	FindOptions.LocalUserId = FriendSearch.LocalUserId;
+
+	FFriendSearchContext* SearchContext = new FFriendSearchContext();
+	SearchContext->SessionInterface = AsShared();
+	SearchContext->FriendSearchId = FriendSearchId;
+	SearchContext->SearchHandle = SearchHandle;
+	SearchContext->Friend = Friend;
+
+	EOS_SessionSearch_Find( SearchHandle, &FindOptions, SearchContext, FindFriendSessionCompleteCallback );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::SendSessionInviteToFriend( int32 LocalUserNum, FName SessionName, const FUniqueNetId& Friend )
+{
+	TArray<TSharedRef<const FUniqueNetId>> Friends;
+	Friends.Add( Friend.AsShared() );
+
+	return SendSessionInviteToFriends( LocalUserNum, SessionName, Friends );
+}
+
+bool FOnlineSessionEOS::SendSessionInviteToFriend( const FUniqueNetId& LocalUserId, FName SessionName, const FUniqueNetId& Friend )
+{
+	TArray<TSharedRef<const FUniqueNetId>> Friends;
+	Friends.Add( Friend.AsShared() );
+
+	return SendSessionInviteToFriends( LocalUserId, SessionName, Friends );
+}
+
+bool FOnlineSessionEOS::SendSessionInviteToFriends( int32 LocalUserNum, FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Friends )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	return SendSessionInvitesInternal( Identity.IsValid() ? Identity->GetUniquePlayerId( LocalUserNum ) : nullptr, SessionName, Friends );
+}
+
+bool FOnlineSessionEOS::SendSessionInviteToFriends( const FUniqueNetId& LocalUserId, FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Friends )
+{
+	return SendSessionInvitesInternal( LocalUserId.AsShared(), SessionName, Friends );
+}
+
+bool FOnlineSessionEOS::SendSessionInvitesInternal( const TSharedPtr<const FUniqueNetId>& LocalUserId, FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Friends )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	if( LocalUserId.IsValid() == false || Identity.IsValid() == false || Identity->GetProductUserId( *LocalUserId ) == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot invite friends to session '%s': no Local User." ), *SessionName.ToString() );
+		return false;
+	}
+
+	const FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	const FOnlineSessionInfoEOS* SessionInfo = Session != nullptr ? static_cast<const FOnlineSessionInfoEOS*>( Session->SessionInfo.Get() ) : nullptr;
+
+	if( SessionInfo == nullptr || SessionInfo->SessionType == EEOSSession::LANSession )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot invite friends to session '%s': %s" ), *SessionName.ToString(), SessionInfo == nullptr ? TEXT( "session does not exist." ) : TEXT( "LAN sessions have no invites." ) );
+		return false;
+	}
+
+	if( Friends.Num() == 0 )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot invite friends to session '%s': no friends given." ), *SessionName.ToString() );
+		return false;
+	}
+
+	// Invites are addressed to Product Users, so any not known yet are looked up before the batch is queued.
+	TArray<TSharedRef<const FUniqueNetId>> Unresolved;
+
+	for( const TSharedRef<const FUniqueNetId>& Friend : Friends )
+	{
+		if( Identity->GetProductUserId( *Friend ) == nullptr )
+		{
+			Unresolved.Add( Friend );
+		}
+	}
+
+	const TSharedRef<const FUniqueNetId> InvitingUserId = LocalUserId.ToSharedRef();
+
+	if( Unresolved.Num() == 0 )
+	{
+		InviteQueue.Enqueue( SessionName, InvitingUserId, Friends, FPlatformTime::Seconds() );
+		return true;
+	}
+
+	TSharedRef<int32> NumQueriesLeft = MakeShared<int32>( FMath::DivideAndRoundUp( Unresolved.Num(), (int32)EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS ) );
+	TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> WeakThis( AsShared() );
+
+	for( int32 ChunkStart = 0; ChunkStart < Unresolved.Num(); ChunkStart += EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS )
+	{
+		TArray<TSharedRef<const FUniqueNetId>> Chunk;
+		Chunk.Append( Unresolved.GetData() + ChunkStart, FMath::Min( (int32)EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS, Unresolved.Num() - ChunkStart ) );
+
+		// Friends still unknown afterwards fail when their invite is sent, and are reported with the rest.
+		Identity->QueryProductUserIds( Chunk, [WeakThis, SessionName, InvitingUserId, Friends, NumQueriesLeft]( bool bWasSuccessful )
+		{
+			TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> StrongThis = WeakThis.Pin();
+
+			if( --( *NumQueriesLeft ) == 0 && StrongThis.IsValid() )
+			{
+				StrongThis->InviteQueue.Enqueue( SessionName, InvitingUserId, Friends, FPlatformTime::Seconds() );
+			}
+		} );
+	}
+
+	return true;
+}
+
+void FOnlineSessionEOS::FlushSessionInvites()
+{
+	TArray<FSessionInviteQueueEOS::FInvite> Ready;
+
+	// Invites wait for the backend to have the session, and go out in the order they were queued.
+	InviteQueue.TakeReady( FPlatformTime::Seconds(), [this]( FName SessionName )
+	{
+		return GetSessionState( SessionName ) != EOnlineSessionState::Creating;
+	}, Ready );
+
+	TArray<FSessionInviteBatchResultEOS> Completed;
+
+	for( const FSessionInviteQueueEOS::FInvite& Invite : Ready )
+	{
+		if( SendSessionInvite( Invite ) == false )
+		{
+			InviteQueue.Complete( Invite.Key, false, Completed );
+		}
+	}
+
+	ReportSessionInvites( Completed );
+}
+
+bool FOnlineSessionEOS::SendSessionInvite( const FSessionInviteQueueEOS::FInvite& Invite )
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	const EOS_ProductUserId LocalUserId = Identity.IsValid() ? Identity->GetProductUserId( *Invite.LocalUserId ) : nullptr;
+	const EOS_ProductUserId TargetUserId = Identity.IsValid() ? Identity->GetProductUserId( *Invite.Friend ) : nullptr;
+
+	const FNamedOnlineSession* Session = GetNamedSession( Invite.SessionName );
+	const FOnlineSessionInfoEOS* SessionInfo = Session != nullptr ? static_cast<const FOnlineSessionInfoEOS*>( Session->SessionInfo.Get() ) : nullptr;
+
+	if( SessionInfo == nullptr || LocalUserId == nullptr || TargetUserId == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot invite %s to session '%s': %s" ), *Invite.Friend->ToString(), *Invite.SessionName.ToString(),
+							   SessionInfo == nullptr ? TEXT( "session no longer exists." ) : TEXT( "no Product User." ) );
+		return false;
+	}
+
+	FSessionInviteContext* RequestContext = new FSessionInviteContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->InviteKey = Invite.Key;
+
+	FEOSScratchArena Arena;
+
+	if( SessionInfo->SessionType == EEOSSession::LobbySession )
+	{
+		EOS_HLobby LobbyHandle = GetLobbyHandle();
+		const FLobbyState* LobbyState = LobbyStates.Find( Invite.SessionName );
+
+		if( LobbyHandle == nullptr || LobbyState == nullptr || LobbyState->LobbyId.IsEmpty() )
+		{
+			delete RequestContext;
+			return false;
+		}
+
+		EOS_Lobby_SendInviteOptions InviteOptions;
+		InviteOptions.ApiVersion = EOS_LOBBY_SENDINVITE_API_LATEST;
+		InviteOptions.LobbyId = Arena.ToUTF8( LobbyState->LobbyId );
+		InviteOptions.LocalUserId = LocalUserId;
+		InviteOptions.TargetUserId = TargetUserId;
+
+		EOS_Lobby_SendInvite( LobbyHandle, &InviteOptions, RequestContext, SendLobbyInviteCompleteCallback );
+		return true;
+	}
+
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	if( SessionsHandle == nullptr )
+	{
+		delete RequestContext;
+		return false;
+	}
+
+	EOS_Sessions_SendInviteOptions InviteOptions;
+	InviteOptions.ApiVersion = EOS_SESSIONS_SENDINVITE_API_LATEST;
+	InviteOptions.SessionName = Arena.ToUTF8( Invite.SessionName.ToString() );
+	InviteOptions.LocalUserId = LocalUserId;
+	InviteOptions.TargetUserId = TargetUserId;
+
+	EOS_Sessions_SendInvite( SessionsHandle, &InviteOptions, RequestContext, SendInviteCompleteCallback );
+	return true;
+}
+
+void FOnlineSessionEOS::HandleSendInviteComplete( const FString& InviteKey, EOS_EResult ResultCode )
+{
+	TArray<FSessionInviteBatchResultEOS> Completed;
+
+	switch( ResultCode )
+	{
+	case EOS_EResult::EOS_Success:
+		InviteQueue.Complete( InviteKey, true, Completed );
+		break;
+
+	// Sent too fast. The invite is tried again once the queue has backed off.
+	case EOS_EResult::EOS_TooManyRequests:
+	case EOS_EResult::EOS_Sessions_TooManyInvites:
+	case EOS_EResult::EOS_Lobby_TooManyInvites:
+		UE_LOG_ONLINE_SESSION( Log, TEXT( "Invite %s throttled: %s" ), *InviteKey, *UEOSCommon::EOSResultToString( ResultCode ) );
+		InviteQueue.Throttle( InviteKey, FPlatformTime::Seconds(), Completed );
+		break;
+
+	default:
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Invite %s failed: %s" ), *InviteKey, *UEOSCommon::EOSResultToString( ResultCode ) );
+		InviteQueue.Complete( InviteKey, false, Completed );
+		break;
+	}
+
+	ReportSessionInvites( Completed );
+}
+
+void FOnlineSessionEOS::ReportSessionInvites( const TArray<FSessionInviteBatchResultEOS>& Completed )
+{
+	for( const FSessionInviteBatchResultEOS& Result : Completed )
+	{
+		OnSendSessionInvitesComplete.Broadcast( *Result.LocalUserId, Result.SessionName, Result.Sent, Result.Failed );
+	}
+}
+
+bool FOnlineSessionEOS::GetResolvedConnectString( FName SessionName, FString& ConnectInfo, FName PortType )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	FOnlineSessionInfoEOS* SessionInfo = Session != nullptr ? static_cast<FOnlineSessionInfoEOS*>( Session->SessionInfo.Get() ) : nullptr;
+
+	if( SessionInfo == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Unknown session name (%s) specified to GetResolvedConnectString()" ), *SessionName.ToString() );
+		return false;
+	}
+
+	return ResolveConnectString( *SessionInfo, Session->SessionSettings, PortType, ConnectInfo );
+}
+
+bool FOnlineSessionEOS::GetResolvedConnectString( const FOnlineSessionSearchResult& SearchResult, FName PortType, FString& ConnectInfo )
+{
+	// Cached on the result's session info, which every copy of the result shares.
+	FOnlineSessionInfoEOS* SessionInfo = static_cast<FOnlineSessionInfoEOS*>( SearchResult.Session.SessionInfo.Get() );
+
+	if( SessionInfo == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Invalid session info in search result to GetResolvedConnectString()" ) );
+		return false;
+	}
+
+	return ResolveConnectString( *SessionInfo, SearchResult.Session.SessionSettings, PortType, ConnectInfo );
+}
+
+FOnlineSessionSettings* FOnlineSessionEOS::GetSessionSettings( FName SessionName )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	return ( Session != nullptr ) ? &Session->SessionSettings : nullptr;
+}
+
+bool FOnlineSessionEOS::RegisterPlayer( FName SessionName, const FUniqueNetId& PlayerId, bool bWasInvited )
+{
+	TArray< TSharedRef<const FUniqueNetId> > Players;
+	Players.Add( PlayerId.AsShared() );
+
+	return RegisterPlayers( SessionName, Players, bWasInvited );
+}
+
+bool FOnlineSessionEOS::RegisterPlayers( FName SessionName, const TArray< TSharedRef<const FUniqueNetId> >& Players, bool bWasInvited )
+{
+	return QueuePlayerRegistrations( SessionName, Players, true );
+}
+
+bool FOnlineSessionEOS::UnregisterPlayer( FName SessionName, const FUniqueNetId& PlayerId )
+{
+	TArray< TSharedRef<const FUniqueNetId> > Players;
+	Players.Add( PlayerId.AsShared() );
+
+	return UnregisterPlayers( SessionName, Players );
+}
+
+bool FOnlineSessionEOS::UnregisterPlayers( FName SessionName, const TArray< TSharedRef<const FUniqueNetId> >& Players )
+{
+	return QueuePlayerRegistrations( SessionName, Players, false );
+}
+
+bool FOnlineSessionEOS::QueuePlayerRegistrations( FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Players, bool bRegister )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	FRegistrationCall Call;
+	Call.Players = Players;
+	Call.bRegister = bRegister;
+	Call.NumWaiting = 0;
+	Call.bWasSuccessful = true;
+
+	if( Session == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "No game present to %s players in session '%s'." ), bRegister ? TEXT( "register" ) : TEXT( "unregister" ), *SessionName.ToString() );
+
+		Call.bWasSuccessful = false;
+		ReportRegistrationCalls( SessionName, { Call } );
+		return false;
+	}
+
+	// The local session is updated straight away, only the backend has to wait for the next flush.
+	for( const TSharedRef<const FUniqueNetId>& Player : Players )
+	{
+		UpdateRegisteredPlayer( *Session, Player, bRegister );
+	}
+
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+
+	if( UpdateState == nullptr )
+	{
+		// Nothing to wait on, the local session is all there is.
+		ReportRegistrationCalls( SessionName, { Call } );
+		return true;
+	}
+
+	const uint32 CallId = UpdateState->NextRegistrationCallId++;
+	TArray<FRegistrationCall> Superseded;
+
+	for( const TSharedRef<const FUniqueNetId>& Player : Players )
+	{
+		const FString PlayerKey = Player->ToString();
+		TArray<uint32> CancelledCallIds;
+
+		// A change that undoes a pending one means the backend already has it right, for this call and the one it undoes.
+		TMap<FString, TSharedRef<const FUniqueNetId>>& Undone = bRegister ? UpdateState->PendingUnregistrations : UpdateState->PendingRegistrations;
+		TMap<FString, TSharedRef<const FUniqueNetId>>& ToSend = bRegister ? UpdateState->PendingRegistrations : UpdateState->PendingUnregistrations;
+
+		if( Undone.Remove( PlayerKey ) > 0 )
+		{
+			UpdateState->PendingCalls.RemoveAndCopyValue( PlayerKey, CancelledCallIds );
+			SettleRegistrationCalls( *UpdateState, CancelledCallIds, true, Superseded );
+		}
+		else if( UpdateState->BackendPlayers.Contains( PlayerKey ) != bRegister )
+		{
+			ToSend.Add( PlayerKey, Player );
+			UpdateState->PendingCalls.FindOrAdd( PlayerKey ).Add( CallId );
+			Call.NumWaiting++;
+		}
+		else if( TArray<uint32>* InFlight = UpdateState->InFlightCalls.Find( PlayerKey ) )
+		{
+			// The same change is already in flight, and this call is only done once it is.
+			InFlight->Add( CallId );
+			Call.NumWaiting++;
+		}
+	}
+
+	if( Call.NumWaiting > 0 )
+	{
+		UpdateState->RegistrationCalls.Add( CallId, MoveTemp( Call ) );
+		MarkSessionDirty( SessionName );
+	}
+	else
+	{
+		Superseded.Add( MoveTemp( Call ) );
+	}
+
+	ReportRegistrationCalls( SessionName, Superseded );
+	return true;
+}
+
+void FOnlineSessionEOS::UpdateRegisteredPlayer( FNamedOnlineSession& Session, const TSharedRef<const FUniqueNetId>& Player, bool bRegister )
+{
+	const int32 PlayerIdx = Session.RegisteredPlayers.IndexOfByPredicate( [&Player]( const TSharedRef<const FUniqueNetId>& RegisteredPlayer )
+	{
+		return *RegisteredPlayer == *Player;
+	} );
+
+	if( bRegister == true && PlayerIdx == INDEX_NONE )
+	{
+		Session.RegisteredPlayers.Add( Player );
+
+		if( Session.NumOpenPublicConnections > 0 )
+		{
+			Session.NumOpenPublicConnections--;
+		}
+		else if( Session.NumOpenPrivateConnections > 0 )
+		{
+			Session.NumOpenPrivateConnections--;
+		}
+	}
+	else if( bRegister == false && PlayerIdx != INDEX_NONE )
+	{
+		Session.RegisteredPlayers.RemoveAtSwap( PlayerIdx );
+
+		if( Session.NumOpenPublicConnections < Session.SessionSettings.NumPublicConnections )
+		{
+			Session.NumOpenPublicConnections++;
+		}
+		else if( Session.NumOpenPrivateConnections < Session.SessionSettings.NumPrivateConnections )
+		{
+			Session.NumOpenPrivateConnections++;
+		}
+	}
+}
+
+void FOnlineSessionEOS::SettleRegistrationCalls( FSessionUpdateState& UpdateState, const TArray<uint32>& CallIds, bool bWasSuccessful, TArray<FRegistrationCall>& OutCompleted )
+{
+	for( const uint32 CallId : CallIds )
+	{
+		FRegistrationCall* Call = UpdateState.RegistrationCalls.Find( CallId );
+
+		if( Call == nullptr )
+		{
+			continue;
+		}
+
+		Call->bWasSuccessful = Call->bWasSuccessful && bWasSuccessful;
+
+		if( --Call->NumWaiting <= 0 )
+		{
+			OutCompleted.Add( MoveTemp( *Call ) );
+			UpdateState.RegistrationCalls.Remove( CallId );
+		}
+	}
+}
+
+void FOnlineSessionEOS::MoveCallsInFlight( FSessionUpdateState& UpdateState, const FString& PlayerKey )
+{
+	TArray<uint32> CallIds;
+
+	if( UpdateState.PendingCalls.RemoveAndCopyValue( PlayerKey, CallIds ) )
+	{
+		UpdateState.InFlightCalls.FindOrAdd( PlayerKey ).Append( CallIds );
+	}
+}
+
+void FOnlineSessionEOS::ReportRegistrationCalls( FName SessionName, const TArray<FRegistrationCall>& Completed )
+{
+	for( const FRegistrationCall& Call : Completed )
+	{
+		if( Call.bRegister == true )
+		{
+			TriggerOnRegisterPlayersCompleteDelegates( SessionName, Call.Players, Call.bWasSuccessful );
+		}
+		else
+		{
+			TriggerOnUnregisterPlayersCompleteDelegates( SessionName, Call.Players, Call.bWasSuccessful );
+		}
+	}
+}
+
+void FOnlineSessionEOS::RemoveSessionUpdateState( FName SessionName )
+{
+	FSessionUpdateState UpdateState;
+
+	if( SessionUpdateStates.RemoveAndCopyValue( SessionName, UpdateState ) == false )
+	{
+		return;
+	}
+
+	TArray<FRegistrationCall> Failed;
+
+	for( TPair<uint32, FRegistrationCall>& Entry : UpdateState.RegistrationCalls )
+	{
+		Entry.Value.bWasSuccessful = false;
+		Failed.Add( MoveTemp( Entry.Value ) );
+	}
+
+	ReportRegistrationCalls( SessionName, Failed );
+}
+
+void FOnlineSessionEOS::RegisterLocalPlayer( const FUniqueNetId& PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate& Delegate )
+{
+
+}
+
+void FOnlineSessionEOS::UnregisterLocalPlayer( const FUniqueNetId& PlayerId, FName SessionName, const FOnUnregisterLocalPlayerCompleteDelegate& Delegate )
+{
+
+}
+
+int32 FOnlineSessionEOS::GetNumSessions()
+{
+	return Sessions.Num();
+}
+
+void FOnlineSessionEOS::DumpSessionState()
+{
+	UE_LOG_ONLINE_SESSION( Log, TEXT( "EOS Sessions: %d" ), Sessions.Num() );
+
+	for( const TPair<FName, TUniquePtr<FNamedOnlineSession>>& Entry : Sessions )
+	{
+		const FNamedOnlineSession& Session = *Entry.Value;
+		const FOnlineSessionInfoEOS* SessionInfo = static_cast<const FOnlineSessionInfoEOS*>( Session.SessionInfo.Get() );
+
+		UE_LOG_ONLINE_SESSION( Log, TEXT( "  Session: %s | Id: %s | Type: %s | State: %s | Hosting: %s | Players: %d/%d | Connection: %s" ),
+							   *Session.SessionName.ToString(),
+							   SessionInfo != nullptr ? *SessionInfo->SessionId.ToString() : TEXT( "None" ),
+							   SessionInfo != nullptr ? EEOSSession::ToString( SessionInfo->SessionType ) : TEXT( "None" ),
+							   EOnlineSessionState::ToString( Session.SessionState ),
+							   Session.bHosting ? TEXT( "true" ) : TEXT( "false" ),
+							   Session.RegisteredPlayers.Num(), Session.SessionSettings.NumPublicConnections + Session.SessionSettings.NumPrivateConnections,
+							   SessionInfo != nullptr ? *LexToString( SessionInfo->ConnectionMethod ) : TEXT( "None" ) );
+
+		if( const FSessionTraceEOS* Trace = SessionTracer.Find( Session.SessionName ) )
+		{
+			UE_LOG_ONLINE_SESSION( Log, TEXT( "    Trace: %s" ), *Trace->ToString() );
+		}
+
+		if( const FSessionUpdateState* UpdateState = SessionUpdateStates.Find( Session.SessionName ) )
+		{
+			const FSessionHostStatsEOS& Stats = UpdateState->Stats;
+
+			UE_LOG_ONLINE_SESSION( Log, TEXT( "    Host: Writes: %d (%d skipped, %d updates merged) | Registrations: %d | Start/End: %d | Failed: %d | Memory: %llu bytes" ),
+								   Stats.NumWrites, Stats.NumWritesSkipped, Stats.NumUpdatesMerged, Stats.NumRegistrationRequests, Stats.NumStateRequests,
+								   Stats.NumFailedRequests, (unsigned long long)GetHostAllocatedSize( Session, *UpdateState ) );
+		}
+	}
+
+	UE_LOG_ONLINE_SESSION( Log, TEXT( "EOS Sessions: %d hosted, %d waiting to be flushed" ), SessionUpdateStates.Num(), DirtySessions.Num() );
+
+	UE_LOG_ONLINE_SESSION( Log, TEXT( "EOS Sessions: Rejoin ticket: %s | Rejoins: %llu (%d failed) | Mean: %.1fms | Last: %.1fms" ),
+						   RejoinTicket.IsSet() ? *RejoinTicket->SessionName.ToString() : TEXT( "None" ), (unsigned long long)RejoinStats.Latencies.GetCount(), RejoinStats.NumFailed,
+						   RejoinStats.Latencies.GetMeanSeconds() * 1000.0, RejoinStats.LastSeconds * 1000.0 );
+
+	const FSessionQuickJoinStatsEOS& QuickJoinStats = QuickJoinPool.GetStats();
+	UE_LOG_ONLINE_SESSION( Log, TEXT( "EOS Sessions: Quick join: %s, %d candidates | Hit rate: %.1f%% | Mean age: %.1fs | Refreshes: %llu (%llu failed) | Pruned: %llu" ),
+						   QuickJoinSearch.IsValid() ? TEXT( "running" ) : TEXT( "stopped" ), QuickJoinPool.Num(), QuickJoinStats.GetHitRate() * 100.0f,
+						   QuickJoinStats.GetMeanServedAgeSeconds(), (unsigned long long)QuickJoinStats.NumRefreshes, (unsigned long long)QuickJoinStats.NumFailedRefreshes,
+						   (unsigned long long)QuickJoinStats.NumPruned );
+
+	const TArray<FSessionTraceEOS>& RecentTraces = SessionTracer.GetRecentTraces();
+	UE_LOG_ONLINE_SESSION( Log, TEXT( "EOS Sessions: %d recently removed" ), RecentTraces.Num() );
+
+	for( const FSessionTraceEOS& Trace : RecentTraces )
+	{
+		UE_LOG_ONLINE_SESSION( Log, TEXT( "  Session: %s | Id: %s" ), *Trace.SessionName.ToString(), Trace.SessionId.IsEmpty() ? TEXT( "None" ) : *Trace.SessionId );
+		UE_LOG_ONLINE_SESSION( Log, TEXT( "    Trace: %s" ), *Trace.ToString() );
+	}
+
+	// Across every session traced, so one slow backend step stands out from the rest.
+	UE_LOG_ONLINE_SESSION( Log, TEXT( "EOS Sessions: Transition latencies" ) );
+
+	for( const TPair<FString, FSessionLatencyHistogramEOS>& Histogram : SessionTracer.GetHistograms() )
+	{
+		const FSessionLatencyHistogramEOS& Latencies = Histogram.Value;
+
+		UE_LOG_ONLINE_SESSION( Log, TEXT( "  %s | Count: %llu | Mean: %.1fms | P50: %.1fms | P90: %.1fms | P99: %.1fms | Max: %.1fms" ),
+							   *Histogram.Key, (unsigned long long)Latencies.GetCount(), Latencies.GetMeanSeconds() * 1000.0,
+							   Latencies.GetPercentileSeconds( 50.0 ) * 1000.0, Latencies.GetPercentileSeconds( 90.0 ) * 1000.0,
+							   Latencies.GetPercentileSeconds( 99.0 ) * 1000.0, Latencies.GetMaxSeconds() * 1000.0 );
+		UE_LOG_ONLINE_SESSION( Log, TEXT( "    %s" ), *Latencies.BucketsToString() );
+	}
+}
+
+void FOnlineSessionEOS::Tick( float DeltaTime )
+{
+	if( QosProber.IsValid() )
+	{
+		QosProber->Tick();
+	}
+
+	if( Matchmakers.Num() > 0 )
+	{
+		// By name, as matchmakers complete through delegates that may start or cancel matchmaking.
+		TArray<FName, TInlineAllocator<4>> MatchmakingSessions;
+		Matchmakers.GetKeys( MatchmakingSessions );
+
+		const double Now = FPlatformTime::Seconds();
+
+		for( const FName& SessionName : MatchmakingSessions )
+		{
+			if( TUniquePtr<FSessionMatchmakerEOS>* Matchmaker = Matchmakers.Find( SessionName ) )
+			{
+				( *Matchmaker )->Tick( Now );
+			}
+		}
+
+		for( const FName& SessionName : MatchmakingSessions )
+		{
+			TUniquePtr<FSessionMatchmakerEOS>* Matchmaker = Matchmakers.Find( SessionName );
+
+			if( Matchmaker == nullptr || ( *Matchmaker )->IsComplete() == false )
+			{
+				continue;
+			}
+
+			const EMatchmakingResultEOS Result = ( *Matchmaker )->GetResult();
+			Matchmakers.Remove( SessionName );
+
+			if( Result == EMatchmakingResultEOS::Cancelled )
+			{
+				TriggerOnCancelMatchmakingCompleteDelegates( SessionName, true );
+			}
+			else
+			{
+				TriggerOnMatchmakingCompleteDelegates( SessionName, Result == EMatchmakingResultEOS::Joined || Result == EMatchmakingResultEOS::Created );
+			}
+		}
+	}
+
+	if( CurrentSessionSearch.IsValid() && bSearchFindInFlight == false )
+	{
+		CopySearchResults( SearchResultsPerTick );
+	}
+
+	if( InviteQueue.HasQueued() )
+	{
+		FlushSessionInvites();
+	}
+
+	// Completions normally run the queued calls themselves. This catches sessions that became idle some other way.
+	if( QueuedSessionOps.Num() > 0 )
+	{
+		TArray<FName, TInlineAllocator<4>> QueuedSessions;
+		QueuedSessionOps.GetKeys( QueuedSessions );
+
+		for( const FName& SessionName : QueuedSessions )
+		{
+			RunQueuedSessionOps( SessionName );
+		}
+	}
+
+	if( FPlatformTime::Seconds() - LastHostSnapshotTime >= HostSnapshotInterval )
+	{
+		LastHostSnapshotTime = FPlatformTime::Seconds();
+		TakeHostSnapshots();
+	}
+
+	if( HostMigrations.Num() > 0 )
+	{
+		TickHostMigrations( FPlatformTime::Seconds() );
+	}
+
+	if( QuickJoinSearch.IsValid() )
+	{
+		TickQuickJoinPool( FPlatformTime::Seconds() );
+	}
+
+	// Every update and registration made this tick goes out together, as a handful of requests per session.
+	if( DirtySessions.Num() > 0 )
+	{
+		FlushDirtySessions();
+	}
+
+	if( LobbyStates.Num() > 0 )
+	{
+		TArray<FName, TInlineAllocator<8>> LobbiesToFlush;
+		TArray<FName, TInlineAllocator<8>> LobbiesToRead;
+
+		for( const TPair<FName, FLobbyState>& LobbyState : LobbyStates )
+		{
+			if( LobbyState.Value.NumPendingUpdates > 0 && LobbyState.Value.bUpdateInFlight == false && LobbyState.Value.LobbyId.IsEmpty() == false )
+			{
+				LobbiesToFlush.Add( LobbyState.Key );
+			}
+
+			if( LobbyState.Value.bLobbyDirty == true || LobbyState.Value.DirtyMembers.Num() > 0 )
+			{
+				LobbiesToRead.Add( LobbyState.Key );
+			}
+		}
+
+		for( const FName& SessionName : LobbiesToFlush )
+		{
+			FlushLobbyUpdate( SessionName );
+		}
+
+		// However many notifications arrived, each lobby and member is read at most once per tick.
+		for( const FName& SessionName : LobbiesToRead )
+		{
+			ApplyLobbyNotifications( SessionName );
+		}
+	}
+}
+
+bool FOnlineSessionEOS::FSessionUpdateState::HasRegistrationsToSend() const
+{
+	if( PendingUnregistrations.Num() > 0 )
+	{
+		return true;
+	}
+
+	// Players still being looked up dirty the session again once found. A lookup may also outlive the
+	// registration it was for, so the two sets can't just be counted.
+	for( const TPair<FString, TSharedRef<const FUniqueNetId>>& Pending : PendingRegistrations )
+	{
+		if( ResolvingPlayers.Contains( Pending.Key ) == false )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FOnlineSessionEOS::FSessionUpdateState::HasPendingWork() const
+{
+	return NumPendingUpdates > 0 || HasRegistrationsToSend();
+}
+
+void FOnlineSessionEOS::MarkSessionDirty( FName SessionName )
+{
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+
+	if( UpdateState != nullptr && UpdateState->bIsDirty == false )
+	{
+		UpdateState->bIsDirty = true;
+		DirtySessions.Add( SessionName );
+	}
+}
+
+void FOnlineSessionEOS::FlushDirtySessions()
+{
+	// Taken first, as completion delegates fired by a flush may dirty, add or remove sessions.
+	TArray<FName> ToFlush = MoveTemp( DirtySessions );
+	DirtySessions.Reset();
+
+	TArray<FName> Deferred;
+	int32 NumWritesLeft = SessionWritesPerTick;
+
+	for( const FName& SessionName : ToFlush )
+	{
+		FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+
+		if( UpdateState == nullptr )
+		{
+			// Destroyed since it was dirtied.
+			continue;
+		}
+
+		if( NumWritesLeft <= 0 )
+		{
+			// Still dirty, and first in line next tick.
+			Deferred.Add( SessionName );
+			continue;
+		}
+
+		UpdateState->bIsDirty = false;
+
+		if( UpdateState->NumPendingUpdates > 0 && UpdateState->bUpdateInFlight == false )
+		{
+			NumWritesLeft -= FlushSessionUpdate( SessionName ) ? 1 : 0;
+			UpdateState = SessionUpdateStates.Find( SessionName );
+		}
+
+		const bool bHasRegistrations = UpdateState != nullptr && UpdateState->HasRegistrationsToSend();
+
+		if( bHasRegistrations == true && UpdateState->NumRegistrationsInFlight == 0 && GetSessionState( SessionName ) != EOnlineSessionState::Creating )
+		{
+			NumWritesLeft -= FlushPlayerRegistrations( SessionName, NumWritesLeft );
+			UpdateState = SessionUpdateStates.Find( SessionName );
+		}
+
+		// Work waiting on a request in flight is picked up once it completes.
+		if( UpdateState != nullptr && UpdateState->HasPendingWork() )
+		{
+			MarkSessionDirty( SessionName );
+		}
+	}
+
+	DirtySessions.Insert( Deferred, 0 );
+}
+
+int32 FOnlineSessionEOS::FlushPlayerRegistrations( FName SessionName, int32 MaxRequests )
+{
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	// Players can only be registered once the backend has the session.
+	if( UpdateState == nullptr || SessionsHandle == nullptr || GetSessionState( SessionName ) == EOnlineSessionState::Creating )
+	{
+		return 0;
+	}
+
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+	if( Identity.IsValid() == false )
+	{
+		return 0;
+	}
+
+	const int32 ChunkSize = RegisterPlayersChunkSize;
+
+	FEOSLargeScratchArena Arena;
+	const char* SessionNameUTF8 = Arena.ToUTF8( SessionName.ToString() );
+
+	// Unregistrations go first, to free up room for the registrations that follow. Whatever doesn't fit in
+	// MaxRequests chunks is left pending.
+	int32 NumRequests = 0;
+	TArray<TSharedRef<const FUniqueNetId>> Unregistrations;
+
+	for( TMap<FString, TSharedRef<const FUniqueNetId>>::TIterator It( UpdateState->PendingUnregistrations ); It && Unregistrations.Num() < MaxRequests * ChunkSize; ++It )
+	{
+		Unregistrations.Add( It.Value() );
+		It.RemoveCurrent();
+	}
+
+	for( int32 ChunkStart = 0; ChunkStart < Unregistrations.Num(); ChunkStart += ChunkSize )
+	{
+		const int32 NumInChunk = FMath::Min( ChunkSize, Unregistrations.Num() - ChunkStart );
+
+		FPlayerRegistrationContext* RequestContext = new FPlayerRegistrationContext();
+		RequestContext->SessionInterface = AsShared();
+		RequestContext->SessionName = SessionName;
+		RequestContext->Players.Append( Unregistrations.GetData() + ChunkStart, NumInChunk );
+
+		for( int32 PlayerIdx = 0; PlayerIdx < NumInChunk; ++PlayerIdx )
+		{
+			const FString PlayerKey = RequestContext->Players[PlayerIdx]->ToString();
+
+			RequestContext->ProductUserIds.Add( UpdateState->BackendPlayers.FindAndRemoveChecked( PlayerKey ) );
+			MoveCallsInFlight( *UpdateState, PlayerKey );
+		}
+
+		EOS_Sessions_UnregisterPlayersOptions UnregisterOptions;
+		UnregisterOptions.ApiVersion = EOS_SESSIONS_UNREGISTERPLAYERS_API_LATEST;
+		UnregisterOptions.SessionName = SessionNameUTF8;
+		UnregisterOptions.PlayersToUnregister = RequestContext->ProductUserIds.GetData();
+		UnregisterOptions.PlayersToUnregisterCount = (uint32_t)NumInChunk;
+
+		NumRequests++;
+		UpdateState->NumRegistrationsInFlight++;
+		UpdateState->Stats.NumRegistrationRequests++;
+		EOS_Sessions_UnregisterPlayers( SessionsHandle, &UnregisterOptions, RequestContext, UnregisterPlayersCompleteCallback );
+	}
+
+	// Registrations need each player's Product User. Those not known yet are looked up, and sent on a later flush.
+	TArray<TSharedRef<const FUniqueNetId>> Registrations;
+	TArray<EOS_ProductUserId> RegistrationProductUserIds;
+	TArray<TSharedRef<const FUniqueNetId>> Unresolved;
+
+	const int32 MaxRegistrations = ( MaxRequests - NumRequests ) * ChunkSize;
+
+	for( TMap<FString, TSharedRef<const FUniqueNetId>>::TIterator It( UpdateState->PendingRegistrations ); It; ++It )
+	{
+		if( UpdateState->ResolvingPlayers.Contains( It.Key() ) )
+		{
+			continue;
+		}
+
+		EOS_ProductUserId ProductUserId = Identity->GetProductUserId( *It.Value() );
+
+		if( ProductUserId != nullptr && Registrations.Num() >= MaxRegistrations )
+		{
+			continue;
+		}
+
+		if( ProductUserId == nullptr )
+		{
+			UpdateState->ResolvingPlayers.Add( It.Key() );
+			Unresolved.Add( It.Value() );
+			continue;
+		}
+
+		UpdateState->BackendPlayers.Add( It.Key(), ProductUserId );
+		MoveCallsInFlight( *UpdateState, It.Key() );
+		Registrations.Add( It.Value() );
+		RegistrationProductUserIds.Add( ProductUserId );
+		It.RemoveCurrent();
+	}
+
+	for( int32 ChunkStart = 0; ChunkStart < Registrations.Num(); ChunkStart += ChunkSize )
+	{
+		const int32 NumInChunk = FMath::Min( ChunkSize, Registrations.Num() - ChunkStart );
+
+		FPlayerRegistrationContext* RequestContext = new FPlayerRegistrationContext();
+		RequestContext->SessionInterface = AsShared();
+		RequestContext->SessionName = SessionName;
+		RequestContext->Players.Append( Registrations.GetData() + ChunkStart, NumInChunk );
+		RequestContext->ProductUserIds.Append( RegistrationProductUserIds.GetData() + ChunkStart, NumInChunk );
+
+		EOS_Sessions_RegisterPlayersOptions RegisterOptions;
+		RegisterOptions.ApiVersion = EOS_SESSIONS_REGISTERPLAYERS_API_LATEST;
+		RegisterOptions.SessionName = SessionNameUTF8;
+		RegisterOptions.PlayersToRegister = RequestContext->ProductUserIds.GetData();
+		RegisterOptions.PlayersToRegisterCount = (uint32_t)NumInChunk;
+
+		NumRequests++;
+		UpdateState->NumRegistrationsInFlight++;
+		UpdateState->Stats.NumRegistrationRequests++;
+		EOS_Sessions_RegisterPlayers( SessionsHandle, &RegisterOptions, RequestContext, RegisterPlayersCompleteCallback );
+	}
+
+	TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> WeakThis( AsShared() );
+
+	for( int32 ChunkStart = 0; ChunkStart < Unresolved.Num(); ChunkStart += EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS )
+	{
+		TArray<TSharedRef<const FUniqueNetId>> Chunk;
+		Chunk.Append( Unresolved.GetData() + ChunkStart, FMath::Min( (int32)EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS, Unresolved.Num() - ChunkStart ) );
+
+		Identity->QueryProductUserIds( Chunk, [WeakThis, SessionName, Chunk]( bool bWasSuccessful )
+		{
+			TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> StrongThis = WeakThis.Pin();
+
+			if( StrongThis.IsValid() )
+			{
+				StrongThis->HandleResolvePlayersComplete( SessionName, Chunk );
+			}
+		} );
+	}
+
+	return NumRequests;
+}
+
+void FOnlineSessionEOS::HandleResolvePlayersComplete( FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Players )
+{
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	if( UpdateState == nullptr || Identity.IsValid() == false )
+	{
+		return;
+	}
+
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	TArray<FRegistrationCall> Completed;
+
+	for( const TSharedRef<const FUniqueNetId>& Player : Players )
+	{
+		const FString PlayerKey = Player->ToString();
+		UpdateState->ResolvingPlayers.Remove( PlayerKey );
+
+		// Players that were found are sent with the next flush. The rest can't be known to the backend.
+		if( Identity->GetProductUserId( *Player ) == nullptr && UpdateState->PendingRegistrations.Remove( PlayerKey ) > 0 )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot register %s with session '%s': no Product User." ), *PlayerKey, *SessionName.ToString() );
+
+			if( Session != nullptr )
+			{
+				UpdateRegisteredPlayer( *Session, Player, false );
+			}
+
+			TArray<uint32> CallIds;
+			UpdateState->PendingCalls.RemoveAndCopyValue( PlayerKey, CallIds );
+			SettleRegistrationCalls( *UpdateState, CallIds, false, Completed );
+		}
+	}
+
+	if( UpdateState->HasPendingWork() )
+	{
+		MarkSessionDirty( SessionName );
+	}
+
+	ReportRegistrationCalls( SessionName, Completed );
+}
+
+void FOnlineSessionEOS::FindSessionsCompleteCallback( const EOS_SessionSearch_FindCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionSearchContext* SearchContext = (FSessionSearchContext*)Data->ClientData;
+	check( SearchContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = SearchContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleFindSessionsComplete( SearchContext->SearchId, SearchContext->SearchHandle, Data->ResultCode );
+	}
+	else
+	{
+		// Nobody is left to read the results.
+		EOS_SessionSearch_Release( SearchContext->SearchHandle );
+	}
+
+	delete SearchContext;
+}
+
+void FOnlineSessionEOS::FindFriendSessionCompleteCallback( const EOS_SessionSearch_FindCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FFriendSearchContext* SearchContext = (FFriendSearchContext*)Data->ClientData;
+	check( SearchContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = SearchContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleFindFriendSessionComplete( SearchContext->FriendSearchId, SearchContext->SearchHandle, SearchContext->Friend.ToSharedRef(), Data->ResultCode );
+	}
+	else
+	{
+		// Nobody is left to read the results.
+		EOS_SessionSearch_Release( SearchContext->SearchHandle );
+	}
+
+	delete SearchContext;
+}
+
+void FOnlineSessionEOS::HandleFindFriendSessionComplete( uint32 FriendSearchId, EOS_HSessionSearch SearchHandle, const TSharedRef<const FUniqueNetId>& Friend, EOS_EResult ResultCode )
+{
+	FFriendSessionSearch* FriendSearch = FriendSessionSearches.Find( FriendSearchId );
+
+	if( FriendSearch == nullptr )
+	{
+		EOS_SessionSearch_Release( SearchHandle );
+		return;
+	}
+
+	FriendSearch->NumInFlight--;
+
+	TArray<FOnlineSessionSearchResult> FriendResults;
+
+	if( ResultCode == EOS_EResult::EOS_Success || ResultCode == EOS_EResult::EOS_NotFound )
+	{
+		FriendSearch->bAnySucceeded = true;
+
+		EOS_SessionSearch_GetSearchResultCountOptions CountOptions;
+		CountOptions.ApiVersion = EOS_SESSIONSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
+
+		const uint32 NumResults = ( ResultCode == EOS_EResult::EOS_Success ) ? EOS_SessionSearch_GetSearchResultCount( SearchHandle, &CountOptions ) : 0;
+
+		EOS_SessionSearch_CopySearchResultByIndexOptions CopyOptions;
+		CopyOptions.ApiVersion = EOS_SESSIONSEARCH_COPYSEARCHRESULTBYINDEX_API_LATEST;
+
+		for( uint32 ResultIdx = 0; ResultIdx < NumResults; ++ResultIdx )
+		{
+			CopyOptions.SessionIndex = ResultIdx;
+
+			EOS_HSessionDetails SessionDetails = nullptr;
+			FOnlineSessionSearchResult SearchResult;
+
+			if( EOS_SessionSearch_CopySearchResultByIndex( SearchHandle, &CopyOptions, &SessionDetails ) == EOS_EResult::EOS_Success && ToSearchResult( SessionDetails, SearchResult ) == true )
+			{
+				FriendResults.Add( MoveTemp( SearchResult ) );
+			}
+		}
+	}
+	else
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to find sessions of %s: %s" ), *Friend->ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+	}
+
+	EOS_SessionSearch_Release( SearchHandle );
+
+	if( FriendResults.Num() > 0 )
+	{
+		const int32 LocalUserNum = FriendSearch->LocalUserNum;
+		FriendSearch->Results.Append( FriendResults );
+
+		OnFindFriendSessionPartialResults.Broadcast( LocalUserNum, *Friend, FriendResults );
+	}
+
+	// Listeners may have started other searches, so the entry is looked up again.
+	PumpFriendSessionSearch( FriendSearchId );
+}
+
+void FOnlineSessionEOS::HandleFindSessionsComplete( uint32 SearchId, EOS_HSessionSearch SearchHandle, EOS_EResult ResultCode )
+{
+	if( SearchId != CurrentSearchId || CurrentSessionSearch.IsValid() == false )
+	{
+		// Cancelled while the backend was searching.
+		EOS_SessionSearch_Release( SearchHandle );
+		return;
+	}
+
+	bSearchFindInFlight = false;
+
+	if( ResultCode != EOS_EResult::EOS_Success && ResultCode != EOS_EResult::EOS_NotFound )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Session search failed: %s" ), *UEOSCommon::EOSResultToString( ResultCode ) );
+		FinishSessionSearch( false );
+		return;
+	}
+
+	EOS_SessionSearch_GetSearchResultCountOptions CountOptions;
+	CountOptions.ApiVersion = EOS_SESSIONSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
+
+	NumSearchResults = ( ResultCode == EOS_EResult::EOS_Success ) ? EOS_SessionSearch_GetSearchResultCount( SearchHandle, &CountOptions ) : 0;
+	NextSearchResultIndex = 0;
+
+	CurrentSessionSearch->SearchResults.Reserve( NumSearchResults );
+
+	// The first result is surfaced straight away, the rest are spread over the following ticks.
+	CopySearchResults( 1 );
+}
+
+void FOnlineSessionEOS::CopySearchResults( uint32 MaxResultsToCopy )
+{
+	const TSharedRef<FOnlineSessionSearch> SearchSettings = CurrentSessionSearch.ToSharedRef();
+	const int32 FirstNewResultIndex = SearchSettings->SearchResults.Num();
+
+	EOS_SessionSearch_CopySearchResultByIndexOptions CopyOptions;
+	CopyOptions.ApiVersion = EOS_SESSIONSEARCH_COPYSEARCHRESULTBYINDEX_API_LATEST;
+
+	const uint32 EndIndex = FMath::Min( NumSearchResults, NextSearchResultIndex + MaxResultsToCopy );
+
+	for( ; NextSearchResultIndex < EndIndex; ++NextSearchResultIndex )
+	{
+		CopyOptions.SessionIndex = NextSearchResultIndex;
+
+		EOS_HSessionDetails SessionDetails = nullptr;
+		if( EOS_SessionSearch_CopySearchResultByIndex( CurrentSearchHandle, &CopyOptions, &SessionDetails ) != EOS_EResult::EOS_Success )
+		{
+			continue;
+		}
+
+		FOnlineSessionSearchResult SearchResult;
+		if( ToSearchResult( SessionDetails, SearchResult ) == true )
+		{
+			SearchSettings->SearchResults.Add( MoveTemp( SearchResult ) );
+		}
+	}
+
+	if( SearchSettings->SearchResults.Num() > FirstNewResultIndex && bCurrentSearchIsRevalidation == false )
+	{
+		OnFindSessionsPartialResults.Broadcast( SearchSettings, FirstNewResultIndex );
+	}
+
+	// Listeners may have cancelled the search.
+	if( CurrentSessionSearch == SearchSettings && NextSearchResultIndex >= NumSearchResults )
+	{
+		FinishSessionSearch( true );
+	}
+}
+
+void FOnlineSessionEOS::FinishSessionSearch( bool bWasSuccessful )
+{
+	if( CurrentSearchHandle != nullptr )
+	{
+		EOS_SessionSearch_Release( CurrentSearchHandle );
+		CurrentSearchHandle = nullptr;
+	}
+
+	TSharedPtr<FOnlineSessionSearch> SearchSettings = CurrentSessionSearch;
+	const FString CacheKey = MoveTemp( CurrentSearchCacheKey );
+	const bool bIsRevalidation = bCurrentSearchIsRevalidation;
+
+	CurrentSessionSearch = nullptr;
+	CurrentSearchCacheKey.Empty();
+	bCurrentSearchIsRevalidation = false;
+	NumSearchResults = 0;
+	NextSearchResultIndex = 0;
+
+	if( SearchSettings.IsValid() )
+	{
+		SearchSettings->SearchState = bWasSuccessful ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
+	}
+
+	if( bIsRevalidation == true )
+	{
+		TSharedPtr<FOnlineSessionSearch> RevalidatedSearch = RevalidatedSessionSearch.Pin();
+		RevalidatedSessionSearch = nullptr;
+
+		if( bWasSuccessful == false || SearchSettings.IsValid() == false )
+		{
+			SearchCache.AbortRevalidation( CacheKey );
+			return;
+		}
+
+		// Only rows whose attributes changed are replaced, the rest keep whatever was measured since.
+		TArray<FOnlineSessionSearchResult> MergedResults;
+		SearchCache.Store( CacheKey, SearchSettings->SearchResults, MergedResults );
+
+		if( RevalidatedSearch.IsValid() && RevalidatedSearch->SearchState == EOnlineAsyncTaskState::Done )
+		{
+			RevalidatedSearch->SearchResults = MoveTemp( MergedResults );
+			OnSessionSearchRevalidated.Broadcast( RevalidatedSearch.ToSharedRef() );
+		}
+
+		return;
+	}
+
+	if( bWasSuccessful == true && SearchSettings.IsValid() && CacheKey.IsEmpty() == false )
+	{
+		TArray<FOnlineSessionSearchResult> MergedResults;
+		SearchCache.Store( CacheKey, SearchSettings->SearchResults, MergedResults );
+	}
+
+	TriggerOnFindSessionsCompleteDelegates( bWasSuccessful );
+}
+
+bool FOnlineSessionEOS::ToSearchResult( EOS_HSessionDetails SessionDetails, FOnlineSessionSearchResult& OutResult )
+{
+	// Owned from here on, and released along with the last copy of the result.
+	TSharedRef<FSessionDetailsEOS> Details = MakeShared<FSessionDetailsEOS>( SessionDetails );
+
+	EOS_SessionDetails_CopyInfoOptions InfoOptions;
+	InfoOptions.ApiVersion = EOS_SESSIONDETAILS_COPYINFO_API_LATEST;
+
+	EOS_SessionDetails_Info* Info = nullptr;
+	if( EOS_SessionDetails_CopyInfo( SessionDetails, &InfoOptions, &Info ) != EOS_EResult::EOS_Success || Info == nullptr )
+	{
+		return false;
+	}
+
+	FOnlineSession& Session = OutResult.Session;
+
+	FOnlineSessionInfoEOS* SessionInfo = new FOnlineSessionInfoEOS( EEOSSession::AdvertisedSessionClient, FUniqueNetIdString( UTF8_TO_TCHAR( Info->SessionId ), EOS_SUBSYSTEM ) );
+	SessionInfo->SessionDetails = Details;
+
+	if( Info->HostAddress != nullptr )
+	{
+		bool bIsValid = false;
+		SessionInfo->HostAddr = ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->CreateInternetAddr();
+		SessionInfo->HostAddr->SetIp( UTF8_TO_TCHAR( Info->HostAddress ), bIsValid );
+
+		if( bIsValid == false )
+		{
+			SessionInfo->HostAddr = nullptr;
+		}
+	}
+
+	Session.SessionInfo = MakeShareable( SessionInfo );
+	Session.NumOpenPublicConnections = Info->NumOpenPublicConnections;
+	Session.NumOpenPrivateConnections = 0;
+
+	if( Info->Settings != nullptr )
+	{
+		Session.SessionSettings.NumPublicConnections = Info->Settings->NumPublicConnections;
+		Session.SessionSettings.bAllowJoinInProgress = ( Info->Settings->bAllowJoinInProgress == EOS_TRUE );
+		Session.SessionSettings.bShouldAdvertise = ( Info->Settings->PermissionLevel == EOS_EOnlineSessionPermissionLevel::EOS_OSPF_PublicAdvertised );
+		Session.SessionSettings.bAllowJoinViaPresence = ( Info->Settings->PermissionLevel != EOS_EOnlineSessionPermissionLevel::EOS_OSPF_InviteOnly );
+		Session.SessionSettings.Set( SETTING_EOS_BUCKETID, FString( UTF8_TO_TCHAR( Info->Settings->BucketId ) ), EOnlineDataAdvertisementType::ViaOnlineService );
+	}
+
+	EOS_SessionDetails_Info_Release( Info );
+
+	EOS_SessionDetails_GetSessionAttributeCountOptions CountOptions;
+	CountOptions.ApiVersion = EOS_SESSIONDETAILS_GETSESSIONATTRIBUTECOUNT_API_LATEST;
+
+	EOS_SessionDetails_CopySessionAttributeByIndexOptions AttributeOptions;
+	AttributeOptions.ApiVersion = EOS_SESSIONDETAILS_COPYSESSIONATTRIBUTEBYINDEX_API_LATEST;
+
+	const uint32_t NumAttributes = EOS_SessionDetails_GetSessionAttributeCount( SessionDetails, &CountOptions );
+	for( uint32_t AttributeIdx = 0; AttributeIdx < NumAttributes; ++AttributeIdx )
+	{
+		AttributeOptions.AttrIndex = AttributeIdx;
+
+		EOS_SessionDetails_Attribute* Attribute = nullptr;
+		if( EOS_SessionDetails_CopySessionAttributeByIndex( SessionDetails, &AttributeOptions, &Attribute ) != EOS_EResult::EOS_Success || Attribute == nullptr )
+		{
+			continue;
+		}
+
+		FVariantData Data;
+		if( Attribute->Data != nullptr && FromSessionAttribute( *Attribute->Data, Data ) == true )
+		{
+			const FName Key( UTF8_TO_TCHAR( Attribute->Data->Key ) );
+
+			if( Key == SETTING_EOS_BUILDID )
+			{
+				Data.GetValue( Session.SessionSettings.BuildUniqueId );
+			}
+			else
+			{
+				Session.SessionSettings.Settings.Add( Key, FOnlineSessionSetting( Data, EOnlineDataAdvertisementType::ViaOnlineService ) );
+			}
+		}
+
+		EOS_SessionDetails_Attribute_Release( Attribute );
+	}
+
+	ReadConnectionMethods( Session );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::FromSessionAttribute( const EOS_Sessions_AttributeData& Attribute, FVariantData& OutData )
+{
+	switch( Attribute.ValueType )
+	{
+	case EOS_ESessionAttributeType::EOS_SAT_Int64:
+		// Settings are overwhelmingly int32, and FVariantData is strict about types when read back.
+		if( Attribute.Value.AsInt64 >= MIN_int32 && Attribute.Value.AsInt64 <= MAX_int32 )
+		{
+			OutData.SetValue( (int32)Attribute.Value.AsInt64 );
+		}
+		else
+		{
+			OutData.SetValue( (int64)Attribute.Value.AsInt64 );
+		}
+		return true;
+	case EOS_ESessionAttributeType::EOS_SAT_Double:
+		OutData.SetValue( Attribute.Value.AsDouble );
+		return true;
+	case EOS_ESessionAttributeType::EOS_SAT_Boolean:
+		OutData.SetValue( Attribute.Value.AsBool == EOS_TRUE );
+		return true;
+	case EOS_ESessionAttributeType::EOS_SAT_String:
+		OutData.SetValue( FString( UTF8_TO_TCHAR( Attribute.Value.AsUtf8 ) ) );
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool FOnlineSessionEOS::FlushSessionUpdate( FName SessionName )
+{
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	if( UpdateState == nullptr || Session == nullptr || SessionsHandle == nullptr )
+	{
+		TriggerOnUpdateSessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	const int32 NumMergedUpdates = UpdateState->NumPendingUpdates;
+	UpdateState->NumPendingUpdates = 0;
+	UpdateState->Stats.NumUpdatesMerged += NumMergedUpdates;
+
+	FSessionSettingsDeltaEOS Delta;
+	UpdateState->PushedSettings.Diff( Session->SessionSettings, Delta );
+
+	// Most updates from game modes that update on every score change change nothing the backend holds.
+	if( Delta.IsEmpty() )
+	{
+		UE_LOG_ONLINE_SESSION( VeryVerbose, TEXT( "Skipped writing session '%s', %d updates changed nothing." ), *SessionName.ToString(), NumMergedUpdates );
+		UpdateState->Stats.NumWritesSkipped++;
+		TriggerOnUpdateSessionCompleteDelegates( SessionName, true );
+		return false;
+	}
+
+	FEOSScratchArena Arena;
+
+	EOS_Sessions_UpdateSessionModificationOptions ModificationOptions;
+	ModificationOptions.ApiVersion = EOS_SESSIONS_UPDATESESSIONMODIFICATION_API_LATEST;
+	ModificationOptions.SessionName = Arena.ToUTF8( SessionName.ToString() );
+
+	EOS_HSessionModification ModificationHandle = nullptr;
+	const EOS_EResult ModificationResult = EOS_Sessions_UpdateSessionModification( SessionsHandle, &ModificationOptions, &ModificationHandle );
+
+	if( ModificationResult != EOS_EResult::EOS_Success || ApplySessionSettings( ModificationHandle, *Session, Delta, false ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot update session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ModificationResult ) );
+
+		if( ModificationHandle != nullptr )
+		{
+			EOS_SessionModification_Release( ModificationHandle );
+		}
+
+		TriggerOnUpdateSessionCompleteDelegates( SessionName, false );
+		return false;
+	}
+
+	UE_LOG_ONLINE_SESSION( Verbose, TEXT( "Writing session '%s', merging %d updates: %d attributes changed, %d removed." ), *SessionName.ToString(), NumMergedUpdates, Delta.Changed.Num(), Delta.Removed.Num() );
+
+	UpdateState->PushedSettings.Commit( Session->SessionSettings, Delta );
+	UpdateState->InFlightDelta = MoveTemp( Delta );
+	UpdateState->bUpdateInFlight = true;
+	UpdateState->Stats.NumWrites++;
+
+	EOS_Sessions_UpdateSessionOptions UpdateOptions;
+	UpdateOptions.ApiVersion = EOS_SESSIONS_UPDATESESSION_API_LATEST;
+	UpdateOptions.SessionModificationHandle = ModificationHandle;
+
+	FSessionRequestContext* RequestContext = new FSessionRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+
+	EOS_Sessions_UpdateSession( SessionsHandle, &UpdateOptions, RequestContext, UpdateSessionCompleteCallback );
+	EOS_SessionModification_Release( ModificationHandle );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::ApplySessionSettings( EOS_HSessionModification ModificationHandle, const FNamedOnlineSession& Session, const FSessionSettingsDeltaEOS& Delta, bool bIsCreate )
+{
+	const FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+	EOS_EResult Result = EOS_EResult::EOS_Success;
+
+	if( bIsCreate == false && Delta.bMaxPlayersChanged == true )
+	{
+		EOS_SessionModification_SetMaxPlayersOptions MaxPlayersOptions;
+		MaxPlayersOptions.ApiVersion = EOS_SESSIONMODIFICATION_SETMAXPLAYERS_API_LATEST;
+		MaxPlayersOptions.MaxPlayers = Settings.NumPublicConnections + Settings.NumPrivateConnections;
+		Result = EOS_SessionModification_SetMaxPlayers( ModificationHandle, &MaxPlayersOptions );
+	}
+
+	if( Result == EOS_EResult::EOS_Success && Delta.bPermissionLevelChanged == true )
+	{
+		EOS_SessionModification_SetPermissionLevelOptions PermissionOptions;
+		PermissionOptions.ApiVersion = EOS_SESSIONMODIFICATION_SETPERMISSIONLEVEL_API_LATEST;
+		PermissionOptions.PermissionLevel = Settings.bShouldAdvertise ? EOS_EOnlineSessionPermissionLevel::EOS_OSPF_PublicAdvertised
+			: ( Settings.bAllowJoinViaPresence ? EOS_EOnlineSessionPermissionLevel::EOS_OSPF_JoinViaPresence : EOS_EOnlineSessionPermissionLevel::EOS_OSPF_InviteOnly );
+		Result = EOS_SessionModification_SetPermissionLevel( ModificationHandle, &PermissionOptions );
+	}
+
+	if( Result == EOS_EResult::EOS_Success && Delta.bJoinInProgressChanged == true )
+	{
+		EOS_SessionModification_SetJoinInProgressAllowedOptions JoinInProgressOptions;
+		JoinInProgressOptions.ApiVersion = EOS_SESSIONMODIFICATION_SETJOININPROGRESSALLOWED_API_LATEST;
+		JoinInProgressOptions.bAllowJoinInProgress = Settings.bAllowJoinInProgress ? EOS_TRUE : EOS_FALSE;
+		Result = EOS_SessionModification_SetJoinInProgressAllowed( ModificationHandle, &JoinInProgressOptions );
+	}
+
+	FEOSLargeScratchArena Arena;
+
+	const FOnlineSessionInfoEOS* SessionInfo = (const FOnlineSessionInfoEOS*)Session.SessionInfo.Get();
+	if( Result == EOS_EResult::EOS_Success && bIsCreate == true && SessionInfo != nullptr && SessionInfo->HostAddr.IsValid() )
+	{
+		EOS_SessionModification_SetHostAddressOptions HostAddressOptions;
+		HostAddressOptions.ApiVersion = EOS_SESSIONMODIFICATION_SETHOSTADDRESS_API_LATEST;
+		HostAddressOptions.HostAddress = Arena.ToUTF8( SessionInfo->HostAddr->ToString( true ) );
+		Result = EOS_SessionModification_SetHostAddress( ModificationHandle, &HostAddressOptions );
+	}
+
+	// Only attributes that changed since the last write. Advertised settings become attributes, along with the build id.
+	EOS_SessionModification_AddAttributeOptions AddAttributeOptions;
+	AddAttributeOptions.ApiVersion = EOS_SESSIONMODIFICATION_ADDATTRIBUTE_API_LATEST;
+
+	const FSessionAttributeSchemaEOS& Schema = FSessionAttributeSchemaEOS::Get();
+	EOS_Sessions_AttributeData Attribute;
+	FVariantData Value;
+
+	for( const FName& Key : Delta.Changed )
+	{
+		if( Result != EOS_EResult::EOS_Success )
+		{
+			break;
+		}
+
+		if( FSessionSettingsDiffEOS::GetAttribute( Settings, Key, Value ) == false )
+		{
+			continue;
+		}
+
+		// Known keys are filled directly from the schema, anything else is converted by type.
+		AddAttributeOptions.AdvertisementType = EOS_ESessionAttributeAdvertisementType::EOS_SAAT_Advertise;
+
+		if( Schema.ToAttribute( Key, Value, Arena, Attribute, AddAttributeOptions.AdvertisementType ) == true || ToSessionAttribute( Arena.ToUTF8( Key.ToString() ), Value, Arena, Attribute ) == true )
+		{
+			AddAttributeOptions.SessionAttribute = &Attribute;
+			Result = EOS_SessionModification_AddAttribute( ModificationHandle, &AddAttributeOptions );
+		}
+	}
+
+	// Settings that have stopped being advertised since the last write.
+	EOS_SessionModification_RemoveAttributeOptions RemoveAttributeOptions;
+	RemoveAttributeOptions.ApiVersion = EOS_SESSIONMODIFICATION_REMOVEATTRIBUTE_API_LATEST;
+
+	for( const FName& Key : Delta.Removed )
+	{
+		if( Result != EOS_EResult::EOS_Success )
+		{
+			break;
+		}
+
+		RemoveAttributeOptions.Key = Arena.ToUTF8( Key.ToString() );
+		Result = EOS_SessionModification_RemoveAttribute( ModificationHandle, &RemoveAttributeOptions );
+	}
+
+	if( Result != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Session '%s' settings rejected: %s" ), *Session.SessionName.ToString(), *UEOSCommon::EOSResultToString( Result ) );
+		return false;
+	}
+
+	return true;
+}
+
+bool FOnlineSessionEOS::ToSessionAttribute( const char* Key, const FVariantData& Data, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute )
+{
+	OutAttribute.ApiVersion = EOS_SESSIONS_SESSIONATTRIBUTEDATA_API_LATEST;
+	OutAttribute.Key = Key;
+
+	switch( Data.GetType() )
+	{
+	case EOnlineKeyValuePairDataType::Int32:
+	case EOnlineKeyValuePairDataType::UInt32:
+	case EOnlineKeyValuePairDataType::Int64:
+	case EOnlineKeyValuePairDataType::UInt64:
+	{
+		int64 Value = 0;
+		if( Data.GetType() == EOnlineKeyValuePairDataType::Int32 )
+		{
+			int32 Value32;
+			Data.GetValue( Value32 );
+			Value = Value32;
+		}
+		else if( Data.GetType() == EOnlineKeyValuePairDataType::UInt32 )
+		{
+			uint32 Value32;
+			Data.GetValue( Value32 );
+			Value = Value32;
+		}
+		else if( Data.GetType() == EOnlineKeyValuePairDataType::UInt64 )
+		{
+			uint64 Value64;
+			Data.GetValue( Value64 );
+			Value = (int64)Value64;
+		}
+		else
+		{
+			Data.GetValue( Value );
+		}
+
+		OutAttribute.ValueType = EOS_ESessionAttributeType::EOS_SAT_Int64;
+		OutAttribute.Value.AsInt64 = Value;
+		return true;
+	}
+	case EOnlineKeyValuePairDataType::Float:
+	case EOnlineKeyValuePairDataType::Double:
+	{
+		double Value = 0.0;
+		if( Data.GetType() == EOnlineKeyValuePairDataType::Float )
+		{
+			float ValueFloat;
+			Data.GetValue( ValueFloat );
+			Value = ValueFloat;
+		}
+		else
+		{
+			Data.GetValue( Value );
+		}
+
+		OutAttribute.ValueType = EOS_ESessionAttributeType::EOS_SAT_Double;
+		OutAttribute.Value.AsDouble = Value;
+		return true;
+	}
+	case EOnlineKeyValuePairDataType::Bool:
+	{
+		bool Value;
+		Data.GetValue( Value );
+
+		OutAttribute.ValueType = EOS_ESessionAttributeType::EOS_SAT_Boolean;
+		OutAttribute.Value.AsBool = Value ? EOS_TRUE : EOS_FALSE;
+		return true;
+	}
+	case EOnlineKeyValuePairDataType::String:
+	{
+		FString Value;
+		Data.GetValue( Value );
+
+		OutAttribute.ValueType = EOS_ESessionAttributeType::EOS_SAT_String;
+		OutAttribute.Value.AsUtf8 = Arena.ToUTF8( Value );
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+EOS_HSessions FOnlineSessionEOS::GetSessionsHandle() const
+{
+	if( EOSSubsystem == nullptr || EOSSubsystem->IsEOSInitialized() == false )
+	{
+		return nullptr;
+	}
+
+	return EOS_Platform_GetSessionsInterface( EOSSubsystem->GetPlatformHandle() );
+}
+
+void FOnlineSessionEOS::CreateSessionCompleteCallback( const EOS_Sessions_UpdateSessionCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionRequestContext* RequestContext = (FSessionRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleCreateSessionComplete( RequestContext->SessionName, Data->ResultCode, Data->SessionId );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::UpdateSessionCompleteCallback( const EOS_Sessions_UpdateSessionCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionRequestContext* RequestContext = (FSessionRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleUpdateSessionComplete( RequestContext->SessionName, Data->ResultCode );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::StartSessionCompleteCallback( const EOS_Sessions_StartSessionCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionRequestContext* RequestContext = (FSessionRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleStartSessionComplete( RequestContext->SessionName, Data->ResultCode );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::EndSessionCompleteCallback( const EOS_Sessions_EndSessionCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionRequestContext* RequestContext = (FSessionRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleEndSessionComplete( RequestContext->SessionName, Data->ResultCode );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::DestroySessionCompleteCallback( const EOS_Sessions_DestroySessionCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionRequestContext* RequestContext = (FSessionRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleDestroySessionComplete( RequestContext->SessionName, Data->ResultCode, RequestContext->DestroyDelegate );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::JoinSessionCompleteCallback( const EOS_Sessions_JoinSessionCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionRequestContext* RequestContext = (FSessionRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleJoinSessionComplete( RequestContext->SessionName, Data->ResultCode );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::HandleCreateSessionComplete( FName SessionName, EOS_EResult ResultCode, const char* SessionId )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+
+	if( Session == nullptr || UpdateState == nullptr || Session->SessionState != EOnlineSessionState::Creating )
+	{
+		// Destroyed while the backend was creating it.
+		return;
+	}
+
+	UpdateState->bUpdateInFlight = false;
+
+	if( ResultCode == EOS_EResult::EOS_Success && SessionId != nullptr )
+	{
+		SetSessionId( SessionName, FUniqueNetIdString( UTF8_TO_TCHAR( SessionId ), EOS_SUBSYSTEM ) );
+
+		SetSessionState( *Session, EOnlineSessionState::Pending );
+
+		// A migrated host registers everyone the old host had, bar the old host itself.
+		if( FHostMigration* Migration = HostMigrations.Find( SessionName ) )
+		{
+			TArray<TSharedRef<const FUniqueNetId>> Players;
+
+			for( const FString& PlayerKey : Migration->Snapshot.PlayerKeys )
+			{
+				if( PlayerKey != Migration->Snapshot.HostKey )
+				{
+					Players.Add( GetSessionPlayerId( PlayerKey ) );
+				}
+			}
+
+			RegisterPlayers( SessionName, Players, false );
+			CompleteHostMigration( SessionName, true );
+		}
+
+		NotifyCreateSessionComplete( SessionName, true );
+		RunQueuedSessionOps( SessionName );
+		return;
+	}
+
+	UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to create session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+
+	RemoveSessionUpdateState( SessionName );
+	RemoveNamedSession( SessionName );
+	StopIdleQosResponder();
+	CompleteHostMigration( SessionName, false );
+	NotifyCreateSessionComplete( SessionName, false );
+	RunQueuedSessionOps( SessionName );
+}
+
+void FOnlineSessionEOS::HandleUpdateSessionComplete( FName SessionName, EOS_EResult ResultCode )
+{
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+
+	if( UpdateState != nullptr )
+	{
+		// Anything merged in the meantime goes out on the next Tick.
+		UpdateState->bUpdateInFlight = false;
+
+		if( ResultCode != EOS_EResult::EOS_Success )
+		{
+			UpdateState->PushedSettings.Invalidate( UpdateState->InFlightDelta );
+			UpdateState->Stats.NumFailedRequests++;
+		}
+
+		UpdateState->InFlightDelta = FSessionSettingsDeltaEOS();
+	}
+
+	if( ResultCode != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to update session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+	}
+
+	TriggerOnUpdateSessionCompleteDelegates( SessionName, ResultCode == EOS_EResult::EOS_Success );
+}
+
+void FOnlineSessionEOS::HandleStartSessionComplete( FName SessionName, EOS_EResult ResultCode )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	const bool bWasSuccessful = ( ResultCode == EOS_EResult::EOS_Success );
+
+	if( Session != nullptr && Session->SessionState == EOnlineSessionState::Starting )
+	{
+		SetSessionState( *Session, bWasSuccessful ? EOnlineSessionState::InProgress : EOnlineSessionState::Pending );
+	}
+
+	if( bWasSuccessful == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to start session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+
+		if( FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName ) )
+		{
+			UpdateState->Stats.NumFailedRequests++;
+		}
+	}
+
+	TriggerOnStartSessionCompleteDelegates( SessionName, bWasSuccessful );
+	RunQueuedSessionOps( SessionName );
+}
+
+void FOnlineSessionEOS::HandleEndSessionComplete( FName SessionName, EOS_EResult ResultCode )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	const bool bWasSuccessful = ( ResultCode == EOS_EResult::EOS_Success );
+
+	if( Session != nullptr && Session->SessionState == EOnlineSessionState::Ending )
+	{
+		SetSessionState( *Session, bWasSuccessful ? EOnlineSessionState::Ended : EOnlineSessionState::InProgress );
+	}
+
+	if( bWasSuccessful == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to end session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+
+		if( FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName ) )
+		{
+			UpdateState->Stats.NumFailedRequests++;
+		}
+	}
+
+	TriggerOnEndSessionCompleteDelegates( SessionName, bWasSuccessful );
+	RunQueuedSessionOps( SessionName );
+}
+
+void FOnlineSessionEOS::RegisterPlayersCompleteCallback( const EOS_Sessions_RegisterPlayersCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FPlayerRegistrationContext* RequestContext = (FPlayerRegistrationContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleRegisterPlayersComplete( RequestContext->SessionName, Data->ResultCode, RequestContext->Players, RequestContext->ProductUserIds, true );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::UnregisterPlayersCompleteCallback( const EOS_Sessions_UnregisterPlayersCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FPlayerRegistrationContext* RequestContext = (FPlayerRegistrationContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleRegisterPlayersComplete( RequestContext->SessionName, Data->ResultCode, RequestContext->Players, RequestContext->ProductUserIds, false );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::SendInviteCompleteCallback( const EOS_Sessions_SendInviteCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionInviteContext* RequestContext = (FSessionInviteContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleSendInviteComplete( RequestContext->InviteKey, Data->ResultCode );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::SendLobbyInviteCompleteCallback( const EOS_Lobby_SendInviteCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionInviteContext* RequestContext = (FSessionInviteContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleSendInviteComplete( RequestContext->InviteKey, Data->ResultCode );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::HandleRegisterPlayersComplete( FName SessionName, EOS_EResult ResultCode, const TArray<TSharedRef<const FUniqueNetId>>& Players, const TArray<EOS_ProductUserId>& ProductUserIds, bool bRegister )
+{
+	FSessionUpdateState* UpdateState = SessionUpdateStates.Find( SessionName );
+
+	if( UpdateState == nullptr )
+	{
+		// Destroyed since, which already failed the calls waiting on these players.
+		return;
+	}
+
+	const bool bWasSuccessful = ( ResultCode == EOS_EResult::EOS_Success );
+
+	UpdateState->NumRegistrationsInFlight--;
+	UpdateState->Stats.NumFailedRequests += bWasSuccessful ? 0 : 1;
+
+	if( bWasSuccessful == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to %s %d players with session '%s': %s" ), bRegister ? TEXT( "register" ) : TEXT( "unregister" ), Players.Num(), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+	}
+
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	TArray<FRegistrationCall> Completed;
+
+	for( int32 PlayerIdx = 0; PlayerIdx < Players.Num(); ++PlayerIdx )
+	{
+		const TSharedRef<const FUniqueNetId>& Player = Players[PlayerIdx];
+		const FString PlayerKey = Player->ToString();
+
+		if( bWasSuccessful == false )
+		{
+			// The backend still has the player as it was. A pending change back to that has nothing left to do, otherwise
+			// the local session is put back to match.
+			if( bRegister == true )
+			{
+				UpdateState->BackendPlayers.Remove( PlayerKey );
+			}
+			else
+			{
+				UpdateState->BackendPlayers.Add( PlayerKey, ProductUserIds[PlayerIdx] );
+			}
+
+			TMap<FString, TSharedRef<const FUniqueNetId>>& Reverting = bRegister ? UpdateState->PendingUnregistrations : UpdateState->PendingRegistrations;
+
+			if( Reverting.Remove( PlayerKey ) > 0 )
+			{
+				TArray<uint32> RevertingCallIds;
+				UpdateState->PendingCalls.RemoveAndCopyValue( PlayerKey, RevertingCallIds );
+				SettleRegistrationCalls( *UpdateState, RevertingCallIds, true, Completed );
+			}
+			else if( Session != nullptr )
+			{
+				UpdateRegisteredPlayer( *Session, Player, bRegister == false );
+			}
+		}
+
+		TArray<uint32> CallIds;
+		UpdateState->InFlightCalls.RemoveAndCopyValue( PlayerKey, CallIds );
+		SettleRegistrationCalls( *UpdateState, CallIds, bWasSuccessful, Completed );
+	}
+
+	if( UpdateState->HasPendingWork() )
+	{
+		MarkSessionDirty( SessionName );
+	}
+
+	ReportRegistrationCalls( SessionName, Completed );
+}
+
+void FOnlineSessionEOS::HandleJoinSessionComplete( FName SessionName, EOS_EResult ResultCode )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( Session == nullptr || Session->SessionState != EOnlineSessionState::Creating )
+	{
+		// Destroyed while the backend was joining it.
+		return;
+	}
+
+	if( ResultCode == EOS_EResult::EOS_Success )
+	{
+		SetSessionState( *Session, EOnlineSessionState::Pending );
+		CompleteJoinSession( SessionName, EOnJoinSessionCompleteResult::Success );
+		return;
+	}
+
+	UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to join session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+
+	EOnJoinSessionCompleteResult::Type Result = EOnJoinSessionCompleteResult::UnknownError;
+
+	switch( ResultCode )
+	{
+	case EOS_EResult::EOS_Sessions_SessionAlreadyExists:	Result = EOnJoinSessionCompleteResult::AlreadyInSession; break;
+	case EOS_EResult::EOS_Sessions_TooManyPlayers:			Result = EOnJoinSessionCompleteResult::SessionIsFull; break;
+	case EOS_EResult::EOS_NotFound:							Result = EOnJoinSessionCompleteResult::SessionDoesNotExist; break;
+	default:
+		break;
+	}
+
+	// Cached searches would otherwise keep offering a session that is full or gone.
+	if( Result == EOnJoinSessionCompleteResult::SessionIsFull || Result == EOnJoinSessionCompleteResult::SessionDoesNotExist )
+	{
+		SearchCache.RemoveSession( Session->SessionInfo->GetSessionId().ToString() );
+		QuickJoinPool.RemoveSession( Session->SessionInfo->GetSessionId().ToString() );
+	}
+
+	RemoveNamedSession( SessionName );
+	CompleteJoinSession( SessionName, Result );
+}
+
+void FOnlineSessionEOS::HandleDestroySessionComplete( FName SessionName, EOS_EResult ResultCode, const FOnDestroySessionCompleteDelegate& CompletionDelegate )
+{
+	// A session the backend no longer knows about is as destroyed as it gets.
+	const bool bWasSuccessful = ( ResultCode == EOS_EResult::EOS_Success || ResultCode == EOS_EResult::EOS_NotFound );
+
+	if( bWasSuccessful == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to destroy session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+	}
+
+	RemoveSessionUpdateState( SessionName );
+	RemoveLobbyState( SessionName );
+	RemoveNamedSession( SessionName );
+	StopIdleQosResponder();
+
+	UpdateLANBeacon();
+
+	CompletionDelegate.ExecuteIfBound( SessionName, bWasSuccessful );
+	TriggerOnDestroySessionCompleteDelegates( SessionName, bWasSuccessful );
+	RunQueuedSessionOps( SessionName );
+}
+
+bool FOnlineSessionEOS::UpdateLobbyMemberSettings( FName SessionName, const FSessionSettings& MemberSettings )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+
+	if( Session == nullptr || LobbyState == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot update member settings of '%s': not a lobby session." ), *SessionName.ToString() );
+		return false;
+	}
+
+	LobbyState->LocalMemberSettings = MemberSettings;
+	LobbyState->NumPendingUpdates++;
+
+	// Mirrored into the session, where every other member's settings are found too.
+	if( LobbyState->LocalMemberKey.IsEmpty() == false )
+	{
+		Session->SessionSettings.MemberSettings.Add( GetLobbyMemberId( LobbyState->LocalUserId ), MemberSettings );
+	}
+
+	return true;
+}
+
+bool FOnlineSessionEOS::CreateLobbyInternal( FNamedOnlineSession& Session, EOS_ProductUserId HostingProductUserId )
+{
+	const FName SessionName = Session.SessionName;
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( LobbyHandle == nullptr || HostingProductUserId == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot create lobby '%s': %s" ), *SessionName.ToString(), LobbyHandle == nullptr ? TEXT( "EOS Lobbies are not available." ) : TEXT( "lobbies are hosted by a logged in Local User." ) );
+		RemoveNamedSession( SessionName );
+		NotifyCreateSessionComplete( SessionName, false );
+		return false;
+	}
+
+	const FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+	FLobbyState& LobbyState = AddLobbyState( SessionName, HostingProductUserId );
+	LobbyState.OwnerKey = LobbyState.LocalMemberKey;
+	LobbyState.WrittenMaxMembers = FMath::Clamp( Settings.NumPublicConnections + Settings.NumPrivateConnections, 1, EOS_LOBBY_MAX_LOBBY_MEMBERS );
+	LobbyState.WrittenPermissionLevel = (int32)ToLobbyPermissionLevel( Settings );
+
+	// Updates made before the backend has the lobby are held back until it does.
+	LobbyState.bUpdateInFlight = true;
+
+	EOS_Lobby_CreateLobbyOptions CreateOptions;
+	CreateOptions.ApiVersion = EOS_LOBBY_CREATELOBBY_API_LATEST;
+	CreateOptions.LocalUserId = HostingProductUserId;
+	CreateOptions.MaxLobbyMembers = (uint32_t)LobbyState.WrittenMaxMembers;
+	CreateOptions.PermissionLevel = ToLobbyPermissionLevel( Settings );
+	CreateOptions.bPresenceEnabled = Settings.bUsesPresence ? EOS_TRUE : EOS_FALSE;
+
+	FLobbyRequestContext* RequestContext = new FLobbyRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+	RequestContext->LocalUserId = HostingProductUserId;
+
+	EOS_Lobby_CreateLobby( LobbyHandle, &CreateOptions, RequestContext, CreateLobbyCompleteCallback );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::JoinLobbyInternal( int32 PlayerNum, const TSharedPtr<const FUniqueNetId>& PlayerId, EOS_ProductUserId ProductUserId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession )
+{
+	const FOnlineSessionInfoEOS* SearchSessionInfo = static_cast<const FOnlineSessionInfoEOS*>( DesiredSession.Session.SessionInfo.Get() );
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	// The backend needs the details handle that came with the search result.
+	if( SearchSessionInfo->LobbyDetails.IsValid() == false || LobbyHandle == nullptr || ProductUserId == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot join lobby '%s': %s" ), *SessionName.ToString(), LobbyHandle == nullptr ? TEXT( "EOS Lobbies are not available." ) : TEXT( "not an EOS lobby search result, or no Local User." ) );
+		NotifyJoinSessionComplete( SessionName, EOnJoinSessionCompleteResult::SessionDoesNotExist );
+		return false;
+	}
+
+	FOnlineSessionInfoEOS* NewSessionInfo = new FOnlineSessionInfoEOS( EEOSSession::LobbySession, SearchSessionInfo->SessionId );
+	NewSessionInfo->CopyConnectionInfo( *SearchSessionInfo );
+	NewSessionInfo->LobbyDetails = SearchSessionInfo->LobbyDetails;
+
+	FOnlineSession JoinedSession = DesiredSession.Session;
+	JoinedSession.SessionInfo = MakeShareable( NewSessionInfo );
+
+	FNamedOnlineSession* Session = AddNamedSession( SessionName, JoinedSession );
+	check( Session != nullptr );
+
+	// Creating until the backend confirms the join, as with hosted sessions.
+	SetSessionState( *Session, EOnlineSessionState::Creating );
+	Session->HostingPlayerNum = PlayerNum;
+	Session->LocalOwnerId = PlayerId;
+
+	FLobbyState& LobbyState = AddLobbyState( SessionName, ProductUserId );
+	LobbyState.LobbyId = SearchSessionInfo->SessionId.ToString();
+	LobbyState.bUpdateInFlight = true;
+
+	StartJoinQos( SessionName, DesiredSession );
+
+	EOS_Lobby_JoinLobbyOptions JoinOptions;
+	JoinOptions.ApiVersion = EOS_LOBBY_JOINLOBBY_API_LATEST;
+	JoinOptions.LobbyDetailsHandle = SearchSessionInfo->LobbyDetails->GetHandle();
+	JoinOptions.LocalUserId = ProductUserId;
+	JoinOptions.bPresenceEnabled = DesiredSession.Session.SessionSettings.bUsesPresence ? EOS_TRUE : EOS_FALSE;
+
+	FLobbyRequestContext* RequestContext = new FLobbyRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+	RequestContext->LocalUserId = ProductUserId;
+
+	EOS_Lobby_JoinLobby( LobbyHandle, &JoinOptions, RequestContext, JoinLobbyCompleteCallback );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::DestroyLobbyInternal( FNamedOnlineSession& Session, FLobbyState& LobbyState, const FOnDestroySessionCompleteDelegate& CompletionDelegate )
+{
+	const FName SessionName = Session.SessionName;
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	// A lobby still being created or joined is left behind once the backend is done with it.
+	if( LobbyHandle == nullptr || LobbyState.LobbyId.IsEmpty() || Session.SessionState == EOnlineSessionState::Creating )
+	{
+		HandleDestroySessionComplete( SessionName, EOS_EResult::EOS_Success, CompletionDelegate );
+		return true;
+	}
+
+	SetSessionState( Session, EOnlineSessionState::Destroying );
+
+	FEOSScratchArena Arena;
+
+	FLobbyRequestContext* RequestContext = new FLobbyRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+	RequestContext->LocalUserId = LobbyState.LocalUserId;
+	RequestContext->DestroyDelegate = CompletionDelegate;
+
+	bool bMigrateHost = false;
+	Session.SessionSettings.Get( SETTING_EOS_HOSTMIGRATION, bMigrateHost );
+
+	// Owners close the lobby for everyone, members only leave it. Owners of a lobby that migrates leave it to the others too.
+	if( LobbyState.OwnerKey == LobbyState.LocalMemberKey && ( bMigrateHost == false || Session.RegisteredPlayers.Num() <= 1 ) )
+	{
+		EOS_Lobby_DestroyLobbyOptions DestroyOptions;
+		DestroyOptions.ApiVersion = EOS_LOBBY_DESTROYLOBBY_API_LATEST;
+		DestroyOptions.LocalUserId = LobbyState.LocalUserId;
+		DestroyOptions.LobbyId = Arena.ToUTF8( LobbyState.LobbyId );
+
+		EOS_Lobby_DestroyLobby( LobbyHandle, &DestroyOptions, RequestContext, DestroyLobbyCompleteCallback );
+	}
+	else
+	{
+		EOS_Lobby_LeaveLobbyOptions LeaveOptions;
+		LeaveOptions.ApiVersion = EOS_LOBBY_LEAVELOBBY_API_LATEST;
+		LeaveOptions.LocalUserId = LobbyState.LocalUserId;
+		LeaveOptions.LobbyId = Arena.ToUTF8( LobbyState.LobbyId );
+
+		EOS_Lobby_LeaveLobby( LobbyHandle, &LeaveOptions, RequestContext, LeaveLobbyCompleteCallback );
+	}
+
+	return true;
+}
+
+void FOnlineSessionEOS::DiscardLobby( EOS_ProductUserId LocalUserId, const FString& LobbyId, bool bIsOwner )
+{
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( LobbyHandle == nullptr || LocalUserId == nullptr || LobbyId.IsEmpty() )
+	{
+		return;
+	}
+
+	FEOSScratchArena Arena;
+
+	FLobbyRequestContext* RequestContext = new FLobbyRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->LocalUserId = LocalUserId;
+	RequestContext->bIsDiscard = true;
+
+	if( bIsOwner == true )
+	{
+		EOS_Lobby_DestroyLobbyOptions DestroyOptions;
+		DestroyOptions.ApiVersion = EOS_LOBBY_DESTROYLOBBY_API_LATEST;
+		DestroyOptions.LocalUserId = LocalUserId;
+		DestroyOptions.LobbyId = Arena.ToUTF8( LobbyId );
+
+		EOS_Lobby_DestroyLobby( LobbyHandle, &DestroyOptions, RequestContext, DestroyLobbyCompleteCallback );
+	}
+	else
+	{
+		EOS_Lobby_LeaveLobbyOptions LeaveOptions;
+		LeaveOptions.ApiVersion = EOS_LOBBY_LEAVELOBBY_API_LATEST;
+		LeaveOptions.LocalUserId = LocalUserId;
+		LeaveOptions.LobbyId = Arena.ToUTF8( LobbyId );
+
+		EOS_Lobby_LeaveLobby( LobbyHandle, &LeaveOptions, RequestContext, LeaveLobbyCompleteCallback );
+	}
+}
+
+FOnlineSessionEOS::FLobbyState& FOnlineSessionEOS::AddLobbyState( FName SessionName, EOS_ProductUserId LocalUserId )
+{
+	if( LobbyStates.Num() == 0 )
+	{
+		RegisterLobbyNotifications();
+	}
+
+	FLobbyState& LobbyState = LobbyStates.Add( SessionName );
+	LobbyState.LocalUserId = LocalUserId;
+	LobbyState.LocalMemberKey = UEOSCommon::ProductUserIdToString( LocalUserId );
+
+	return LobbyState;
+}
+
+void FOnlineSessionEOS::RemoveLobbyState( FName SessionName )
+{
+	if( LobbyStates.Remove( SessionName ) > 0 && LobbyStates.Num() == 0 )
+	{
+		UnregisterLobbyNotifications();
+	}
+}
+
+FOnlineSessionEOS::FLobbyState* FOnlineSessionEOS::FindLobbyState( const FString& LobbyId, FName& OutSessionName )
+{
+	FNamedOnlineSession* Session = GetNamedSessionFromLobbyId( FUniqueNetIdString( LobbyId, EOS_SUBSYSTEM ) );
+
+	if( Session == nullptr )
+	{
+		return nullptr;
+	}
+
+	OutSessionName = Session->SessionName;
+	return LobbyStates.Find( OutSessionName );
+}
+
+TSharedRef<const FUniqueNetId> FOnlineSessionEOS::GetLobbyMemberId( EOS_ProductUserId MemberUserId ) const
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+	TSharedPtr<const FUniqueNetId> MemberId = Identity.IsValid() ? Identity->FindUniquePlayerId( MemberUserId ) : nullptr;
+
+	if( MemberId.IsValid() )
+	{
+		return MemberId.ToSharedRef();
+	}
+
+	return MakeShared<FUniqueNetIdString>( UEOSCommon::ProductUserIdToString( MemberUserId ), EOS_SUBSYSTEM );
+}
+
+FString FOnlineSessionEOS::GetLobbyMemberKey( const FUniqueNetId& PlayerId ) const
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+	EOS_ProductUserId ProductUserId = Identity.IsValid() ? Identity->GetProductUserId( PlayerId ) : nullptr;
+
+	// Members the identity didn't know are already registered by Product User.
+	return ProductUserId != nullptr ? UEOSCommon::ProductUserIdToString( ProductUserId ) : PlayerId.ToString();
+}
+
+TSharedRef<const FUniqueNetId> FOnlineSessionEOS::GetSessionPlayerId( const FString& PlayerKey ) const
+{
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+	TSharedPtr<const FUniqueNetId> PlayerId = Identity.IsValid() ? Identity->CreateUniquePlayerId( PlayerKey ) : nullptr;
+
+	if( PlayerId.IsValid() )
+	{
+		return PlayerId.ToSharedRef();
+	}
+
+	return MakeShared<FUniqueNetIdString>( PlayerKey, EOS_SUBSYSTEM );
+}
+
+void FOnlineSessionEOS::FlushLobbyUpdate( FName SessionName )
+{
+	FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( LobbyState == nullptr || Session == nullptr || LobbyHandle == nullptr )
+	{
+		CompleteLobbyUpdate( SessionName, false );
+		return;
+	}
+
+	const int32 NumMergedUpdates = LobbyState->NumPendingUpdates;
+	LobbyState->NumPendingUpdates = 0;
+
+	const FOnlineSessionSettings& Settings = Session->SessionSettings;
+	const bool bIsOwner = ( LobbyState->OwnerKey == LobbyState->LocalMemberKey );
+
+	TArray<FName> Changed;
+	TArray<FName> Removed;
+	TArray<FName> MemberChanged;
+	TArray<FName> MemberRemoved;
+
+	// Only the owner writes the lobby itself, along with the build id searches filter on.
+	FSessionSettings DesiredLobbySettings;
+	const int32 MaxMembers = FMath::Clamp( Settings.NumPublicConnections + Settings.NumPrivateConnections, 1, EOS_LOBBY_MAX_LOBBY_MEMBERS );
+	const EOS_ELobbyPermissionLevel PermissionLevel = ToLobbyPermissionLevel( Settings );
+	bool bPropertiesChanged = false;
+
+	if( bIsOwner == true )
+	{
+		DesiredLobbySettings = Settings.Settings;
+		DesiredLobbySettings.Remove( SETTING_EOS_USELOBBY );
+		DesiredLobbySettings.Add( SETTING_EOS_BUILDID, FOnlineSessionSetting( Settings.BuildUniqueId, EOnlineDataAdvertisementType::ViaOnlineService ) );
+
+		LobbyState->LobbyAttributes.Diff( DesiredLobbySettings, Changed, Removed );
+		bPropertiesChanged = ( MaxMembers != LobbyState->WrittenMaxMembers || (int32)PermissionLevel != LobbyState->WrittenPermissionLevel );
+	}
+
+	LobbyState->LocalMemberAttributes.Diff( LobbyState->LocalMemberSettings, MemberChanged, MemberRemoved );
+
+	if( bPropertiesChanged == false && Changed.Num() == 0 && Removed.Num() == 0 && MemberChanged.Num() == 0 && MemberRemoved.Num() == 0 )
+	{
+		// Nothing the backend doesn't already hold.
+		CompleteLobbyUpdate( SessionName, true );
+		return;
+	}
+
+	FEOSLargeScratchArena Arena;
+
+	EOS_Lobby_UpdateLobbyModificationOptions ModificationOptions;
+	ModificationOptions.ApiVersion = EOS_LOBBY_UPDATELOBBYMODIFICATION_API_LATEST;
+	ModificationOptions.LocalUserId = LobbyState->LocalUserId;
+	ModificationOptions.LobbyId = Arena.ToUTF8( LobbyState->LobbyId );
+
+	EOS_HLobbyModification ModificationHandle = nullptr;
+	EOS_EResult Result = EOS_Lobby_UpdateLobbyModification( LobbyHandle, &ModificationOptions, &ModificationHandle );
+
+	if( Result == EOS_EResult::EOS_Success && bPropertiesChanged == true )
+	{
+		EOS_LobbyModification_SetMaxMembersOptions MaxMembersOptions;
+		MaxMembersOptions.ApiVersion = EOS_LOBBYMODIFICATION_SETMAXMEMBERS_API_LATEST;
+		MaxMembersOptions.MaxMembers = (uint32_t)MaxMembers;
+		Result = EOS_LobbyModification_SetMaxMembers( ModificationHandle, &MaxMembersOptions );
+
+		if( Result == EOS_EResult::EOS_Success )
+		{
+			EOS_LobbyModification_SetPermissionLevelOptions PermissionOptions;
+			PermissionOptions.ApiVersion = EOS_LOBBYMODIFICATION_SETPERMISSIONLEVEL_API_LATEST;
+			PermissionOptions.PermissionLevel = PermissionLevel;
+			Result = EOS_LobbyModification_SetPermissionLevel( ModificationHandle, &PermissionOptions );
+		}
+	}
+
+	EOS_Lobby_AttributeData Attribute;
+
+	EOS_LobbyModification_AddAttributeOptions AddAttributeOptions;
+	AddAttributeOptions.ApiVersion = EOS_LOBBYMODIFICATION_ADDATTRIBUTE_API_LATEST;
+	AddAttributeOptions.Attribute = &Attribute;
+	AddAttributeOptions.Visibility = EOS_ELobbyAttributeVisibility::EOS_LAT_PUBLIC;
+
+	for( int32 KeyIdx = Changed.Num() - 1; KeyIdx >= 0; --KeyIdx )
+	{
+		if( Result != EOS_EResult::EOS_Success )
+		{
+			break;
+		}
+
+		const FName& Key = Changed[KeyIdx];
+
+		// Keys that can't be held by a lobby attribute are never sent, so must not be committed as written.
+		if( ToLobbyAttribute( Arena.ToUTF8( Key.ToString() ), DesiredLobbySettings.FindChecked( Key ).Data, Arena, Attribute ) == false )
+		{
+			Changed.RemoveAtSwap( KeyIdx );
+			continue;
+		}
+
+		Result = EOS_LobbyModification_AddAttribute( ModificationHandle, &AddAttributeOptions );
+	}
+
+	EOS_LobbyModification_RemoveAttributeOptions RemoveAttributeOptions;
+	RemoveAttributeOptions.ApiVersion = EOS_LOBBYMODIFICATION_REMOVEATTRIBUTE_API_LATEST;
+
+	for( const FName& Key : Removed )
+	{
+		if( Result != EOS_EResult::EOS_Success )
+		{
+			break;
+		}
+
+		RemoveAttributeOptions.Key = Arena.ToUTF8( Key.ToString() );
+		Result = EOS_LobbyModification_RemoveAttribute( ModificationHandle, &RemoveAttributeOptions );
+	}
+
+	EOS_LobbyModification_AddMemberAttributeOptions AddMemberAttributeOptions;
+	AddMemberAttributeOptions.ApiVersion = EOS_LOBBYMODIFICATION_ADDMEMBERATTRIBUTE_API_LATEST;
+	AddMemberAttributeOptions.Attribute = &Attribute;
+	AddMemberAttributeOptions.Visibility = EOS_ELobbyAttributeVisibility::EOS_LAT_PUBLIC;
+
+	for( int32 KeyIdx = MemberChanged.Num() - 1; KeyIdx >= 0; --KeyIdx )
+	{
+		if( Result != EOS_EResult::EOS_Success )
+		{
+			break;
+		}
+
+		const FName& Key = MemberChanged[KeyIdx];
+
+		if( ToLobbyAttribute( Arena.ToUTF8( Key.ToString() ), LobbyState->LocalMemberSettings.FindChecked( Key ).Data, Arena, Attribute ) == false )
+		{
+			MemberChanged.RemoveAtSwap( KeyIdx );
+			continue;
+		}
+
+		Result = EOS_LobbyModification_AddMemberAttribute( ModificationHandle, &AddMemberAttributeOptions );
+	}
+
+	EOS_LobbyModification_RemoveMemberAttributeOptions RemoveMemberAttributeOptions;
+	RemoveMemberAttributeOptions.ApiVersion = EOS_LOBBYMODIFICATION_REMOVEMEMBERATTRIBUTE_API_LATEST;
+
+	for( const FName& Key : MemberRemoved )
+	{
+		if( Result != EOS_EResult::EOS_Success )
+		{
+			break;
+		}
+
+		RemoveMemberAttributeOptions.Key = Arena.ToUTF8( Key.ToString() );
+		Result = EOS_LobbyModification_RemoveMemberAttribute( ModificationHandle, &RemoveMemberAttributeOptions );
+	}
+
+	if( Result != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot update lobby '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( Result ) );
+
+		if( ModificationHandle != nullptr )
+		{
+			EOS_LobbyModification_Release( ModificationHandle );
+		}
+
+		CompleteLobbyUpdate( SessionName, false );
+		return;
+	}
+
+	UE_LOG_ONLINE_SESSION( Verbose, TEXT( "Writing lobby '%s', merging %d updates: %d attributes, %d member attributes." ), *SessionName.ToString(), NumMergedUpdates, Changed.Num() + Removed.Num(), MemberChanged.Num() + MemberRemoved.Num() );
+
+	// Assumed written, so updates merged while this one is in flight are diffed against it.
+	LobbyState->LobbyAttributes.Commit( DesiredLobbySettings, Changed, Removed );
+	LobbyState->LocalMemberAttributes.Commit( LobbyState->LocalMemberSettings, MemberChanged, MemberRemoved );
+
+	if( bIsOwner == true )
+	{
+		LobbyState->WrittenMaxMembers = MaxMembers;
+		LobbyState->WrittenPermissionLevel = (int32)PermissionLevel;
+	}
+
+	LobbyState->InFlightChanged = MoveTemp( Changed );
+	LobbyState->InFlightRemoved = MoveTemp( Removed );
+	LobbyState->InFlightMemberChanged = MoveTemp( MemberChanged );
+	LobbyState->InFlightMemberRemoved = MoveTemp( MemberRemoved );
+	LobbyState->bUpdateInFlight = true;
+
+	EOS_Lobby_UpdateLobbyOptions UpdateOptions;
+	UpdateOptions.ApiVersion = EOS_LOBBY_UPDATELOBBY_API_LATEST;
+	UpdateOptions.LobbyModificationHandle = ModificationHandle;
+
+	FLobbyRequestContext* RequestContext = new FLobbyRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+	RequestContext->LocalUserId = LobbyState->LocalUserId;
+
+	EOS_Lobby_UpdateLobby( LobbyHandle, &UpdateOptions, RequestContext, UpdateLobbyCompleteCallback );
+	EOS_LobbyModification_Release( ModificationHandle );
+}
+
+void FOnlineSessionEOS::CompleteLobbyUpdate( FName SessionName, bool bWasSuccessful )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( Session == nullptr || Session->SessionState != EOnlineSessionState::Creating )
+	{
+		TriggerOnUpdateSessionCompleteDelegates( SessionName, bWasSuccessful );
+		return;
+	}
+
+	// The first write carries the attributes searches see, so the lobby is only created once it lands.
+	if( bWasSuccessful == true )
+	{
+		SetSessionState( *Session, EOnlineSessionState::Pending );
+		NotifyCreateSessionComplete( SessionName, true );
+		RunQueuedSessionOps( SessionName );
+		return;
+	}
+
+	if( FLobbyState* LobbyState = LobbyStates.Find( SessionName ) )
+	{
+		DiscardLobby( LobbyState->LocalUserId, LobbyState->LobbyId, true );
+	}
+
+	RemoveLobbyState( SessionName );
+	RemoveNamedSession( SessionName );
+	NotifyCreateSessionComplete( SessionName, false );
+	RunQueuedSessionOps( SessionName );
+}
+
+void FOnlineSessionEOS::ApplyLobbyNotifications( FName SessionName )
+{
+	FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( LobbyState == nullptr || Session == nullptr || LobbyHandle == nullptr )
+	{
+		return;
+	}
+
+	const bool bLobbyDirty = LobbyState->bLobbyDirty;
+	const TMap<FString, EOS_ProductUserId> DirtyMembers = MoveTemp( LobbyState->DirtyMembers );
+
+	LobbyState->bLobbyDirty = false;
+	LobbyState->DirtyMembers.Reset();
+
+	FEOSScratchArena Arena;
+
+	EOS_Lobby_CopyLobbyDetailsHandleOptions CopyOptions;
+	CopyOptions.ApiVersion = EOS_LOBBY_COPYLOBBYDETAILSHANDLE_API_LATEST;
+	CopyOptions.LobbyId = Arena.ToUTF8( LobbyState->LobbyId );
+	CopyOptions.LocalUserId = LobbyState->LocalUserId;
+
+	EOS_HLobbyDetails LobbyDetails = nullptr;
+	const EOS_EResult CopyResult = EOS_Lobby_CopyLobbyDetailsHandle( LobbyHandle, &CopyOptions, &LobbyDetails );
+
+	if( CopyResult != EOS_EResult::EOS_Success || LobbyDetails == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot read lobby '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( CopyResult ) );
+		return;
+	}
+
+	bool bSettingsChanged = false;
+
+	// The owner's settings are the lobby's, there is nothing for it to read back.
+	if( bLobbyDirty == true && LobbyState->OwnerKey != LobbyState->LocalMemberKey )
+	{
+		EOS_LobbyDetails_CopyInfoOptions InfoOptions;
+		InfoOptions.ApiVersion = EOS_LOBBYDETAILS_COPYINFO_API_LATEST;
+
+		EOS_LobbyDetails_Info* Info = nullptr;
+		if( EOS_LobbyDetails_CopyInfo( LobbyDetails, &InfoOptions, &Info ) == EOS_EResult::EOS_Success && Info != nullptr )
+		{
+			const int32 NumPublicConnections = (int32)Info->MaxMembers;
+			const bool bShouldAdvertise = ( Info->PermissionLevel == EOS_ELobbyPermissionLevel::EOS_LPL_PUBLICADVERTISED );
+			const bool bAllowJoinViaPresence = ( Info->PermissionLevel != EOS_ELobbyPermissionLevel::EOS_LPL_INVITEONLY );
+
+			bSettingsChanged |= ( Session->SessionSettings.NumPublicConnections != NumPublicConnections || Session->SessionSettings.bShouldAdvertise != bShouldAdvertise || Session->SessionSettings.bAllowJoinViaPresence != bAllowJoinViaPresence );
+
+			Session->SessionSettings.NumPublicConnections = NumPublicConnections;
+			Session->SessionSettings.NumPrivateConnections = 0;
+			Session->SessionSettings.bShouldAdvertise = bShouldAdvertise;
+			Session->SessionSettings.bAllowJoinViaPresence = bAllowJoinViaPresence;
+			Session->NumOpenPublicConnections = (int32)Info->AvailableSlots;
+
+			EOS_LobbyDetails_Info_Release( Info );
+		}
+
+		TArray<FName> Changed;
+		TArray<FName> Removed;
+		ReadLobbyAttributes( LobbyDetails, nullptr, LobbyState->LobbyAttributes, Changed, Removed );
+
+		const TMap<FName, FVariantData>& Values = LobbyState->LobbyAttributes.GetValues();
+
+		for( const FName& Key : Changed )
+		{
+			if( Key == SETTING_EOS_BUILDID )
+			{
+				Values.FindChecked( Key ).GetValue( Session->SessionSettings.BuildUniqueId );
+			}
+			else
+			{
+				Session->SessionSettings.Settings.Add( Key, FOnlineSessionSetting( Values.FindChecked( Key ), EOnlineDataAdvertisementType::ViaOnlineService ) );
+			}
+		}
+
+		for( const FName& Key : Removed )
+		{
+			Session->SessionSettings.Settings.Remove( Key );
+		}
+
+		bSettingsChanged |= ( Changed.Num() > 0 || Removed.Num() > 0 );
+	}
+
+	TArray<TSharedRef<const FUniqueNetId>, TInlineAllocator<16>> UpdatedMembers;
+
+	for( const TPair<FString, EOS_ProductUserId>& DirtyMember : DirtyMembers )
+	{
+		// Our own attributes are only ever written from here.
+		if( DirtyMember.Key == LobbyState->LocalMemberKey )
+		{
+			continue;
+		}
+
+		FLobbyAttributeSyncEOS& MemberAttributes = LobbyState->MemberAttributes.FindOrAdd( DirtyMember.Key );
+
+		TArray<FName> Changed;
+		TArray<FName> Removed;
+		ReadLobbyAttributes( LobbyDetails, DirtyMember.Value, MemberAttributes, Changed, Removed );
+
+		if( Changed.Num() == 0 && Removed.Num() == 0 )
+		{
+			continue;
+		}
+
+		const TSharedRef<const FUniqueNetId> MemberId = GetLobbyMemberId( DirtyMember.Value );
+		FSessionSettings& MemberSettings = Session->SessionSettings.MemberSettings.FindOrAdd( MemberId );
+
+		for( const FName& Key : Changed )
+		{
+			MemberSettings.Add( Key, FOnlineSessionSetting( MemberAttributes.GetValues().FindChecked( Key ), EOnlineDataAdvertisementType::ViaOnlineService ) );
+		}
+
+		for( const FName& Key : Removed )
+		{
+			MemberSettings.Remove( Key );
+		}
+
+		UpdatedMembers.Add( MemberId );
+	}
+
+	EOS_LobbyDetails_Release( LobbyDetails );
+
+	// Listeners may destroy the session, so it is looked up again before each notification.
+	if( bSettingsChanged == true )
+	{
+		TriggerOnSessionSettingsUpdatedDelegates( SessionName, Session->SessionSettings );
+	}
+
+	for( const TSharedRef<const FUniqueNetId>& MemberId : UpdatedMembers )
+	{
+		Session = GetNamedSession( SessionName );
+		if( Session == nullptr )
+		{
+			break;
+		}
+
+		TriggerOnSessionParticipantSettingsUpdatedDelegates( SessionName, *MemberId, Session->SessionSettings );
+	}
+}
+
+void FOnlineSessionEOS::HandleLobbyRemoved( FName SessionName )
+{
+	UE_LOG_ONLINE_SESSION( Log, TEXT( "No longer in lobby '%s', it was closed or we were removed from it." ), *SessionName.ToString() );
+
+	const FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+	const TSharedRef<const FUniqueNetId> LocalMemberId = GetLobbyMemberId( LobbyState != nullptr ? LobbyState->LocalUserId : nullptr );
+
+	RemoveLobbyState( SessionName );
+	RemoveNamedSession( SessionName );
+	TriggerOnSessionFailureDelegates( *LocalMemberId, ESessionFailure::ServiceConnectionLost );
+}
+
+bool FOnlineSessionEOS::StartLobbySearch( EOS_ProductUserId SearchingProductUserId, const TSharedRef<FOnlineSessionSearch>& SearchSettings )
+{
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( LobbyHandle == nullptr || SearchingProductUserId == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot search for lobbies: %s" ), LobbyHandle == nullptr ? TEXT( "EOS Lobbies are not available." ) : TEXT( "no Local User." ) );
+		return false;
+	}
+
+	EOS_Lobby_CreateLobbySearchOptions SearchOptions;
+	SearchOptions.ApiVersion = EOS_LOBBY_CREATELOBBYSEARCH_API_LATEST;
+	SearchOptions.MaxResults = (uint32_t)FMath::Clamp( SearchSettings->MaxSearchResults, 1, EOS_LOBBY_MAX_SEARCH_RESULTS );
+
+	EOS_HLobbySearch SearchHandle = nullptr;
+	EOS_EResult Result = EOS_Lobby_CreateLobbySearch( LobbyHandle, &SearchOptions, &SearchHandle );
+
+	FEOSLargeScratchArena Arena;
+
+	EOS_Lobby_AttributeData Parameter;
+
+	EOS_LobbySearch_SetParameterOptions ParameterOptions;
+	ParameterOptions.ApiVersion = EOS_LOBBYSEARCH_SETPARAMETER_API_LATEST;
+	ParameterOptions.Parameter = &Parameter;
+
+	bool bHasBuildId = false;
+
+	for( const TPair<FName, FOnlineSessionSearchParam>& SearchParam : SearchSettings->QuerySettings.SearchParams )
+	{
+		if( Result != EOS_EResult::EOS_Success )
+		{
+			break;
+		}
+
+		// Lobbies have no bucket, and presence is implied by the permission level.
+		if( SearchParam.Key == SEARCH_LOBBIES || SearchParam.Key == SEARCH_PRESENCE || SearchParam.Key == SETTING_EOS_BUCKETID )
+		{
+			continue;
+		}
+
+		switch( SearchParam.Value.ComparisonOp )
+		{
+		case EOnlineComparisonOp::Equals:				ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_EQUAL; break;
+		case EOnlineComparisonOp::NotEquals:			ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_NOTEQUAL; break;
+		case EOnlineComparisonOp::GreaterThan:			ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_GREATERTHAN; break;
+		case EOnlineComparisonOp::GreaterThanEquals:	ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_GREATERTHANOREQUAL; break;
+		case EOnlineComparisonOp::LessThan:				ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_LESSTHAN; break;
+		case EOnlineComparisonOp::LessThanEquals:		ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_LESSTHANOREQUAL; break;
+		case EOnlineComparisonOp::Near:					ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_DISTANCE; break;
+		case EOnlineComparisonOp::In:					ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_ANYOF; break;
+		case EOnlineComparisonOp::NotIn:				ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_NOTANYOF; break;
+		default:
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Search parameter %s has no EOS comparison, ignoring it." ), *SearchParam.Key.ToString() );
+			continue;
+		}
+
+		FVariantData Data = SearchParam.Value.Data;
+		const char* Key = nullptr;
+
+		if( SearchParam.Key == SEARCH_EOS_MINSLOTSAVAILABLE )
+		{
+			Key = EOS_LOBBYSEARCH_MINSLOTSAVAILABLE;
+		}
+		else
+		{
+			Key = Arena.ToUTF8( SearchParam.Key.ToString() );
+			bHasBuildId |= ( SearchParam.Key == SETTING_EOS_BUILDID );
+		}
+
+		if( ToLobbyAttribute( Key, Data, Arena, Parameter ) == false )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Search parameter %s has no EOS representation, ignoring it." ), *SearchParam.Key.ToString() );
+			continue;
+		}
+
+		Result = EOS_LobbySearch_SetParameter( SearchHandle, &ParameterOptions );
+	}
+
+	// Incompatible builds are filtered by the backend, as with session searches.
+	if( Result == EOS_EResult::EOS_Success && bHasBuildId == false )
+	{
+		ParameterOptions.ComparisonOp = EOS_EComparisonOp::EOS_CO_EQUAL;
+
+		ToLobbyAttribute( Arena.ToUTF8( SETTING_EOS_BUILDID.ToString() ), FVariantData( GetBuildUniqueId() ), Arena, Parameter );
+		Result = EOS_LobbySearch_SetParameter( SearchHandle, &ParameterOptions );
+	}
+
+	if( Result != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot search for lobbies: %s" ), *UEOSCommon::EOSResultToString( Result ) );
+
+		if( SearchHandle != nullptr )
+		{
+			EOS_LobbySearch_Release( SearchHandle );
+		}
+
+		return false;
+	}
+
+	SearchSettings->SearchResults.Reset();
+	SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+
+	// Tracked as the current search, so it can be cancelled like any other. Results are copied all at once.
+	CurrentSessionSearch = SearchSettings;
+	CurrentSearchCacheKey.Empty();
+	bCurrentSearchIsRevalidation = false;
+	CurrentSearchHandle = nullptr;
+	CurrentSearchId++;
+	bSearchFindInFlight = true;
+	NumSearchResults = 0;
+	NextSearchResultIndex = 0;
+
+	EOS_LobbySearch_FindOptions FindOptions;
+	FindOptions.ApiVersion = EOS_LOBBYSEARCH_FIND_API_LATEST;
+	FindOptions.LocalUserId = SearchingProductUserId;
+
+	FLobbySearchContext* SearchContext = new FLobbySearchContext();
+	SearchContext->SessionInterface = AsShared();
+	SearchContext->SearchId = CurrentSearchId;
+	SearchContext->SearchHandle = SearchHandle;
+
+	EOS_LobbySearch_Find( SearchHandle, &FindOptions, SearchContext, FindLobbiesCompleteCallback );
+
+	return true;
+}
+
+void FOnlineSessionEOS::FindLobbiesCompleteCallback( const EOS_LobbySearch_FindCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FLobbySearchContext* SearchContext = (FLobbySearchContext*)Data->ClientData;
+	check( SearchContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = SearchContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleFindLobbiesComplete( SearchContext->SearchId, SearchContext->SearchHandle, Data->ResultCode );
+	}
+	else
+	{
+		// Nobody is left to read the results.
+		EOS_LobbySearch_Release( SearchContext->SearchHandle );
+	}
+
+	delete SearchContext;
+}
+
+void FOnlineSessionEOS::HandleFindLobbiesComplete( uint32 SearchId, EOS_HLobbySearch SearchHandle, EOS_EResult ResultCode )
+{
+	if( SearchId != CurrentSearchId || CurrentSessionSearch.IsValid() == false )
+	{
+		// Cancelled while the backend was searching.
+		EOS_LobbySearch_Release( SearchHandle );
+		return;
+	}
+
+	bSearchFindInFlight = false;
+
+	if( ResultCode != EOS_EResult::EOS_Success && ResultCode != EOS_EResult::EOS_NotFound )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Lobby search failed: %s" ), *UEOSCommon::EOSResultToString( ResultCode ) );
+		EOS_LobbySearch_Release( SearchHandle );
+		FinishSessionSearch( false );
+		return;
+	}
+
+	const TSharedRef<FOnlineSessionSearch> SearchSettings = CurrentSessionSearch.ToSharedRef();
+
+	EOS_LobbySearch_GetSearchResultCountOptions CountOptions;
+	CountOptions.ApiVersion = EOS_LOBBYSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
+
+	EOS_LobbySearch_CopySearchResultByIndexOptions CopyOptions;
+	CopyOptions.ApiVersion = EOS_LOBBYSEARCH_COPYSEARCHRESULTBYINDEX_API_LATEST;
+
+	const uint32_t NumResults = ( ResultCode == EOS_EResult::EOS_Success ) ? EOS_LobbySearch_GetSearchResultCount( SearchHandle, &CountOptions ) : 0;
+	SearchSettings->SearchResults.Reserve( NumResults );
+
+	for( uint32_t ResultIdx = 0; ResultIdx < NumResults; ++ResultIdx )
+	{
+		CopyOptions.LobbyIndex = ResultIdx;
+
+		EOS_HLobbyDetails LobbyDetails = nullptr;
+		if( EOS_LobbySearch_CopySearchResultByIndex( SearchHandle, &CopyOptions, &LobbyDetails ) != EOS_EResult::EOS_Success )
+		{
+			continue;
+		}
+
+		FOnlineSessionSearchResult SearchResult;
+		if( ToLobbySearchResult( LobbyDetails, SearchResult ) == true )
+		{
+			SearchSettings->SearchResults.Add( MoveTemp( SearchResult ) );
+		}
+	}
+
+	EOS_LobbySearch_Release( SearchHandle );
+
+	if( SearchSettings->SearchResults.Num() > 0 )
+	{
+		OnFindSessionsPartialResults.Broadcast( SearchSettings, 0 );
+	}
+
+	// Listeners may have cancelled the search.
+	if( CurrentSessionSearch == SearchSettings )
+	{
+		FinishSessionSearch( true );
+	}
+}
+
+bool FOnlineSessionEOS::ToLobbySearchResult( EOS_HLobbyDetails LobbyDetails, FOnlineSessionSearchResult& OutResult )
+{
+	// Owned from here on, and released along with the last copy of the result.
+	TSharedRef<FLobbyDetailsEOS> Details = MakeShared<FLobbyDetailsEOS>( LobbyDetails );
+
+	EOS_LobbyDetails_CopyInfoOptions InfoOptions;
+	InfoOptions.ApiVersion = EOS_LOBBYDETAILS_COPYINFO_API_LATEST;
+
+	EOS_LobbyDetails_Info* Info = nullptr;
+	if( EOS_LobbyDetails_CopyInfo( LobbyDetails, &InfoOptions, &Info ) != EOS_EResult::EOS_Success || Info == nullptr )
+	{
+		return false;
+	}
+
+	FOnlineSession& Session = OutResult.Session;
+
+	FOnlineSessionInfoEOS* SessionInfo = new FOnlineSessionInfoEOS( EEOSSession::LobbySession, FUniqueNetIdString( UTF8_TO_TCHAR( Info->LobbyId ), EOS_SUBSYSTEM ) );
+	SessionInfo->LobbyDetails = Details;
+
+	Session.SessionInfo = MakeShareable( SessionInfo );
+	Session.NumOpenPublicConnections = (int32)Info->AvailableSlots;
+	Session.NumOpenPrivateConnections = 0;
+	Session.SessionSettings.NumPublicConnections = (int32)Info->MaxMembers;
+	Session.SessionSettings.bShouldAdvertise = ( Info->PermissionLevel == EOS_ELobbyPermissionLevel::EOS_LPL_PUBLICADVERTISED );
+	Session.SessionSettings.bAllowJoinViaPresence = ( Info->PermissionLevel != EOS_ELobbyPermissionLevel::EOS_LPL_INVITEONLY );
+	Session.SessionSettings.Set( SETTING_EOS_USELOBBY, true, EOnlineDataAdvertisementType::DontAdvertise );
+
+	EOS_LobbyDetails_Info_Release( Info );
+
+	FLobbyAttributeSyncEOS Attributes;
+	TArray<FName> Changed;
+	TArray<FName> Removed;
+	ReadLobbyAttributes( LobbyDetails, nullptr, Attributes, Changed, Removed );
+
+	for( const TPair<FName, FVariantData>& Attribute : Attributes.GetValues() )
+	{
+		if( Attribute.Key == SETTING_EOS_BUILDID )
+		{
+			Attribute.Value.GetValue( Session.SessionSettings.BuildUniqueId );
+		}
+		else
+		{
+			Session.SessionSettings.Settings.Add( Attribute.Key, FOnlineSessionSetting( Attribute.Value, EOnlineDataAdvertisementType::ViaOnlineService ) );
+		}
+	}
+
+	ReadConnectionMethods( Session );
+
+	return true;
+}
+
+void FOnlineSessionEOS::ReadLobbyAttributes( EOS_HLobbyDetails LobbyDetails, EOS_ProductUserId TargetUserId, FLobbyAttributeSyncEOS& Attributes, TArray<FName>& OutChanged, TArray<FName>& OutRemoved )
+{
+	uint32_t NumAttributes = 0;
+
+	if( TargetUserId == nullptr )
+	{
+		EOS_LobbyDetails_GetAttributeCountOptions CountOptions;
+		CountOptions.ApiVersion = EOS_LOBBYDETAILS_GETATTRIBUTECOUNT_API_LATEST;
+		NumAttributes = EOS_LobbyDetails_GetAttributeCount( LobbyDetails, &CountOptions );
+	}
+	else
+	{
+		EOS_LobbyDetails_GetMemberAttributeCountOptions CountOptions;
+		CountOptions.ApiVersion = EOS_LOBBYDETAILS_GETMEMBERATTRIBUTECOUNT_API_LATEST;
+		CountOptions.TargetUserId = TargetUserId;
+		NumAttributes = EOS_LobbyDetails_GetMemberAttributeCount( LobbyDetails, &CountOptions );
+	}
+
+	EOS_LobbyDetails_CopyAttributeByIndexOptions AttributeOptions;
+	AttributeOptions.ApiVersion = EOS_LOBBYDETAILS_COPYATTRIBUTEBYINDEX_API_LATEST;
+
+	EOS_LobbyDetails_CopyMemberAttributeByIndexOptions MemberAttributeOptions;
+	MemberAttributeOptions.ApiVersion = EOS_LOBBYDETAILS_COPYMEMBERATTRIBUTEBYINDEX_API_LATEST;
+	MemberAttributeOptions.TargetUserId = TargetUserId;
+
+	TSet<FName> PresentKeys;
+
+	for( uint32_t AttributeIdx = 0; AttributeIdx < NumAttributes; ++AttributeIdx )
+	{
+		EOS_Lobby_Attribute* Attribute = nullptr;
+		EOS_EResult Result;
+
+		if( TargetUserId == nullptr )
+		{
+			AttributeOptions.AttrIndex = AttributeIdx;
+			Result = EOS_LobbyDetails_CopyAttributeByIndex( LobbyDetails, &AttributeOptions, &Attribute );
+		}
+		else
+		{
+			MemberAttributeOptions.AttrIndex = AttributeIdx;
+			Result = EOS_LobbyDetails_CopyMemberAttributeByIndex( LobbyDetails, &MemberAttributeOptions, &Attribute );
+		}
+
+		if( Result != EOS_EResult::EOS_Success || Attribute == nullptr )
+		{
+			continue;
+		}
+
+		FVariantData Data;
+		if( Attribute->Data != nullptr && FromLobbyAttribute( *Attribute->Data, Data ) == true )
+		{
+			const FName Key( UTF8_TO_TCHAR( Attribute->Data->Key ) );
+			PresentKeys.Add( Key );
+
+			if( Attributes.ApplyRemote( Key, Data ) == true )
+			{
+				OutChanged.Add( Key );
+			}
+		}
+
+		EOS_Lobby_Attribute_Release( Attribute );
+	}
+
+	Attributes.RemoveMissing( PresentKeys, OutRemoved );
+}
+
+bool FOnlineSessionEOS::ToLobbyAttribute( const char* Key, const FVariantData& Data, FEOSLargeScratchArena& Arena, EOS_Lobby_AttributeData& OutAttribute )
+{
+	// Lobby attributes take the same values as session attributes, only the types differ.
+	EOS_Sessions_AttributeData SessionAttribute;
+	if( ToSessionAttribute( Key, Data, Arena, SessionAttribute ) == false )
+	{
+		return false;
+	}
+
+	OutAttribute.ApiVersion = EOS_LOBBY_ATTRIBUTEDATA_API_LATEST;
+	OutAttribute.Key = SessionAttribute.Key;
+
+	switch( SessionAttribute.ValueType )
+	{
+	case EOS_ESessionAttributeType::EOS_SAT_Int64:
+		OutAttribute.ValueType = EOS_ELobbyAttributeType::EOS_AT_INT64;
+		OutAttribute.Value.AsInt64 = SessionAttribute.Value.AsInt64;
+		return true;
+	case EOS_ESessionAttributeType::EOS_SAT_Double:
+		OutAttribute.ValueType = EOS_ELobbyAttributeType::EOS_AT_DOUBLE;
+		OutAttribute.Value.AsDouble = SessionAttribute.Value.AsDouble;
+		return true;
+	case EOS_ESessionAttributeType::EOS_SAT_Boolean:
+		OutAttribute.ValueType = EOS_ELobbyAttributeType::EOS_AT_BOOLEAN;
+		OutAttribute.Value.AsBool = SessionAttribute.Value.AsBool;
+		return true;
+	case EOS_ESessionAttributeType::EOS_SAT_String:
+		OutAttribute.ValueType = EOS_ELobbyAttributeType::EOS_AT_STRING;
+		OutAttribute.Value.AsUtf8 = SessionAttribute.Value.AsUtf8;
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool FOnlineSessionEOS::FromLobbyAttribute( const EOS_Lobby_AttributeData& Attribute, FVariantData& OutData )
+{
+	EOS_Sessions_AttributeData SessionAttribute;
+	SessionAttribute.ApiVersion = EOS_SESSIONS_SESSIONATTRIBUTEDATA_API_LATEST;
+	SessionAttribute.Key = Attribute.Key;
+
+	switch( Attribute.ValueType )
+	{
+	case EOS_ELobbyAttributeType::EOS_AT_INT64:
+		SessionAttribute.ValueType = EOS_ESessionAttributeType::EOS_SAT_Int64;
+		SessionAttribute.Value.AsInt64 = Attribute.Value.AsInt64;
+		break;
+	case EOS_ELobbyAttributeType::EOS_AT_DOUBLE:
+		SessionAttribute.ValueType = EOS_ESessionAttributeType::EOS_SAT_Double;
+		SessionAttribute.Value.AsDouble = Attribute.Value.AsDouble;
+		break;
+	case EOS_ELobbyAttributeType::EOS_AT_BOOLEAN:
+		SessionAttribute.ValueType = EOS_ESessionAttributeType::EOS_SAT_Boolean;
+		SessionAttribute.Value.AsBool = Attribute.Value.AsBool;
+		break;
+	case EOS_ELobbyAttributeType::EOS_AT_STRING:
+		SessionAttribute.ValueType = EOS_ESessionAttributeType::EOS_SAT_String;
+		SessionAttribute.Value.AsUtf8 = Attribute.Value.AsUtf8;
+		break;
+	default:
+		return false;
+	}
+
+	return FromSessionAttribute( SessionAttribute, OutData );
+}
+
+EOS_ELobbyPermissionLevel FOnlineSessionEOS::ToLobbyPermissionLevel( const FOnlineSessionSettings& Settings )
+{
+	return Settings.bShouldAdvertise ? EOS_ELobbyPermissionLevel::EOS_LPL_PUBLICADVERTISED
+		: ( Settings.bAllowJoinViaPresence ? EOS_ELobbyPermissionLevel::EOS_LPL_JOINVIAPRESENCE : EOS_ELobbyPermissionLevel::EOS_LPL_INVITEONLY );
+}
+
+void FOnlineSessionEOS::RegisterLobbyNotifications()
+{
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( LobbyHandle == nullptr || LobbyUpdateNotificationId != EOS_INVALID_NOTIFICATIONID )
+	{
+		return;
+	}
+
+	EOS_Lobby_AddNotifyLobbyUpdateReceivedOptions UpdateOptions;
+	UpdateOptions.ApiVersion = EOS_LOBBY_ADDNOTIFYLOBBYUPDATERECEIVED_API_LATEST;
+	LobbyUpdateNotificationId = EOS_Lobby_AddNotifyLobbyUpdateReceived( LobbyHandle, &UpdateOptions, this, LobbyUpdateReceivedCallback );
+
+	EOS_Lobby_AddNotifyLobbyMemberUpdateReceivedOptions MemberUpdateOptions;
+	MemberUpdateOptions.ApiVersion = EOS_LOBBY_ADDNOTIFYLOBBYMEMBERUPDATERECEIVED_API_LATEST;
+	LobbyMemberUpdateNotificationId = EOS_Lobby_AddNotifyLobbyMemberUpdateReceived( LobbyHandle, &MemberUpdateOptions, this, LobbyMemberUpdateReceivedCallback );
+
+	EOS_Lobby_AddNotifyLobbyMemberStatusReceivedOptions MemberStatusOptions;
+	MemberStatusOptions.ApiVersion = EOS_LOBBY_ADDNOTIFYLOBBYMEMBERSTATUSRECEIVED_API_LATEST;
+	LobbyMemberStatusNotificationId = EOS_Lobby_AddNotifyLobbyMemberStatusReceived( LobbyHandle, &MemberStatusOptions, this, LobbyMemberStatusReceivedCallback );
+}
+
+void FOnlineSessionEOS::UnregisterLobbyNotifications()
+{
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( LobbyHandle != nullptr )
+	{
+		EOS_Lobby_RemoveNotifyLobbyUpdateReceived( LobbyHandle, LobbyUpdateNotificationId );
+		EOS_Lobby_RemoveNotifyLobbyMemberUpdateReceived( LobbyHandle, LobbyMemberUpdateNotificationId );
+		EOS_Lobby_RemoveNotifyLobbyMemberStatusReceived( LobbyHandle, LobbyMemberStatusNotificationId );
+	}
+
+	LobbyUpdateNotificationId = EOS_INVALID_NOTIFICATIONID;
+	LobbyMemberUpdateNotificationId = EOS_INVALID_NOTIFICATIONID;
+	LobbyMemberStatusNotificationId = EOS_INVALID_NOTIFICATIONID;
+}
+
+EOS_HLobby FOnlineSessionEOS::GetLobbyHandle() const
+{
+	if( EOSSubsystem == nullptr || EOSSubsystem->IsEOSInitialized() == false )
+	{
+		return nullptr;
+	}
+
+	return EOS_Platform_GetLobbyInterface( EOSSubsystem->GetPlatformHandle() );
+}
+
+void FOnlineSessionEOS::CreateLobbyCompleteCallback( const EOS_Lobby_CreateLobbyCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FLobbyRequestContext* RequestContext = (FLobbyRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleCreateLobbyComplete( RequestContext->SessionName, RequestContext->LocalUserId, Data->ResultCode, Data->LobbyId );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::UpdateLobbyCompleteCallback( const EOS_Lobby_UpdateLobbyCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FLobbyRequestContext* RequestContext = (FLobbyRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleUpdateLobbyComplete( RequestContext->SessionName, Data->ResultCode );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::JoinLobbyCompleteCallback( const EOS_Lobby_JoinLobbyCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FLobbyRequestContext* RequestContext = (FLobbyRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleJoinLobbyComplete( RequestContext->SessionName, RequestContext->LocalUserId, Data->ResultCode, Data->LobbyId );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::DestroyLobbyCompleteCallback( const EOS_Lobby_DestroyLobbyCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FLobbyRequestContext* RequestContext = (FLobbyRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() && RequestContext->bIsDiscard == false )
+	{
+		SessionInterface->HandleDestroySessionComplete( RequestContext->SessionName, Data->ResultCode, RequestContext->DestroyDelegate );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::LeaveLobbyCompleteCallback( const EOS_Lobby_LeaveLobbyCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FLobbyRequestContext* RequestContext = (FLobbyRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() && RequestContext->bIsDiscard == false )
+	{
+		SessionInterface->HandleDestroySessionComplete( RequestContext->SessionName, Data->ResultCode, RequestContext->DestroyDelegate );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::LobbyUpdateReceivedCallback( const EOS_Lobby_LobbyUpdateReceivedCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FOnlineSessionEOS* SessionInterface = (FOnlineSessionEOS*)Data->ClientData;
+	check( SessionInterface != nullptr );
+
+	SessionInterface->HandleLobbyUpdateReceived( UTF8_TO_TCHAR( Data->LobbyId ), nullptr );
+}
+
+void FOnlineSessionEOS::LobbyMemberUpdateReceivedCallback( const EOS_Lobby_LobbyMemberUpdateReceivedCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FOnlineSessionEOS* SessionInterface = (FOnlineSessionEOS*)Data->ClientData;
+	check( SessionInterface != nullptr );
+
+	SessionInterface->HandleLobbyUpdateReceived( UTF8_TO_TCHAR( Data->LobbyId ), Data->TargetUserId );
+}
+
+void FOnlineSessionEOS::LobbyMemberStatusReceivedCallback( const EOS_Lobby_LobbyMemberStatusReceivedCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FOnlineSessionEOS* SessionInterface = (FOnlineSessionEOS*)Data->ClientData;
+	check( SessionInterface != nullptr );
+
+	SessionInterface->HandleLobbyMemberStatusReceived( UTF8_TO_TCHAR( Data->LobbyId ), Data->TargetUserId, Data->CurrentStatus );
+}
+
+void FOnlineSessionEOS::HandleCreateLobbyComplete( FName SessionName, EOS_ProductUserId LocalUserId, EOS_EResult ResultCode, const char* LobbyId )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+
+	if( Session == nullptr || LobbyState == nullptr || Session->SessionState != EOnlineSessionState::Creating )
+	{
+		// Destroyed while the backend was creating it, so nobody wants the lobby any more.
+		if( ResultCode == EOS_EResult::EOS_Success && LobbyId != nullptr )
+		{
+			DiscardLobby( LocalUserId, UTF8_TO_TCHAR( LobbyId ), true );
+		}
+		return;
+	}
+
+	LobbyState->bUpdateInFlight = false;
+
+	if( ResultCode != EOS_EResult::EOS_Success || LobbyId == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to create lobby '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+
+		RemoveLobbyState( SessionName );
+		RemoveNamedSession( SessionName );
+		NotifyCreateSessionComplete( SessionName, false );
+		RunQueuedSessionOps( SessionName );
+		return;
+	}
+
+	LobbyState->LobbyId = UTF8_TO_TCHAR( LobbyId );
+	SetSessionId( SessionName, FUniqueNetIdString( LobbyState->LobbyId, EOS_SUBSYSTEM ) );
+
+	Session->RegisteredPlayers.Add( GetLobbyMemberId( LobbyState->LocalUserId ) );
+
+	// The lobby's attributes go out in a first write, which completes the creation.
+	FlushLobbyUpdate( SessionName );
+}
+
+void FOnlineSessionEOS::HandleUpdateLobbyComplete( FName SessionName, EOS_EResult ResultCode )
+{
+	FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+
+	if( LobbyState != nullptr )
+	{
+		// Anything merged in the meantime goes out on the next Tick.
+		LobbyState->bUpdateInFlight = false;
+
+		// The backend kept its previous values, so the keys of this write are sent again with the next one.
+		if( ResultCode != EOS_EResult::EOS_Success )
+		{
+			LobbyState->LobbyAttributes.Invalidate( LobbyState->InFlightChanged, LobbyState->InFlightRemoved );
+			LobbyState->LocalMemberAttributes.Invalidate( LobbyState->InFlightMemberChanged, LobbyState->InFlightMemberRemoved );
+			LobbyState->WrittenMaxMembers = -1;
+			LobbyState->WrittenPermissionLevel = -1;
+		}
+
+		LobbyState->InFlightChanged.Reset();
+		LobbyState->InFlightRemoved.Reset();
+		LobbyState->InFlightMemberChanged.Reset();
+		LobbyState->InFlightMemberRemoved.Reset();
+	}
+
+	if( ResultCode != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to update lobby '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+	}
+
+	CompleteLobbyUpdate( SessionName, ResultCode == EOS_EResult::EOS_Success );
+}
+
+void FOnlineSessionEOS::HandleJoinLobbyComplete( FName SessionName, EOS_ProductUserId LocalUserId, EOS_EResult ResultCode, const char* LobbyId )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( Session == nullptr || LobbyState == nullptr || Session->SessionState != EOnlineSessionState::Creating )
+	{
+		// Destroyed while the backend was joining it.
+		if( ResultCode == EOS_EResult::EOS_Success && LobbyId != nullptr )
+		{
+			DiscardLobby( LocalUserId, UTF8_TO_TCHAR( LobbyId ), false );
+		}
+		return;
+	}
+
+	LobbyState->bUpdateInFlight = false;
+
+	if( ResultCode == EOS_EResult::EOS_Success && LobbyHandle != nullptr )
+	{
+		FEOSScratchArena Arena;
+
+		EOS_Lobby_CopyLobbyDetailsHandleOptions CopyOptions;
+		CopyOptions.ApiVersion = EOS_LOBBY_COPYLOBBYDETAILSHANDLE_API_LATEST;
+		CopyOptions.LobbyId = Arena.ToUTF8( LobbyState->LobbyId );
+		CopyOptions.LocalUserId = LobbyState->LocalUserId;
+
+		// The member list is read once, it is kept up to date by member status notifications from here on.
+		EOS_HLobbyDetails LobbyDetails = nullptr;
+		if( EOS_Lobby_CopyLobbyDetailsHandle( LobbyHandle, &CopyOptions, &LobbyDetails ) == EOS_EResult::EOS_Success && LobbyDetails != nullptr )
+		{
+			EOS_LobbyDetails_GetLobbyOwnerOptions OwnerOptions;
+			OwnerOptions.ApiVersion = EOS_LOBBYDETAILS_GETLOBBYOWNER_API_LATEST;
+			LobbyState->OwnerKey = UEOSCommon::ProductUserIdToString( EOS_LobbyDetails_GetLobbyOwner( LobbyDetails, &OwnerOptions ) );
+
+			EOS_LobbyDetails_GetMemberCountOptions CountOptions;
+			CountOptions.ApiVersion = EOS_LOBBYDETAILS_GETMEMBERCOUNT_API_LATEST;
+
+			EOS_LobbyDetails_GetMemberByIndexOptions MemberOptions;
+			MemberOptions.ApiVersion = EOS_LOBBYDETAILS_GETMEMBERBYINDEX_API_LATEST;
+
+			const uint32_t NumMembers = EOS_LobbyDetails_GetMemberCount( LobbyDetails, &CountOptions );
+			for( uint32_t MemberIdx = 0; MemberIdx < NumMembers; ++MemberIdx )
+			{
+				MemberOptions.MemberIndex = MemberIdx;
+
+				EOS_ProductUserId MemberUserId = EOS_LobbyDetails_GetMemberByIndex( LobbyDetails, &MemberOptions );
+				const FString MemberKey = UEOSCommon::ProductUserIdToString( MemberUserId );
+
+				if( MemberKey.IsEmpty() == false )
+				{
+					Session->RegisteredPlayers.Add( GetLobbyMemberId( MemberUserId ) );
+					LobbyState->DirtyMembers.Add( MemberKey, MemberUserId );
+				}
+			}
+
+			EOS_LobbyDetails_Release( LobbyDetails );
+		}
+
+		// Everything is read on the next tick, through the same path as later changes.
+		LobbyState->bLobbyDirty = true;
+
+		SetSessionState( *Session, EOnlineSessionState::Pending );
+		CompleteJoinSession( SessionName, EOnJoinSessionCompleteResult::Success );
+		return;
+	}
+
+	UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to join lobby '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+
+	EOnJoinSessionCompleteResult::Type Result = EOnJoinSessionCompleteResult::UnknownError;
+
+	switch( ResultCode )
+	{
+	case EOS_EResult::EOS_Lobby_TooManyPlayers:			Result = EOnJoinSessionCompleteResult::SessionIsFull; break;
+	case EOS_EResult::EOS_NotFound:						Result = EOnJoinSessionCompleteResult::SessionDoesNotExist; break;
+	default:
+		break;
+	}
+
+	RemoveLobbyState( SessionName );
+	RemoveNamedSession( SessionName );
+	CompleteJoinSession( SessionName, Result );
+}
+
+void FOnlineSessionEOS::HandleLobbyUpdateReceived( const FString& LobbyId, EOS_ProductUserId TargetUserId )
+{
+	FName SessionName;
+	FLobbyState* LobbyState = FindLobbyState( LobbyId, SessionName );
+
+	if( LobbyState == nullptr )
+	{
+		return;
+	}
+
+	if( TargetUserId == nullptr )
+	{
+		LobbyState->bLobbyDirty = true;
+	}
+	else
+	{
+		LobbyState->DirtyMembers.Add( UEOSCommon::ProductUserIdToString( TargetUserId ), TargetUserId );
+	}
+}
+
+void FOnlineSessionEOS::HandleLobbyMemberStatusReceived( const FString& LobbyId, EOS_ProductUserId TargetUserId, EOS_ELobbyMemberStatus CurrentStatus )
+{
+	FName SessionName;
+	FLobbyState* LobbyState = FindLobbyState( LobbyId, SessionName );
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( LobbyState == nullptr || Session == nullptr )
+	{
+		return;
+	}
+
+	const FString MemberKey = UEOSCommon::ProductUserIdToString( TargetUserId );
+	const TSharedRef<const FUniqueNetId> MemberId = GetLobbyMemberId( TargetUserId );
+
+	// Matched by Product User, as the member may have been registered before the identity knew their Epic Account.
+	const int32 PlayerIdx = Session->RegisteredPlayers.IndexOfByPredicate( [this, &MemberKey]( const TSharedRef<const FUniqueNetId>& RegisteredPlayer )
+	{
+		return GetLobbyMemberKey( *RegisteredPlayer ) == MemberKey;
+	} );
+
+	switch( CurrentStatus )
+	{
+	case EOS_ELobbyMemberStatus::EOS_LMS_JOINED:
+		if( PlayerIdx == INDEX_NONE )
+		{
+			Session->RegisteredPlayers.Add( MemberId );
+		}
+
+		// Their attributes are read on the next tick.
+		LobbyState->DirtyMembers.Add( MemberKey, TargetUserId );
+		TriggerOnSessionParticipantsChangeDelegates( SessionName, *MemberId, true );
+		break;
+
+	case EOS_ELobbyMemberStatus::EOS_LMS_PROMOTED:
+		// A new owner writes the lobby from what the backend holds, so only what differs from it is sent.
+		LobbyState->OwnerKey = MemberKey;
+		LobbyState->bLobbyDirty = true;
+
+		if( FHostMigration* Migration = HostMigrations.Find( SessionName ) )
+		{
+			if( MemberKey == Migration->SuccessorKey )
+			{
+				if( Migration->bIsSuccessor == true )
+				{
+					TakeOverLobby( SessionName, *Migration );
+				}
+
+				CompleteHostMigration( SessionName, true );
+			}
+			else if( MemberKey == LobbyState->LocalMemberKey )
+			{
+				// The backend picked us, but everyone agreed on someone else.
+				PromoteLobbyMember( SessionName, *LobbyState, Migration->SuccessorKey );
+			}
+		}
+		break;
+
+	case EOS_ELobbyMemberStatus::EOS_LMS_CLOSED:
+		// The lobby is gone for everyone, whoever the notification names.
+		HandleLobbyRemoved( SessionName );
+		break;
+
+	case EOS_ELobbyMemberStatus::EOS_LMS_LEFT:
+	case EOS_ELobbyMemberStatus::EOS_LMS_DISCONNECTED:
+	case EOS_ELobbyMemberStatus::EOS_LMS_KICKED:
+		if( MemberKey == LobbyState->LocalMemberKey )
+		{
+			HandleLobbyRemoved( SessionName );
+			break;
+		}
+
+		if( PlayerIdx != INDEX_NONE )
+		{
+			Session->RegisteredPlayers.RemoveAtSwap( PlayerIdx );
+		}
+
+		Session->SessionSettings.MemberSettings.Remove( MemberId );
+		LobbyState->MemberAttributes.Remove( MemberKey );
+		LobbyState->DirtyMembers.Remove( MemberKey );
+
+		TriggerOnSessionParticipantsChangeDelegates( SessionName, *MemberId, false );
+		break;
+
+	default:
+		break;
+	}
+}
+
+/**
+ * Advertisement packet helpers. Settings are written as a key, a type byte and the bare value, which keeps
+ * a typical session well inside a single LAN_BEACON_MAX_PACKET_SIZE packet.
+ */
+namespace EOSLANPacket
+{
+	/** Bits of the flags byte, in the order they are packed. */
+	enum EFlags : uint8
+	{
+		ShouldAdvertise			= 1 << 0,
+		AllowJoinInProgress		= 1 << 1,
+		UsesPresence			= 1 << 2,
+		AllowJoinViaPresence	= 1 << 3,
+		AllowInvites			= 1 << 4,
+		IsDedicated				= 1 << 5,
+		UsesStats				= 1 << 6,
+		AntiCheatProtected		= 1 << 7
+	};
+
+	/** @return bool True if a setting goes into advertisements. As with EOS sessions, only those advertised via the online service do. */
+	static bool IsAdvertised( const FOnlineSessionSetting& Setting )
+	{
+		if( Setting.AdvertisementType != EOnlineDataAdvertisementType::ViaOnlineService && Setting.AdvertisementType != EOnlineDataAdvertisementType::ViaOnlineServiceAndPing )
+		{
+			return false;
+		}
+
+		return Setting.Data.GetType() != EOnlineKeyValuePairDataType::Empty && Setting.Data.GetType() != EOnlineKeyValuePairDataType::Blob;
+	}
+
+	static void WriteValue( FNboSerializeToBuffer& Packet, const FVariantData& Data )
+	{
+		Packet << (uint8)Data.GetType();
+
+		switch( Data.GetType() )
+		{
+		case EOnlineKeyValuePairDataType::Int32:	{ int32 Value;	Data.GetValue( Value ); Packet << Value; break; }
+		case EOnlineKeyValuePairDataType::UInt32:	{ uint32 Value;	Data.GetValue( Value ); Packet << Value; break; }
+		case EOnlineKeyValuePairDataType::Int64:	{ int64 Value;	Data.GetValue( Value ); Packet << (uint64)Value; break; }
+		case EOnlineKeyValuePairDataType::UInt64:	{ uint64 Value;	Data.GetValue( Value ); Packet << Value; break; }
+		case EOnlineKeyValuePairDataType::Float:	{ float Value;	Data.GetValue( Value ); Packet << Value; break; }
+		case EOnlineKeyValuePairDataType::Double:	{ double Value;	Data.GetValue( Value ); Packet << Value; break; }
+		case EOnlineKeyValuePairDataType::String:	{ FString Value; Data.GetValue( Value ); Packet << Value; break; }
+		case EOnlineKeyValuePairDataType::Bool:		{ bool Value;	Data.GetValue( Value ); Packet << (uint8)( Value ? 1 : 0 ); break; }
+		default:
+			break;
+		}
+	}
+
+	/** @return bool False if the type is not one WriteValue writes. */
+	static bool ReadValue( FNboSerializeFromBuffer& Packet, FVariantData& OutData )
+	{
+		uint8 Type = 0;
+		Packet >> Type;
+
+		switch( (EOnlineKeyValuePairDataType::Type)Type )
+		{
+		case EOnlineKeyValuePairDataType::Int32:	{ int32 Value = 0;		Packet >> Value; OutData.SetValue( Value ); return true; }
+		case EOnlineKeyValuePairDataType::UInt32:	{ uint32 Value = 0;		Packet >> Value; OutData.SetValue( Value ); return true; }
+		case EOnlineKeyValuePairDataType::Int64:	{ uint64 Value = 0;		Packet >> Value; OutData.SetValue( (int64)Value ); return true; }
+		case EOnlineKeyValuePairDataType::UInt64:	{ uint64 Value = 0;		Packet >> Value; OutData.SetValue( Value ); return true; }
+		case EOnlineKeyValuePairDataType::Float:	{ float Value = 0.0f;	Packet >> Value; OutData.SetValue( Value ); return true; }
+		case EOnlineKeyValuePairDataType::Double:	{ double Value = 0.0;	Packet >> Value; OutData.SetValue( Value ); return true; }
+		case EOnlineKeyValuePairDataType::String:	{ FString Value;		Packet >> Value; OutData.SetValue( Value ); return true; }
+		case EOnlineKeyValuePairDataType::Bool:		{ uint8 Value = 0;		Packet >> Value; OutData.SetValue( Value != 0 ); return true; }
+		default:
+			return false;
+		}
+	}
+}
+
+void FOnlineSessionEOS::TickLAN( float DeltaTime )
+{
+	if( LANSession == nullptr || LANSession->GetBeaconState() == ELanBeaconState::NotUsingLanBeacon )
+	{
+		return;
+	}
+
+	const TSharedPtr<FOnlineSessionSearch> SearchSettings = ( LANSession->GetBeaconState() == ELanBeaconState::Searching ) ? CurrentSessionSearch : nullptr;
+	const int32 FirstNewResultIndex = SearchSettings.IsValid() ? SearchSettings->SearchResults.Num() : 0;
+
+	// Drains every packet that arrived since the last tick, without blocking.
+	LANSession->Tick( DeltaTime );
+
+	if( SearchSettings.IsValid() == false )
+	{
+		return;
+	}
+
+	// Everything found this tick is handed out together, once the beacon is done with its packets.
+	if( SearchSettings->SearchResults.Num() > FirstNewResultIndex )
+	{
+		OnFindSessionsPartialResults.Broadcast( SearchSettings.ToSharedRef(), FirstNewResultIndex );
+	}
+
+	// Listeners may have cancelled the search. There is no waiting out the timeout once enough sessions answered.
+	if( CurrentSessionSearch == SearchSettings && ( bLANSearchTimedOut == true || SearchSettings->SearchResults.Num() >= SearchSettings->MaxSearchResults ) )
+	{
+		StopLANSearch();
+
+		bSearchFindInFlight = false;
+		FinishSessionSearch( true );
+	}
+}
+
+FLANSession& FOnlineSessionEOS::GetLANSession()
+{
+	if( LANSession == nullptr )
+	{
+		LANSession = new FLANSession();
+
+		if( LANAnnouncePort > 0 )
+		{
+			LANSession->LanAnnouncePort = LANAnnouncePort;
+		}
+
+		if( LANQueryTimeout > 0.0f )
+		{
+			LANSession->LanQueryTimeout = LANQueryTimeout;
+		}
+	}
+
+	return *LANSession;
+}
+
+bool FOnlineSessionEOS::UpdateLANBeacon()
+{
+	bool bNeedsBeacon = false;
+
+	for( const TPair<FName, TUniquePtr<FNamedOnlineSession>>& Entry : Sessions )
+	{
+		const FOnlineSessionSettings& Settings = Entry.Value->SessionSettings;
+
+		if( Entry.Value->bHosting == true && Settings.bIsLANMatch == true && Settings.bShouldAdvertise == true )
+		{
+			bNeedsBeacon = true;
+			break;
+		}
+	}
+
+	if( LANSession == nullptr && bNeedsBeacon == false )
+	{
+		return true;
+	}
+
+	FLANSession& LAN = GetLANSession();
+	const ELanBeaconState::Type BeaconState = LAN.GetBeaconState();
+
+	// The beacon does one thing at a time. A search keeps it until it completes, which calls back in here.
+	if( BeaconState == ELanBeaconState::Searching )
+	{
+		return true;
+	}
+
+	if( bNeedsBeacon == false )
+	{
+		if( BeaconState != ELanBeaconState::NotUsingLanBeacon )
+		{
+			LAN.StopLANSession();
+		}
+
+		return true;
+	}
+
+	if( BeaconState == ELanBeaconState::Hosting )
+	{
+		return true;
+	}
+
+	FOnValidQueryPacketDelegate QueryDelegate = FOnValidQueryPacketDelegate::CreateRaw( this, &FOnlineSessionEOS::HandleLANQueryPacket );
+
+	if( LAN.Host( QueryDelegate ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot host the LAN beacon on port %d." ), LAN.LanAnnouncePort );
+		LAN.StopLANSession();
+		return false;
+	}
+
+	return true;
+}
+
+bool FOnlineSessionEOS::StartLANSearch( const TSharedRef<FOnlineSessionSearch>& SearchSettings )
+{
+	FLANSession& LAN = GetLANSession();
+
+	// Hosts echo the nonce back, so responses to someone else's query are told apart.
+	const FGuid Nonce = FGuid::NewGuid();
+	LAN.LanNonce = ( (uint64)Nonce.A << 32 ) | (uint64)Nonce.B;
+
+	FNboSerializeToBuffer Packet( LAN_BEACON_MAX_PACKET_SIZE );
+	LAN.CreateClientQueryPacket( Packet, LAN.LanNonce );
+
+	FOnValidResponsePacketDelegate ResponseDelegate = FOnValidResponsePacketDelegate::CreateRaw( this, &FOnlineSessionEOS::HandleLANResponsePacket );
+	FOnSearchingTimeoutDelegate TimeoutDelegate = FOnSearchingTimeoutDelegate::CreateRaw( this, &FOnlineSessionEOS::HandleLANSearchTimeout );
+
+	if( LAN.Search( Packet, ResponseDelegate, TimeoutDelegate ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot search for LAN sessions on port %d." ), LAN.LanAnnouncePort );
+		StopLANSearch();
+		return false;
+	}
+
+	SearchSettings->SearchResults.Reset();
+	SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+
+	// Tracked as the current search, so it can be cancelled like any other. In flight until TickLAN completes it.
+	CurrentSessionSearch = SearchSettings;
+	CurrentSearchCacheKey.Empty();
+	bCurrentSearchIsRevalidation = false;
+	CurrentSearchHandle = nullptr;
+	CurrentSearchId++;
+	bSearchFindInFlight = true;
+	NumSearchResults = 0;
+	NextSearchResultIndex = 0;
+
+	LANSearchSessionIds.Reset();
+	LANSearchStartTime = FPlatformTime::Seconds();
+	bLANSearchTimedOut = false;
+
+	return true;
+}
+
+void FOnlineSessionEOS::StopLANSearch()
+{
+	LANSearchSessionIds.Reset();
+	bLANSearchTimedOut = false;
+
+	if( LANSession != nullptr && LANSession->GetBeaconState() == ELanBeaconState::Searching )
+	{
+		LANSession->StopLANSession();
+	}
+
+	UpdateLANBeacon();
+}
+
+void FOnlineSessionEOS::HandleLANQueryPacket( uint8* PacketData, int32 PacketLength, uint64 ClientNonce )
+{
+	for( const TPair<FName, TUniquePtr<FNamedOnlineSession>>& Entry : Sessions )
+	{
+		const FNamedOnlineSession& Session = *Entry.Value;
+		const FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+		const bool bIsInProgress = ( Session.SessionState == EOnlineSessionState::InProgress );
+		const bool bIsJoinable = Session.bHosting == true && Settings.bIsLANMatch == true && Settings.bShouldAdvertise == true
+			&& Session.SessionState != EOnlineSessionState::Destroying && ( bIsInProgress == false || Settings.bAllowJoinInProgress == true )
+			&& Session.NumOpenPublicConnections > 0;
+
+		if( bIsJoinable == false )
+		{
+			continue;
+		}
+
+		FNboSerializeToBuffer Packet( LAN_BEACON_MAX_PACKET_SIZE );
+		LANSession->CreateHostResponsePacket( Packet, ClientNonce );
+		AppendSessionToPacket( Packet, Session );
+
+		if( Packet.HasOverflow() == true )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot advertise '%s' on the LAN: its settings don't fit in a packet." ), *Entry.Key.ToString() );
+			continue;
+		}
+
+		LANSession->BroadcastPacket( Packet, Packet.GetByteCount() );
+	}
+}
+
+void FOnlineSessionEOS::HandleLANResponsePacket( uint8* PacketData, int32 PacketLength )
+{
+	if( CurrentSessionSearch.IsValid() == false )
+	{
+		return;
+	}
+
+	FOnlineSessionSearchResult SearchResult;
+	FNboSerializeFromBuffer Packet( PacketData, PacketLength );
+
+	if( ReadSessionFromPacket( Packet, SearchResult.Session ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Verbose, TEXT( "Ignoring a malformed LAN advertisement." ) );
+		return;
+	}
+
+	// Hosts with several interfaces answer once per interface.
+	bool bIsAlreadyFound = false;
+	LANSearchSessionIds.Add( SearchResult.Session.GetSessionIdStr(), &bIsAlreadyFound );
+
+	if( bIsAlreadyFound == true )
+	{
+		return;
+	}
+
+	// Time to the first answer of each host, which is as close to a round trip as the beacon gets.
+	SearchResult.PingInMs = FMath::Max( 0, (int32)( ( FPlatformTime::Seconds() - LANSearchStartTime ) * 1000.0 ) );
+
+	CurrentSessionSearch->SearchResults.Add( MoveTemp( SearchResult ) );
+}
+
+void FOnlineSessionEOS::HandleLANSearchTimeout()
+{
+	// Completed from TickLAN, as the beacon is still in the middle of its own Tick.
+	bLANSearchTimedOut = true;
+}
+
+void FOnlineSessionEOS::AppendSessionToPacket( FNboSerializeToBuffer& Packet, const FNamedOnlineSession& Session )
+{
+	const FOnlineSessionInfoEOS* SessionInfo = static_cast<const FOnlineSessionInfoEOS*>( Session.SessionInfo.Get() );
+	const FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+	Packet << SessionInfo->SessionId.ToString();
+
+	// The raw address: 4 bytes for IPv4 hosts, 16 for IPv6 ones.
+	const TArray<uint8> RawIp = SessionInfo->HostAddr.IsValid() ? SessionInfo->HostAddr->GetRawIp() : TArray<uint8>();
+
+	Packet << (uint8)RawIp.Num();
+	for( const uint8 Byte : RawIp )
+	{
+		Packet << Byte;
+	}
+	Packet << (int32)( SessionInfo->HostAddr.IsValid() ? SessionInfo->HostAddr->GetPort() : 0 );
+
+	Packet << ( Session.OwningUserId.IsValid() ? Session.OwningUserId->ToString() : FString() );
+	Packet << Session.OwningUserName;
+	Packet << Settings.BuildUniqueId;
+	Packet << Settings.NumPublicConnections << Settings.NumPrivateConnections;
+	Packet << Session.NumOpenPublicConnections << Session.NumOpenPrivateConnections;
+
+	uint8 Flags = 0;
+	Flags |= Settings.bShouldAdvertise ? EOSLANPacket::ShouldAdvertise : 0;
+	Flags |= Settings.bAllowJoinInProgress ? EOSLANPacket::AllowJoinInProgress : 0;
+	Flags |= Settings.bUsesPresence ? EOSLANPacket::UsesPresence : 0;
+	Flags |= Settings.bAllowJoinViaPresence ? EOSLANPacket::AllowJoinViaPresence : 0;
+	Flags |= Settings.bAllowInvites ? EOSLANPacket::AllowInvites : 0;
+	Flags |= Settings.bIsDedicated ? EOSLANPacket::IsDedicated : 0;
+	Flags |= Settings.bUsesStats ? EOSLANPacket::UsesStats : 0;
+	Flags |= Settings.bAntiCheatProtected ? EOSLANPacket::AntiCheatProtected : 0;
+	Packet << Flags;
+
+	uint8 NumSettings = 0;
+	for( const TPair<FName, FOnlineSessionSetting>& Setting : Settings.Settings )
+	{
+		NumSettings += ( EOSLANPacket::IsAdvertised( Setting.Value ) && NumSettings < MAX_uint8 ) ? 1 : 0;
+	}
+
+	Packet << NumSettings;
+
+	for( const TPair<FName, FOnlineSessionSetting>& Setting : Settings.Settings )
+	{
+		if( NumSettings == 0 )
+		{
+			break;
+		}
+
+		if( EOSLANPacket::IsAdvertised( Setting.Value ) )
+		{
+			Packet << Setting.Key.ToString();
+			EOSLANPacket::WriteValue( Packet, Setting.Value.Data );
+			NumSettings--;
+		}
+	}
+}
+
+bool FOnlineSessionEOS::ReadSessionFromPacket( FNboSerializeFromBuffer& Packet, FOnlineSession& OutSession )
+{
+	FString SessionId;
+	Packet >> SessionId;
+
+	uint8 RawIpLength = 0;
+	Packet >> RawIpLength;
+
+	TArray<uint8> RawIp;
+	RawIp.SetNumUninitialized( RawIpLength );
+	for( uint8& Byte : RawIp )
+	{
+		Packet >> Byte;
+	}
+
+	int32 Port = 0;
+	Packet >> Port;
+
+	FString OwningUserId;
+	Packet >> OwningUserId;
+	Packet >> OutSession.OwningUserName;
+
+	FOnlineSessionSettings& Settings = OutSession.SessionSettings;
+	Packet >> Settings.BuildUniqueId;
+	Packet >> Settings.NumPublicConnections >> Settings.NumPrivateConnections;
+	Packet >> OutSession.NumOpenPublicConnections >> OutSession.NumOpenPrivateConnections;
+
+	uint8 Flags = 0;
+	Packet >> Flags;
+
+	Settings.bIsLANMatch = true;
+	Settings.bShouldAdvertise = ( Flags & EOSLANPacket::ShouldAdvertise ) != 0;
+	Settings.bAllowJoinInProgress = ( Flags & EOSLANPacket::AllowJoinInProgress ) != 0;
+	Settings.bUsesPresence = ( Flags & EOSLANPacket::UsesPresence ) != 0;
+	Settings.bAllowJoinViaPresence = ( Flags & EOSLANPacket::AllowJoinViaPresence ) != 0;
+	Settings.bAllowInvites = ( Flags & EOSLANPacket::AllowInvites ) != 0;
+	Settings.bIsDedicated = ( Flags & EOSLANPacket::IsDedicated ) != 0;
+	Settings.bUsesStats = ( Flags & EOSLANPacket::UsesStats ) != 0;
+	Settings.bAntiCheatProtected = ( Flags & EOSLANPacket::AntiCheatProtected ) != 0;
+
+	uint8 NumSettings = 0;
+	Packet >> NumSettings;
+
+	for( uint8 SettingIdx = 0; SettingIdx < NumSettings; ++SettingIdx )
+	{
+		FString Key;
+		Packet >> Key;
+
+		FVariantData Data;
+		if( EOSLANPacket::ReadValue( Packet, Data ) == false || Packet.HasOverflow() == true )
+		{
+			return false;
+		}
+
+		Settings.Settings.Add( FName( *Key ), FOnlineSessionSetting( Data, EOnlineDataAdvertisementType::ViaOnlineService ) );
+	}
+
+	if( Packet.HasOverflow() == true || SessionId.IsEmpty() || RawIp.Num() == 0 )
+	{
+		return false;
+	}
+
+	TSharedRef<FInternetAddr> HostAddr = ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->CreateInternetAddr();
+	HostAddr->SetRawIp( RawIp );
+	HostAddr->SetPort( Port );
+
+	FOnlineSessionInfoEOS* SessionInfo = new FOnlineSessionInfoEOS( EEOSSession::LANSession, FUniqueNetIdString( SessionId, EOS_SUBSYSTEM ) );
+	SessionInfo->HostAddr = HostAddr;
+
+	OutSession.SessionInfo = MakeShareable( SessionInfo );
+
+	if( OwningUserId.IsEmpty() == false )
+	{
+		OutSession.OwningUserId = MakeShared<FUniqueNetIdString>( OwningUserId, EOS_SUBSYSTEM );
+	}
+
+	return true;
+}
+
+/** Host migration snapshots share the LAN advertisement's value encoding, behind a header of their own. */
+namespace EOSSessionSnapshot
+{
+	/** Bumped whenever the layout changes, so snapshots from other builds are rejected rather than misread. */
+	static const uint8 Version = 1;
+
+	/** Largest snapshot written. A session with a few dozen settings and players takes a couple of KB. */
+	static const int32 MaxSize = 16 * 1024;
+}
+
+bool FOnlineSessionEOS::WriteSessionSnapshot( const FSessionSnapshot& Snapshot, TArray<uint8>& OutBytes )
+{
+	const FOnlineSessionSettings& Settings = Snapshot.Settings;
+	FNboSerializeToBuffer Packet( EOSSessionSnapshot::MaxSize );
+
+	Packet << EOSSessionSnapshot::Version << Snapshot.Sequence;
+	Packet << Snapshot.SessionId << Snapshot.HostKey;
+	Packet << Settings.BuildUniqueId;
+	Packet << Settings.NumPublicConnections << Settings.NumPrivateConnections;
+
+	uint8 Flags = 0;
+	Flags |= Settings.bShouldAdvertise ? EOSLANPacket::ShouldAdvertise : 0;
+	Flags |= Settings.bAllowJoinInProgress ? EOSLANPacket::AllowJoinInProgress : 0;
+	Flags |= Settings.bUsesPresence ? EOSLANPacket::UsesPresence : 0;
+	Flags |= Settings.bAllowJoinViaPresence ? EOSLANPacket::AllowJoinViaPresence : 0;
+	Flags |= Settings.bAllowInvites ? EOSLANPacket::AllowInvites : 0;
+	Flags |= Settings.bIsDedicated ? EOSLANPacket::IsDedicated : 0;
+	Flags |= Settings.bUsesStats ? EOSLANPacket::UsesStats : 0;
+	Flags |= Settings.bAntiCheatProtected ? EOSLANPacket::AntiCheatProtected : 0;
+	Packet << Flags;
+
+	// Unlike an advertisement, the successor needs every setting, advertised or not.
+	int32 NumSettings = 0;
+	for( const TPair<FName, FOnlineSessionSetting>& Setting : Settings.Settings )
+	{
+		NumSettings += ( Setting.Value.Data.GetType() != EOnlineKeyValuePairDataType::Empty && Setting.Value.Data.GetType() != EOnlineKeyValuePairDataType::Blob ) ? 1 : 0;
+	}
+
+	Packet << NumSettings;
+
+	for( const TPair<FName, FOnlineSessionSetting>& Setting : Settings.Settings )
+	{
+		if( Setting.Value.Data.GetType() != EOnlineKeyValuePairDataType::Empty && Setting.Value.Data.GetType() != EOnlineKeyValuePairDataType::Blob )
+		{
+			Packet << Setting.Key.ToString();
+			Packet << (uint8)Setting.Value.AdvertisementType;
+			EOSLANPacket::WriteValue( Packet, Setting.Value.Data );
+		}
+	}
+
+	Packet << Snapshot.PlayerKeys.Num();
+
+	for( const FString& PlayerKey : Snapshot.PlayerKeys )
+	{
+		Packet << PlayerKey;
+	}
+
+	if( Packet.HasOverflow() == true )
+	{
+		return false;
+	}
+
+	OutBytes.Reset( Packet.GetByteCount() );
+	OutBytes.Append( Packet.GetRawBuffer( 0 ), Packet.GetByteCount() );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::ReadSessionSnapshot( const TArray<uint8>& Bytes, FSessionSnapshot& OutSnapshot )
+{
+	FNboSerializeFromBuffer Packet( Bytes.GetData(), Bytes.Num() );
+	FOnlineSessionSettings& Settings = OutSnapshot.Settings;
+
+	uint8 Version = 0;
+	Packet >> Version;
+
+	if( Version != EOSSessionSnapshot::Version )
+	{
+		return false;
+	}
+
+	Packet >> OutSnapshot.Sequence;
+	Packet >> OutSnapshot.SessionId >> OutSnapshot.HostKey;
+	Packet >> Settings.BuildUniqueId;
+	Packet >> Settings.NumPublicConnections >> Settings.NumPrivateConnections;
+
+	uint8 Flags = 0;
+	Packet >> Flags;
+
+	Settings.bIsLANMatch = false;
+	Settings.bShouldAdvertise = ( Flags & EOSLANPacket::ShouldAdvertise ) != 0;
+	Settings.bAllowJoinInProgress = ( Flags & EOSLANPacket::AllowJoinInProgress ) != 0;
+	Settings.bUsesPresence = ( Flags & EOSLANPacket::UsesPresence ) != 0;
+	Settings.bAllowJoinViaPresence = ( Flags & EOSLANPacket::AllowJoinViaPresence ) != 0;
+	Settings.bAllowInvites = ( Flags & EOSLANPacket::AllowInvites ) != 0;
+	Settings.bIsDedicated = ( Flags & EOSLANPacket::IsDedicated ) != 0;
+	Settings.bUsesStats = ( Flags & EOSLANPacket::UsesStats ) != 0;
+	Settings.bAntiCheatProtected = ( Flags & EOSLANPacket::AntiCheatProtected ) != 0;
+
+	int32 NumSettings = 0;
+	Packet >> NumSettings;
+
+	for( int32 SettingIdx = 0; SettingIdx < NumSettings; ++SettingIdx )
+	{
+		FString Key;
+		Packet >> Key;
+
+		uint8 AdvertisementType = 0;
+		Packet >> AdvertisementType;
+
+		FVariantData Data;
+		if( EOSLANPacket::ReadValue( Packet, Data ) == false || Packet.HasOverflow() == true )
+		{
+			return false;
+		}
+
+		Settings.Settings.Add( FName( *Key ), FOnlineSessionSetting( Data, (EOnlineDataAdvertisementType::Type)AdvertisementType ) );
+	}
+
+	int32 NumPlayers = 0;
+	Packet >> NumPlayers;
+
+	// Bounded by what is left of the snapshot, so a corrupt count can't allocate much.
+	for( int32 PlayerIdx = 0; PlayerIdx < NumPlayers && Packet.HasOverflow() == false; ++PlayerIdx )
+	{
+		Packet >> OutSnapshot.PlayerKeys.AddDefaulted_GetRef();
+	}
+
+	return Packet.HasOverflow() == false && OutSnapshot.SessionId.IsEmpty() == false;
+}
+
+FString FOnlineSessionEOS::ElectSuccessor( const FSessionSnapshot& Snapshot )
+{
+	// Case sensitive, so every member orders the ids the same way whatever its locale.
+	FString Successor;
+
+	for( const FString& PlayerKey : Snapshot.PlayerKeys )
+	{
+		if( PlayerKey != Snapshot.HostKey && ( Successor.IsEmpty() || PlayerKey.Compare( Successor, ESearchCase::CaseSensitive ) < 0 ) )
+		{
+			Successor = PlayerKey;
+		}
+	}
+
+	return Successor;
+}
+
+bool FOnlineSessionEOS::GetHostMigrationSnapshot( FName SessionName, TArray<uint8>& OutSnapshot ) const
+{
+	const FHostSnapshotState* SnapshotState = HostSnapshots.Find( SessionName );
+
+	if( SnapshotState == nullptr )
+	{
+		return false;
+	}
+
+	OutSnapshot = SnapshotState->Snapshot;
+	return true;
+}
+
+void FOnlineSessionEOS::TakeHostSnapshots()
+{
+	TArray<TPair<FName, FSessionSnapshot>, TInlineAllocator<4>> Snapshots;
+
+	for( const TPair<FName, TUniquePtr<FNamedOnlineSession>>& Entry : Sessions )
+	{
+		const FNamedOnlineSession& Session = *Entry.Value;
+
+		bool bMigrateHost = false;
+		Session.SessionSettings.Get( SETTING_EOS_HOSTMIGRATION, bMigrateHost );
+
+		// Only while the backend has the session. LAN sessions have nothing to migrate.
+		const bool bIsLive = Session.SessionState != EOnlineSessionState::Creating && Session.SessionState != EOnlineSessionState::Destroying;
+
+		if( Session.bHosting == false || bMigrateHost == false || Session.SessionSettings.bIsLANMatch == true || bIsLive == false || Session.SessionInfo.IsValid() == false )
+		{
+			continue;
+		}
+
+		FSessionSnapshot& Snapshot = Snapshots.Emplace_GetRef( Entry.Key, FSessionSnapshot() ).Value;
+		Snapshot.SessionId = Session.SessionInfo->GetSessionId().ToString();
+		Snapshot.Settings = Session.SessionSettings;
+
+		// Lobby members are known by Product User, session players by whatever id they were registered with.
+		const FLobbyState* LobbyState = LobbyStates.Find( Entry.Key );
+		Snapshot.HostKey = LobbyState != nullptr ? LobbyState->LocalMemberKey : ( Session.OwningUserId.IsValid() ? Session.OwningUserId->ToString() : FString() );
+
+		for( const TSharedRef<const FUniqueNetId>& Player : Session.RegisteredPlayers )
+		{
+			Snapshot.PlayerKeys.Add( LobbyState != nullptr ? GetLobbyMemberKey( *Player ) : Player->ToString() );
+		}
+
+		// Registration order shuffles as players leave, which is no change worth handing out.
+		Snapshot.PlayerKeys.Sort();
+	}
+
+	// Sessions no longer hosted here, or no longer migrating, are forgotten.
+	for( auto It = HostSnapshots.CreateIterator(); It; ++It )
+	{
+		if( Snapshots.ContainsByPredicate( [&It]( const TPair<FName, FSessionSnapshot>& Snapshot ) { return Snapshot.Key == It.Key(); } ) == false )
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	for( TPair<FName, FSessionSnapshot>& Entry : Snapshots )
+	{
+		FHostSnapshotState& SnapshotState = HostSnapshots.FindOrAdd( Entry.Key );
+		FSessionSnapshot& Snapshot = Entry.Value;
+
+		// Written with the last sequence first, so an unchanged session compares equal to its last snapshot.
+		TArray<uint8> Bytes;
+		Snapshot.Sequence = SnapshotState.Sequence;
+
+		if( WriteSessionSnapshot( Snapshot, Bytes ) == false )
+		{
+			UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot snapshot session '%s': it doesn't fit in %d bytes." ), *Entry.Key.ToString(), EOSSessionSnapshot::MaxSize );
+			continue;
+		}
+
+		if( SnapshotState.Snapshot.Num() > 0 && Bytes == SnapshotState.Snapshot )
+		{
+			continue;
+		}
+
+		Snapshot.Sequence = ++SnapshotState.Sequence;
+		WriteSessionSnapshot( Snapshot, SnapshotState.Snapshot );
+
+		OnHostMigrationSnapshot.Broadcast( Entry.Key, SnapshotState.Snapshot );
+	}
+}
+
+bool FOnlineSessionEOS::MigrateSessionHost( FName SessionName, const TArray<uint8>& Snapshot )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+
+	if( Session == nullptr || Session->bHosting == true || HostMigrations.Contains( SessionName ) )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot migrate the host of session '%s': %s" ), *SessionName.ToString(),
+			Session == nullptr ? TEXT( "session does not exist." ) : ( Session->bHosting == true ? TEXT( "it is hosted here." ) : TEXT( "already migrating." ) ) );
+		return false;
+	}
+
+	FHostMigration Migration;
+	const FString SessionId = Session->SessionInfo.IsValid() ? Session->SessionInfo->GetSessionId().ToString() : FString();
+
+	if( ReadSessionSnapshot( Snapshot, Migration.Snapshot ) == false || Migration.Snapshot.SessionId != SessionId )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot migrate the host of session '%s': the snapshot is malformed, or of another session." ), *SessionName.ToString() );
+		return false;
+	}
+
+	Migration.SuccessorKey = ElectSuccessor( Migration.Snapshot );
+
+	if( Migration.SuccessorKey.IsEmpty() )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot migrate the host of session '%s': nobody is left to host it." ), *SessionName.ToString() );
+		return false;
+	}
+
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	Migration.PlayerNum = Session->HostingPlayerNum;
+	Migration.PlayerId = Session->LocalOwnerId;
+	Migration.ProductUserId = ( Identity.IsValid() && Migration.PlayerId.IsValid() ) ? Identity->GetProductUserId( *Migration.PlayerId ) : nullptr;
+
+	const FString LocalProductUserKey = Migration.ProductUserId != nullptr ? UEOSCommon::ProductUserIdToString( Migration.ProductUserId ) : FString();
+	Migration.bIsSuccessor = ( Migration.SuccessorKey == LocalProductUserKey || ( Migration.PlayerId.IsValid() && Migration.SuccessorKey == Migration.PlayerId->ToString() ) );
+
+	Migration.Deadline = FPlatformTime::Seconds() + HostMigrationTimeout;
+
+	FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+	FHostMigration& PendingMigration = HostMigrations.Add( SessionName, MoveTemp( Migration ) );
+
+	if( LobbyState != nullptr )
+	{
+		// The backend promotes someone as soon as the owner leaves. Whoever it picked hands the lobby on to the successor.
+		if( LobbyState->OwnerKey == PendingMigration.SuccessorKey )
+		{
+			if( PendingMigration.bIsSuccessor == true )
+			{
+				TakeOverLobby( SessionName, PendingMigration );
+			}
+
+			CompleteHostMigration( SessionName, true );
+		}
+		else if( LobbyState->OwnerKey == LobbyState->LocalMemberKey )
+		{
+			PromoteLobbyMember( SessionName, *LobbyState, PendingMigration.SuccessorKey );
+		}
+
+		return true;
+	}
+
+	// An EOS session can't change owner, so everyone leaves it for the one the successor creates in its place.
+	if( LeaveMigratedSession( SessionName ) == false )
+	{
+		CompleteHostMigration( SessionName, false );
+		return false;
+	}
+
+	return true;
+}
+
+void FOnlineSessionEOS::TickHostMigrations( double Now )
+{
+	TArray<FName, TInlineAllocator<4>> TimedOut;
+
+	for( TPair<FName, FHostMigration>& Entry : HostMigrations )
+	{
+		FHostMigration& Migration = Entry.Value;
+
+		if( Now >= Migration.Deadline )
+		{
+			TimedOut.Add( Entry.Key );
+			continue;
+		}
+
+		// Followers search until the successor has advertised the new session, then join it.
+		if( Migration.bIsSuccessor == false && Migration.bHasLeft == true && Migration.bSearchInFlight == false && Now >= Migration.NextSearchTime && GetNamedSession( Entry.Key ) == nullptr )
+		{
+			Migration.NextSearchTime = Now + 1.0;
+			Migration.bSearchInFlight = StartMigrationSearch( Entry.Key, Migration );
+		}
+	}
+
+	for( const FName& SessionName : TimedOut )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Timed out migrating the host of session '%s'." ), *SessionName.ToString() );
+		CompleteHostMigration( SessionName, false );
+	}
+}
+
+void FOnlineSessionEOS::TakeOverLobby( FName SessionName, const FHostMigration& Migration )
+{
+	FNamedOnlineSession* Session = GetNamedSession( SessionName );
+	FLobbyState* LobbyState = LobbyStates.Find( SessionName );
+
+	if( Session == nullptr || LobbyState == nullptr )
+	{
+		return;
+	}
+
+	// The snapshot has the settings as the host last had them, including those it never advertised. Members' own are kept.
+	FOnlineSessionSettings Settings = Migration.Snapshot.Settings;
+	RemoveHostSettings( Settings );
+	Settings.MemberSettings = Session->SessionSettings.MemberSettings;
+	Settings.BuildUniqueId = Session->SessionSettings.BuildUniqueId;
+
+	SetSessionSettings( *Session, Settings );
+	Session->bHosting = true;
+	Session->OwningUserId = Migration.PlayerId;
+
+	// Written on the next tick, carrying only what differs from what the backend holds.
+	LobbyState->NumPendingUpdates++;
+}
+
+void FOnlineSessionEOS::PromoteLobbyMember( FName SessionName, const FLobbyState& LobbyState, const FString& SuccessorKey )
+{
+	EOS_HLobby LobbyHandle = GetLobbyHandle();
+
+	if( LobbyHandle == nullptr || LobbyState.LobbyId.IsEmpty() )
+	{
+		return;
+	}
+
+	FEOSScratchArena Arena;
+
+	EOS_Lobby_PromoteMemberOptions PromoteOptions;
+	PromoteOptions.ApiVersion = EOS_LOBBY_PROMOTEMEMBER_API_LATEST;
+	PromoteOptions.LobbyId = Arena.ToUTF8( LobbyState.LobbyId );
+	PromoteOptions.LocalUserId = LobbyState.LocalUserId;
+	PromoteOptions.TargetUserId = EOS_ProductUserId_FromString( Arena.ToUTF8( SuccessorKey ) );
+
+	FLobbyRequestContext* RequestContext = new FLobbyRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+	RequestContext->LocalUserId = LobbyState.LocalUserId;
+
+	EOS_Lobby_PromoteMember( LobbyHandle, &PromoteOptions, RequestContext, PromoteMemberCompleteCallback );
+}
+
+bool FOnlineSessionEOS::LeaveMigratedSession( FName SessionName )
+{
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	if( SessionsHandle == nullptr )
+	{
+		return false;
+	}
+
+	FEOSScratchArena Arena;
+
+	EOS_Sessions_DestroySessionOptions DestroyOptions;
+	DestroyOptions.ApiVersion = EOS_SESSIONS_DESTROYSESSION_API_LATEST;
+	DestroyOptions.SessionName = Arena.ToUTF8( SessionName.ToString() );
+
+	FSessionRequestContext* RequestContext = new FSessionRequestContext();
+	RequestContext->SessionInterface = AsShared();
+	RequestContext->SessionName = SessionName;
+
+	EOS_Sessions_DestroySession( SessionsHandle, &DestroyOptions, RequestContext, MigrationLeaveCompleteCallback );
+
+	return true;
+}
+
+bool FOnlineSessionEOS::StartMigrationSearch( FName SessionName, FHostMigration& Migration )
+{
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+
+	if( SessionsHandle == nullptr )
+	{
+		return false;
+	}
+
+	FEOSLargeScratchArena Arena;
+
+	EOS_Sessions_CreateSessionSearchOptions SearchOptions;
+	SearchOptions.ApiVersion = EOS_SESSIONS_CREATESESSIONSEARCH_API_LATEST;
+	SearchOptions.MaxSearchResults = 1;
+
+	EOS_HSessionSearch SearchHandle = nullptr;
+	EOS_EResult Result = EOS_Sessions_CreateSessionSearch( SessionsHandle, &SearchOptions, &SearchHandle );
+
+	if( Result == EOS_EResult::EOS_Success )
+	{
+		EOS_Sessions_AttributeData Parameter;
+		EOSSessionAttributeSchema::ToAttribute<FSessionAttributeMigratedFromEOS>( Migration.Snapshot.SessionId, Arena, Parameter );
+
+		EOS_SessionSearch_SetParameterOptions ParameterOptions;
+		ParameterOptions.ApiVersion = EOS_SESSIONSEARCH_SETPARAMETER_API_LATEST;
+		ParameterOptions.Parameter = &Parameter;
+		ParameterOptions.ComparisonOp = EOS_EOnlineComparisonOp::EOS_OCO_EQUAL;
+
+		Result = EOS_SessionSearch_SetParameter( SearchHandle, &ParameterOptions );
+	}
+
+	if( Result != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot search for the migrated session '%s': %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( Result ) );
+
+		if( SearchHandle != nullptr )
+		{
+			EOS_SessionSearch_Release( SearchHandle );
+		}
+
+		return false;
+	}
+
+	EOS_SessionSearch_FindOptions FindOptions;
+	FindOptions.ApiVersion = EOS_SESSIONSEARCH_FIND_API_LATEST;
+	FindOptions.LocalUserId = Migration.ProductUserId;
+
+	FMigrationSearchContext* SearchContext = new FMigrationSearchContext();
+	SearchContext->SessionInterface = AsShared();
+	SearchContext->SessionName = SessionName;
+	SearchContext->SearchHandle = SearchHandle;
+
+	EOS_SessionSearch_Find( SearchHandle, &FindOptions, SearchContext, MigrationSearchCompleteCallback );
+
+	return true;
+}
+
+void FOnlineSessionEOS::CompleteHostMigration( FName SessionName, bool bWasSuccessful )
+{
+	FHostMigration Migration;
+
+	if( HostMigrations.RemoveAndCopyValue( SessionName, Migration ) == false )
+	{
+		return;
+	}
+
+	// Lobby successors are elected by Product User, session successors by the id they were registered with.
+	const bool bIsLobby = LobbyStates.Contains( SessionName );
+	FEOSScratchArena Arena;
+	const TSharedRef<const FUniqueNetId> NewHost = bIsLobby ? GetLobbyMemberId( EOS_ProductUserId_FromString( Arena.ToUTF8( Migration.SuccessorKey ) ) ) : GetSessionPlayerId( Migration.SuccessorKey );
+
+	if( bWasSuccessful == false )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to migrate the host of session '%s' to %s." ), *SessionName.ToString(), *Migration.SuccessorKey );
+	}
+	else if( Migration.bIsSuccessor == false && bIsLobby == true )
+	{
+		// Joined EOS sessions already name their new owner.
+		if( FNamedOnlineSession* Session = GetNamedSession( SessionName ) )
+		{
+			Session->OwningUserId = NewHost;
+		}
+	}
+
+	OnSessionHostMigrated.Broadcast( SessionName, *NewHost, bWasSuccessful );
+}
+
+void FOnlineSessionEOS::RemoveHostSettings( FOnlineSessionSettings& Settings )
+{
+	Settings.Remove( SETTING_EOS_P2PHOSTID );
+	Settings.Remove( SETTING_EOS_PARTNERADDR );
+	Settings.Remove( SETTING_EOS_PARTNERQOSPORT );
+	Settings.Remove( SETTING_EOS_QOSPORT );
+}
+
+void FOnlineSessionEOS::MigrationLeaveCompleteCallback( const EOS_Sessions_DestroySessionCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FSessionRequestContext* RequestContext = (FSessionRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = RequestContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleMigrationLeaveComplete( RequestContext->SessionName, Data->ResultCode );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::MigrationSearchCompleteCallback( const EOS_SessionSearch_FindCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FMigrationSearchContext* SearchContext = (FMigrationSearchContext*)Data->ClientData;
+	check( SearchContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = SearchContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleMigrationSearchComplete( SearchContext->SessionName, SearchContext->SearchHandle, Data->ResultCode );
+	}
+	else
+	{
+		// Nobody is left to read the results.
+		EOS_SessionSearch_Release( SearchContext->SearchHandle );
+	}
+
+	delete SearchContext;
+}
+
+void FOnlineSessionEOS::PromoteMemberCompleteCallback( const EOS_Lobby_PromoteMemberCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FLobbyRequestContext* RequestContext = (FLobbyRequestContext*)Data->ClientData;
+	check( RequestContext != nullptr );
+
+	// Nothing else to do, the successor completes the migration once notified of its promotion.
+	if( Data->ResultCode != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to hand lobby '%s' to its elected host: %s" ), *RequestContext->SessionName.ToString(), *UEOSCommon::EOSResultToString( Data->ResultCode ) );
+	}
+
+	delete RequestContext;
+}
+
+void FOnlineSessionEOS::HandleMigrationLeaveComplete( FName SessionName, EOS_EResult ResultCode )
+{
+	FHostMigration* Migration = HostMigrations.Find( SessionName );
+
+	if( Migration == nullptr )
+	{
+		// Timed out in the meantime.
+		return;
+	}
+
+	// Whether or not the backend still had us, the old session is of no more use.
+	if( ResultCode != EOS_EResult::EOS_Success && ResultCode != EOS_EResult::EOS_NotFound )
+	{
+		UE_LOG_ONLINE_SESSION( Verbose, TEXT( "Failed to leave session '%s' behind: %s" ), *SessionName.ToString(), *UEOSCommon::EOSResultToString( ResultCode ) );
+	}
+
+	RemoveNamedSession( SessionName );
+	Migration->bHasLeft = true;
+
+	if( Migration->bIsSuccessor == false )
+	{
+		Migration->NextSearchTime = FPlatformTime::Seconds();
+		return;
+	}
+
+	FOnlineSessionSettings Settings = Migration->Snapshot.Settings;
+	RemoveHostSettings( Settings );
+	Settings.Set( SETTING_EOS_MIGRATEDFROM, Migration->Snapshot.SessionId, EOnlineDataAdvertisementType::ViaOnlineService );
+
+	// Completed along with the creation. Copied, as the migration may complete before this returns.
+	const int32 PlayerNum = Migration->PlayerNum;
+	const TSharedPtr<const FUniqueNetId> PlayerId = Migration->PlayerId;
+
+	MigrationSessionCalls.Add( SessionName );
+
+	if( CreateSessionInternal( PlayerNum, PlayerId, Migration->ProductUserId, SessionName, Settings ) == false )
+	{
+		CompleteHostMigration( SessionName, false );
+	}
+}
+
+void FOnlineSessionEOS::HandleMigrationSearchComplete( FName SessionName, EOS_HSessionSearch SearchHandle, EOS_EResult ResultCode )
+{
+	FHostMigration* Migration = HostMigrations.Find( SessionName );
+	FOnlineSessionSearchResult SearchResult;
+	bool bWasFound = false;
+
+	if( Migration != nullptr && ResultCode == EOS_EResult::EOS_Success )
+	{
+		EOS_SessionSearch_GetSearchResultCountOptions CountOptions;
+		CountOptions.ApiVersion = EOS_SESSIONSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
+
+		EOS_SessionSearch_CopySearchResultByIndexOptions CopyOptions;
+		CopyOptions.ApiVersion = EOS_SESSIONSEARCH_COPYSEARCHRESULTBYINDEX_API_LATEST;
+		CopyOptions.SessionIndex = 0;
+
+		EOS_HSessionDetails SessionDetails = nullptr;
+
+		bWasFound = EOS_SessionSearch_GetSearchResultCount( SearchHandle, &CountOptions ) > 0
+			&& EOS_SessionSearch_CopySearchResultByIndex( SearchHandle, &CopyOptions, &SessionDetails ) == EOS_EResult::EOS_Success
+			&& ToSearchResult( SessionDetails, SearchResult ) == true;
+	}
+
+	EOS_SessionSearch_Release( SearchHandle );
+
+	if( Migration == nullptr )
+	{
+		return;
+	}
+
+	// Searched for again on a later tick if not advertised yet, or if the join fails before it reaches the backend.
+	Migration->bSearchInFlight = false;
+
+	if( bWasFound == false )
+	{
+		return;
+	}
+
+	MigrationSessionCalls.Add( SessionName );
+	JoinSessionInternal( Migration->PlayerNum, Migration->PlayerId, Migration->ProductUserId, SessionName, SearchResult );
+}
+
+bool FOnlineSessionEOS::StartQuickJoinPool( int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings )
+{
+	bool bSearchLobbies = false;
+
+	if( QuickJoinPool.IsEnabled() == false || SearchSettings->bIsLanQuery == true || ( SearchSettings->QuerySettings.Get( SEARCH_LOBBIES, bSearchLobbies ) && bSearchLobbies == true ) )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Cannot keep a quick-join pool: it is turned off, or the search is not for EOS sessions." ) );
+		return false;
+	}
+
+	StopQuickJoinPool();
+
+	// Copied, as the caller may go on to use the search for something else.
+	QuickJoinSearch = MakeShared<FOnlineSessionSearch>();
+	QuickJoinSearch->QuerySettings = SearchSettings->QuerySettings;
+	QuickJoinSearch->MaxSearchResults = SearchSettings->MaxSearchResults;
+	QuickJoinPlayerNum = SearchingPlayerNum;
+
+	StartQuickJoinRefresh( FPlatformTime::Seconds() );
+
+	return true;
+}
+
+void FOnlineSessionEOS::StopQuickJoinPool()
+{
+	QuickJoinSearch.Reset();
+	QuickJoinRefreshId++;
+	QuickJoinPool.Empty();
+}
+
+bool FOnlineSessionEOS::QuickJoinSession( int32 PlayerNum, FName SessionName )
+{
+	FOnlineSessionSearchResult SearchResult;
+
+	if( QuickJoinPool.Take( FPlatformTime::Seconds(), SearchResult ) == false )
+	{
+		return false;
+	}
+
+	return JoinSession( PlayerNum, SessionName, SearchResult );
+}
+
+int32 FOnlineSessionEOS::GetNumQuickJoinCandidates() const
+{
+	return QuickJoinPool.Num();
+}
+
+const FSessionQuickJoinStatsEOS& FOnlineSessionEOS::GetQuickJoinStats() const
+{
+	return QuickJoinPool.GetStats();
+}
+
+void FOnlineSessionEOS::TickQuickJoinPool( double Now )
+{
+	QuickJoinPool.Prune( Now );
+
+	if( QuickJoinPool.NeedsRefresh( Now ) )
+	{
+		StartQuickJoinRefresh( Now );
+	}
+}
+
+void FOnlineSessionEOS::StartQuickJoinRefresh( double Now )
+{
+	QuickJoinPool.BeginRefresh( Now );
+
+	TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> Identity = StaticCastSharedPtr<FOnlineIdentityEOS>( EOSSubsystem->GetIdentityInterface() );
+
+	EOS_HSessions SessionsHandle = GetSessionsHandle();
+	EOS_ProductUserId ProductUserId = Identity.IsValid() ? Identity->GetProductUserId( QuickJoinPlayerNum ) : nullptr;
+
+	// Tried again once QuickJoinMinRefreshSeconds have passed, e.g. once the player has logged in.
+	if( SessionsHandle == nullptr || ProductUserId == nullptr )
+	{
+		QuickJoinPool.FailRefresh();
+		return;
+	}
+
+	EOS_Sessions_CreateSessionSearchOptions SearchOptions;
+	SearchOptions.ApiVersion = EOS_SESSIONS_CREATESESSIONSEARCH_API_LATEST;
+	SearchOptions.MaxSearchResults = (uint32_t)FMath::Clamp( QuickJoinPool.GetMaxResults(), 1, EOS_SESSIONS_MAX_SEARCH_RESULTS );
+
+	EOS_HSessionSearch SearchHandle = nullptr;
+	const EOS_EResult Result = EOS_Sessions_CreateSessionSearch( SessionsHandle, &SearchOptions, &SearchHandle );
+
+	if( Result != EOS_EResult::EOS_Success || ApplySearchParameters( SearchHandle, *QuickJoinSearch ) == false )
+	{
+		UE_LOG_ONLINE_SESSION( Verbose, TEXT( "Cannot refresh the quick-join pool: %s" ), *UEOSCommon::EOSResultToString( Result ) );
+
+		if( SearchHandle != nullptr )
+		{
+			EOS_SessionSearch_Release( SearchHandle );
+		}
+
+		QuickJoinPool.FailRefresh();
+		return;
+	}
+
+	EOS_SessionSearch_FindOptions FindOptions;
+	FindOptions.ApiVersion = EOS_SESSIONSEARCH_FIND_API_LATEST;
+	FindOptions.LocalUserId = ProductUserId;
+
+	FQuickJoinSearchContext* SearchContext = new FQuickJoinSearchContext();
+	SearchContext->SessionInterface = AsShared();
+	SearchContext->RefreshId = QuickJoinRefreshId;
+	SearchContext->SearchHandle = SearchHandle;
+
+	EOS_SessionSearch_Find( SearchHandle, &FindOptions, SearchContext, QuickJoinSearchCompleteCallback );
+}
+
+void FOnlineSessionEOS::QuickJoinSearchCompleteCallback( const EOS_SessionSearch_FindCallbackInfo* Data )
+{
+	check( Data != NULL );
+
+	FQuickJoinSearchContext* SearchContext = (FQuickJoinSearchContext*)Data->ClientData;
+	check( SearchContext != nullptr );
+
+	TSharedPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface = SearchContext->SessionInterface.Pin();
+
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->HandleQuickJoinSearchComplete( SearchContext->RefreshId, SearchContext->SearchHandle, Data->ResultCode );
+	}
+	else
+	{
+		// Nobody is left to read the results.
+		EOS_SessionSearch_Release( SearchContext->SearchHandle );
+	}
+
+	delete SearchContext;
+}
+
+void FOnlineSessionEOS::HandleQuickJoinSearchComplete( uint32 RefreshId, EOS_HSessionSearch SearchHandle, EOS_EResult ResultCode )
+{
+	// The pool was stopped or restarted in the meantime.
+	if( RefreshId != QuickJoinRefreshId )
+	{
+		EOS_SessionSearch_Release( SearchHandle );
+		return;
+	}
+
+	// Nothing matching is a successful refresh, and leaves the pool empty rather than serving what it had.
+	if( ResultCode == EOS_EResult::EOS_NotFound )
+	{
+		EOS_SessionSearch_Release( SearchHandle );
+		QuickJoinPool.Store( TArray<FOnlineSessionSearchResult>(), FPlatformTime::Seconds() );
+		return;
+	}
+
+	if( ResultCode != EOS_EResult::EOS_Success )
+	{
+		UE_LOG_ONLINE_SESSION( Verbose, TEXT( "Failed to refresh the quick-join pool: %s" ), *UEOSCommon::EOSResultToString( ResultCode ) );
+
+		EOS_SessionSearch_Release( SearchHandle );
+		QuickJoinPool.FailRefresh();
+		return;
+	}
+
+	EOS_SessionSearch_GetSearchResultCountOptions CountOptions;
+	CountOptions.ApiVersion = EOS_SESSIONSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
+
+	EOS_SessionSearch_CopySearchResultByIndexOptions CopyOptions;
+	CopyOptions.ApiVersion = EOS_SESSIONSEARCH_COPYSEARCHRESULTBYINDEX_API_LATEST;
+
+	const uint32 NumResults = EOS_SessionSearch_GetSearchResultCount( SearchHandle, &CountOptions );
+
+	TArray<FOnlineSessionSearchResult> Results;
+	Results.Reserve( NumResults );
+
+	for( uint32 ResultIdx = 0; ResultIdx < NumResults; ++ResultIdx )
+	{
+		CopyOptions.SessionIndex = ResultIdx;
+
+		EOS_HSessionDetails SessionDetails = nullptr;
+		if( EOS_SessionSearch_CopySearchResultByIndex( SearchHandle, &CopyOptions, &SessionDetails ) != EOS_EResult::EOS_Success )
+		{
+			continue;
+		}
+
+		FOnlineSessionSearchResult SearchResult;
+		if( ToSearchResult( SessionDetails, SearchResult ) == true )
+		{
+			Results.Add( MoveTemp( SearchResult ) );
+		}
+	}
+
+	EOS_SessionSearch_Release( SearchHandle );
 
+	QuickJoinPool.Store( Results, FPlatformTime::Seconds() );
 }
 
 /** Implementation of the ConnectionMethod converters */
@@ -6,19 +6,178 @@
 #include "CoreMinimal.h"
 #include "UObject/CoreOnline.h"
 #include "Misc/ScopeLock.h"
+#include "Misc/Optional.h"
+#include "Templates/UniquePtr.h"
 #include "OnlineKeyValuePair.h"
 #include "OnlineSessionSettings.h"
 #include "Interfaces/OnlineSessionInterface.h"
 
 // EOS Includes
 #include "OnlineSubsystemEOSTypes.h"
+#include "OnlineSessionSearchCacheEOS.h"
+#include "OnlineSessionQosEOS.h"
+#include "OnlineSessionMatchmakerEOS.h"
+#include "OnlineSessionLobbyEOS.h"
+#include "OnlineSessionSettingsDiffEOS.h"
+#include "OnlineSessionTraceEOS.h"
+#include "OnlineSessionInviteEOS.h"
+#include "OnlineSessionQuickJoinPoolEOS.h"
+
+// EOS SDK Includes
+#include "eos_sdk.h"
+#include "eos_sessions.h"
+#include "eos_lobby.h"
 
 
 // Forward Declarations
 class FOnlineSubsystemEOS;
 class FLANSession;
 class FNamedOnlineSession;
+class FNboSerializeToBuffer;
+class FNboSerializeFromBuffer;
+
+/** Session setting naming the EOS bucket a session is created in. Defaults to SessionBucketId from config. */
+#define SETTING_EOS_BUCKETID FName( TEXT( "EOS_BUCKETID" ) )
+
+/** Session attribute advertising FOnlineSessionSettings::BuildUniqueId, so searches can skip incompatible builds. */
+#define SETTING_EOS_BUILDID FName( TEXT( "EOS_BUILDID" ) )
+
+/**
+ * Session setting that, when true, backs the session with an EOS lobby rather than an EOS session. Lobbies
+ * suit parties: every member can see and set attributes of their own, and changes reach everyone as they happen.
+ * Set it with EOnlineDataAdvertisementType::DontAdvertise. Search for lobbies with SEARCH_LOBBIES.
+ */
+#define SETTING_EOS_USELOBBY FName( TEXT( "EOS_USELOBBY" ) )
+
+/** Session attribute holding a host's Product User Id, for reaching it over EOS P2P. Not advertised until there is a P2P net driver. */
+#define SETTING_EOS_P2PHOSTID FName( TEXT( "EOS_P2PHOSTID" ) )
+
+/** Session attribute advertising the ip:port of a partner-hosted relay in front of the host. From SessionPartnerHostAddress in config. */
+#define SETTING_EOS_PARTNERADDR FName( TEXT( "EOS_PARTNERADDR" ) )
+
+/** Session attribute advertising the port the partner-hosted relay answers QoS probes on, if it does. From SessionPartnerQosPort in config. */
+#define SETTING_EOS_PARTNERQOSPORT FName( TEXT( "EOS_PARTNERQOSPORT" ) )
+
+/**
+ * Session setting that, when true, lets the session outlive its host leaving. The host snapshots the session every
+ * HostSnapshotIntervalSeconds, and passes each snapshot that changed to OnHostMigrationSnapshot, for the game to
+ * hand to its clients. Set it with EOnlineDataAdvertisementType::DontAdvertise.
+ */
+#define SETTING_EOS_HOSTMIGRATION FName( TEXT( "EOS_HOSTMIGRATION" ) )
+
+/** Session attribute advertising the id of the session a migrated host re-created this one from. Set by MigrateSessionHost. */
+#define SETTING_EOS_MIGRATEDFROM FName( TEXT( "EOS_MIGRATEDFROM" ) )
+
+/** Search key restricting results to sessions with at least this many open slots. */
+#define SEARCH_EOS_MINSLOTSAVAILABLE FName( TEXT( "EOS_MINSLOTSAVAILABLE" ) )
+
+/**
+ * Delegate fired as FindSessions results stream in, ahead of OnFindSessionsComplete.
+ *
+ * @param SearchSettings The search whose SearchResults grew.
+ * @param FirstNewResultIndex Index of the first result added since the previous notification.
+ */
+DECLARE_MULTICAST_DELEGATE_TwoParams( FOnFindSessionsPartialResultsEOS, const TSharedRef<FOnlineSessionSearch>& /*SearchSettings*/, int32 /*FirstNewResultIndex*/ );
+
+/**
+ * Delegate fired when a search that was served stale from the cache has been refreshed from the backend.
+ *
+ * @param SearchSettings The search whose SearchResults were replaced.
+ */
+DECLARE_MULTICAST_DELEGATE_OneParam( FOnSessionSearchRevalidatedEOS, const TSharedRef<FOnlineSessionSearch>& /*SearchSettings*/ );
+
+/**
+ * Delegate fired as each friend's sessions are found, ahead of OnFindFriendSessionComplete.
+ *
+ * @param LocalUserNum The Local User searching.
+ * @param Friend The friend whose sessions were found.
+ * @param FriendSearchResults The sessions the friend is in.
+ */
+DECLARE_MULTICAST_DELEGATE_ThreeParams( FOnFindFriendSessionPartialResultsEOS, int32 /*LocalUserNum*/, const FUniqueNetId& /*Friend*/, const TArray<FOnlineSessionSearchResult>& /*FriendSearchResults*/ );
+
+/**
+ * Delegate fired once every invite of a SendSessionInviteToFriend(s) call has been sent, or has failed.
+ *
+ * @param LocalUserId The Local User the invites are from.
+ * @param SessionName The session the friends were invited to.
+ * @param Sent Friends the backend accepted an invite for.
+ * @param Failed Friends that could not be invited.
+ */
+DECLARE_MULTICAST_DELEGATE_FourParams( FOnSendSessionInvitesCompleteEOS, const FUniqueNetId& /*LocalUserId*/, FName /*SessionName*/, const TArray<TSharedRef<const FUniqueNetId>>& /*Sent*/, const TArray<TSharedRef<const FUniqueNetId>>& /*Failed*/ );
+
+/**
+ * Delegate fired when the host of a session with SETTING_EOS_HOSTMIGRATION takes a snapshot that differs from its last.
+ *
+ * @param SessionName The session snapshotted.
+ * @param Snapshot The session's settings and registered players, to pass to MigrateSessionHost should the host leave.
+ */
+DECLARE_MULTICAST_DELEGATE_TwoParams( FOnHostMigrationSnapshotEOS, FName /*SessionName*/, const TArray<uint8>& /*Snapshot*/ );
+
+/**
+ * Delegate fired once a MigrateSessionHost call has completed.
+ *
+ * @param SessionName The session that changed hosts. If this instance is the new host, the session is now hosted here.
+ * @param NewHost The player elected to host the session.
+ * @param bWasSuccessful Whether the session is back up under its new host.
+ */
+DECLARE_MULTICAST_DELEGATE_ThreeParams( FOnSessionHostMigratedEOS, FName /*SessionName*/, const FUniqueNetId& /*NewHost*/, bool /*bWasSuccessful*/ );
+
+/**
+ * What one session hosted through EOS_Sessions has asked of the backend, and how much memory it holds.
+ */
+struct FSessionHostStatsEOS
+{
+	/** Session writes sent, including the creation. */
+	int32									NumWrites;
+
+	/** Flushes that found nothing changed, so sent nothing. */
+	int32									NumWritesSkipped;
+
+	/** UpdateSession calls merged into writes. */
+	int32									NumUpdatesMerged;
+
+	/** Register and unregister requests sent. */
+	int32									NumRegistrationRequests;
+
+	/** Start and end requests sent. */
+	int32									NumStateRequests;
+
+	/** Requests of any kind the backend failed. */
+	int32									NumFailedRequests;
+
+	/** Bytes held by the session and its backend state, not counting the contents of strings and ids. */
+	SIZE_T									AllocatedSize;
+
+	FSessionHostStatsEOS()
+		: NumWrites( 0 )
+		, NumWritesSkipped( 0 )
+		, NumUpdatesMerged( 0 )
+		, NumRegistrationRequests( 0 )
+		, NumStateRequests( 0 )
+		, NumFailedRequests( 0 )
+		, AllocatedSize( 0 )
+	{}
+};
+
+/**
+ * How quickly RejoinSession gets clients back into the session they dropped out of.
+ */
+struct FSessionRejoinStatsEOS
+{
+	/** Seconds from RejoinSession to the join completing, of every rejoin that succeeded. */
+	FSessionLatencyHistogramEOS				Latencies;
+
+	/** Seconds the last successful rejoin took. */
+	double									LastSeconds;
 
+	/** Rejoins the backend or the session turned down. */
+	int32									NumFailed;
+
+	FSessionRejoinStatsEOS()
+		: LastSeconds( 0.0 )
+		, NumFailed( 0 )
+	{}
+};
 
 
 /**
@@ -26,19 +185,167 @@ class FNamedOnlineSession;
  * Session services are defined as anything related managing a session
  * and its state within a platform service
  */
-class FOnlineSessionEOS : public IOnlineSession
+class FOnlineSessionEOS : public IOnlineSession, public TSharedFromThis<FOnlineSessionEOS, ESPMode::ThreadSafe>
 {
 
 public:
 
+	/** Fired as FindSessions results are copied out of the backend search, starting with the first one. */
+	FOnFindSessionsPartialResultsEOS		OnFindSessionsPartialResults;
+
+	/** Fired once stale cached results handed out by FindSessions have been refreshed. */
+	FOnSessionSearchRevalidatedEOS			OnSessionSearchRevalidated;
+
+	/** Fired as FindFriendSession finds each friend's sessions, so a friends list fills in as searches complete. */
+	FOnFindFriendSessionPartialResultsEOS	OnFindFriendSessionPartialResults;
+
+	/** Fired once per SendSessionInviteToFriend(s) call, when all of its invites have completed. */
+	FOnSendSessionInvitesCompleteEOS		OnSendSessionInvitesComplete;
+
+	/** Fired on the host as snapshots of sessions with SETTING_EOS_HOSTMIGRATION change. */
+	FOnHostMigrationSnapshotEOS				OnHostMigrationSnapshot;
+
+	/** Fired once per MigrateSessionHost call. */
+	FOnSessionHostMigratedEOS				OnSessionHostMigrated;
+
+	/** @return The session search cache's hit rate and staleness counters. */
+	const FSessionSearchCacheStatsEOS&		GetSearchCacheStats() const;
+
+	/** Drops every cached search, so the next FindSessions goes to the backend. */
+	void									FlushSearchCache();
+
+	/**
+	* Gets the backend requests and memory of a session hosted through EOS_Sessions.
+	*
+	* @return bool False if the session is not hosted through EOS_Sessions.
+	*/
+	bool									GetSessionHostStats( FName SessionName, FSessionHostStatsEOS& OutStats );
+
+	/**
+	* Measures the latency to the host of every result of a search, concurrently. Fills in PingInMs and
+	* triggers OnPingSearchResultsComplete once every host has replied or timed out.
+	*
+	* @param bSortByPing Whether to sort SearchResults by PingInMs, lowest first, once measured.
+	* @return bool True if any result could be pinged.
+	*/
+	bool									PingSearchResults( const TSharedRef<FOnlineSessionSearch>& SearchSettings, bool bSortByPing );
+
+	/** Sorts a search's results by PingInMs, lowest first. Results with equal pings keep their order. */
+	static void								SortSearchResultsByPing( FOnlineSessionSearch& SearchSettings );
+
+	/**
+	* Sets the local member's own attributes in a lobby session. Like UpdateSession, calls are merged and
+	* written on the next tick, and only the keys that changed since the last write are sent.
+	*
+	* @param MemberSettings The member's settings. Those advertised via the online service become member attributes.
+	* @return bool False if the session is not a lobby.
+	*/
+	bool									UpdateLobbyMemberSettings( FName SessionName, const FSessionSettings& MemberSettings );
+
+	/**
+	* Gets the latest snapshot of a session this instance hosts, as last passed to OnHostMigrationSnapshot.
+	*
+	* @return bool False if the session has no SETTING_EOS_HOSTMIGRATION, or has not been snapshotted yet.
+	*/
+	bool									GetHostMigrationSnapshot( FName SessionName, TArray<uint8>& OutSnapshot ) const;
+
+	/**
+	* Moves a session whose host left to a successor, elected from the snapshot so every member agrees on it.
+	*
+	* Lobbies carry on under the successor, who is promoted to owner. EOS_Sessions can't change owner, so the
+	* successor creates the session again from the snapshot, advertising SETTING_EOS_MIGRATEDFROM, and everyone
+	* else leaves the old one to join it. Triggers OnSessionHostMigrated once done, and nothing else: the create
+	* and join made along the way don't trigger OnCreateSessionComplete or OnJoinSessionComplete.
+	*
+	* @param Snapshot The last snapshot the host took of the session.
+	* @return bool False if the snapshot is not of the session, or the session is hosted here.
+	*/
+	bool									MigrateSessionHost( FName SessionName, const TArray<uint8>& Snapshot );
+
+	/**
+	* Joins the session last left again, for a while after leaving it. The session is joined as it was found, along
+	* with its connect strings and measured connection methods, so there is no search, resolution or probe. Players
+	* registered in it are registered again once back in. Triggers OnJoinSessionComplete.
+	*
+	* @return bool False if there is no rejoin ticket for the session, or it expired after RejoinTicketSeconds.
+	*/
+	bool									RejoinSession( FName SessionName );
+
+	/** @return bool True if RejoinSession can be called for the session. */
+	bool									HasRejoinTicket( FName SessionName ) const;
+
+	/** @return How long RejoinSession calls took. */
+	const FSessionRejoinStatsEOS&			GetRejoinStats() const;
+
+	/**
+	* Keeps a pool of joinable sessions matching a search, refreshed in the background, so QuickJoinSession can
+	* join one without searching. Replaces the search of a pool already running.
+	*
+	* @return bool False if the search is for LAN sessions or lobbies, or the pool is turned off in config.
+	*/
+	bool									StartQuickJoinPool( int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings );
+
+	/** Stops refreshing the quick-join pool, and drops its candidates. */
+	void									StopQuickJoinPool();
+
+	/**
+	* Joins the best candidate of the quick-join pool, which is used up. Triggers OnJoinSessionComplete, unless
+	* the pool had no candidate.
+	*
+	* @return bool False if the pool has no candidate, so the caller should search, or the join could not start.
+	*/
+	bool									QuickJoinSession( int32 PlayerNum, FName SessionName );
+
+	/** @return int32 Number of sessions QuickJoinSession could pick from right now. */
+	int32									GetNumQuickJoinCandidates() const;
+
+	/** @return The quick-join pool's hit rate and refresh counters. */
+	const FSessionQuickJoinStatsEOS&		GetQuickJoinStats() const;
+
 PACKAGE_SCOPE :
 
 	FOnlineSessionEOS( FOnlineSubsystemEOS* InSubsystem )
-		: EOSSubsystem( InSubsystem )
+		: NumPresenceSessions( 0 )
+		, SessionWritesPerTick( 64 )
+		, bQosResponder( true )
+		, DefaultBucketId( TEXT( "Default" ) )
+		, SearchMaxResults( EOS_SESSIONS_MAX_SEARCH_RESULTS )
+		, RegisterPlayersChunkSize( EOS_SESSIONS_MAXREGISTEREDPLAYERS )
+		, PartnerQosPort( 0 )
+		, bJoinQos( true )
+		, RejoinTicketSeconds( 60.0f )
+		, HostMigrationTimeout( 30.0f )
+		, LANAnnouncePort( 0 )
+		, LANQueryTimeout( 0.0f )
+		, LobbyUpdateNotificationId( EOS_INVALID_NOTIFICATIONID )
+		, LobbyMemberUpdateNotificationId( EOS_INVALID_NOTIFICATIONID )
+		, LobbyMemberStatusNotificationId( EOS_INVALID_NOTIFICATIONID )
+		, EOSSubsystem( InSubsystem )
 		, LANSession( nullptr )
-	{}
+		, LANSearchStartTime( 0.0 )
+		, bLANSearchTimedOut( false )
+		, CurrentSearchHandle( nullptr )
+		, CurrentSearchId( 0 )
+		, bSearchFindInFlight( false )
+		, NumSearchResults( 0 )
+		, NextSearchResultIndex( 0 )
+		, SearchResultsPerTick( 16 )
+		, bCurrentSearchIsRevalidation( false )
+		, NextFriendSearchId( 0 )
+		, FriendSearchConcurrency( 16 )
+		, LastHostSnapshotTime( 0.0 )
+		, HostSnapshotInterval( 5.0f )
+		, QuickJoinPlayerNum( 0 )
+		, QuickJoinRefreshId( 0 )
+	{
+		SearchCache.Init();
+		SessionTracer.Init();
+		InviteQueue.Init();
+		QuickJoinPool.Init();
+		LoadConfig();
+	}
 
-	virtual ~FOnlineSessionEOS() {}
+	virtual ~FOnlineSessionEOS();
 
 	// IOnlineSession
 
@@ -50,7 +357,7 @@ PACKAGE_SCOPE :
 	 * @param SessionName the name to search for
 	 * @param GameSettings the game settings to add
 	 *
-	 * @return a pointer to the struct that was added
+	 * @return a pointer to the struct that was added, nullptr if a session of that name already exists
 	 */
 	FNamedOnlineSession*					AddNamedSession( FName SessionName, const FOnlineSessionSettings& SessionSettings ) override;
 	
@@ -60,7 +367,7 @@ PACKAGE_SCOPE :
 	 * @param SessionName the name to search for
 	 * @param GameSettings the game settings to add
 	 *
-	 * @return a pointer to the struct that was added
+	 * @return a pointer to the struct that was added, nullptr if a session of that name already exists
 	 */
 	FNamedOnlineSession*					AddNamedSession( FName SessionName, const FOnlineSession& Session ) override;
 	
@@ -73,7 +380,7 @@ PACKAGE_SCOPE :
 	 *
 	 * @return pointer to the struct if found, NULL otherwise
 	 */
-	inline FNamedOnlineSession*				GetNamedSessionFromLobbyId( FUniqueNetIdEOS& LobbyId );
+	inline FNamedOnlineSession*				GetNamedSessionFromLobbyId( const FUniqueNetId& LobbyId );
 	
 	virtual void							RemoveNamedSession( FName SessionName ) override;
 	virtual bool							HasPresenceSession() override;
@@ -115,26 +422,1088 @@ PACKAGE_SCOPE :
 	virtual int32							GetNumSessions() override;
 	virtual void							DumpSessionState() override;
 
+	/** Flushes the UpdateSession calls made since the last tick. Called from the owning subsystem. */
+	void									Tick( float DeltaTime );
+
+	/** Services the LAN beacon. Called from the owning subsystem, whether or not EOS is available. */
+	void									TickLAN( float DeltaTime );
+
+	/** @return The QoS prober, created on first use. */
+	FSessionQosProberEOS&					GetQosProber();
+
+	/**
+	* Starts answering QoS probes, if not already.
+	*
+	* @param Port The port to listen on, 0 for any.
+	* @return bool True if the responder is running.
+	*/
+	bool									StartQosResponder( int32 Port );
+
+	/** Stops answering QoS probes once no session hosted through EOS_Sessions is left. */
+	void									StopIdleQosResponder();
+
 protected:
 
-	/** Critical sections for thread safe operation of session lists */
-	mutable FCriticalSection				SessionLock;
+	/**
+	* Current sessions, by name. Heap allocated so pointers handed out stay valid until the session is removed.
+	* Game thread only, like the rest of the interface: the sessions are handed out and changed in place with no lock held.
+	*/
+	TMap<FName, TUniquePtr<FNamedOnlineSession>> Sessions;
+
+	/** Current sessions, by the backend session (or lobby) id, once one has been issued. */
+	TMap<FString, FNamedOnlineSession*>		SessionsById;
+
+	/** Number of current sessions that use presence. */
+	int32									NumPresenceSessions;
+
+	/** Reads the session options from [OnlineSubsystemEOS] in the Engine ini, once, on construction. */
+	void									LoadConfig();
 
-	/** Current session settings */
-	TArray<FNamedOnlineSession>				Sessions;
+	/** Stores a new session and indexes it. Refused if a session of the same name exists. */
+	FNamedOnlineSession*					AddNamedSessionInternal( TUniquePtr<FNamedOnlineSession>&& NewSession );
+
+	/** Adds a session to the id index, once its session info carries a valid id. Requires the write lock. */
+	void									IndexSessionId( FNamedOnlineSession& Session );
+
+	/** Removes a session from the id index. Requires the write lock. */
+	void									UnindexSessionId( FNamedOnlineSession& Session );
+
+	/** Updates a session's id, keeping the id index in sync. */
+	void									SetSessionId( FName SessionName, const FUniqueNetIdString& SessionId );
+
+	/** Replaces a session's settings, keeping the presence count in sync. */
+	void									SetSessionSettings( FNamedOnlineSession& Session, const FOnlineSessionSettings& SessionSettings );
+
+	/** Moves a session to a new state, recording the transition in its trace. */
+	void									SetSessionState( FNamedOnlineSession& Session, EOnlineSessionState::Type NewState );
+
+	/** Timestamps every session's state transitions, and their latencies across sessions. */
+	FSessionTracerEOS						SessionTracer;
 
 private:
 
+	/** Per-request data passed through the SDK as ClientData for session operations. */
+	struct FSessionRequestContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		FName								SessionName;
+		FOnDestroySessionCompleteDelegate	DestroyDelegate;
+	};
+
+	/** A RegisterPlayers or UnregisterPlayers call on a session hosted through EOS_Sessions, reported once the backend has every player in it right. */
+	struct FRegistrationCall
+	{
+		TArray<TSharedRef<const FUniqueNetId>> Players;
+		bool								bRegister;
+
+		/** Players the backend has yet to confirm. */
+		int32								NumWaiting;
+
+		/** Cleared as soon as the backend fails any of the players. */
+		bool								bWasSuccessful;
+	};
+
+	/** Backend write state for a session hosted through EOS_Sessions. */
+	struct FSessionUpdateState
+	{
+		/** Number of UpdateSession calls merged into the next write. */
+		int32								NumPendingUpdates;
+
+		/** Whether a write (or the creation) is in flight. Further updates wait for it to complete. */
+		bool								bUpdateInFlight;
+
+		/** The settings as last pushed, so a write only carries what changed. */
+		FSessionSettingsDiffEOS				PushedSettings;
+
+		/** The write in flight, forgotten if it fails so it is sent again. */
+		FSessionSettingsDeltaEOS			InFlightDelta;
+
+		/** Players to register with the backend on the next flush, by id. */
+		TMap<FString, TSharedRef<const FUniqueNetId>> PendingRegistrations;
+
+		/** Players to unregister from the backend on the next flush, by id. */
+		TMap<FString, TSharedRef<const FUniqueNetId>> PendingUnregistrations;
+
+		/** Players the backend holds, or is being sent, and the Product User each was registered as. */
+		TMap<FString, EOS_ProductUserId>	BackendPlayers;
+
+		/** Pending players whose Product User is being looked up. */
+		TSet<FString>						ResolvingPlayers;
+
+		/** Number of register/unregister requests in flight. The next flush waits for them, so requests can't overtake each other. */
+		int32								NumRegistrationsInFlight;
+
+		/** Register and unregister calls waiting on the backend, by id. */
+		TMap<uint32, FRegistrationCall>		RegistrationCalls;
+
+		/** The calls waiting on each player's pending registration or unregistration. */
+		TMap<FString, TArray<uint32>>		PendingCalls;
+
+		/** The calls waiting on each player's registration or unregistration in flight. */
+		TMap<FString, TArray<uint32>>		InFlightCalls;
+
+		uint32								NextRegistrationCallId;
+
+		/** Whether the session is in DirtySessions. */
+		bool								bIsDirty;
+
+		/** Requests made on behalf of the session. AllocatedSize is worked out when asked for. */
+		FSessionHostStatsEOS				Stats;
+
+		FSessionUpdateState()
+			: NumPendingUpdates( 0 )
+			, bUpdateInFlight( false )
+			, NumRegistrationsInFlight( 0 )
+			, NextRegistrationCallId( 0 )
+			, bIsDirty( false )
+		{}
+
+		/** @return bool True if a pending player, or unregistration, can be sent now, i.e. is not waiting on a lookup. */
+		bool								HasRegistrationsToSend() const;
+
+		/** @return bool True if anything is waiting to be sent, or for a request in flight to complete before it can be. */
+		bool								HasPendingWork() const;
+	};
+
+	/** Per-request data passed through the SDK as ClientData for lobby operations. */
+	struct FLobbyRequestContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		FName								SessionName;
+		EOS_ProductUserId					LocalUserId;
+		FOnDestroySessionCompleteDelegate	DestroyDelegate;
+
+		/** Whether the lobby is being left behind by a session that no longer exists, so nobody is waiting on it. */
+		bool								bIsDiscard;
+
+		FLobbyRequestContext()
+			: LocalUserId( nullptr )
+			, bIsDiscard( false )
+		{}
+	};
+
+	/**
+	* Backend state of a session backed by an EOS lobby.
+	*
+	* Writes only carry the lobby and member attributes that changed since the last one. Notifications only mark
+	* the lobby or a member as changed, and are applied once per tick, reading just the attributes they concern.
+	*/
+	struct FLobbyState
+	{
+		/** The lobby's id, once the backend has issued it. */
+		FString								LobbyId;
+
+		/** The Product User that created or joined the lobby. */
+		EOS_ProductUserId					LocalUserId;
+		FString								LocalMemberKey;
+
+		/** Product User of the lobby's owner, the only member that may write the lobby's own attributes. */
+		FString								OwnerKey;
+
+		/** Number of UpdateSession and UpdateLobbyMemberSettings calls merged into the next write. */
+		int32								NumPendingUpdates;
+
+		/** Whether a write (or the creation or join) is in flight. Further updates wait for it to complete. */
+		bool								bUpdateInFlight;
+
+		/** The local member's own settings, as last set. */
+		FSessionSettings					LocalMemberSettings;
+
+		/** The lobby's attributes, as the backend holds them. */
+		FLobbyAttributeSyncEOS				LobbyAttributes;
+
+		/** The local member's attributes, as the backend holds them. */
+		FLobbyAttributeSyncEOS				LocalMemberAttributes;
+
+		/** Every other member's attributes, as last read, by Product User. */
+		TMap<FString, FLobbyAttributeSyncEOS> MemberAttributes;
+
+		/** Keys in the write in flight, forgotten if it fails so they are sent again. */
+		TArray<FName>						InFlightChanged;
+		TArray<FName>						InFlightRemoved;
+		TArray<FName>						InFlightMemberChanged;
+		TArray<FName>						InFlightMemberRemoved;
+
+		/** Lobby properties as last written, -1 if they must be written again. */
+		int32								WrittenMaxMembers;
+		int32								WrittenPermissionLevel;
+
+		/** Whether the lobby's attributes changed since they were last read. */
+		bool								bLobbyDirty;
+
+		/** Members whose attributes changed since they were last read, by Product User. */
+		TMap<FString, EOS_ProductUserId>	DirtyMembers;
+
+		FLobbyState()
+			: LocalUserId( nullptr )
+			, NumPendingUpdates( 0 )
+			, bUpdateInFlight( false )
+			, WrittenMaxMembers( -1 )
+			, WrittenPermissionLevel( -1 )
+			, bLobbyDirty( false )
+		{}
+	};
+
+	/** Per-request data passed through the SDK as ClientData for EOS_Sessions_SendInvite and EOS_Lobby_SendInvite. */
+	struct FSessionInviteContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		FString								InviteKey;
+	};
+
+	/** Per-request data passed through the SDK as ClientData for EOS_Sessions_RegisterPlayers and EOS_Sessions_UnregisterPlayers. */
+	struct FPlayerRegistrationContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		FName								SessionName;
+		TArray<TSharedRef<const FUniqueNetId>> Players;
+
+		/** The Product User each player was sent as. */
+		TArray<EOS_ProductUserId>			ProductUserIds;
+	};
+
+	/** Matchmaking backend over this interface, one per StartMatchmaking call. */
+	class FMatchmakingBackend;
+
+	/** Per-search data passed through the SDK as ClientData for EOS_SessionSearch_Find. */
+	struct FSessionSearchContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		uint32								SearchId;
+		EOS_HSessionSearch					SearchHandle;
+	};
+
+	/** Serves a search from the cache, or starts a backend search on behalf of a Local User's Product User. */
+	bool									FindSessionsInternal( EOS_ProductUserId SearchingProductUserId, const TSharedRef<FOnlineSessionSearch>& SearchSettings );
+
+	/**
+	* Issues a backend search, which becomes the current search.
+	*
+	* @param CacheKey Where the results are cached once complete, empty if they are not.
+	* @param bIsRevalidation True to refresh a cached search in the background, without notifying anyone but the cache.
+	* @return bool False if the SDK rejected the search.
+	*/
+	bool									StartSessionSearch( EOS_ProductUserId SearchingProductUserId, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FString& CacheKey, bool bIsRevalidation );
+
+	/** Drops the current search without completing it. */
+	void									AbandonSessionSearch();
+
+	/**
+	* Adds the QoS responders of a search result's host to a set of targets, one per connection method that can be measured.
+	*
+	* @return bool False if the result has nothing to measure, e.g. no host address.
+	*/
+	bool									AddQosTarget( const FOnlineSessionSearchResult& SearchResult, TArray<FSessionQosTargetEOS>& OutTargets ) const;
+
+	/** Applies measured pings to a search, and to the search cache. */
+	void									HandlePingSearchResultsComplete( const TMap<FString, int32>& PingsInMs, TWeakPtr<FOnlineSessionSearch> SearchSettings, bool bSortByPing );
+
+	/** @return FString The id a connection method of a session is probed under. Direct probes use the session id alone. */
+	static FString							GetQosTargetId( const FString& SessionId, FEOSConnectionMethod Method );
+
+	/**
+	* Applies a probe's results to a search result: the ping of each connection method, the method chosen, and the ping of that method.
+	*
+	* @return bool False if the probe measured nothing of this result.
+	*/
+	static bool								ApplyQosResults( const TMap<FString, int32>& PingsInMs, FOnlineSessionSearchResult& SearchResult );
+
+	/** Records the ping of each connection method of a session, and re-selects its connection method. @return bool False if nothing was measured. */
+	static bool								ApplyMethodPings( const TMap<FString, int32>& PingsInMs, FOnlineSessionInfoEOS& SessionInfo );
+
+	/** @return The order connection methods are preferred in, where pings don't tell them apart. From SessionConnectionMethodOrder in config. */
+	static const TArray<FEOSConnectionMethod>& GetConnectionMethodOrder();
+
+	/**
+	* Picks the connection method with the lowest measured round trip. Methods that were measured and never answered are
+	* passed over, and where nothing answered the first available method in GetConnectionMethodOrder() is used.
+	*/
+	static FEOSConnectionMethod				SelectConnectionMethod( const FOnlineSessionInfoEOS& SessionInfo );
+
+	/** Advertises every way the host can be reached, as session attributes, and records them on the session info. */
+	void									AdvertiseConnectionMethods( FNamedOnlineSession& Session, EOS_ProductUserId HostingProductUserId ) const;
+
+	/** Reads the ways a found session's host can be reached from its attributes, and picks one. */
+	static void								ReadConnectionMethods( FOnlineSession& Session );
+
+	/**
+	* Resolves the connect string of a session for its connection method, once per port type.
+	*
+	* @return bool False if the session can't be reached on that port type.
+	*/
+	static bool								ResolveConnectString( FOnlineSessionInfoEOS& SessionInfo, const FOnlineSessionSettings& SessionSettings, FName PortType, FString& ConnectInfo );
+
+	/**
+	* Measures every way of reaching the host of a session being joined, alongside the backend join, so the join
+	* completes with the fastest one chosen. Skipped if there is only one way, or a search already measured them.
+	*
+	* @return bool True if a probe was started.
+	*/
+	bool									StartJoinQos( FName SessionName, const FOnlineSessionSearchResult& DesiredSession );
+
+	void									HandleJoinQosComplete( const TMap<FString, int32>& PingsInMs, FName SessionName, FString SessionId );
+
+	/** Reports a join as complete, unless it succeeded and its connection methods are still being measured. */
+	void									CompleteJoinSession( FName SessionName, EOnJoinSessionCompleteResult::Type Result );
+
+	/** Triggers OnCreateSessionComplete, unless the create was made by a host migration, which reports it itself. */
+	void									NotifyCreateSessionComplete( FName SessionName, bool bWasSuccessful );
+
+	/** Triggers OnJoinSessionComplete, unless the join was made by a host migration, which reports it itself. */
+	void									NotifyJoinSessionComplete( FName SessionName, EOnJoinSessionCompleteResult::Type Result );
+
+	/** A session left recently, kept so it can be joined again straight away. */
+	struct FRejoinTicket
+	{
+		FName								SessionName;
+
+		/** The session as it was joined, its session info holding the details handle, connect strings and pings. */
+		FOnlineSessionSearchResult			SearchResult;
+
+		int32								PlayerNum;
+		TSharedPtr<const FUniqueNetId>		PlayerId;
+
+		/** Players that were registered in the session, registered again on rejoining. */
+		TArray<TSharedRef<const FUniqueNetId>> RegisteredPlayers;
+
+		double								ExpiryTime;
+
+		/** When RejoinSession was called, 0 if it hasn't been. */
+		double								RejoinStartTime;
+
+		FRejoinTicket()
+			: PlayerNum( 0 )
+			, ExpiryTime( 0.0 )
+			, RejoinStartTime( 0.0 )
+		{}
+	};
+
+	/** Keeps a rejoin ticket for a joined session being left, replacing any other. */
+	void									KeepRejoinTicket( const FNamedOnlineSession& Session );
+
+	/** Records how a rejoin went, and uses up the ticket. */
+	void									CompleteRejoin( FName SessionName, EOnJoinSessionCompleteResult::Type Result );
+
+	/**
+	* Pushes a search's QuerySettings down to the backend as search parameters, rather than filtering results locally.
+	*
+	* @return bool False if the SDK rejected a parameter.
+	*/
+	bool									ApplySearchParameters( EOS_HSessionSearch SearchHandle, const FOnlineSessionSearch& SearchSettings );
+
+	/** Copies up to MaxResultsToCopy more results of the current search into its SearchResults. */
+	void									CopySearchResults( uint32 MaxResultsToCopy );
+
+	/** Completes the current search, releasing its handle. */
+	void									FinishSessionSearch( bool bWasSuccessful );
+
+	/** Converts a backend session into a search result, taking ownership of SessionDetails. */
+	static bool								ToSearchResult( EOS_HSessionDetails SessionDetails, FOnlineSessionSearchResult& OutResult );
+
+	/** Converts an EOS session attribute back into a session setting value. */
+	static bool								FromSessionAttribute( const EOS_Sessions_AttributeData& Attribute, FVariantData& OutData );
+
+	static void								FindSessionsCompleteCallback( const EOS_SessionSearch_FindCallbackInfo* Data );
+
+	void									HandleFindSessionsComplete( uint32 SearchId, EOS_HSessionSearch SearchHandle, EOS_EResult ResultCode );
+
+	/**
+	* A FindFriendSession call. Each friend's sessions are searched for separately, by target user, with up to
+	* FriendSessionSearchConcurrency searches in flight at once.
+	*/
+	struct FFriendSessionSearch
+	{
+		int32								LocalUserNum;
+		EOS_ProductUserId					LocalUserId;
+
+		/** Friends whose Product User is known, waiting to be searched. */
+		TArray<TSharedRef<const FUniqueNetId>> ReadyFriends;
+
+		/** Friends whose Product User is being looked up. */
+		int32								NumResolving;
+
+		int32								NumInFlight;
+
+		/** Friends a search was tried for, whether or not it could be started. */
+		int32								NumSearched;
+
+		/** Whether any search completed, even if it found nothing. */
+		bool								bAnySucceeded;
+
+		/** Every friend's sessions found so far. */
+		TArray<FOnlineSessionSearchResult>	Results;
+
+		FFriendSessionSearch()
+			: LocalUserNum( 0 )
+			, LocalUserId( nullptr )
+			, NumResolving( 0 )
+			, NumInFlight( 0 )
+			, NumSearched( 0 )
+			, bAnySucceeded( false )
+		{}
+	};
+
+	/** Per-search data passed through the SDK as ClientData for a friend's EOS_SessionSearch_Find. */
+	struct FFriendSearchContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		uint32								FriendSearchId;
+		EOS_HSessionSearch					SearchHandle;
+		TSharedPtr<const FUniqueNetId>		Friend;
+	};
+
+	/** Readies the friends whose Product User a lookup found, and starts their searches. */
+	void									HandleResolveFriendsComplete( uint32 FriendSearchId, const TArray<TSharedRef<const FUniqueNetId>>& Friends );
+
+	/** Starts searches for waiting friends, up to the concurrency window, and completes the call once none are left. */
+	void									PumpFriendSessionSearch( uint32 FriendSearchId );
+
+	/** @return bool False if the search could not be handed to the SDK. */
+	bool									StartFriendSessionSearch( uint32 FriendSearchId, FFriendSessionSearch& FriendSearch, const TSharedRef<const FUniqueNetId>& Friend, EOS_ProductUserId FriendUserId );
+
+	static void								FindFriendSessionCompleteCallback( const EOS_SessionSearch_FindCallbackInfo* Data );
+
+	void									HandleFindFriendSessionComplete( uint32 FriendSearchId, EOS_HSessionSearch SearchHandle, const TSharedRef<const FUniqueNetId>& Friend, EOS_EResult ResultCode );
+
+	/** Searches for lobbies rather than sessions, for searches that set SEARCH_LOBBIES. Lobby searches are not cached. */
+	bool									StartLobbySearch( EOS_ProductUserId SearchingProductUserId, const TSharedRef<FOnlineSessionSearch>& SearchSettings );
+
+	/** Per-search data passed through the SDK as ClientData for EOS_LobbySearch_Find. */
+	struct FLobbySearchContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		uint32								SearchId;
+		EOS_HLobbySearch					SearchHandle;
+	};
+
+	static void								FindLobbiesCompleteCallback( const EOS_LobbySearch_FindCallbackInfo* Data );
+
+	void									HandleFindLobbiesComplete( uint32 SearchId, EOS_HLobbySearch SearchHandle, EOS_EResult ResultCode );
+
+	/** Converts a backend lobby into a search result, taking ownership of LobbyDetails. */
+	static bool								ToLobbySearchResult( EOS_HLobbyDetails LobbyDetails, FOnlineSessionSearchResult& OutResult );
+
+	/**
+	* Reads the lobby's attributes, or those of one member, into a synced set.
+	*
+	* @param TargetUserId The member whose attributes to read, nullptr for the lobby's own.
+	* @param OutChanged Keys whose value is new or differs from the one held.
+	* @param OutRemoved Keys that are no longer held by the backend.
+	*/
+	static void								ReadLobbyAttributes( EOS_HLobbyDetails LobbyDetails, EOS_ProductUserId TargetUserId, FLobbyAttributeSyncEOS& Attributes, TArray<FName>& OutChanged, TArray<FName>& OutRemoved );
+
+	/** Converts a session setting into an EOS lobby attribute. Strings are marshalled into the arena. */
+	static bool								ToLobbyAttribute( const char* Key, const FVariantData& Data, FEOSLargeScratchArena& Arena, EOS_Lobby_AttributeData& OutAttribute );
+
+	/** Converts an EOS lobby attribute back into a session setting value. */
+	static bool								FromLobbyAttribute( const EOS_Lobby_AttributeData& Attribute, FVariantData& OutData );
+
+	/** @return The lobby permission level matching a session's advertising and presence settings. */
+	static EOS_ELobbyPermissionLevel		ToLobbyPermissionLevel( const FOnlineSessionSettings& Settings );
+
+	/** Joins a session found by a search, on behalf of a Local User. */
+	bool									JoinSessionInternal( int32 PlayerNum, const TSharedPtr<const FUniqueNetId>& PlayerId, EOS_ProductUserId ProductUserId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession );
+
+	/** A Start, End or Destroy call made while an earlier call on the same session was still in flight. */
+	struct FQueuedSessionOp
+	{
+		enum class EType : uint8
+		{
+			Start,
+			End,
+			Destroy
+		};
+
+		EType								Type;
+
+		/** Every Destroy call folded into this one. */
+		TArray<FOnDestroySessionCompleteDelegate> DestroyDelegates;
+
+		FQueuedSessionOp( EType InType )
+			: Type( InType )
+		{}
+	};
+
+	bool									StartSessionInternal( FName SessionName );
+
+	bool									EndSessionInternal( FName SessionName );
+
+	bool									DestroySessionInternal( FName SessionName, const FOnDestroySessionCompleteDelegate& CompletionDelegate );
+
+	/** @return bool True if a session is waiting on the backend to create, start, end or destroy it. */
+	bool									IsSessionBusy( FName SessionName );
+
+	/** @return bool True if a call on a session must wait for the calls before it, as they are still in flight. */
+	bool									ShouldQueueSessionOp( FName SessionName );
+
+	/**
+	* Queues a call behind those in flight. A Destroy drops the Starts and Ends queued before it, which complete
+	* successfully straight away, and a Destroy queued after another completes with it.
+	*/
+	void									QueueSessionOp( FName SessionName, FQueuedSessionOp::EType Type, const FOnDestroySessionCompleteDelegate& CompletionDelegate = FOnDestroySessionCompleteDelegate() );
+
+	/** Issues the calls queued on a session, for as long as the session isn't waiting on the backend. */
+	void									RunQueuedSessionOps( FName SessionName );
+
+	/** Creates a session, on behalf of a Local User or, with no Product User, a dedicated server. */
+	bool									CreateSessionInternal( int32 HostingPlayerNum, const TSharedPtr<const FUniqueNetId>& HostingPlayerId, EOS_ProductUserId HostingProductUserId, FName SessionName, const FOnlineSessionSettings& NewSessionSettings );
+
+	/** Creates the lobby behind a session being created. */
+	bool									CreateLobbyInternal( FNamedOnlineSession& Session, EOS_ProductUserId HostingProductUserId );
+
+	/** Joins a lobby found by a lobby search. */
+	bool									JoinLobbyInternal( int32 PlayerNum, const TSharedPtr<const FUniqueNetId>& PlayerId, EOS_ProductUserId ProductUserId, FName SessionName, const FOnlineSessionSearchResult& DesiredSession );
+
+	/** Destroys a lobby session's lobby if we own it, or leaves it. */
+	bool									DestroyLobbyInternal( FNamedOnlineSession& Session, FLobbyState& LobbyState, const FOnDestroySessionCompleteDelegate& CompletionDelegate );
+
+	/** Destroys or leaves a lobby whose session is already gone. */
+	void									DiscardLobby( EOS_ProductUserId LocalUserId, const FString& LobbyId, bool bIsOwner );
+
+	/** Starts tracking a lobby session, listening for lobby notifications if it is the first. */
+	FLobbyState&							AddLobbyState( FName SessionName, EOS_ProductUserId LocalUserId );
+
+	/** Stops tracking a lobby session, and stops listening for notifications once none are left. */
+	void									RemoveLobbyState( FName SessionName );
+
+	/** @return The state of the lobby session with a backend lobby id, or nullptr. */
+	FLobbyState*							FindLobbyState( const FString& LobbyId, FName& OutSessionName );
+
+	/**
+	* @return The id a lobby member is registered with: their Epic Account where the identity knows it, so it compares equal
+	* to the game's ids, otherwise their Product User.
+	*/
+	TSharedRef<const FUniqueNetId>			GetLobbyMemberId( EOS_ProductUserId MemberUserId ) const;
+
+	/** @return The Product User key of a player registered with a lobby session, the inverse of GetLobbyMemberId. */
+	FString									GetLobbyMemberKey( const FUniqueNetId& PlayerId ) const;
+
+	/** @return The id of a player registered with an EOS session, from its string form, as the identity would create it. */
+	TSharedRef<const FUniqueNetId>			GetSessionPlayerId( const FString& PlayerKey ) const;
+
+	/**
+	* Issues a single lobby modification covering every change since the last write, carrying only the
+	* lobby and member attributes that changed.
+	*/
+	void									FlushLobbyUpdate( FName SessionName );
+
+	/** Reports the end of a lobby write, which completes the creation if it was the lobby's first. */
+	void									CompleteLobbyUpdate( FName SessionName, bool bWasSuccessful );
+
+	/** Applies the lobby and member changes notified since the last tick. */
+	void									ApplyLobbyNotifications( FName SessionName );
+
+	/**
+	* Removes a lobby session the local member is no longer in, because it closed or we were kicked. Nobody asked for the
+	* destroy, so it is reported through OnSessionFailure rather than OnDestroySessionComplete.
+	*/
+	void									HandleLobbyRemoved( FName SessionName );
+
+	void									RegisterLobbyNotifications();
+	void									UnregisterLobbyNotifications();
+
+	/** @return The Lobby interface handle, or nullptr if the SDK is not available. */
+	EOS_HLobby								GetLobbyHandle() const;
+
+	static void								CreateLobbyCompleteCallback( const EOS_Lobby_CreateLobbyCallbackInfo* Data );
+	static void								UpdateLobbyCompleteCallback( const EOS_Lobby_UpdateLobbyCallbackInfo* Data );
+	static void								JoinLobbyCompleteCallback( const EOS_Lobby_JoinLobbyCallbackInfo* Data );
+	static void								DestroyLobbyCompleteCallback( const EOS_Lobby_DestroyLobbyCallbackInfo* Data );
+	static void								LeaveLobbyCompleteCallback( const EOS_Lobby_LeaveLobbyCallbackInfo* Data );
+	static void								LobbyUpdateReceivedCallback( const EOS_Lobby_LobbyUpdateReceivedCallbackInfo* Data );
+	static void								LobbyMemberUpdateReceivedCallback( const EOS_Lobby_LobbyMemberUpdateReceivedCallbackInfo* Data );
+	static void								LobbyMemberStatusReceivedCallback( const EOS_Lobby_LobbyMemberStatusReceivedCallbackInfo* Data );
+
+	void									HandleCreateLobbyComplete( FName SessionName, EOS_ProductUserId LocalUserId, EOS_EResult ResultCode, const char* LobbyId );
+	void									HandleUpdateLobbyComplete( FName SessionName, EOS_EResult ResultCode );
+	void									HandleJoinLobbyComplete( FName SessionName, EOS_ProductUserId LocalUserId, EOS_EResult ResultCode, const char* LobbyId );
+
+	/** Marks the lobby, or one of its members, as changed. Read on the next tick. */
+	void									HandleLobbyUpdateReceived( const FString& LobbyId, EOS_ProductUserId TargetUserId );
+
+	void									HandleLobbyMemberStatusReceived( const FString& LobbyId, EOS_ProductUserId TargetUserId, EOS_ELobbyMemberStatus CurrentStatus );
+
+	/** Queues a hosted session to be flushed on the next tick, unless it already is. */
+	void									MarkSessionDirty( FName SessionName );
+
+	/**
+	* Flushes the hosted sessions with work pending, oldest first, sending at most SessionWritesPerTick requests.
+	* Sessions left over keep their place for the next tick.
+	*/
+	void									FlushDirtySessions();
+
+	/** @return SIZE_T Bytes held by a hosted session and its backend state, not counting the contents of strings and ids. */
+	static SIZE_T							GetHostAllocatedSize( const FNamedOnlineSession& Session, const FSessionUpdateState& UpdateState );
+
+	/**
+	* Issues a single EOS_Sessions_UpdateSession covering every UpdateSession call since the last write.
+	*
+	* @return bool True if a write was sent, false if there was nothing to write or it failed.
+	*/
+	bool									FlushSessionUpdate( FName SessionName );
+
+	/**
+	* Sends a session's pending registrations and unregistrations to the backend, in chunks of at most
+	* SessionRegisterPlayersChunkSize players. Players whose Product User is not known yet are looked up first,
+	* and sent on a later flush, as are the chunks past MaxRequests.
+	*
+	* @return int32 Number of requests sent.
+	*/
+	int32									FlushPlayerRegistrations( FName SessionName, int32 MaxRequests );
+
+	/**
+	* Queues invites from a Local User to friends, once every friend's Product User is known.
+	*
+	* @return bool False if the invites can't be sent at all, e.g. the session doesn't exist.
+	*/
+	bool									SendSessionInvitesInternal( const TSharedPtr<const FUniqueNetId>& LocalUserId, FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Friends );
+
+	/** Sends as many queued invites as the pacing allows. */
+	void									FlushSessionInvites();
+
+	/** @return bool False if the invite could not be handed to the SDK, and has failed. */
+	bool									SendSessionInvite( const FSessionInviteQueueEOS::FInvite& Invite );
+
+	void									HandleSendInviteComplete( const FString& InviteKey, EOS_EResult ResultCode );
+
+	/** Fires OnSendSessionInvitesComplete for invite batches that completed. */
+	void									ReportSessionInvites( const TArray<FSessionInviteBatchResultEOS>& Completed );
+
+	/** Completes the registration of players whose Product User could not be found. */
+	void									HandleResolvePlayersComplete( FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Players );
+
+	/**
+	* Adds or removes players from a session's local RegisteredPlayers, and queues the change for the backend.
+	* Changes that cancel a still pending one are dropped, rather than sent. For a session hosted through
+	* EOS_Sessions, the call is only reported once the backend has confirmed every player in it.
+	*/
+	bool									QueuePlayerRegistrations( FName SessionName, const TArray<TSharedRef<const FUniqueNetId>>& Players, bool bRegister );
+
+	/** Adds a player to, or removes one from, a session's RegisteredPlayers, taking or giving back an open connection. */
+	static void								UpdateRegisteredPlayer( FNamedOnlineSession& Session, const TSharedRef<const FUniqueNetId>& Player, bool bRegister );
+
+	/** Settles a player for each call waiting on it, moving the calls with no players left to wait on into OutCompleted. */
+	static void								SettleRegistrationCalls( FSessionUpdateState& UpdateState, const TArray<uint32>& CallIds, bool bWasSuccessful, TArray<FRegistrationCall>& OutCompleted );
+
+	/** Moves the calls waiting on a player's pending change over to the change in flight, once it is sent. */
+	static void								MoveCallsInFlight( FSessionUpdateState& UpdateState, const FString& PlayerKey );
+
+	/** Triggers OnRegisterPlayersComplete or OnUnregisterPlayersComplete for each completed call. */
+	void									ReportRegistrationCalls( FName SessionName, const TArray<FRegistrationCall>& Completed );
+
+	/** Forgets a session's backend state, failing the register and unregister calls still waiting on it. */
+	void									RemoveSessionUpdateState( FName SessionName );
+
+	/**
+	* Writes the settings in a delta into a modification handle.
+	*
+	* @param bIsCreate True when the handle creates the session, so the host address is set and max players already is.
+	* @return bool False if the SDK rejected any of the settings.
+	*/
+	bool									ApplySessionSettings( EOS_HSessionModification ModificationHandle, const FNamedOnlineSession& Session, const FSessionSettingsDeltaEOS& Delta, bool bIsCreate );
+
+	/**
+	* Converts a session setting into an EOS session attribute. Strings are marshalled into the arena.
+	*
+	* @return bool False if the setting has no EOS representation (e.g. blobs).
+	*/
+	static bool								ToSessionAttribute( const char* Key, const FVariantData& Data, FEOSLargeScratchArena& Arena, EOS_Sessions_AttributeData& OutAttribute );
+
+	/** @return The Sessions interface handle, or nullptr if the SDK is not available. */
+	EOS_HSessions							GetSessionsHandle() const;
+
+	/** @return The LAN beacon, created on first use. Its port and query timeout are read from config. */
+	FLANSession&							GetLANSession();
+
+	/**
+	* Hosts the LAN beacon while any LAN session we host is advertised, and tears it down otherwise. A search
+	* in progress keeps the beacon until it completes.
+	*
+	* @return bool False if the beacon should be hosted, but could not be.
+	*/
+	bool									UpdateLANBeacon();
+
+	/** Broadcasts a LAN query. Responses are added to the search as they arrive, until LanQueryTimeout. */
+	bool									StartLANSearch( const TSharedRef<FOnlineSessionSearch>& SearchSettings );
+
+	/** Stops a LAN search, and goes back to hosting if needed. */
+	void									StopLANSearch();
+
+	/** Answers a client's LAN query with one advertisement per joinable LAN session we host. */
+	void									HandleLANQueryPacket( uint8* PacketData, int32 PacketLength, uint64 ClientNonce );
+
+	/** Adds the session advertised by a host's response to the current search, unless already found. */
+	void									HandleLANResponsePacket( uint8* PacketData, int32 PacketLength );
+
+	void									HandleLANSearchTimeout();
+
+	/**
+	* Writes a session's advertisement. Only what a client needs to list and join the session is sent: the host
+	* address, slot counts, the flags packed into a byte, and the settings advertised via the online service.
+	*/
+	static void								AppendSessionToPacket( FNboSerializeToBuffer& Packet, const FNamedOnlineSession& Session );
+
+	/** @return bool False if the advertisement is malformed or truncated. */
+	static bool								ReadSessionFromPacket( FNboSerializeFromBuffer& Packet, FOnlineSession& OutSession );
+
+	/** What a successor needs to take over a session: its full settings and who was registered in it. */
+	struct FSessionSnapshot
+	{
+		/** Counts up with each snapshot the host takes that differs from its last. */
+		uint32								Sequence;
+
+		FString								SessionId;
+
+		/** Product User of the host that took the snapshot. */
+		FString								HostKey;
+
+		FOnlineSessionSettings				Settings;
+
+		/** Registered players, by id. */
+		TArray<FString>						PlayerKeys;
+
+		FSessionSnapshot()
+			: Sequence( 0 )
+		{}
+	};
+
+	/** Snapshots of a session hosted here, as last handed out. */
+	struct FHostSnapshotState
+	{
+		TArray<uint8>						Snapshot;
+		uint32								Sequence;
+
+		FHostSnapshotState()
+			: Sequence( 0 )
+		{}
+	};
+
+	/** A MigrateSessionHost call in progress. */
+	struct FHostMigration
+	{
+		/** The session as it was under the host that left. */
+		FSessionSnapshot					Snapshot;
+
+		/** Id of the elected successor, one of the snapshot's PlayerKeys. */
+		FString								SuccessorKey;
+		bool								bIsSuccessor;
+
+		/** The Local User in the session, who takes it over or follows the successor. */
+		int32								PlayerNum;
+		TSharedPtr<const FUniqueNetId>		PlayerId;
+		EOS_ProductUserId					ProductUserId;
+
+		/** Followers of a re-created EOS session search for it until it shows up, or the migration times out. */
+		bool								bHasLeft;
+		bool								bSearchInFlight;
+		double								NextSearchTime;
+		double								Deadline;
+
+		FHostMigration()
+			: bIsSuccessor( false )
+			, PlayerNum( 0 )
+			, ProductUserId( nullptr )
+			, bHasLeft( false )
+			, bSearchInFlight( false )
+			, NextSearchTime( 0.0 )
+			, Deadline( 0.0 )
+		{}
+	};
+
+	/** Per-search data passed through the SDK as ClientData for the search for a re-created session. */
+	struct FMigrationSearchContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		FName								SessionName;
+		EOS_HSessionSearch					SearchHandle;
+	};
+
+	/**
+	* Writes a snapshot in the same compact form as LAN advertisements, but with every setting that has a value,
+	* whether advertised or not.
+	*
+	* @return bool False if it doesn't fit in HostSnapshotMaxSize bytes.
+	*/
+	static bool								WriteSessionSnapshot( const FSessionSnapshot& Snapshot, TArray<uint8>& OutBytes );
+
+	/** @return bool False if the snapshot is malformed or truncated. */
+	static bool								ReadSessionSnapshot( const TArray<uint8>& Bytes, FSessionSnapshot& OutSnapshot );
+
+	/** @return FString The player every member elects to host once the snapshot's host left: the lowest id, other than the host's. */
+	static FString							ElectSuccessor( const FSessionSnapshot& Snapshot );
+
+	/** Snapshots every session hosted here with SETTING_EOS_HOSTMIGRATION, handing out those that changed. */
+	void									TakeHostSnapshots();
+
+	/** Drives migrations waiting on the backend, and fails those that ran out of time. */
+	void									TickHostMigrations( double Now );
+
+	/** Makes the local member the host of a lobby session it was promoted to own. */
+	void									TakeOverLobby( FName SessionName, const FHostMigration& Migration );
+
+	/** Hands ownership of a lobby to the elected successor. */
+	void									PromoteLobbyMember( FName SessionName, const FLobbyState& LobbyState, const FString& SuccessorKey );
+
+	/** Leaves the EOS session of the host that left, without reporting its destruction. */
+	bool									LeaveMigratedSession( FName SessionName );
+
+	/** Looks for the session the successor re-created, by its SETTING_EOS_MIGRATEDFROM. */
+	bool									StartMigrationSearch( FName SessionName, FHostMigration& Migration );
+
+	/** Ends a migration, triggering OnSessionHostMigrated. */
+	void									CompleteHostMigration( FName SessionName, bool bWasSuccessful );
+
+	/** Drops the settings that describe where the old host could be reached, for the new host to advertise its own. */
+	static void								RemoveHostSettings( FOnlineSessionSettings& Settings );
+
+	static void								MigrationLeaveCompleteCallback( const EOS_Sessions_DestroySessionCallbackInfo* Data );
+	static void								MigrationSearchCompleteCallback( const EOS_SessionSearch_FindCallbackInfo* Data );
+	static void								PromoteMemberCompleteCallback( const EOS_Lobby_PromoteMemberCallbackInfo* Data );
+
+	void									HandleMigrationLeaveComplete( FName SessionName, EOS_EResult ResultCode );
+	void									HandleMigrationSearchComplete( FName SessionName, EOS_HSessionSearch SearchHandle, EOS_EResult ResultCode );
+
+	/** Per-refresh data passed through the SDK as ClientData for the quick-join pool's EOS_SessionSearch_Find. */
+	struct FQuickJoinSearchContext
+	{
+		TWeakPtr<FOnlineSessionEOS, ESPMode::ThreadSafe> SessionInterface;
+		uint32								RefreshId;
+		EOS_HSessionSearch					SearchHandle;
+	};
+
+	/** Prunes the quick-join pool, and refreshes it when due. */
+	void									TickQuickJoinPool( double Now );
+
+	/** Searches for candidates for the quick-join pool with QuickJoinSearch. */
+	void									StartQuickJoinRefresh( double Now );
+
+	static void								QuickJoinSearchCompleteCallback( const EOS_SessionSearch_FindCallbackInfo* Data );
+
+	void									HandleQuickJoinSearchComplete( uint32 RefreshId, EOS_HSessionSearch SearchHandle, EOS_EResult ResultCode );
+
+	static void								CreateSessionCompleteCallback( const EOS_Sessions_UpdateSessionCallbackInfo* Data );
+	static void								UpdateSessionCompleteCallback( const EOS_Sessions_UpdateSessionCallbackInfo* Data );
+	static void								StartSessionCompleteCallback( const EOS_Sessions_StartSessionCallbackInfo* Data );
+	static void								EndSessionCompleteCallback( const EOS_Sessions_EndSessionCallbackInfo* Data );
+	static void								DestroySessionCompleteCallback( const EOS_Sessions_DestroySessionCallbackInfo* Data );
+	static void								JoinSessionCompleteCallback( const EOS_Sessions_JoinSessionCallbackInfo* Data );
+	static void								RegisterPlayersCompleteCallback( const EOS_Sessions_RegisterPlayersCallbackInfo* Data );
+	static void								UnregisterPlayersCompleteCallback( const EOS_Sessions_UnregisterPlayersCallbackInfo* Data );
+	static void								SendInviteCompleteCallback( const EOS_Sessions_SendInviteCallbackInfo* Data );
+	static void								SendLobbyInviteCompleteCallback( const EOS_Lobby_SendInviteCallbackInfo* Data );
+
+	void									HandleCreateSessionComplete( FName SessionName, EOS_EResult ResultCode, const char* SessionId );
+	void									HandleUpdateSessionComplete( FName SessionName, EOS_EResult ResultCode );
+	void									HandleStartSessionComplete( FName SessionName, EOS_EResult ResultCode );
+	void									HandleEndSessionComplete( FName SessionName, EOS_EResult ResultCode );
+	void									HandleDestroySessionComplete( FName SessionName, EOS_EResult ResultCode, const FOnDestroySessionCompleteDelegate& CompletionDelegate );
+	void									HandleJoinSessionComplete( FName SessionName, EOS_EResult ResultCode );
+	void									HandleRegisterPlayersComplete( FName SessionName, EOS_EResult ResultCode, const TArray<TSharedRef<const FUniqueNetId>>& Players, const TArray<EOS_ProductUserId>& ProductUserIds, bool bRegister );
+
+	/** Backend write state of each EOS hosted session, by session name. */
+	TMap<FName, FSessionUpdateState>		SessionUpdateStates;
+
+	/**
+	* Hosted sessions with work pending, in the order they got it. Only these are visited each tick, so a server
+	* hosting hundreds of idle matches pays nothing for them.
+	*/
+	TArray<FName>							DirtySessions;
+
+	/** Most requests flushed to the backend per tick, across all sessions. From SessionWritesPerTick in config. */
+	int32									SessionWritesPerTick;
+
+	/** Whether hosts answer QoS probes. From bSessionQosResponder in config. */
+	bool									bQosResponder;
+
+	/** Bucket sessions are created and searched in, unless the settings name one. From SessionBucketId in config. */
+	FString									DefaultBucketId;
+
+	/** Most results a session search asks the backend for. From SessionSearchMaxResults in config. */
+	int32									SearchMaxResults;
+
+	/** Most players sent in one register or unregister request. From SessionRegisterPlayersChunkSize in config. */
+	int32									RegisterPlayersChunkSize;
+
+	/** Address and QoS port of the partner host to advertise, if any. From SessionPartnerHostAddress and SessionPartnerQosPort in config. */
+	FString									PartnerHostAddress;
+	int32									PartnerQosPort;
+
+	/** Whether joins probe the connection methods first, when the search result has no pings. From bSessionJoinQos in config. */
+	bool									bJoinQos;
+
+	/** How long a rejoin ticket is kept after leaving a session, or zero for none. From RejoinTicketSeconds in config. */
+	float									RejoinTicketSeconds;
+
+	/** How long a host migration may take. From HostMigrationTimeoutSeconds in config. */
+	float									HostMigrationTimeout;
+
+	/** LAN beacon port and query timeout, or zero to keep the LAN session's own. From SessionLANPort and SessionLANQueryTimeout in config. */
+	int32									LANAnnouncePort;
+	float									LANQueryTimeout;
+
+	/** Backend state of each lobby session, by session name. */
+	TMap<FName, FLobbyState>				LobbyStates;
+
+	/** Lobby notifications, registered while there are lobby sessions. */
+	EOS_NotificationId						LobbyUpdateNotificationId;
+	EOS_NotificationId						LobbyMemberUpdateNotificationId;
+	EOS_NotificationId						LobbyMemberStatusNotificationId;
+
 	/** Reference to the main EOS subsystem */
 	FOnlineSubsystemEOS*					EOSSubsystem;
 
 	/** Instance of a LAN session for hosting/client searches */
 	FLANSession*							LANSession;
 
+	/** Sessions already found by the current LAN search, by id, as hosts may answer a query more than once. */
+	TSet<FString>							LANSearchSessionIds;
+
+	/** When the current LAN search was broadcast, to estimate the ping of each response. */
+	double									LANSearchStartTime;
+
+	/** Set by the beacon when the current LAN search runs out of time. The search completes on the next TickLAN. */
+	bool									bLANSearchTimedOut;
+
+	/** The search in progress, if any. */
+	TSharedPtr<FOnlineSessionSearch>		CurrentSessionSearch;
+
+	/** The backend search behind CurrentSessionSearch. */
+	EOS_HSessionSearch						CurrentSearchHandle;
+
+	/** Incremented per search, so callbacks of cancelled searches can be told apart. */
+	uint32									CurrentSearchId;
+
+	/** Whether the backend is still searching, rather than results being copied out. */
+	bool									bSearchFindInFlight;
+
+	/** Number of results the backend returned for the current search. */
+	uint32									NumSearchResults;
+
+	/** Next backend result to copy into the current search. */
+	uint32									NextSearchResultIndex;
+
+	/** How many results are copied per tick, after the first. From SessionSearchResultsPerTick in config. */
+	int32									SearchResultsPerTick;
+
+	/** Recent search results, by normalized search parameters. */
+	FSessionSearchCacheEOS					SearchCache;
+
+	/** Cache key of the current search, empty if it is not cached. */
+	FString									CurrentSearchCacheKey;
+
+	/** Whether the current search is a background refresh of a cached one. */
+	bool									bCurrentSearchIsRevalidation;
+
+	/** The search that was served the stale results being refreshed. */
+	TWeakPtr<FOnlineSessionSearch>			RevalidatedSessionSearch;
+
+	/** The search FindSessions was last called with, whose results single PingSearchResults calls update. */
+	TWeakPtr<FOnlineSessionSearch>			LastSessionSearch;
+
+	/** Measures the latency to search results' hosts. */
+	TUniquePtr<FSessionQosProberEOS>		QosProber;
+
+	/** Answers QoS probes while this instance hosts a session. */
+	TUniquePtr<FSessionQosResponderEOS>		QosResponder;
+
+	/** A join whose connection methods are being measured. */
+	struct FJoinQosState
+	{
+		/** The session being joined, as a session of the same name may be joined again before the probe completes. */
+		FString								SessionId;
+
+		/** How the backend join went, once it has. */
+		TOptional<EOnJoinSessionCompleteResult::Type> JoinResult;
+	};
+
+	/** Joins waiting on a probe of their connection methods, by session name. */
+	TMap<FName, FJoinQosState>				JoinsAwaitingQos;
+
+	/** Invites waiting to be sent, paced to stay under the backend's rate limits. */
+	FSessionInviteQueueEOS					InviteQueue;
+
+	/** FindFriendSession calls in progress, by id. */
+	TMap<uint32, FFriendSessionSearch>		FriendSessionSearches;
+
+	uint32									NextFriendSearchId;
+
+	/** Most friend searches in flight per FindFriendSession call. From FriendSessionSearchConcurrency in config. */
+	int32									FriendSearchConcurrency;
+
+	/** Matchmaking in progress, by the name of the session it will join or create. */
+	TMap<FName, TUniquePtr<FSessionMatchmakerEOS>> Matchmakers;
+
+	/** Backends of matchmaking cancelled mid join or create, kept until it completes so the session can be left. */
+	TArray<TSharedRef<IMatchmakingBackendEOS>> AbandonedMatchmakingBackends;
+
+	/** Calls waiting for the one in flight on their session, oldest first, by session name. */
+	TMap<FName, TArray<FQueuedSessionOp>>	QueuedSessionOps;
+
+	/** Snapshots of the sessions hosted here with SETTING_EOS_HOSTMIGRATION, by session name. */
+	TMap<FName, FHostSnapshotState>			HostSnapshots;
+
+	double									LastHostSnapshotTime;
+
+	/** Seconds between host snapshots. From HostSnapshotIntervalSeconds in config. */
+	float									HostSnapshotInterval;
+
+	/** MigrateSessionHost calls in progress, by session name. */
+	TMap<FName, FHostMigration>				HostMigrations;
+
+	/** Sessions with a create or join in flight on behalf of a migration, until it reports completion. */
+	TSet<FName>								MigrationSessionCalls;
+
+	/** The joined session last left, if not expired or used up. */
+	TOptional<FRejoinTicket>				RejoinTicket;
+
+	FSessionRejoinStatsEOS					RejoinStats;
+
+	/** Joinable sessions matching QuickJoinSearch, for QuickJoinSession. */
+	FSessionQuickJoinPoolEOS				QuickJoinPool;
+
+	/** The search the quick-join pool is refreshed with, while it runs. */
+	TSharedPtr<FOnlineSessionSearch>		QuickJoinSearch;
+
+	/** The local player the quick-join pool searches as. */
+	int32									QuickJoinPlayerNum;
+
+	/** Bumped whenever the quick-join pool starts or stops, so refreshes of an earlier search are dropped. */
+	uint32									QuickJoinRefreshId;
+
 	/** Hidden on purpose */
 	FOnlineSessionEOS()
-		: EOSSubsystem( nullptr )
+		: NumPresenceSessions( 0 )
+		, SessionWritesPerTick( 64 )
+		, bQosResponder( true )
+		, DefaultBucketId( TEXT( "Default" ) )
+		, SearchMaxResults( EOS_SESSIONS_MAX_SEARCH_RESULTS )
+		, RegisterPlayersChunkSize( EOS_SESSIONS_MAXREGISTEREDPLAYERS )
+		, PartnerQosPort( 0 )
+		, bJoinQos( true )
+		, RejoinTicketSeconds( 60.0f )
+		, HostMigrationTimeout( 30.0f )
+		, LANAnnouncePort( 0 )
+		, LANQueryTimeout( 0.0f )
+		, LobbyUpdateNotificationId( EOS_INVALID_NOTIFICATIONID )
+		, LobbyMemberUpdateNotificationId( EOS_INVALID_NOTIFICATIONID )
+		, LobbyMemberStatusNotificationId( EOS_INVALID_NOTIFICATIONID )
+		, EOSSubsystem( nullptr )
 		, LANSession( nullptr )
+		, LANSearchStartTime( 0.0 )
+		, bLANSearchTimedOut( false )
+		, CurrentSearchHandle( nullptr )
+		, CurrentSearchId( 0 )
+		, bSearchFindInFlight( false )
+		, NumSearchResults( 0 )
+		, NextSearchResultIndex( 0 )
+		, SearchResultsPerTick( 16 )
+		, bCurrentSearchIsRevalidation( false )
+		, NextFriendSearchId( 0 )
+		, FriendSearchConcurrency( 16 )
+		, LastHostSnapshotTime( 0.0 )
+		, HostSnapshotInterval( 5.0f )
+		, QuickJoinPlayerNum( 0 )
+		, QuickJoinRefreshId( 0 )
 	{}
 
 };
@@ -0,0 +1,184 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionInviteEOS.h"
+
+// Engine Includes
+#include "Misc/ConfigCacheIni.h"
+
+
+FSessionInviteQueueEOS::FSessionInviteQueueEOS()
+	: NextBatchId( 0 )
+	, NumInFlight( 0 )
+	, Tokens( 0.0 )
+	, LastRefillTime( 0.0 )
+	, PausedUntil( 0.0 )
+	, InvitesPerSecond( 4.0f )
+	, Burst( 8 )
+	, MaxInFlight( 4 )
+	, BackoffSeconds( 2.0f )
+	, MaxAttempts( 3 )
+{
+}
+
+void FSessionInviteQueueEOS::Init()
+{
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionInvitesPerSecond" ), InvitesPerSecond, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionInviteBurst" ), Burst, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionInvitesMaxInFlight" ), MaxInFlight, GEngineIni );
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionInviteBackoffSeconds" ), BackoffSeconds, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionInviteMaxAttempts" ), MaxAttempts, GEngineIni );
+
+	InvitesPerSecond = FMath::Max( InvitesPerSecond, 0.1f );
+	Burst = FMath::Max( Burst, 1 );
+	MaxInFlight = FMath::Max( MaxInFlight, 1 );
+	MaxAttempts = FMath::Max( MaxAttempts, 1 );
+
+	Tokens = (double)Burst;
+}
+
+void FSessionInviteQueueEOS::Enqueue( FName SessionName, const TSharedRef<const FUniqueNetId>& LocalUserId, const TArray<TSharedRef<const FUniqueNetId>>& Friends, double Now )
+{
+	Refill( Now );
+
+	const uint32 BatchId = NextBatchId++;
+
+	FBatch& Batch = Batches.Add( BatchId );
+	Batch.Result.SessionName = SessionName;
+	Batch.Result.LocalUserId = LocalUserId;
+	Batch.NumOutstanding = 0;
+
+	for( const TSharedRef<const FUniqueNetId>& Friend : Friends )
+	{
+		const FString Key = MakeKey( SessionName, *Friend );
+		FPendingInvite* Invite = Invites.Find( Key );
+
+		if( Invite == nullptr )
+		{
+			Invite = &Invites.Add( Key, FPendingInvite( SessionName, LocalUserId, Friend ) );
+			Queue.Add( Key );
+		}
+		else if( Invite->BatchIds.Contains( BatchId ) )
+		{
+			// Listed twice in the same call.
+			continue;
+		}
+
+		Invite->BatchIds.Add( BatchId );
+		Batch.NumOutstanding++;
+	}
+
+	if( Batch.NumOutstanding == 0 )
+	{
+		Batches.Remove( BatchId );
+	}
+}
+
+void FSessionInviteQueueEOS::TakeReady( double Now, TFunctionRef<bool( FName SessionName )> CanSend, TArray<FInvite>& OutInvites )
+{
+	Refill( Now );
+
+	if( Now < PausedUntil )
+	{
+		return;
+	}
+
+	TArray<FString> Remaining;
+
+	for( int32 QueueIdx = 0; QueueIdx < Queue.Num(); ++QueueIdx )
+	{
+		if( NumInFlight >= MaxInFlight || Tokens < 1.0 )
+		{
+			Remaining.Append( Queue.GetData() + QueueIdx, Queue.Num() - QueueIdx );
+			break;
+		}
+
+		FPendingInvite& Invite = Invites.FindChecked( Queue[QueueIdx] );
+
+		if( CanSend( Invite.SessionName ) == false )
+		{
+			Remaining.Add( Queue[QueueIdx] );
+			continue;
+		}
+
+		Invite.bInFlight = true;
+		Invite.NumAttempts++;
+
+		NumInFlight++;
+		Tokens -= 1.0;
+
+		OutInvites.Emplace( Queue[QueueIdx], Invite.SessionName, Invite.LocalUserId, Invite.Friend );
+	}
+
+	Queue = MoveTemp( Remaining );
+}
+
+void FSessionInviteQueueEOS::Complete( const FString& Key, bool bWasSent, TArray<FSessionInviteBatchResultEOS>& OutCompleted )
+{
+	FPendingInvite* Invite = Invites.Find( Key );
+
+	if( Invite == nullptr || Invite->bInFlight == false )
+	{
+		return;
+	}
+
+	NumInFlight--;
+
+	for( const uint32 BatchId : Invite->BatchIds )
+	{
+		FBatch& Batch = Batches.FindChecked( BatchId );
+		( bWasSent ? Batch.Result.Sent : Batch.Result.Failed ).Add( Invite->Friend );
+
+		if( --Batch.NumOutstanding == 0 )
+		{
+			OutCompleted.Add( MoveTemp( Batch.Result ) );
+			Batches.Remove( BatchId );
+		}
+	}
+
+	Invites.Remove( Key );
+}
+
+void FSessionInviteQueueEOS::Throttle( const FString& Key, double Now, TArray<FSessionInviteBatchResultEOS>& OutCompleted )
+{
+	FPendingInvite* Invite = Invites.Find( Key );
+
+	if( Invite == nullptr || Invite->bInFlight == false )
+	{
+		return;
+	}
+
+	if( Invite->NumAttempts >= MaxAttempts )
+	{
+		Complete( Key, false, OutCompleted );
+		return;
+	}
+
+	Invite->bInFlight = false;
+	NumInFlight--;
+
+	Queue.Insert( Key, 0 );
+
+	// Whatever the bucket held was evidently too much.
+	PausedUntil = FMath::Max( PausedUntil, Now + BackoffSeconds );
+	Tokens = 0.0;
+	LastRefillTime = PausedUntil;
+}
+
+bool FSessionInviteQueueEOS::HasQueued() const
+{
+	return Queue.Num() > 0;
+}
+
+FString FSessionInviteQueueEOS::MakeKey( FName SessionName, const FUniqueNetId& Friend )
+{
+	return SessionName.ToString() + TEXT( "|" ) + Friend.ToString();
+}
+
+void FSessionInviteQueueEOS::Refill( double Now )
+{
+	if( Now > LastRefillTime )
+	{
+		Tokens = FMath::Min( (double)Burst, Tokens + ( Now - LastRefillTime ) * InvitesPerSecond );
+		LastRefillTime = Now;
+	}
+}
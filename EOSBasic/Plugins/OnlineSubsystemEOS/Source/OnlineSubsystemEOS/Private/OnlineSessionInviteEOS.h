@@ -0,0 +1,162 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "UObject/CoreOnline.h"
+
+
+/**
+ * Outcome of one SendSessionInviteToFriends call, reported once every invite in it was sent or failed.
+ */
+struct FSessionInviteBatchResultEOS
+{
+	FName											SessionName;
+
+	TSharedPtr<const FUniqueNetId>					LocalUserId;
+
+	/** Friends the backend accepted an invite for. */
+	TArray<TSharedRef<const FUniqueNetId>>			Sent;
+
+	/** Friends that could not be invited. */
+	TArray<TSharedRef<const FUniqueNetId>>			Failed;
+};
+
+/**
+ * Queue of session invites waiting to be sent, paced by a token bucket so inviting a whole friends list
+ * doesn't trip the backend's rate limits.
+ *
+ * At most SessionInvitesPerSecond invites are sent per second, in bursts of up to SessionInviteBurst, with no
+ * more than SessionInvitesMaxInFlight awaiting the backend. An invite to a friend that is already queued or
+ * in flight for the same session is not sent again; it completes with the one already pending. When the
+ * backend throttles an invite, it goes back to the front of the queue and sending pauses for
+ * SessionInviteBackoffSeconds.
+ *
+ * Game thread only.
+ */
+class FSessionInviteQueueEOS
+{
+
+public:
+
+	/** An invite handed out to be sent. */
+	struct FInvite
+	{
+		/** Identifies the invite when it completes. */
+		FString										Key;
+
+		FName										SessionName;
+
+		TSharedRef<const FUniqueNetId>				LocalUserId;
+
+		TSharedRef<const FUniqueNetId>				Friend;
+
+		FInvite( const FString& InKey, FName InSessionName, const TSharedRef<const FUniqueNetId>& InLocalUserId, const TSharedRef<const FUniqueNetId>& InFriend )
+			: Key( InKey )
+			, SessionName( InSessionName )
+			, LocalUserId( InLocalUserId )
+			, Friend( InFriend )
+		{}
+	};
+
+	FSessionInviteQueueEOS();
+
+	/** Reads the pacing options from [OnlineSubsystemEOS] in the Engine ini. */
+	void											Init();
+
+	/** Queues invites to each friend as one batch, reported together once they have all completed. */
+	void											Enqueue( FName SessionName, const TSharedRef<const FUniqueNetId>& LocalUserId, const TArray<TSharedRef<const FUniqueNetId>>& Friends, double Now );
+
+	/**
+	* Takes as many invites, oldest first, as the pacing allows right now. They count as in flight until completed.
+	*
+	* @param CanSend Whether invites to a session may be sent yet. Those that can't keep their place in the queue.
+	*/
+	void											TakeReady( double Now, TFunctionRef<bool( FName SessionName )> CanSend, TArray<FInvite>& OutInvites );
+
+	/**
+	* Completes an invite that was taken.
+	*
+	* @param OutCompleted Gains the result of every batch this was the last outstanding invite of.
+	*/
+	void											Complete( const FString& Key, bool bWasSent, TArray<FSessionInviteBatchResultEOS>& OutCompleted );
+
+	/**
+	* Puts an invite the backend throttled back at the front of the queue, and pauses sending for a while.
+	* After SessionInviteMaxAttempts it fails instead.
+	*/
+	void											Throttle( const FString& Key, double Now, TArray<FSessionInviteBatchResultEOS>& OutCompleted );
+
+	/** @return bool True if invites are waiting to be taken. */
+	bool											HasQueued() const;
+
+private:
+
+	struct FPendingInvite
+	{
+		FName										SessionName;
+
+		TSharedRef<const FUniqueNetId>				LocalUserId;
+
+		TSharedRef<const FUniqueNetId>				Friend;
+
+		/** Every batch that asked for this invite. */
+		TArray<uint32>								BatchIds;
+
+		int32										NumAttempts;
+
+		bool										bInFlight;
+
+		FPendingInvite( FName InSessionName, const TSharedRef<const FUniqueNetId>& InLocalUserId, const TSharedRef<const FUniqueNetId>& InFriend )
+			: SessionName( InSessionName )
+			, LocalUserId( InLocalUserId )
+			, Friend( InFriend )
+			, NumAttempts( 0 )
+			, bInFlight( false )
+		{}
+	};
+
+	struct FBatch
+	{
+		FSessionInviteBatchResultEOS				Result;
+
+		/** Invites of the batch that have not completed yet. */
+		int32										NumOutstanding;
+	};
+
+	/** @return FString Pending invites are unique per session and friend. */
+	static FString									MakeKey( FName SessionName, const FUniqueNetId& Friend );
+
+	/** Adds the tokens earned since the last refill, up to the burst size. */
+	void											Refill( double Now );
+
+	TMap<FString, FPendingInvite>					Invites;
+
+	/** Keys of the invites not taken yet, oldest first. */
+	TArray<FString>									Queue;
+
+	TMap<uint32, FBatch>							Batches;
+
+	uint32											NextBatchId;
+
+	int32											NumInFlight;
+
+	/** Invites that may be sent before the bucket runs dry. */
+	double											Tokens;
+
+	double											LastRefillTime;
+
+	/** Nothing is sent before this time, after the backend throttled us. */
+	double											PausedUntil;
+
+	float											InvitesPerSecond;
+
+	int32											Burst;
+
+	int32											MaxInFlight;
+
+	float											BackoffSeconds;
+
+	int32											MaxAttempts;
+};
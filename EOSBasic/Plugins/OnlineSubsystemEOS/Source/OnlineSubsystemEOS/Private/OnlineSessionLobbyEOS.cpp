@@ -0,0 +1,97 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionLobbyEOS.h"
+
+
+bool FLobbyAttributeSyncEOS::IsSynced( const FOnlineSessionSetting& Setting )
+{
+	return Setting.AdvertisementType == EOnlineDataAdvertisementType::ViaOnlineService || Setting.AdvertisementType == EOnlineDataAdvertisementType::ViaOnlineServiceAndPing;
+}
+
+void FLobbyAttributeSyncEOS::Diff( const FSessionSettings& Desired, TArray<FName>& OutChanged, TArray<FName>& OutRemoved ) const
+{
+	for( const TPair<FName, FOnlineSessionSetting>& Setting : Desired )
+	{
+		if( IsSynced( Setting.Value ) == false )
+		{
+			continue;
+		}
+
+		const FVariantData* Held = Values.Find( Setting.Key );
+		if( Held == nullptr || !( *Held == Setting.Value.Data ) )
+		{
+			OutChanged.Add( Setting.Key );
+		}
+	}
+
+	for( const TPair<FName, FVariantData>& Held : Values )
+	{
+		const FOnlineSessionSetting* Setting = Desired.Find( Held.Key );
+		if( Setting == nullptr || IsSynced( *Setting ) == false )
+		{
+			OutRemoved.Add( Held.Key );
+		}
+	}
+}
+
+void FLobbyAttributeSyncEOS::Commit( const FSessionSettings& Desired, const TArray<FName>& Changed, const TArray<FName>& Removed )
+{
+	for( const FName& Key : Changed )
+	{
+		Values.Add( Key, Desired.FindChecked( Key ).Data );
+	}
+
+	for( const FName& Key : Removed )
+	{
+		Values.Remove( Key );
+	}
+}
+
+void FLobbyAttributeSyncEOS::Invalidate( const TArray<FName>& Changed, const TArray<FName>& Removed )
+{
+	for( const FName& Key : Changed )
+	{
+		Values.Remove( Key );
+	}
+
+	// Still held by the backend, so the next Diff removes them again.
+	for( const FName& Key : Removed )
+	{
+		Values.Add( Key, FVariantData() );
+	}
+}
+
+bool FLobbyAttributeSyncEOS::ApplyRemote( FName Key, const FVariantData& Value )
+{
+	FVariantData* Held = Values.Find( Key );
+
+	if( Held != nullptr && *Held == Value )
+	{
+		return false;
+	}
+
+	Values.Add( Key, Value );
+	return true;
+}
+
+void FLobbyAttributeSyncEOS::RemoveMissing( const TSet<FName>& PresentKeys, TArray<FName>& OutRemoved )
+{
+	for( TMap<FName, FVariantData>::TIterator It( Values ); It; ++It )
+	{
+		if( PresentKeys.Contains( It.Key() ) == false )
+		{
+			OutRemoved.Add( It.Key() );
+			It.RemoveCurrent();
+		}
+	}
+}
+
+const TMap<FName, FVariantData>& FLobbyAttributeSyncEOS::GetValues() const
+{
+	return Values;
+}
+
+void FLobbyAttributeSyncEOS::Empty()
+{
+	Values.Empty();
+}
@@ -0,0 +1,59 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+
+/**
+ * One set of lobby attributes, either the lobby's own or a single member's, as the backend last held them.
+ *
+ * Outgoing, it turns the full local settings into the few keys that changed since the last write, so a lobby
+ * modification only carries those. Incoming, it takes attributes as read from the backend and reports which
+ * of them actually changed, so a notification about one key of one member doesn't look like a whole new lobby.
+ *
+ * Game thread only.
+ */
+class FLobbyAttributeSyncEOS
+{
+
+public:
+
+	/** @return bool True if a setting is synchronized with the lobby, rather than kept locally. */
+	static bool										IsSynced( const FOnlineSessionSetting& Setting );
+
+	/**
+	* Works out which keys must be written for the backend to match Desired.
+	*
+	* @param OutChanged Keys that are new or hold a different value.
+	* @param OutRemoved Keys the backend holds that are no longer synced.
+	*/
+	void											Diff( const FSessionSettings& Desired, TArray<FName>& OutChanged, TArray<FName>& OutRemoved ) const;
+
+	/** Records a write of the keys Diff returned, as sent. */
+	void											Commit( const FSessionSettings& Desired, const TArray<FName>& Changed, const TArray<FName>& Removed );
+
+	/** Forgets a write that failed, so the next Diff sends the same keys again. */
+	void											Invalidate( const TArray<FName>& Changed, const TArray<FName>& Removed );
+
+	/**
+	* Records a value read from the backend.
+	*
+	* @return bool True if it differs from the value held.
+	*/
+	bool											ApplyRemote( FName Key, const FVariantData& Value );
+
+	/** Drops every key that is not in PresentKeys, i.e. was removed on the backend. */
+	void											RemoveMissing( const TSet<FName>& PresentKeys, TArray<FName>& OutRemoved );
+
+	const TMap<FName, FVariantData>&				GetValues() const;
+
+	void											Empty();
+
+private:
+
+	/** Values the backend holds, by key. A key with an empty value is held by the backend, but must be removed. */
+	TMap<FName, FVariantData>						Values;
+};
@@ -0,0 +1,730 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionMatchmakerEOS.h"
+
+// Engine Includes
+#include "OnlineSubsystem.h"
+#include "Math/RandomStream.h"
+#include "Misc/ConfigCacheIni.h"
+
+// OSS EOS Includes
+#include "OnlineSubsystemEOSTypes.h"
+#include "OnlineSessionInterfaceEOS.h"
+
+
+void FMatchmakingParamsEOS::LoadConfig()
+{
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingMaxCandidates" ), MaxCandidates, GEngineIni );
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingSearchIntervalSeconds" ), SearchIntervalSeconds, GEngineIni );
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingEscalationSeconds" ), EscalationSeconds, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingMaxEscalations" ), MaxEscalations, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingBaseSkillSpread" ), BaseSkillSpread, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingBasePingMs" ), BasePingMs, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingPingStepMs" ), PingStepMs, GEngineIni );
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingFallbackSeconds" ), FallbackSeconds, GEngineIni );
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingSkillWeight" ), SkillWeight, GEngineIni );
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingPingWeight" ), PingWeight, GEngineIni );
+	GConfig->GetFloat( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionMatchmakingFillWeight" ), FillWeight, GEngineIni );
+
+	MaxCandidates = FMath::Max( MaxCandidates, 1 );
+	SearchIntervalSeconds = FMath::Max( SearchIntervalSeconds, 0.1 );
+	EscalationSeconds = FMath::Max( EscalationSeconds, 0.1 );
+	MaxEscalations = FMath::Max( MaxEscalations, 0 );
+}
+
+
+FSessionMatchmakerEOS::FSessionMatchmakerEOS( const TSharedRef<IMatchmakingBackendEOS>& InBackend, const FMatchmakingParamsEOS& InParams, const FOnlineSessionSettings& InNewSessionSettings, const FOnlineSessionSearch& InSearchSettings, int32 InNumPlayers )
+	: Backend( InBackend )
+	, Params( InParams )
+	, NewSessionSettings( InNewSessionSettings )
+	, NumPlayers( FMath::Max( InNumPlayers, 1 ) )
+	, SkillBucket( 0 )
+	, bHasSkillBucket( false )
+	, State( EState::Idle )
+	, Result( EMatchmakingResultEOS::None )
+	, StartTime( 0.0 )
+	, CurrentTime( 0.0 )
+	, NextSearchTime( 0.0 )
+	, EscalationLevel( 0 )
+	, NumFailedJoins( 0 )
+{
+	BaseSearch.QuerySettings = InSearchSettings.QuerySettings;
+	BaseSearch.MaxSearchResults = InSearchSettings.MaxSearchResults;
+	BaseSearch.bIsLanQuery = InSearchSettings.bIsLanQuery;
+
+	bHasSkillBucket = NewSessionSettings.Get( SETTING_EOS_SKILLBUCKET, SkillBucket );
+
+	Candidates.Reserve( Params.MaxCandidates );
+}
+
+void FSessionMatchmakerEOS::Start( double Now )
+{
+	StartTime = Now;
+	CurrentTime = Now;
+
+	StartSearch();
+}
+
+void FSessionMatchmakerEOS::Tick( double Now )
+{
+	CurrentTime = Now;
+
+	if( State == EState::Done || State == EState::Joining || State == EState::Creating )
+	{
+		return;
+	}
+
+	const double Elapsed = Now - StartTime;
+
+	if( Elapsed >= Params.FallbackSeconds )
+	{
+		if( State == EState::Searching )
+		{
+			Backend->CancelSearch();
+		}
+
+		StartFallback();
+		return;
+	}
+
+	// A wider search is worth running straight away, rather than waiting out the interval.
+	const int32 NewEscalationLevel = FMath::Min( Params.MaxEscalations, FMath::FloorToInt( Elapsed / Params.EscalationSeconds ) );
+
+	if( NewEscalationLevel != EscalationLevel )
+	{
+		EscalationLevel = NewEscalationLevel;
+		NextSearchTime = Now;
+	}
+
+	if( State == EState::Idle && Now >= NextSearchTime )
+	{
+		StartSearch();
+	}
+}
+
+void FSessionMatchmakerEOS::Cancel()
+{
+	if( State == EState::Searching )
+	{
+		Backend->CancelSearch();
+	}
+	else if( State == EState::Joining || State == EState::Creating )
+	{
+		Backend->Abandon();
+	}
+
+	if( State != EState::Done )
+	{
+		Finish( EMatchmakingResultEOS::Cancelled );
+	}
+}
+
+bool FSessionMatchmakerEOS::IsComplete() const
+{
+	return State == EState::Done;
+}
+
+EMatchmakingResultEOS FSessionMatchmakerEOS::GetResult() const
+{
+	return Result;
+}
+
+int32 FSessionMatchmakerEOS::GetEscalationLevel() const
+{
+	return EscalationLevel;
+}
+
+int32 FSessionMatchmakerEOS::GetNumFailedJoins() const
+{
+	return NumFailedJoins;
+}
+
+TSharedPtr<FOnlineSessionSearch> FSessionMatchmakerEOS::GetCurrentSearch() const
+{
+	return CurrentSearch;
+}
+
+void FSessionMatchmakerEOS::StartSearch()
+{
+	NextSearchTime = CurrentTime + Params.SearchIntervalSeconds;
+
+	CurrentSearch = MakeShared<FOnlineSessionSearch>();
+	CurrentSearch->QuerySettings = BaseSearch.QuerySettings;
+	CurrentSearch->MaxSearchResults = BaseSearch.MaxSearchResults;
+	CurrentSearch->bIsLanQuery = BaseSearch.bIsLanQuery;
+
+	// The backend takes one constraint per key, so the lower skill bound is pushed down and the upper one checked when scoring.
+	if( bHasSkillBucket == true )
+	{
+		CurrentSearch->QuerySettings.Set( SETTING_EOS_SKILLBUCKET, SkillBucket - ( Params.BaseSkillSpread + EscalationLevel ), EOnlineComparisonOp::GreaterThanEquals );
+	}
+
+	CurrentSearch->QuerySettings.Set( SEARCH_EOS_MINSLOTSAVAILABLE, NumPlayers, EOnlineComparisonOp::GreaterThanEquals );
+
+	State = EState::Searching;
+
+	if( Backend->Search( CurrentSearch.ToSharedRef(), FOnMatchmakingStepCompleteEOS::CreateRaw( this, &FSessionMatchmakerEOS::HandleSearchComplete ) ) == false )
+	{
+		State = EState::Idle;
+	}
+}
+
+void FSessionMatchmakerEOS::HandleSearchComplete( bool bWasSuccessful )
+{
+	if( State != EState::Searching )
+	{
+		return;
+	}
+
+	State = EState::Idle;
+
+	if( bWasSuccessful == false || CurrentSearch.IsValid() == false )
+	{
+		return;
+	}
+
+	// Results are only as good as the search that found them, so the previous candidates are dropped.
+	Candidates.Reset();
+
+	for( const FOnlineSessionSearchResult& SearchResult : CurrentSearch->SearchResults )
+	{
+		if( SearchResult.Session.SessionInfo.IsValid() == false )
+		{
+			continue;
+		}
+
+		const FString SessionId = SearchResult.Session.SessionInfo->GetSessionId().ToString();
+		if( FailedSessions.Contains( SessionId ) )
+		{
+			continue;
+		}
+
+		const float Score = ScoreCandidate( SearchResult );
+		if( Score >= 0.0f )
+		{
+			AddCandidate( SearchResult, SessionId, Score );
+		}
+	}
+
+	JoinBestCandidate();
+}
+
+void FSessionMatchmakerEOS::AddCandidate( const FOnlineSessionSearchResult& SearchResult, const FString& SessionId, float Score )
+{
+	if( Candidates.Num() >= Params.MaxCandidates )
+	{
+		if( Score <= Candidates.HeapTop().Score )
+		{
+			return;
+		}
+
+		Candidates.HeapPopDiscard( false );
+	}
+
+	FCandidate Candidate;
+	Candidate.Result = SearchResult;
+	Candidate.SessionId = SessionId;
+	Candidate.Score = Score;
+
+	Candidates.HeapPush( MoveTemp( Candidate ) );
+}
+
+void FSessionMatchmakerEOS::JoinBestCandidate()
+{
+	while( Candidates.Num() > 0 )
+	{
+		// The heap keeps the worst on top, and is small, so the best is found by a scan.
+		int32 BestIdx = 0;
+		for( int32 CandidateIdx = 1; CandidateIdx < Candidates.Num(); ++CandidateIdx )
+		{
+			if( Candidates[CandidateIdx].Score > Candidates[BestIdx].Score )
+			{
+				BestIdx = CandidateIdx;
+			}
+		}
+
+		FCandidate Best = MoveTemp( Candidates[BestIdx] );
+		Candidates.HeapRemoveAt( BestIdx, false );
+
+		JoiningSessionId = Best.SessionId;
+		State = EState::Joining;
+
+		if( Backend->Join( Best.Result, FOnMatchmakingStepCompleteEOS::CreateRaw( this, &FSessionMatchmakerEOS::HandleJoinComplete ) ) == true )
+		{
+			return;
+		}
+
+		FailedSessions.Add( JoiningSessionId );
+		NumFailedJoins++;
+	}
+
+	State = EState::Idle;
+}
+
+void FSessionMatchmakerEOS::HandleJoinComplete( bool bWasSuccessful )
+{
+	if( State != EState::Joining )
+	{
+		return;
+	}
+
+	if( bWasSuccessful == true )
+	{
+		Finish( EMatchmakingResultEOS::Joined );
+		return;
+	}
+
+	// Most likely filled up since the search, try the next best.
+	FailedSessions.Add( JoiningSessionId );
+	NumFailedJoins++;
+
+	JoinBestCandidate();
+}
+
+void FSessionMatchmakerEOS::StartFallback()
+{
+	Candidates.Reset();
+	State = EState::Creating;
+
+	if( Backend->Create( NewSessionSettings, FOnMatchmakingStepCompleteEOS::CreateRaw( this, &FSessionMatchmakerEOS::HandleCreateComplete ) ) == false )
+	{
+		Finish( EMatchmakingResultEOS::Failed );
+	}
+}
+
+void FSessionMatchmakerEOS::HandleCreateComplete( bool bWasSuccessful )
+{
+	if( State == EState::Creating )
+	{
+		Finish( bWasSuccessful ? EMatchmakingResultEOS::Created : EMatchmakingResultEOS::Failed );
+	}
+}
+
+float FSessionMatchmakerEOS::ScoreCandidate( const FOnlineSessionSearchResult& SearchResult ) const
+{
+	const FOnlineSession& Session = SearchResult.Session;
+
+	if( Session.NumOpenPublicConnections < NumPlayers )
+	{
+		return -1.0f;
+	}
+
+	const int32 SkillSpread = Params.BaseSkillSpread + EscalationLevel;
+	const int32 MaxPingMs = Params.BasePingMs + Params.PingStepMs * EscalationLevel;
+
+	float SkillScore = 1.0f;
+	if( bHasSkillBucket == true )
+	{
+		// Sessions that don't advertise a skill are treated as the worst acceptable match.
+		int32 CandidateSkill = 0;
+		const int32 SkillDiff = Session.SessionSettings.Get( SETTING_EOS_SKILLBUCKET, CandidateSkill ) ? FMath::Abs( CandidateSkill - SkillBucket ) : SkillSpread;
+
+		if( SkillDiff > SkillSpread )
+		{
+			return -1.0f;
+		}
+
+		SkillScore = 1.0f - (float)SkillDiff / (float)( SkillSpread + 1 );
+	}
+
+	// Hosts that could not be measured are not ruled out, they just score as the worst acceptable ping.
+	const int32 PingInMs = ( SearchResult.PingInMs >= MAX_QUERY_PING ) ? MaxPingMs : SearchResult.PingInMs;
+	if( PingInMs > MaxPingMs )
+	{
+		return -1.0f;
+	}
+
+	const float PingScore = 1.0f - (float)PingInMs / (float)( MaxPingMs + 1 );
+
+	// Fuller sessions start sooner, and leave the emptier ones to groups that need the room.
+	const int32 NumSlots = Session.SessionSettings.NumPublicConnections;
+	const float FillScore = NumSlots > 0 ? (float)( NumSlots - Session.NumOpenPublicConnections ) / (float)NumSlots : 0.0f;
+
+	const float TotalWeight = Params.SkillWeight + Params.PingWeight + Params.FillWeight;
+	if( TotalWeight <= 0.0f )
+	{
+		return 0.0f;
+	}
+
+	return ( SkillScore * Params.SkillWeight + PingScore * Params.PingWeight + FillScore * Params.FillWeight ) / TotalWeight;
+}
+
+void FSessionMatchmakerEOS::Finish( EMatchmakingResultEOS InResult )
+{
+	State = EState::Done;
+	Result = InResult;
+	Candidates.Empty();
+}
+
+
+namespace EOSMatchmakingBenchmark
+{
+	/** A session in the simulated population. */
+	struct FSimulatedSession
+	{
+		FString										Id;
+		int32										SkillBucket;
+		int32										BasePingMs;
+		int32										NumSlots;
+		int32										NumOpen;
+	};
+
+	/**
+	* Stand-in for the session backend. Every matchmaker shares it, so they compete for the same slots.
+	* Requests complete after a simulated latency, on the simulated clock.
+	*/
+	class FSimulatedPopulation
+	{
+
+	public:
+
+		FSimulatedPopulation( const FMatchmakingBenchmarkConfigEOS& InConfig )
+			: Config( InConfig )
+			, Rng( InConfig.Seed )
+			, Now( 0.0 )
+			, NextSessionId( 0 )
+		{
+			for( int32 SessionIdx = 0; SessionIdx < Config.NumSessions; ++SessionIdx )
+			{
+				// Seeded sessions already have some players, so fill rate matters from the start.
+				AddSession( Rng.RandRange( 0, Config.NumSkillBuckets - 1 ), Rng.RandRange( 1, Config.SessionSize - 1 ) );
+			}
+		}
+
+		void AddSession( int32 SkillBucket, int32 NumPlayers )
+		{
+			FSimulatedSession& Session = Sessions.AddDefaulted_GetRef();
+			Session.Id = FString::Printf( TEXT( "SimSession%d" ), NextSessionId++ );
+			Session.SkillBucket = SkillBucket;
+			Session.BasePingMs = Rng.RandRange( 10, 250 );
+			Session.NumSlots = Config.SessionSize;
+			Session.NumOpen = FMath::Max( Config.SessionSize - NumPlayers, 0 );
+		}
+
+		FSimulatedSession* FindSession( const FString& Id )
+		{
+			return Sessions.FindByPredicate( [&Id]( const FSimulatedSession& Session )
+			{
+				return Session.Id == Id;
+			} );
+		}
+
+		void Schedule( double Delay, TFunction<void()>&& Completion )
+		{
+			FPendingCompletion& Pending = PendingCompletions.AddDefaulted_GetRef();
+			Pending.DueTime = Now + Delay;
+			Pending.Completion = MoveTemp( Completion );
+		}
+
+		void Tick( double InNow )
+		{
+			Now = InNow;
+
+			// Completions may schedule more work, so the due ones are taken out first.
+			TArray<FPendingCompletion> Due;
+			for( int32 PendingIdx = PendingCompletions.Num() - 1; PendingIdx >= 0; --PendingIdx )
+			{
+				if( PendingCompletions[PendingIdx].DueTime <= Now )
+				{
+					Due.Add( MoveTemp( PendingCompletions[PendingIdx] ) );
+					PendingCompletions.RemoveAtSwap( PendingIdx, 1, false );
+				}
+			}
+
+			for( FPendingCompletion& Pending : Due )
+			{
+				Pending.Completion();
+			}
+		}
+
+		const FMatchmakingBenchmarkConfigEOS&		Config;
+
+		FRandomStream								Rng;
+
+		TArray<FSimulatedSession>					Sessions;
+
+		double										Now;
+
+	private:
+
+		struct FPendingCompletion
+		{
+			double									DueTime;
+			TFunction<void()>						Completion;
+		};
+
+		TArray<FPendingCompletion>					PendingCompletions;
+
+		int32										NextSessionId;
+	};
+
+	/** One player's view of the simulated population. */
+	class FSimulatedBackend : public IMatchmakingBackendEOS
+	{
+
+	public:
+
+		FSimulatedBackend( FSimulatedPopulation& InPopulation )
+			: Population( InPopulation )
+			, PingJitterMs( InPopulation.Rng.RandRange( 0, 40 ) )
+			, SearchSerial( 0 )
+			, bAbandoned( false )
+		{}
+
+		virtual bool Search( const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnMatchmakingStepCompleteEOS& Delegate ) override
+		{
+			const uint32 Serial = ++SearchSerial;
+			TWeakPtr<IMatchmakingBackendEOS> WeakThis = AsShared();
+
+			Population.Schedule( Population.Config.SearchLatencySeconds, [this, WeakThis, Serial, SearchSettings, Delegate]()
+			{
+				if( WeakThis.IsValid() == false || Serial != SearchSerial )
+				{
+					return;
+				}
+
+				FillResults( *SearchSettings );
+				Delegate.ExecuteIfBound( true );
+			} );
+
+			return true;
+		}
+
+		virtual void CancelSearch() override
+		{
+			++SearchSerial;
+		}
+
+		virtual bool Join( const FOnlineSessionSearchResult& Candidate, const FOnMatchmakingStepCompleteEOS& Delegate ) override
+		{
+			const FString SessionId = Candidate.Session.SessionInfo->GetSessionId().ToString();
+			TWeakPtr<IMatchmakingBackendEOS> WeakThis = AsShared();
+
+			Population.Schedule( Population.Config.JoinLatencySeconds, [this, WeakThis, SessionId, Delegate]()
+			{
+				// An abandoned join or create goes nowhere, as if it had been left straight away.
+				if( WeakThis.IsValid() == false || bAbandoned == true )
+				{
+					return;
+				}
+
+				// Other players may have taken the last slot since the search.
+				FSimulatedSession* Session = Population.FindSession( SessionId );
+				const bool bWasSuccessful = ( Session != nullptr && Session->NumOpen > 0 );
+
+				if( bWasSuccessful == true )
+				{
+					Session->NumOpen--;
+				}
+
+				Delegate.ExecuteIfBound( bWasSuccessful );
+			} );
+
+			return true;
+		}
+
+		virtual bool Create( const FOnlineSessionSettings& SessionSettings, const FOnMatchmakingStepCompleteEOS& Delegate ) override
+		{
+			int32 SkillBucket = 0;
+			SessionSettings.Get( SETTING_EOS_SKILLBUCKET, SkillBucket );
+
+			TWeakPtr<IMatchmakingBackendEOS> WeakThis = AsShared();
+
+			Population.Schedule( Population.Config.JoinLatencySeconds, [this, WeakThis, SkillBucket, Delegate]()
+			{
+				if( WeakThis.IsValid() == false || bAbandoned == true )
+				{
+					return;
+				}
+
+				Population.AddSession( SkillBucket, 1 );
+				Delegate.ExecuteIfBound( true );
+			} );
+
+			return true;
+		}
+
+		virtual void Abandon() override
+		{
+			bAbandoned = true;
+		}
+
+	private:
+
+		/** Applies the pushed down constraints, as the backend would, and measures every result's ping. */
+		void FillResults( FOnlineSessionSearch& SearchSettings )
+		{
+			int32 MinSkill = MIN_int32;
+			int32 MinSlots = 1;
+
+			if( const FOnlineSessionSearchParam* SkillParam = SearchSettings.QuerySettings.SearchParams.Find( SETTING_EOS_SKILLBUCKET ) )
+			{
+				SkillParam->Data.GetValue( MinSkill );
+			}
+
+			if( const FOnlineSessionSearchParam* SlotsParam = SearchSettings.QuerySettings.SearchParams.Find( SEARCH_EOS_MINSLOTSAVAILABLE ) )
+			{
+				SlotsParam->Data.GetValue( MinSlots );
+			}
+
+			TArray<int32> Matches;
+			for( int32 SessionIdx = 0; SessionIdx < Population.Sessions.Num(); ++SessionIdx )
+			{
+				const FSimulatedSession& Session = Population.Sessions[SessionIdx];
+
+				if( Session.SkillBucket >= MinSkill && Session.NumOpen >= MinSlots )
+				{
+					Matches.Add( SessionIdx );
+				}
+			}
+
+			// The backend returns an arbitrary subset once there are more matches than results.
+			for( int32 MatchIdx = Matches.Num() - 1; MatchIdx > 0; --MatchIdx )
+			{
+				Matches.Swap( MatchIdx, Population.Rng.RandRange( 0, MatchIdx ) );
+			}
+
+			SearchSettings.SearchResults.Reset();
+
+			for( int32 MatchIdx = 0; MatchIdx < FMath::Min( Matches.Num(), SearchSettings.MaxSearchResults ); ++MatchIdx )
+			{
+				const FSimulatedSession& Session = Population.Sessions[Matches[MatchIdx]];
+
+				FOnlineSessionSearchResult& SearchResult = SearchSettings.SearchResults.AddDefaulted_GetRef();
+				SearchResult.Session.SessionInfo = MakeShareable( new FOnlineSessionInfoEOS( EEOSSession::AdvertisedSessionClient, FUniqueNetIdString( Session.Id, EOS_SUBSYSTEM ) ) );
+				SearchResult.Session.NumOpenPublicConnections = Session.NumOpen;
+				SearchResult.Session.SessionSettings.NumPublicConnections = Session.NumSlots;
+				SearchResult.Session.SessionSettings.Set( SETTING_EOS_SKILLBUCKET, Session.SkillBucket, EOnlineDataAdvertisementType::ViaOnlineService );
+				SearchResult.PingInMs = Session.BasePingMs + PingJitterMs;
+			}
+
+			SearchSettings.SearchState = EOnlineAsyncTaskState::Done;
+		}
+
+		FSimulatedPopulation&						Population;
+
+		/** This player's distance from every host, on top of the host's own latency. */
+		int32										PingJitterMs;
+
+		/** Incremented per search, so cancelled searches never complete. */
+		uint32										SearchSerial;
+
+		/** Set once matchmaking is cancelled mid join or create, which then goes nowhere. */
+		bool										bAbandoned;
+	};
+
+	/** A simulated player, and how it got on. */
+	struct FSimulatedPlayer
+	{
+		TUniquePtr<FSessionMatchmakerEOS>			Matchmaker;
+		double										ArrivalTime;
+		double										MatchTime;
+		bool										bStarted;
+	};
+
+	FString Run( const FMatchmakingParamsEOS& Params, const FMatchmakingBenchmarkConfigEOS& Config )
+	{
+		static const double TimeStep = 0.05;
+
+		FSimulatedPopulation Population( Config );
+
+		TArray<FSimulatedPlayer> Players;
+		Players.SetNum( FMath::Max( Config.NumPlayers, 0 ) );
+
+		for( int32 PlayerIdx = 0; PlayerIdx < Players.Num(); ++PlayerIdx )
+		{
+			FOnlineSessionSettings NewSessionSettings;
+			NewSessionSettings.NumPublicConnections = Config.SessionSize;
+			NewSessionSettings.Set( SETTING_EOS_SKILLBUCKET, Population.Rng.RandRange( 0, Config.NumSkillBuckets - 1 ), EOnlineDataAdvertisementType::ViaOnlineService );
+
+			FOnlineSessionSearch SearchSettings;
+			SearchSettings.MaxSearchResults = 50;
+
+			FSimulatedPlayer& Player = Players[PlayerIdx];
+			Player.Matchmaker = MakeUnique<FSessionMatchmakerEOS>( MakeShared<FSimulatedBackend>( Population ), Params, NewSessionSettings, SearchSettings, 1 );
+			Player.ArrivalTime = Players.Num() > 1 ? Config.ArrivalSeconds * PlayerIdx / ( Players.Num() - 1 ) : 0.0;
+			Player.MatchTime = 0.0;
+			Player.bStarted = false;
+		}
+
+		// Every matchmaker falls back eventually, so this only guards against a stuck simulation.
+		const double EndTime = Config.ArrivalSeconds + Params.FallbackSeconds + 60.0;
+
+		int32 NumComplete = 0;
+		double Now = 0.0;
+
+		while( NumComplete < Players.Num() && Now < EndTime )
+		{
+			Population.Tick( Now );
+
+			for( FSimulatedPlayer& Player : Players )
+			{
+				if( Player.bStarted == false )
+				{
+					if( Now >= Player.ArrivalTime )
+					{
+						Player.Matchmaker->Start( Now );
+						Player.bStarted = true;
+					}
+					continue;
+				}
+
+				if( Player.Matchmaker->IsComplete() == false )
+				{
+					Player.Matchmaker->Tick( Now );
+
+					if( Player.Matchmaker->IsComplete() == true )
+					{
+						Player.MatchTime = Now - Player.ArrivalTime;
+						NumComplete++;
+					}
+				}
+			}
+
+			Now += TimeStep;
+		}
+
+		TArray<double> MatchTimes;
+		int32 NumJoined = 0;
+		int32 NumCreated = 0;
+		int32 NumFailed = 0;
+		int32 NumFailedJoins = 0;
+		int32 TotalEscalation = 0;
+
+		for( const FSimulatedPlayer& Player : Players )
+		{
+			const EMatchmakingResultEOS MatchResult = Player.Matchmaker->GetResult();
+
+			NumJoined += ( MatchResult == EMatchmakingResultEOS::Joined ) ? 1 : 0;
+			NumCreated += ( MatchResult == EMatchmakingResultEOS::Created ) ? 1 : 0;
+			NumFailed += ( MatchResult == EMatchmakingResultEOS::Failed || MatchResult == EMatchmakingResultEOS::None ) ? 1 : 0;
+			NumFailedJoins += Player.Matchmaker->GetNumFailedJoins();
+			TotalEscalation += Player.Matchmaker->GetEscalationLevel();
+
+			if( MatchResult == EMatchmakingResultEOS::Joined || MatchResult == EMatchmakingResultEOS::Created )
+			{
+				MatchTimes.Add( Player.MatchTime );
+			}
+		}
+
+		MatchTimes.Sort();
+
+		auto Percentile = [&MatchTimes]( float Fraction )
+		{
+			return MatchTimes.Num() > 0 ? MatchTimes[FMath::Clamp( FMath::CeilToInt( Fraction * MatchTimes.Num() ) - 1, 0, MatchTimes.Num() - 1 )] : 0.0;
+		};
+
+		double TotalMatchTime = 0.0;
+		for( const double MatchTime : MatchTimes )
+		{
+			TotalMatchTime += MatchTime;
+		}
+
+		const int32 NumPlayers = FMath::Max( Players.Num(), 1 );
+
+		return FString::Printf( TEXT( "EOS Matchmaking Benchmark: %d players | %d sessions (%d at end) | Joined: %d | Created: %d (%.1f%%) | Failed: %d | Failed Joins: %d | Mean Escalation: %.2f\n" )
+								TEXT( "EOS Matchmaking Benchmark: Time To Match | Mean: %.2fs | p50: %.2fs | p95: %.2fs | Max: %.2fs" ),
+								Players.Num(), Config.NumSessions, Population.Sessions.Num(), NumJoined, NumCreated, 100.0f * NumCreated / NumPlayers, NumFailed, NumFailedJoins, (float)TotalEscalation / NumPlayers,
+								MatchTimes.Num() > 0 ? TotalMatchTime / MatchTimes.Num() : 0.0, Percentile( 0.5f ), Percentile( 0.95f ), MatchTimes.Num() > 0 ? MatchTimes.Last() : 0.0 );
+	}
+}
@@ -0,0 +1,300 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+/** Session setting holding the skill bucket a session (or a matchmaking player) plays at. */
+#define SETTING_EOS_SKILLBUCKET FName( TEXT( "EOS_SKILLBUCKET" ) )
+
+
+/**
+ * Delegate fired when a matchmaking backend step completes.
+ *
+ * @param bWasSuccessful Whether the search, join or create succeeded.
+ */
+DECLARE_DELEGATE_OneParam( FOnMatchmakingStepCompleteEOS, bool /*bWasSuccessful*/ );
+
+/**
+ * What the matchmaker needs of the session backend. Implemented over the session interface, and by a
+ * simulated population for benchmarking. Delegates may fire before the call that was given them returns.
+ */
+class IMatchmakingBackendEOS : public TSharedFromThis<IMatchmakingBackendEOS>
+{
+
+public:
+
+	virtual ~IMatchmakingBackendEOS() {}
+
+	/**
+	* Searches for sessions, filling in SearchSettings' results along with their PingInMs.
+	*
+	* @return bool False if a search can't be started right now.
+	*/
+	virtual bool									Search( const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnMatchmakingStepCompleteEOS& Delegate ) = 0;
+
+	/** Abandons the search in progress, its delegate will not fire. */
+	virtual void									CancelSearch() = 0;
+
+	/** @return bool False if the join could not be started. */
+	virtual bool									Join( const FOnlineSessionSearchResult& Candidate, const FOnMatchmakingStepCompleteEOS& Delegate ) = 0;
+
+	/** @return bool False if the session could not be created. */
+	virtual bool									Create( const FOnlineSessionSettings& SessionSettings, const FOnMatchmakingStepCompleteEOS& Delegate ) = 0;
+
+	/** Gives up on the join or create in flight. Its delegate will not fire, and any session it ends up in is left. */
+	virtual void									Abandon() = 0;
+};
+
+/**
+ * Matchmaker tuning. Read from [OnlineSubsystemEOS] in the Engine ini, prefixed with SessionMatchmaking.
+ */
+struct FMatchmakingParamsEOS
+{
+	/** Number of candidates kept from each search. */
+	int32											MaxCandidates;
+
+	/** Time between searches, while nothing has been joined. */
+	double											SearchIntervalSeconds;
+
+	/** The search widens every time this much more has passed. */
+	double											EscalationSeconds;
+
+	/** How many times the search can widen. */
+	int32											MaxEscalations;
+
+	/** Skill buckets either side of the player's a candidate may be, before any escalation. */
+	int32											BaseSkillSpread;
+
+	/** Highest ping a candidate may have, before any escalation. */
+	int32											BasePingMs;
+
+	/** How much the ping limit grows per escalation. */
+	int32											PingStepMs;
+
+	/** Time after which the matchmaker stops looking, and creates a session of its own. */
+	double											FallbackSeconds;
+
+	/** How much skill, latency and fill rate weigh in a candidate's score. */
+	float											SkillWeight;
+	float											PingWeight;
+	float											FillWeight;
+
+	FMatchmakingParamsEOS()
+		: MaxCandidates( 8 )
+		, SearchIntervalSeconds( 2.0 )
+		, EscalationSeconds( 5.0 )
+		, MaxEscalations( 4 )
+		, BaseSkillSpread( 0 )
+		, BasePingMs( 60 )
+		, PingStepMs( 40 )
+		, FallbackSeconds( 20.0 )
+		, SkillWeight( 1.0f )
+		, PingWeight( 1.0f )
+		, FillWeight( 0.5f )
+	{}
+
+	/** Overrides the defaults with whatever is set in config. */
+	void											LoadConfig();
+};
+
+/** How a matchmaking attempt ended */
+enum class EMatchmakingResultEOS : uint8
+{
+	/** Still matchmaking. */
+	None,
+	/** Joined an existing session. */
+	Joined,
+	/** Nothing suitable turned up, so a session was created instead. */
+	Created,
+	/** Neither joining nor creating worked. */
+	Failed,
+	/** Cancelled before completing. */
+	Cancelled
+};
+
+/**
+ * Client-side matchmaker. Searches repeatedly, keeps the best MaxCandidates results of each search in a
+ * fixed-size min-heap, and tries to join them best first. While nothing is joined the search widens every
+ * EscalationSeconds, accepting a wider skill spread and higher pings, until FallbackSeconds have passed and
+ * a session is created instead.
+ *
+ * Time is passed in to Tick, so the same matchmaker runs against the real clock or a simulated one.
+ */
+class FSessionMatchmakerEOS
+{
+
+public:
+
+	/**
+	* @param NewSessionSettings Settings of the session to create on fallback. Its SETTING_EOS_SKILLBUCKET is the player's skill.
+	* @param SearchSettings The base search, whose query is extended with the skill and slot constraints.
+	* @param NumPlayers Number of players matchmaking together, who all need room in the session.
+	*/
+	FSessionMatchmakerEOS( const TSharedRef<IMatchmakingBackendEOS>& InBackend, const FMatchmakingParamsEOS& InParams, const FOnlineSessionSettings& InNewSessionSettings, const FOnlineSessionSearch& InSearchSettings, int32 InNumPlayers );
+
+	/** Starts the first search. */
+	void											Start( double Now );
+
+	/** Searches again, escalates or falls back as time passes. */
+	void											Tick( double Now );
+
+	/** Stops matchmaking. A join or create already in flight is abandoned, and left if it goes through. */
+	void											Cancel();
+
+	/** @return bool True once the matchmaker is done, one way or another. */
+	bool											IsComplete() const;
+
+	EMatchmakingResultEOS							GetResult() const;
+
+	/** @return int32 How many times the search has widened. */
+	int32											GetEscalationLevel() const;
+
+	/** @return int32 Number of joins that failed, e.g. because the session filled up first. */
+	int32											GetNumFailedJoins() const;
+
+	/** @return The search the matchmaker ran last, if any. */
+	TSharedPtr<FOnlineSessionSearch>				GetCurrentSearch() const;
+
+private:
+
+	/** What the matchmaker is waiting on */
+	enum class EState : uint8
+	{
+		Idle,
+		Searching,
+		Joining,
+		Creating,
+		Done
+	};
+
+	/** A search result worth joining, and how good a match it is. */
+	struct FCandidate
+	{
+		FOnlineSessionSearchResult					Result;
+		FString										SessionId;
+		float										Score;
+
+		/** Orders the heap so the worst candidate is on top, ready to be evicted. */
+		bool operator<( const FCandidate& Other ) const
+		{
+			return Score < Other.Score;
+		}
+	};
+
+	void											StartSearch();
+
+	void											HandleSearchComplete( bool bWasSuccessful );
+
+	/** Tries candidates, best first, until a join starts. Idles if none is left. */
+	void											JoinBestCandidate();
+
+	void											HandleJoinComplete( bool bWasSuccessful );
+
+	void											StartFallback();
+
+	void											HandleCreateComplete( bool bWasSuccessful );
+
+	/**
+	* Scores a search result against the current escalation level.
+	*
+	* @return float In [0,1], higher is better. Negative if the result is not acceptable at all.
+	*/
+	float											ScoreCandidate( const FOnlineSessionSearchResult& SearchResult ) const;
+
+	/** Adds a candidate to the heap, evicting the worst if it is full. */
+	void											AddCandidate( const FOnlineSessionSearchResult& SearchResult, const FString& SessionId, float Score );
+
+	void											Finish( EMatchmakingResultEOS InResult );
+
+	TSharedRef<IMatchmakingBackendEOS>				Backend;
+
+	FMatchmakingParamsEOS							Params;
+
+	FOnlineSessionSettings							NewSessionSettings;
+
+	FOnlineSessionSearch							BaseSearch;
+
+	TSharedPtr<FOnlineSessionSearch>				CurrentSearch;
+
+	int32											NumPlayers;
+
+	/** The player's skill bucket, if NewSessionSettings has one. */
+	int32											SkillBucket;
+	bool											bHasSkillBucket;
+
+	EState											State;
+
+	EMatchmakingResultEOS							Result;
+
+	/** Min-heap of the best results of the last search, by score. */
+	TArray<FCandidate>								Candidates;
+
+	/** Sessions that could not be joined, so they are not tried again. */
+	TSet<FString>									FailedSessions;
+
+	/** The session being joined. */
+	FString											JoiningSessionId;
+
+	double											StartTime;
+
+	double											CurrentTime;
+
+	double											NextSearchTime;
+
+	int32											EscalationLevel;
+
+	int32											NumFailedJoins;
+};
+
+/**
+ * Options for a matchmaking benchmark run.
+ */
+struct FMatchmakingBenchmarkConfigEOS
+{
+	/** Number of players that matchmake, each on their own. */
+	int32											NumPlayers;
+
+	/** Number of sessions the simulated population starts with. */
+	int32											NumSessions;
+
+	/** Players start matchmaking spread evenly over this many seconds. */
+	double											ArrivalSeconds;
+
+	/** Number of skill buckets players and sessions are spread across. */
+	int32											NumSkillBuckets;
+
+	/** Players per session. */
+	int32											SessionSize;
+
+	/** Simulated latency of searches and joins. */
+	double											SearchLatencySeconds;
+	double											JoinLatencySeconds;
+
+	/** Seed for the simulated population. */
+	int32											Seed;
+
+	FMatchmakingBenchmarkConfigEOS()
+		: NumPlayers( 200 )
+		, NumSessions( 40 )
+		, ArrivalSeconds( 30.0 )
+		, NumSkillBuckets( 10 )
+		, SessionSize( 8 )
+		, SearchLatencySeconds( 0.3 )
+		, JoinLatencySeconds( 0.2 )
+		, Seed( 0 )
+	{}
+};
+
+/**
+ * Measures time-to-match by running many matchmakers against a simulated population of sessions, on a
+ * simulated clock. Sessions fill up as players join them, and new sessions are created by players who fall
+ * back, so later players see a different population to earlier ones.
+ */
+namespace EOSMatchmakingBenchmark
+{
+	/** Runs the benchmark to completion. @return A report of the time-to-match percentiles and outcomes. */
+	FString											Run( const FMatchmakingParamsEOS& Params, const FMatchmakingBenchmarkConfigEOS& Config );
+}
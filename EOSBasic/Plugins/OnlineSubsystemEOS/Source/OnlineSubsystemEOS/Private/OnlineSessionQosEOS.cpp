@@ -0,0 +1,286 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionQosEOS.h"
+
+// Engine Includes
+#include "OnlineSubsystem.h"
+#include "OnlineSessionSettings.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Misc/ConfigCacheIni.h"
+
+
+FSessionQosProberEOS::FSessionQosProberEOS()
+	: Socket( nullptr )
+	, Receiver( nullptr )
+	, SendCursor( 0 )
+	, NextSequence( 0 )
+	, NextBatchId( 0 )
+	, MaxInFlight( 32 )
+	, ProbesPerHost( 3 )
+	, TimeoutSeconds( 1.0 )
+{
+}
+
+FSessionQosProberEOS::~FSessionQosProberEOS()
+{
+	// Stops the receiver thread, before the socket goes away beneath it.
+	delete Receiver;
+
+	if( Socket != nullptr )
+	{
+		ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->DestroySocket( Socket );
+	}
+}
+
+bool FSessionQosProberEOS::Init()
+{
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionQosMaxInFlight" ), MaxInFlight, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionQosProbesPerHost" ), ProbesPerHost, GEngineIni );
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionQosTimeoutSeconds" ), TimeoutSeconds, GEngineIni );
+
+	MaxInFlight = FMath::Max( MaxInFlight, 1 );
+	ProbesPerHost = FMath::Max( ProbesPerHost, 1 );
+
+	Socket = FUdpSocketBuilder( TEXT( "EOS QoS Prober" ) )
+		.AsNonBlocking()
+		.BoundToPort( 0 )
+		.WithReceiveBufferSize( 64 * 1024 )
+		.Build();
+
+	if( Socket == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to open the QoS prober socket." ) );
+		return false;
+	}
+
+	Receiver = new FUdpSocketReceiver( Socket, FTimespan::FromMilliseconds( 100 ), TEXT( "EOS QoS Prober" ) );
+	Receiver->OnDataReceived().BindRaw( this, &FSessionQosProberEOS::OnDataReceived );
+	Receiver->Start();
+
+	return true;
+}
+
+void FSessionQosProberEOS::Probe( const TArray<FSessionQosTargetEOS>& NewTargets, const FOnSessionQosCompleteEOS& Delegate )
+{
+	const uint32 BatchId = NextBatchId++;
+
+	FBatch& Batch = Batches.Add( BatchId );
+	Batch.Delegate = Delegate;
+	Batch.NumRemaining = NewTargets.Num();
+	Batch.PingsInMs.Reserve( NewTargets.Num() );
+
+	Targets.Reserve( Targets.Num() + NewTargets.Num() );
+	for( const FSessionQosTargetEOS& Target : NewTargets )
+	{
+		Targets.Emplace( Target, BatchId );
+	}
+
+	// Nothing to wait for, so complete on the next tick rather than re-entering the caller.
+	if( Socket == nullptr )
+	{
+		for( int32 TargetIdx = Targets.Num() - NewTargets.Num(); TargetIdx < Targets.Num(); ++TargetIdx )
+		{
+			Targets[TargetIdx].NumProbesSent = Targets[TargetIdx].NumProbesDone = ProbesPerHost;
+			Batch.PingsInMs.Add( Targets[TargetIdx].Target.Id, MAX_QUERY_PING );
+		}
+
+		Batch.NumRemaining = 0;
+	}
+}
+
+void FSessionQosProberEOS::Tick()
+{
+	// Match replies to their probes.
+	FReply Reply;
+	while( Replies.Dequeue( Reply ) )
+	{
+		FInFlightProbe InFlightProbe;
+		if( InFlightProbes.RemoveAndCopyValue( Reply.Sequence, InFlightProbe ) )
+		{
+			CompleteProbe( InFlightProbe.TargetIdx, Reply.ReceiveTime - InFlightProbe.SendTime );
+		}
+	}
+
+	// Expire lost probes.
+	const double Now = FPlatformTime::Seconds();
+	for( TMap<uint32, FInFlightProbe>::TIterator It( InFlightProbes ); It; ++It )
+	{
+		if( Now - It.Value().SendTime > TimeoutSeconds )
+		{
+			const int32 TargetIdx = It.Value().TargetIdx;
+			It.RemoveCurrent();
+			CompleteProbe( TargetIdx, DBL_MAX );
+		}
+	}
+
+	// Fill the window. Each target has at most one probe out, so a slow host can't crowd out the rest.
+	if( Socket != nullptr && Targets.Num() > 0 )
+	{
+		uint8 Packet[EOSQosPacket::Size];
+		FMemory::Memcpy( Packet, EOSQosPacket::Magic, sizeof( EOSQosPacket::Magic ) );
+
+		for( int32 Visited = 0; Visited < Targets.Num() && InFlightProbes.Num() < MaxInFlight; ++Visited )
+		{
+			const int32 TargetIdx = ( SendCursor + Visited ) % Targets.Num();
+			FTarget& Target = Targets[TargetIdx];
+
+			if( Target.bProbeInFlight == true || Target.NumProbesSent >= ProbesPerHost )
+			{
+				continue;
+			}
+
+			const uint32 Sequence = NextSequence++;
+			FMemory::Memcpy( Packet + sizeof( EOSQosPacket::Magic ), &Sequence, sizeof( Sequence ) );
+
+			int32 BytesSent = 0;
+			const bool bWasSent = Socket->SendTo( Packet, sizeof( Packet ), BytesSent, *Target.Target.Address );
+
+			Target.NumProbesSent++;
+
+			if( bWasSent == false )
+			{
+				CompleteProbe( TargetIdx, DBL_MAX );
+				continue;
+			}
+
+			FInFlightProbe& InFlightProbe = InFlightProbes.Add( Sequence );
+			InFlightProbe.TargetIdx = TargetIdx;
+			InFlightProbe.SendTime = FPlatformTime::Seconds();
+
+			Target.bProbeInFlight = true;
+		}
+
+		SendCursor = ( SendCursor + 1 ) % Targets.Num();
+	}
+
+	// Deliver finished batches. Delegates may queue more work, so they are only fired once Batches is settled.
+	TArray<FBatch> FinishedBatches;
+	for( TMap<uint32, FBatch>::TIterator It( Batches ); It; ++It )
+	{
+		if( It.Value().NumRemaining <= 0 )
+		{
+			FinishedBatches.Add( MoveTemp( It.Value() ) );
+			It.RemoveCurrent();
+		}
+	}
+
+	if( Batches.Num() == 0 && InFlightProbes.Num() == 0 )
+	{
+		Targets.Reset();
+		SendCursor = 0;
+	}
+
+	for( const FBatch& Batch : FinishedBatches )
+	{
+		Batch.Delegate.ExecuteIfBound( Batch.PingsInMs );
+	}
+}
+
+bool FSessionQosProberEOS::IsIdle() const
+{
+	return Batches.Num() == 0 && InFlightProbes.Num() == 0;
+}
+
+void FSessionQosProberEOS::OnDataReceived( const FArrayReaderPtr& Data, const FIPv4Endpoint& Endpoint )
+{
+	const double ReceiveTime = FPlatformTime::Seconds();
+
+	if( EOSQosPacket::IsValid( Data->GetData(), Data->Num() ) )
+	{
+		FReply Reply;
+		FMemory::Memcpy( &Reply.Sequence, Data->GetData() + sizeof( EOSQosPacket::Magic ), sizeof( Reply.Sequence ) );
+		Reply.ReceiveTime = ReceiveTime;
+
+		Replies.Enqueue( Reply );
+	}
+}
+
+void FSessionQosProberEOS::CompleteProbe( int32 TargetIdx, double RoundTrip )
+{
+	FTarget& Target = Targets[TargetIdx];
+
+	Target.bProbeInFlight = false;
+	Target.NumProbesDone++;
+	Target.BestRoundTrip = FMath::Min( Target.BestRoundTrip, RoundTrip );
+
+	if( Target.NumProbesDone < ProbesPerHost )
+	{
+		return;
+	}
+
+	if( FBatch* Batch = Batches.Find( Target.BatchId ) )
+	{
+		const int32 PingInMs = Target.BestRoundTrip < TimeoutSeconds ? FMath::Max( FMath::RoundToInt( Target.BestRoundTrip * 1000.0 ), 1 ) : MAX_QUERY_PING;
+
+		// Several results can share a host, keep the best of them.
+		int32& BatchPing = Batch->PingsInMs.FindOrAdd( Target.Target.Id, MAX_QUERY_PING );
+		BatchPing = FMath::Min( BatchPing, PingInMs );
+
+		Batch->NumRemaining--;
+	}
+}
+
+
+FSessionQosResponderEOS::FSessionQosResponderEOS()
+	: Socket( nullptr )
+	, Receiver( nullptr )
+	, BoundPort( 0 )
+{
+}
+
+FSessionQosResponderEOS::~FSessionQosResponderEOS()
+{
+	delete Receiver;
+
+	if( Socket != nullptr )
+	{
+		ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->DestroySocket( Socket );
+	}
+}
+
+int32 FSessionQosResponderEOS::GetConfiguredPort()
+{
+	int32 Port = DefaultPort;
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionQosPort" ), Port, GEngineIni );
+	return Port;
+}
+
+bool FSessionQosResponderEOS::Init( int32 Port )
+{
+	Socket = FUdpSocketBuilder( TEXT( "EOS QoS Responder" ) )
+		.AsNonBlocking()
+		.AsReusable()
+		.BoundToPort( Port )
+		.Build();
+
+	if( Socket == nullptr )
+	{
+		UE_LOG_ONLINE_SESSION( Warning, TEXT( "Failed to open the QoS responder on port %d." ), Port );
+		return false;
+	}
+
+	BoundPort = Socket->GetPortNo();
+
+	Receiver = new FUdpSocketReceiver( Socket, FTimespan::FromMilliseconds( 100 ), TEXT( "EOS QoS Responder" ) );
+	Receiver->OnDataReceived().BindRaw( this, &FSessionQosResponderEOS::OnDataReceived );
+	Receiver->Start();
+
+	return true;
+}
+
+int32 FSessionQosResponderEOS::GetPort() const
+{
+	return BoundPort;
+}
+
+void FSessionQosResponderEOS::OnDataReceived( const FArrayReaderPtr& Data, const FIPv4Endpoint& Endpoint )
+{
+	// Only well formed probes are answered, and never with more than was sent, so the responder can't be used to amplify traffic.
+	if( EOSQosPacket::IsValid( Data->GetData(), Data->Num() ) )
+	{
+		int32 BytesSent = 0;
+		Socket->SendTo( Data->GetData(), Data->Num(), BytesSent, *Endpoint.ToInternetAddr() );
+	}
+}
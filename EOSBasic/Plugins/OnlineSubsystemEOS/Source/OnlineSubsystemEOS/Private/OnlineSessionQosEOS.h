@@ -0,0 +1,203 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "IPAddress.h"
+#include "Common/UdpSocketReceiver.h"
+
+// Forward Declarations
+class FSocket;
+
+/** Session setting advertising the port a host's QoS responder listens on. */
+#define SETTING_EOS_QOSPORT FName( TEXT( "EOS_QOSPORT" ) )
+
+
+/** Wire format shared by the prober and the responder. The responder echoes probes back unchanged. */
+namespace EOSQosPacket
+{
+	/** Probes start with these bytes, anything else is ignored. */
+	static const uint8 Magic[4] = { 'E', 'Q', 'O', 'S' };
+
+	/** Magic, followed by a sequence number only the prober interprets. */
+	enum { Size = sizeof( Magic ) + sizeof( uint32 ) };
+
+	/** @return bool True if Data looks like a probe, or a reply to one. */
+	inline bool IsValid( const uint8* Data, int32 Length )
+	{
+		return Length == Size && FMemory::Memcmp( Data, Magic, sizeof( Magic ) ) == 0;
+	}
+}
+
+/** A host to measure the latency to. */
+struct FSessionQosTargetEOS
+{
+	/** Identifies the host in the results, e.g. its session id. */
+	FString											Id;
+
+	/** Where the host's QoS responder listens. */
+	TSharedRef<FInternetAddr>						Address;
+
+	FSessionQosTargetEOS( const FString& InId, const TSharedRef<FInternetAddr>& InAddress )
+		: Id( InId )
+		, Address( InAddress )
+	{}
+};
+
+/**
+ * Delegate fired once every target of a Probe() call has replied or timed out.
+ *
+ * @param PingsInMs Best round trip time of each target, by target id. MAX_QUERY_PING for targets that never replied.
+ */
+DECLARE_DELEGATE_OneParam( FOnSessionQosCompleteEOS, const TMap<FString, int32>& /*PingsInMs*/ );
+
+/**
+ * Measures the latency to many hosts at once, over a single non-blocking UDP socket.
+ *
+ * Each target is sent SessionQosProbesPerHost probes, one at a time, and its best round trip kept. At most
+ * SessionQosMaxInFlight probes are outstanding, and a probe with no reply after SessionQosTimeoutSeconds
+ * counts as lost. Replies are timestamped as they arrive on a receiver thread, so the measurement does not
+ * depend on the frame rate; everything else happens on the game thread, in Tick.
+ */
+class FSessionQosProberEOS
+{
+
+public:
+
+	FSessionQosProberEOS();
+	~FSessionQosProberEOS();
+
+	/** Reads the prober options from config, and opens the socket. */
+	bool											Init();
+
+	/** Queues a set of targets. Delegate fires from Tick once they are all measured. */
+	void											Probe( const TArray<FSessionQosTargetEOS>& Targets, const FOnSessionQosCompleteEOS& Delegate );
+
+	/** Sends due probes, matches up replies and expires lost probes. */
+	void											Tick();
+
+	/** @return bool True if nothing is queued or in flight. */
+	bool											IsIdle() const;
+
+private:
+
+	/** A reply, as stamped by the receiver thread. */
+	struct FReply
+	{
+		uint32										Sequence;
+		double										ReceiveTime;
+	};
+
+	/** A target, and what has been measured of it so far. */
+	struct FTarget
+	{
+		FSessionQosTargetEOS						Target;
+		uint32										BatchId;
+		int32										NumProbesSent;
+		int32										NumProbesDone;
+		double										BestRoundTrip;
+		bool										bProbeInFlight;
+
+		FTarget( const FSessionQosTargetEOS& InTarget, uint32 InBatchId )
+			: Target( InTarget )
+			, BatchId( InBatchId )
+			, NumProbesSent( 0 )
+			, NumProbesDone( 0 )
+			, BestRoundTrip( DBL_MAX )
+			, bProbeInFlight( false )
+		{}
+	};
+
+	/** The targets of one Probe() call. */
+	struct FBatch
+	{
+		FOnSessionQosCompleteEOS					Delegate;
+		TMap<FString, int32>						PingsInMs;
+		int32										NumRemaining;
+	};
+
+	/** A probe awaiting its reply. */
+	struct FInFlightProbe
+	{
+		int32										TargetIdx;
+		double										SendTime;
+	};
+
+	/** Receiver thread. Only stamps and queues replies. */
+	void											OnDataReceived( const FArrayReaderPtr& Data, const FIPv4Endpoint& Endpoint );
+
+	/** Records the outcome of a probe, completing its target (and batch) once every probe is done. */
+	void											CompleteProbe( int32 TargetIdx, double RoundTrip );
+
+	FSocket*										Socket;
+
+	FUdpSocketReceiver*								Receiver;
+
+	/** Replies waiting to be matched up on the game thread. */
+	TQueue<FReply, EQueueMode::Spsc>				Replies;
+
+	/** Every target of every batch in progress. Cleared once all are complete. */
+	TArray<FTarget>									Targets;
+
+	TMap<uint32, FBatch>							Batches;
+
+	/** Outstanding probes, by sequence number. */
+	TMap<uint32, FInFlightProbe>					InFlightProbes;
+
+	/** Where the next pass over Targets starts, so probes are spread fairly. */
+	int32											SendCursor;
+
+	uint32											NextSequence;
+
+	uint32											NextBatchId;
+
+	int32											MaxInFlight;
+
+	int32											ProbesPerHost;
+
+	double											TimeoutSeconds;
+};
+
+/**
+ * Echoes QoS probes back to whoever sent them, so clients can measure their latency to this host.
+ *
+ * Replies are sent straight from the receiver thread, so the game's frame rate does not add to the measurement.
+ */
+class FSessionQosResponderEOS
+{
+
+public:
+
+	/** Port used when SessionQosPort is not set in config. */
+	enum { DefaultPort = 7779 };
+
+	FSessionQosResponderEOS();
+	~FSessionQosResponderEOS();
+
+	/** @return int32 SessionQosPort from [OnlineSubsystemEOS] in the Engine ini, or DefaultPort. */
+	static int32									GetConfiguredPort();
+
+	/**
+	* Opens the responder socket.
+	*
+	* @param Port The port to listen on, 0 for any.
+	* @return bool False if the port could not be bound.
+	*/
+	bool											Init( int32 Port );
+
+	/** @return int32 The port the responder is listening on. */
+	int32											GetPort() const;
+
+private:
+
+	/** Receiver thread. */
+	void											OnDataReceived( const FArrayReaderPtr& Data, const FIPv4Endpoint& Endpoint );
+
+	FSocket*										Socket;
+
+	FUdpSocketReceiver*								Receiver;
+
+	int32											BoundPort;
+};
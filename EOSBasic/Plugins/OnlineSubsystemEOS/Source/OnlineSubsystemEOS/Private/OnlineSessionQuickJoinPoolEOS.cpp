@@ -0,0 +1,166 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionQuickJoinPoolEOS.h"
+
+// Engine Includes
+#include "Misc/ConfigCacheIni.h"
+
+
+FSessionQuickJoinPoolEOS::FSessionQuickJoinPoolEOS()
+	: LastRefreshTime( 0.0 )
+	, bRefreshInFlight( false )
+	, PoolSize( 8 )
+	, RefreshSeconds( 30.0 )
+	, MinRefreshSeconds( 5.0 )
+	, MaxAgeSeconds( 60.0 )
+{
+}
+
+void FSessionQuickJoinPoolEOS::Init()
+{
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "QuickJoinPoolSize" ), PoolSize, GEngineIni );
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "QuickJoinRefreshSeconds" ), RefreshSeconds, GEngineIni );
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "QuickJoinMinRefreshSeconds" ), MinRefreshSeconds, GEngineIni );
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "QuickJoinCandidateMaxAgeSeconds" ), MaxAgeSeconds, GEngineIni );
+
+	MinRefreshSeconds = FMath::Max( MinRefreshSeconds, 1.0 );
+	RefreshSeconds = FMath::Max( RefreshSeconds, MinRefreshSeconds );
+	MaxAgeSeconds = FMath::Max( MaxAgeSeconds, RefreshSeconds );
+}
+
+bool FSessionQuickJoinPoolEOS::IsEnabled() const
+{
+	return PoolSize > 0;
+}
+
+int32 FSessionQuickJoinPoolEOS::GetMaxResults() const
+{
+	// Some of what comes back is full or unjoinable by the time it is sorted.
+	return PoolSize * 4;
+}
+
+void FSessionQuickJoinPoolEOS::Prune( double Now )
+{
+	const int32 NumRemoved = Candidates.RemoveAll( [this, Now]( const FCandidate& Candidate )
+	{
+		return Now - Candidate.ValidatedTime > MaxAgeSeconds;
+	} );
+
+	Stats.NumPruned += NumRemoved;
+}
+
+bool FSessionQuickJoinPoolEOS::NeedsRefresh( double Now ) const
+{
+	if( bRefreshInFlight == true )
+	{
+		return false;
+	}
+
+	const double SinceRefresh = Now - LastRefreshTime;
+
+	return SinceRefresh >= RefreshSeconds || ( Candidates.Num() * 2 < PoolSize && SinceRefresh >= MinRefreshSeconds );
+}
+
+void FSessionQuickJoinPoolEOS::BeginRefresh( double Now )
+{
+	bRefreshInFlight = true;
+	LastRefreshTime = Now;
+}
+
+void FSessionQuickJoinPoolEOS::Store( const TArray<FOnlineSessionSearchResult>& Results, double Now )
+{
+	if( bRefreshInFlight == false )
+	{
+		return;
+	}
+
+	bRefreshInFlight = false;
+	Stats.NumRefreshes++;
+
+	// Whatever the backend no longer returns is no longer a candidate either.
+	Candidates.Reset();
+
+	for( const FOnlineSessionSearchResult& Result : Results )
+	{
+		const FString SessionId = Result.Session.SessionInfo.IsValid() ? Result.Session.SessionInfo->GetSessionId().ToString() : FString();
+
+		if( SessionId.IsEmpty() || IsJoinable( Result ) == false || Candidates.ContainsByPredicate( [&SessionId]( const FCandidate& Candidate ) { return Candidate.SessionId == SessionId; } ) )
+		{
+			continue;
+		}
+
+		FCandidate& Candidate = Candidates.AddDefaulted_GetRef();
+		Candidate.Result = Result;
+		Candidate.SessionId = SessionId;
+		Candidate.ValidatedTime = Now;
+	}
+
+	// Candidates are not QoS probed, so there is no ping to order by; fullest first, so sessions fill up.
+	Candidates.StableSort( []( const FCandidate& A, const FCandidate& B )
+	{
+		return A.Result.Session.NumOpenPublicConnections < B.Result.Session.NumOpenPublicConnections;
+	} );
+
+	if( Candidates.Num() > PoolSize )
+	{
+		Candidates.SetNum( PoolSize );
+	}
+}
+
+void FSessionQuickJoinPoolEOS::FailRefresh()
+{
+	if( bRefreshInFlight == true )
+	{
+		bRefreshInFlight = false;
+		Stats.NumFailedRefreshes++;
+	}
+}
+
+bool FSessionQuickJoinPoolEOS::Take( double Now, FOnlineSessionSearchResult& OutResult )
+{
+	Prune( Now );
+
+	if( Candidates.Num() == 0 )
+	{
+		Stats.NumMisses++;
+		return false;
+	}
+
+	Stats.NumHits++;
+	Stats.TotalServedAgeSeconds += Now - Candidates[0].ValidatedTime;
+
+	OutResult = MoveTemp( Candidates[0].Result );
+	Candidates.RemoveAt( 0 );
+
+	return true;
+}
+
+void FSessionQuickJoinPoolEOS::RemoveSession( const FString& SessionId )
+{
+	Stats.NumPruned += Candidates.RemoveAll( [&SessionId]( const FCandidate& Candidate )
+	{
+		return Candidate.SessionId == SessionId;
+	} );
+}
+
+void FSessionQuickJoinPoolEOS::Empty()
+{
+	Candidates.Empty();
+	bRefreshInFlight = false;
+	LastRefreshTime = 0.0;
+}
+
+int32 FSessionQuickJoinPoolEOS::Num() const
+{
+	return Candidates.Num();
+}
+
+const FSessionQuickJoinStatsEOS& FSessionQuickJoinPoolEOS::GetStats() const
+{
+	return Stats;
+}
+
+bool FSessionQuickJoinPoolEOS::IsJoinable( const FOnlineSessionSearchResult& Result )
+{
+	return Result.Session.NumOpenPublicConnections > 0 && Result.Session.SessionInfo.IsValid() && Result.Session.SessionInfo->IsValid();
+}
@@ -0,0 +1,148 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+
+/**
+ * Counters describing how well the quick-join pool is doing. Totals since the pool was created.
+ */
+struct FSessionQuickJoinStatsEOS
+{
+	/** Quick joins served a candidate. */
+	uint64											NumHits;
+
+	/** Quick joins that found the pool empty, and had to search. */
+	uint64											NumMisses;
+
+	/** Refreshes that completed, and failed. */
+	uint64											NumRefreshes;
+	uint64											NumFailedRefreshes;
+
+	/** Candidates dropped before being served, as full, gone or too old. */
+	uint64											NumPruned;
+
+	/** Sum of the age of every candidate served, in seconds. */
+	double											TotalServedAgeSeconds;
+
+	FSessionQuickJoinStatsEOS()
+		: NumHits( 0 )
+		, NumMisses( 0 )
+		, NumRefreshes( 0 )
+		, NumFailedRefreshes( 0 )
+		, NumPruned( 0 )
+		, TotalServedAgeSeconds( 0.0 )
+	{}
+
+	/** @return float Fraction of quick joins served without a search. */
+	float GetHitRate() const
+	{
+		const uint64 NumLookups = NumHits + NumMisses;
+		return NumLookups > 0 ? (float)NumHits / (float)NumLookups : 0.0f;
+	}
+
+	/** @return double Mean time since the candidates served were last seen by the backend, in seconds. */
+	double GetMeanServedAgeSeconds() const
+	{
+		return NumHits > 0 ? TotalServedAgeSeconds / (double)NumHits : 0.0;
+	}
+};
+
+/**
+ * A small pool of joinable sessions, kept up by searching in the background, so a quick join can pick one
+ * without waiting on a search.
+ *
+ * The owner searches every QuickJoinRefreshSeconds, or as soon as QuickJoinMinRefreshSeconds allows once the
+ * pool is down to half of QuickJoinPoolSize. Each refresh replaces the candidates with the best joinable
+ * results, fullest first so sessions fill up. Candidates not seen by the backend for
+ * QuickJoinCandidateMaxAgeSeconds, or known to be full or gone, are pruned. A candidate is served once.
+ *
+ * Game thread only.
+ */
+class FSessionQuickJoinPoolEOS
+{
+
+public:
+
+	FSessionQuickJoinPoolEOS();
+
+	/** Reads the pool options from [OnlineSubsystemEOS] in the Engine ini. */
+	void											Init();
+
+	/** @return bool False if the pool is turned off in config. */
+	bool											IsEnabled() const;
+
+	/** @return int32 How many results a refresh should ask the backend for. */
+	int32											GetMaxResults() const;
+
+	/** Drops the candidates that are too old to be trusted. */
+	void											Prune( double Now );
+
+	/** @return bool True if a refresh should be started. */
+	bool											NeedsRefresh( double Now ) const;
+
+	/** Marks a refresh as in flight. */
+	void											BeginRefresh( double Now );
+
+	/** Replaces the candidates with the joinable results of the refresh in flight. */
+	void											Store( const TArray<FOnlineSessionSearchResult>& Results, double Now );
+
+	/** Clears the refresh in flight, keeping the candidates as they are. */
+	void											FailRefresh();
+
+	/**
+	* Takes the best candidate, recording the outcome in the stats.
+	*
+	* @return bool False if the pool is empty.
+	*/
+	bool											Take( double Now, FOnlineSessionSearchResult& OutResult );
+
+	/** Drops a session, e.g. once it is known to be full or gone. */
+	void											RemoveSession( const FString& SessionId );
+
+	/** Drops every candidate, and forgets the refresh in flight. */
+	void											Empty();
+
+	/** @return int32 Number of candidates held. */
+	int32											Num() const;
+
+	const FSessionQuickJoinStatsEOS&				GetStats() const;
+
+private:
+
+	struct FCandidate
+	{
+		FOnlineSessionSearchResult					Result;
+
+		FString										SessionId;
+
+		/** When the backend last returned the session. */
+		double										ValidatedTime;
+	};
+
+	/** @return bool True if a search result has room for another player. */
+	static bool										IsJoinable( const FOnlineSessionSearchResult& Result );
+
+	/** Candidates, best first. */
+	TArray<FCandidate>								Candidates;
+
+	FSessionQuickJoinStatsEOS						Stats;
+
+	double											LastRefreshTime;
+
+	bool											bRefreshInFlight;
+
+	/** How many candidates are kept. */
+	int32											PoolSize;
+
+	double											RefreshSeconds;
+
+	/** Least time between refreshes, when the pool runs low. */
+	double											MinRefreshSeconds;
+
+	/** How long a candidate is kept without the backend returning it again. */
+	double											MaxAgeSeconds;
+};
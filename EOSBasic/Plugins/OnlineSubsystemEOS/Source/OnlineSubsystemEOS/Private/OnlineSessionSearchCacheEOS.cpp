@@ -0,0 +1,267 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionSearchCacheEOS.h"
+
+// Engine Includes
+#include "Misc/ConfigCacheIni.h"
+
+
+FSessionSearchCacheEOS::FSessionSearchCacheEOS()
+	: FreshSeconds( 10.0 )
+	, MaxAgeSeconds( 120.0 )
+	, MaxEntries( 16 )
+{
+}
+
+void FSessionSearchCacheEOS::Init()
+{
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionSearchCacheFreshSeconds" ), FreshSeconds, GEngineIni );
+	GConfig->GetDouble( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionSearchCacheMaxAgeSeconds" ), MaxAgeSeconds, GEngineIni );
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionSearchCacheMaxEntries" ), MaxEntries, GEngineIni );
+
+	MaxAgeSeconds = FMath::Max( MaxAgeSeconds, FreshSeconds );
+}
+
+bool FSessionSearchCacheEOS::IsEnabled() const
+{
+	return MaxEntries > 0 && MaxAgeSeconds > 0.0;
+}
+
+FString FSessionSearchCacheEOS::MakeKey( const FOnlineSessionSearch& SearchSettings )
+{
+	TArray<FString> Params;
+	Params.Reserve( SearchSettings.QuerySettings.SearchParams.Num() );
+
+	for( const TPair<FName, FOnlineSessionSearchParam>& SearchParam : SearchSettings.QuerySettings.SearchParams )
+	{
+		Params.Add( FString::Printf( TEXT( "%s %s %s:%s" ),
+			*SearchParam.Key.ToString().ToLower(),
+			EOnlineComparisonOp::ToString( SearchParam.Value.ComparisonOp ),
+			EOnlineKeyValuePairDataType::ToString( SearchParam.Value.Data.GetType() ),
+			*SearchParam.Value.Data.ToString() ) );
+	}
+
+	// Parameters are unordered as far as the backend is concerned.
+	Params.Sort();
+
+	return FString::Printf( TEXT( "%d|%d|%s" ), SearchSettings.bIsLanQuery ? 1 : 0, SearchSettings.MaxSearchResults, *FString::Join( Params, TEXT( "|" ) ) );
+}
+
+ESessionSearchCacheLookupEOS FSessionSearchCacheEOS::Find( const FString& Key, TArray<FOnlineSessionSearchResult>& OutResults )
+{
+	FEntry* Entry = Entries.Find( Key );
+	const double Age = Entry != nullptr ? FPlatformTime::Seconds() - Entry->FetchTime : 0.0;
+
+	if( Entry == nullptr || Age > MaxAgeSeconds )
+	{
+		// Too old to show at all. Unless it is being revalidated, in which case the refresh will replace it.
+		if( Entry != nullptr && Entry->bRevalidating == false )
+		{
+			Entries.Remove( Key );
+		}
+
+		Stats.NumMisses++;
+		return ESessionSearchCacheLookupEOS::Miss;
+	}
+
+	OutResults.Reset( Entry->Rows.Num() );
+	for( const FRow& Row : Entry->Rows )
+	{
+		OutResults.Add( Row.Result );
+	}
+
+	Stats.TotalServedAgeSeconds += Age;
+	Stats.MaxServedAgeSeconds = FMath::Max( Stats.MaxServedAgeSeconds, Age );
+
+	if( Age > FreshSeconds )
+	{
+		Stats.NumStaleHits++;
+		return ESessionSearchCacheLookupEOS::Stale;
+	}
+
+	Stats.NumHits++;
+	return ESessionSearchCacheLookupEOS::Fresh;
+}
+
+bool FSessionSearchCacheEOS::BeginRevalidation( const FString& Key )
+{
+	FEntry* Entry = Entries.Find( Key );
+	if( Entry == nullptr || Entry->bRevalidating == true )
+	{
+		return false;
+	}
+
+	Entry->bRevalidating = true;
+	return true;
+}
+
+void FSessionSearchCacheEOS::AbortRevalidation( const FString& Key )
+{
+	if( FEntry* Entry = Entries.Find( Key ) )
+	{
+		Entry->bRevalidating = false;
+	}
+}
+
+void FSessionSearchCacheEOS::Store( const FString& Key, const TArray<FOnlineSessionSearchResult>& Results, TArray<FOnlineSessionSearchResult>& OutMerged )
+{
+	FEntry& Entry = Entries.FindOrAdd( Key );
+	const bool bIsRevalidation = Entry.bRevalidating;
+
+	// Index the rows we already have, so each fetched row is matched in constant time.
+	TMap<FString, int32> PreviousRows;
+	PreviousRows.Reserve( Entry.Rows.Num() );
+	for( int32 RowIdx = 0; RowIdx < Entry.Rows.Num(); ++RowIdx )
+	{
+		PreviousRows.Add( GetSessionId( Entry.Rows[RowIdx].Result ), RowIdx );
+	}
+
+	TArray<FRow> Rows;
+	Rows.Reserve( Results.Num() );
+
+	int32 NumMatched = 0;
+
+	for( const FOnlineSessionSearchResult& Result : Results )
+	{
+		const uint32 Fingerprint = GetFingerprint( Result );
+		const int32* PreviousIdx = PreviousRows.Find( GetSessionId( Result ) );
+		NumMatched += ( PreviousIdx != nullptr ) ? 1 : 0;
+
+		if( PreviousIdx != nullptr && Entry.Rows[*PreviousIdx].Fingerprint == Fingerprint )
+		{
+			Rows.Add( MoveTemp( Entry.Rows[*PreviousIdx] ) );
+
+			if( bIsRevalidation )
+			{
+				Stats.NumRowsUnchanged++;
+			}
+		}
+		else
+		{
+			FRow& Row = Rows.AddDefaulted_GetRef();
+			Row.Result = Result;
+			Row.Fingerprint = Fingerprint;
+
+			if( bIsRevalidation )
+			{
+				if( PreviousIdx != nullptr )
+				{
+					Stats.NumRowsChanged++;
+				}
+				else
+				{
+					Stats.NumRowsAdded++;
+				}
+			}
+		}
+	}
+
+	if( bIsRevalidation )
+	{
+		Stats.NumRowsRemoved += FMath::Max( 0, Entry.Rows.Num() - NumMatched );
+		Stats.NumRevalidations++;
+	}
+
+	Entry.Rows = MoveTemp( Rows );
+	Entry.FetchTime = FPlatformTime::Seconds();
+	Entry.bRevalidating = false;
+
+	OutMerged.Reset( Entry.Rows.Num() );
+	for( const FRow& Row : Entry.Rows )
+	{
+		OutMerged.Add( Row.Result );
+	}
+
+	TrimEntries();
+}
+
+void FSessionSearchCacheEOS::UpdatePing( const FString& SessionId, int32 PingInMs )
+{
+	for( TPair<FString, FEntry>& Entry : Entries )
+	{
+		for( FRow& Row : Entry.Value.Rows )
+		{
+			if( GetSessionId( Row.Result ) == SessionId )
+			{
+				Row.Result.PingInMs = PingInMs;
+			}
+		}
+	}
+}
+
+void FSessionSearchCacheEOS::RemoveSession( const FString& SessionId )
+{
+	for( TPair<FString, FEntry>& Entry : Entries )
+	{
+		Entry.Value.Rows.RemoveAll( [&SessionId]( const FRow& Row )
+		{
+			return GetSessionId( Row.Result ) == SessionId;
+		} );
+	}
+}
+
+void FSessionSearchCacheEOS::Empty()
+{
+	Entries.Empty();
+}
+
+int32 FSessionSearchCacheEOS::Num() const
+{
+	return Entries.Num();
+}
+
+const FSessionSearchCacheStatsEOS& FSessionSearchCacheEOS::GetStats() const
+{
+	return Stats;
+}
+
+void FSessionSearchCacheEOS::ResetStats()
+{
+	Stats = FSessionSearchCacheStatsEOS();
+}
+
+FString FSessionSearchCacheEOS::GetSessionId( const FOnlineSessionSearchResult& Result )
+{
+	return Result.Session.SessionInfo.IsValid() ? Result.Session.SessionInfo->GetSessionId().ToString() : FString();
+}
+
+uint32 FSessionSearchCacheEOS::GetFingerprint( const FOnlineSessionSearchResult& Result )
+{
+	const FOnlineSession& Session = Result.Session;
+	const FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+	uint32 Hash = GetTypeHash( Session.NumOpenPublicConnections );
+	Hash = HashCombine( Hash, GetTypeHash( Session.NumOpenPrivateConnections ) );
+	Hash = HashCombine( Hash, GetTypeHash( Settings.NumPublicConnections ) );
+	Hash = HashCombine( Hash, GetTypeHash( Settings.BuildUniqueId ) );
+	Hash = HashCombine( Hash, (uint32)Settings.bAllowJoinInProgress | ( (uint32)Settings.bShouldAdvertise << 1 ) | ( (uint32)Settings.bAllowJoinViaPresence << 2 ) );
+
+	// Attributes come back in no particular order, so combine them order-independently.
+	uint32 SettingsHash = 0;
+	for( const TPair<FName, FOnlineSessionSetting>& Setting : Settings.Settings )
+	{
+		SettingsHash += HashCombine( GetTypeHash( Setting.Key ), GetTypeHash( Setting.Value.Data.ToString() ) );
+	}
+
+	return HashCombine( Hash, SettingsHash );
+}
+
+void FSessionSearchCacheEOS::TrimEntries()
+{
+	while( Entries.Num() > MaxEntries )
+	{
+		const FString* OldestKey = nullptr;
+		double OldestTime = DBL_MAX;
+
+		for( const TPair<FString, FEntry>& Entry : Entries )
+		{
+			if( Entry.Value.FetchTime < OldestTime )
+			{
+				OldestKey = &Entry.Key;
+				OldestTime = Entry.Value.FetchTime;
+			}
+		}
+
+		Entries.Remove( FString( *OldestKey ) );
+	}
+}
@@ -0,0 +1,200 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+
+/** Result of looking a search up in the cache */
+enum class ESessionSearchCacheLookupEOS : uint8
+{
+	/** Nothing usable is cached, the search must go to the backend. */
+	Miss,
+	/** Cached results are fresh, and may be served as they are. */
+	Fresh,
+	/** Cached results may be served, but should be revalidated against the backend. */
+	Stale
+};
+
+/**
+ * Counters describing how well the search cache is doing. Totals since the cache was created or the stats reset.
+ */
+struct FSessionSearchCacheStatsEOS
+{
+	/** Searches served from fresh entries. */
+	uint64											NumHits;
+
+	/** Searches served from stale entries, with a revalidation started. */
+	uint64											NumStaleHits;
+
+	/** Searches that went to the backend. */
+	uint64											NumMisses;
+
+	/** Revalidations that completed. */
+	uint64											NumRevalidations;
+
+	/** Rows revalidation found unchanged, added, changed or gone. */
+	uint64											NumRowsUnchanged;
+	uint64											NumRowsAdded;
+	uint64											NumRowsChanged;
+	uint64											NumRowsRemoved;
+
+	/** Sum and maximum of the age of every entry served, in seconds. */
+	double											TotalServedAgeSeconds;
+	double											MaxServedAgeSeconds;
+
+	FSessionSearchCacheStatsEOS()
+		: NumHits( 0 )
+		, NumStaleHits( 0 )
+		, NumMisses( 0 )
+		, NumRevalidations( 0 )
+		, NumRowsUnchanged( 0 )
+		, NumRowsAdded( 0 )
+		, NumRowsChanged( 0 )
+		, NumRowsRemoved( 0 )
+		, TotalServedAgeSeconds( 0.0 )
+		, MaxServedAgeSeconds( 0.0 )
+	{}
+
+	/** @return float Fraction of searches served without waiting on the backend, fresh or stale. */
+	float GetHitRate() const
+	{
+		const uint64 NumLookups = NumHits + NumStaleHits + NumMisses;
+		return NumLookups > 0 ? (float)( NumHits + NumStaleHits ) / (float)NumLookups : 0.0f;
+	}
+
+	/** @return double Mean age of the entries served, in seconds. */
+	double GetMeanServedAgeSeconds() const
+	{
+		const uint64 NumServed = NumHits + NumStaleHits;
+		return NumServed > 0 ? TotalServedAgeSeconds / (double)NumServed : 0.0;
+	}
+
+	/** @return float Fraction of revalidated rows that were out of date, i.e. how stale served results really were. */
+	float GetRowChurn() const
+	{
+		const uint64 NumRows = NumRowsUnchanged + NumRowsAdded + NumRowsChanged + NumRowsRemoved;
+		return NumRows > 0 ? (float)( NumRowsAdded + NumRowsChanged + NumRowsRemoved ) / (float)NumRows : 0.0f;
+	}
+};
+
+/**
+ * Caches session search results, keyed by the normalized search parameters.
+ *
+ * Entries younger than SessionSearchCacheFreshSeconds are served as they are. Older ones, up to
+ * SessionSearchCacheMaxAgeSeconds, are served while the owner revalidates them; revalidated results
+ * are merged in by session id, so only rows whose attributes changed are replaced. At most
+ * SessionSearchCacheMaxEntries searches are kept, the oldest being evicted first.
+ *
+ * Game thread only.
+ */
+class FSessionSearchCacheEOS
+{
+
+public:
+
+	FSessionSearchCacheEOS();
+
+	/** Reads the cache options from [OnlineSubsystemEOS] in the Engine ini. */
+	void											Init();
+
+	/** @return bool False if caching is turned off in config. */
+	bool											IsEnabled() const;
+
+	/**
+	* Builds the cache key for a search. Searches that would return the same results produce the same key,
+	* regardless of the order their parameters were added in.
+	*/
+	static FString									MakeKey( const FOnlineSessionSearch& SearchSettings );
+
+	/**
+	* Looks a search up, recording the outcome in the stats.
+	*
+	* @param OutResults Populated with the cached results, unless this is a Miss.
+	*/
+	ESessionSearchCacheLookupEOS					Find( const FString& Key, TArray<FOnlineSessionSearchResult>& OutResults );
+
+	/**
+	* Marks a stale entry as being revalidated.
+	*
+	* @return bool False if it already is, or is no longer cached.
+	*/
+	bool											BeginRevalidation( const FString& Key );
+
+	/** Clears the revalidation mark of an entry whose refresh failed or was abandoned. */
+	void											AbortRevalidation( const FString& Key );
+
+	/**
+	* Stores the backend's results for a search. Rows already cached are matched by session id, and kept
+	* as they are (along with anything measured since, such as ping) unless their attributes changed.
+	*
+	* @param OutMerged Populated with the entry's results after the merge.
+	*/
+	void											Store( const FString& Key, const TArray<FOnlineSessionSearchResult>& Results, TArray<FOnlineSessionSearchResult>& OutMerged );
+
+	/** Records a session's measured ping in every entry it appears in, so it is served along with the session. */
+	void											UpdatePing( const FString& SessionId, int32 PingInMs );
+
+	/** Drops a session from every entry, e.g. once it is known to be gone. */
+	void											RemoveSession( const FString& SessionId );
+
+	/** Drops every entry. */
+	void											Empty();
+
+	/** @return int32 Number of searches cached. */
+	int32											Num() const;
+
+	const FSessionSearchCacheStatsEOS&				GetStats() const;
+
+	void											ResetStats();
+
+private:
+
+	/** A cached search result, and a hash of what it advertised when it was fetched. */
+	struct FRow
+	{
+		FOnlineSessionSearchResult					Result;
+		uint32										Fingerprint;
+	};
+
+	/** A cached search. */
+	struct FEntry
+	{
+		TArray<FRow>								Rows;
+
+		/** When the rows were last fetched from the backend. */
+		double										FetchTime;
+
+		/** Whether a revalidation is in flight. */
+		bool										bRevalidating;
+
+		FEntry()
+			: FetchTime( 0.0 )
+			, bRevalidating( false )
+		{}
+	};
+
+	/** @return The backend id of the session behind a search result. */
+	static FString									GetSessionId( const FOnlineSessionSearchResult& Result );
+
+	/** Hashes everything a session advertises, to tell whether a row changed between fetches. */
+	static uint32									GetFingerprint( const FOnlineSessionSearchResult& Result );
+
+	/** Evicts the oldest entries until at most MaxEntries remain. */
+	void											TrimEntries();
+
+	TMap<FString, FEntry>							Entries;
+
+	FSessionSearchCacheStatsEOS						Stats;
+
+	/** How long results are served without revalidation. */
+	double											FreshSeconds;
+
+	/** How long results are served at all. */
+	double											MaxAgeSeconds;
+
+	/** How many searches are kept. */
+	int32											MaxEntries;
+};
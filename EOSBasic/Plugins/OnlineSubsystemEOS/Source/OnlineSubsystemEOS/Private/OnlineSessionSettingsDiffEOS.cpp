@@ -0,0 +1,239 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionSettingsDiffEOS.h"
+
+// Engine Includes
+#include "OnlineSubsystem.h"
+#include "Hash/CityHash.h"
+
+// EOS Includes
+#include "OnlineSubsystemEOSTypes.h"
+#include "OnlineSessionInterfaceEOS.h"
+
+
+bool FSessionSettingsDeltaEOS::IsEmpty() const
+{
+	return Changed.Num() == 0 && Removed.Num() == 0 && bMaxPlayersChanged == false && bPermissionLevelChanged == false && bJoinInProgressChanged == false;
+}
+
+// Passed by reference to TMap::Add, so it needs a definition of its own.
+const uint64 FSessionSettingsDiffEOS::RemovedHash;
+
+FSessionSettingsDiffEOS::FSessionSettingsDiffEOS()
+	: WrittenMaxPlayers( -1 )
+	, WrittenPermissionLevel( -1 )
+	, WrittenJoinInProgress( -1 )
+{
+}
+
+bool FSessionSettingsDiffEOS::GetAttribute( const FOnlineSessionSettings& Settings, FName Key, FVariantData& OutValue )
+{
+	if( Key == SETTING_EOS_BUILDID )
+	{
+		OutValue.SetValue( Settings.BuildUniqueId );
+		return true;
+	}
+
+	const FOnlineSessionSetting* Setting = Settings.Settings.Find( Key );
+
+	if( Setting == nullptr || IsAdvertised( Key, *Setting ) == false )
+	{
+		return false;
+	}
+
+	OutValue = Setting->Data;
+	return true;
+}
+
+void FSessionSettingsDiffEOS::Diff( const FOnlineSessionSettings& Desired, FSessionSettingsDeltaEOS& OutDelta ) const
+{
+	const uint64* BuildIdHash = AttributeHashes.Find( SETTING_EOS_BUILDID );
+	if( BuildIdHash == nullptr || *BuildIdHash != HashValue( FVariantData( Desired.BuildUniqueId ) ) )
+	{
+		OutDelta.Changed.Add( SETTING_EOS_BUILDID );
+	}
+
+	for( const TPair<FName, FOnlineSessionSetting>& Setting : Desired.Settings )
+	{
+		if( IsAdvertised( Setting.Key, Setting.Value ) == false )
+		{
+			continue;
+		}
+
+		const uint64* Hash = AttributeHashes.Find( Setting.Key );
+		if( Hash == nullptr || *Hash != HashValue( Setting.Value.Data ) )
+		{
+			OutDelta.Changed.Add( Setting.Key );
+		}
+	}
+
+	FVariantData Unused;
+
+	for( const TPair<FName, uint64>& Held : AttributeHashes )
+	{
+		if( GetAttribute( Desired, Held.Key, Unused ) == false )
+		{
+			OutDelta.Removed.Add( Held.Key );
+		}
+	}
+
+	OutDelta.bMaxPlayersChanged = WrittenMaxPlayers != Desired.NumPublicConnections + Desired.NumPrivateConnections;
+	OutDelta.bPermissionLevelChanged = WrittenPermissionLevel != GetPermissionLevel( Desired );
+	OutDelta.bJoinInProgressChanged = WrittenJoinInProgress != ( Desired.bAllowJoinInProgress ? 1 : 0 );
+}
+
+void FSessionSettingsDiffEOS::Commit( const FOnlineSessionSettings& Desired, const FSessionSettingsDeltaEOS& Delta )
+{
+	FVariantData Value;
+
+	for( const FName& Key : Delta.Changed )
+	{
+		if( GetAttribute( Desired, Key, Value ) == true )
+		{
+			AttributeHashes.Add( Key, HashValue( Value ) );
+		}
+	}
+
+	for( const FName& Key : Delta.Removed )
+	{
+		AttributeHashes.Remove( Key );
+	}
+
+	WrittenMaxPlayers = Desired.NumPublicConnections + Desired.NumPrivateConnections;
+	WrittenPermissionLevel = GetPermissionLevel( Desired );
+	WrittenJoinInProgress = Desired.bAllowJoinInProgress ? 1 : 0;
+}
+
+void FSessionSettingsDiffEOS::Invalidate( const FSessionSettingsDeltaEOS& Delta )
+{
+	for( const FName& Key : Delta.Changed )
+	{
+		AttributeHashes.Remove( Key );
+	}
+
+	// Still held by the backend, so the next Diff removes them again.
+	for( const FName& Key : Delta.Removed )
+	{
+		AttributeHashes.Add( Key, RemovedHash );
+	}
+
+	if( Delta.bMaxPlayersChanged == true )
+	{
+		WrittenMaxPlayers = -1;
+	}
+
+	if( Delta.bPermissionLevelChanged == true )
+	{
+		WrittenPermissionLevel = -1;
+	}
+
+	if( Delta.bJoinInProgressChanged == true )
+	{
+		WrittenJoinInProgress = -1;
+	}
+}
+
+void FSessionSettingsDiffEOS::Empty()
+{
+	AttributeHashes.Empty();
+	WrittenMaxPlayers = -1;
+	WrittenPermissionLevel = -1;
+	WrittenJoinInProgress = -1;
+}
+
+SIZE_T FSessionSettingsDiffEOS::GetAllocatedSize() const
+{
+	return AttributeHashes.GetAllocatedSize();
+}
+
+bool FSessionSettingsDiffEOS::IsAdvertised( FName Key, const FOnlineSessionSetting& Setting )
+{
+	// The bucket is given when the session is created, and can't change. Blobs have no attribute type.
+	if( Key == SETTING_EOS_BUCKETID || Setting.Data.GetType() == EOnlineKeyValuePairDataType::Blob || Setting.Data.GetType() == EOnlineKeyValuePairDataType::Empty )
+	{
+		return false;
+	}
+
+	return Setting.AdvertisementType == EOnlineDataAdvertisementType::ViaOnlineService || Setting.AdvertisementType == EOnlineDataAdvertisementType::ViaOnlineServiceAndPing;
+}
+
+uint64 FSessionSettingsDiffEOS::HashValue( const FVariantData& Value )
+{
+	const uint8 Type = (uint8)Value.GetType();
+	uint64 Hash = CityHash64( (const char*)&Type, sizeof( Type ) );
+
+	auto HashBytes = [&Hash]( const void* Bytes, int32 Size )
+	{
+		Hash = CityHash64WithSeed( (const char*)Bytes, Size, Hash );
+	};
+
+	switch( Value.GetType() )
+	{
+	case EOnlineKeyValuePairDataType::Int32:
+	{
+		int32 Data = 0;
+		Value.GetValue( Data );
+		HashBytes( &Data, sizeof( Data ) );
+		break;
+	}
+	case EOnlineKeyValuePairDataType::UInt32:
+	{
+		uint32 Data = 0;
+		Value.GetValue( Data );
+		HashBytes( &Data, sizeof( Data ) );
+		break;
+	}
+	case EOnlineKeyValuePairDataType::Int64:
+	{
+		int64 Data = 0;
+		Value.GetValue( Data );
+		HashBytes( &Data, sizeof( Data ) );
+		break;
+	}
+	case EOnlineKeyValuePairDataType::UInt64:
+	{
+		uint64 Data = 0;
+		Value.GetValue( Data );
+		HashBytes( &Data, sizeof( Data ) );
+		break;
+	}
+	case EOnlineKeyValuePairDataType::Float:
+	{
+		float Data = 0.0f;
+		Value.GetValue( Data );
+		HashBytes( &Data, sizeof( Data ) );
+		break;
+	}
+	case EOnlineKeyValuePairDataType::Double:
+	{
+		double Data = 0.0;
+		Value.GetValue( Data );
+		HashBytes( &Data, sizeof( Data ) );
+		break;
+	}
+	case EOnlineKeyValuePairDataType::Bool:
+	{
+		bool bData = false;
+		Value.GetValue( bData );
+		const uint8 Data = bData ? 1 : 0;
+		HashBytes( &Data, sizeof( Data ) );
+		break;
+	}
+	case EOnlineKeyValuePairDataType::String:
+	{
+		FString Data;
+		Value.GetValue( Data );
+		HashBytes( *Data, Data.Len() * sizeof( TCHAR ) );
+		break;
+	}
+	default:
+		break;
+	}
+
+	return Hash != RemovedHash ? Hash : RemovedHash + 1;
+}
+
+int32 FSessionSettingsDiffEOS::GetPermissionLevel( const FOnlineSessionSettings& Settings )
+{
+	return Settings.bShouldAdvertise ? 2 : ( Settings.bAllowJoinViaPresence ? 1 : 0 );
+}
@@ -0,0 +1,95 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+
+
+/**
+ * What a session write must carry for the backend to match the local settings.
+ */
+struct FSessionSettingsDeltaEOS
+{
+	/** Attributes that are new or hold a different value. */
+	TArray<FName>									Changed;
+
+	/** Attributes the backend holds that are no longer advertised. */
+	TArray<FName>									Removed;
+
+	bool											bMaxPlayersChanged;
+
+	bool											bPermissionLevelChanged;
+
+	bool											bJoinInProgressChanged;
+
+	FSessionSettingsDeltaEOS()
+		: bMaxPlayersChanged( false )
+		, bPermissionLevelChanged( false )
+		, bJoinInProgressChanged( false )
+	{}
+
+	/** @return bool True if the backend already matches, so there is nothing to write. */
+	bool											IsEmpty() const;
+};
+
+/**
+ * The settings of a session hosted through EOS_Sessions, as last pushed to the backend.
+ *
+ * Attribute values are kept as 64 bit hashes rather than copies, so a session advertising many settings can be
+ * compared against its full local settings on every UpdateSession without holding a second copy of them.
+ * Properties are kept as written, -1 if they must be written again.
+ *
+ * Game thread only.
+ */
+class FSessionSettingsDiffEOS
+{
+
+public:
+
+	FSessionSettingsDiffEOS();
+
+	/**
+	* Looks up the value of an attribute as it is advertised. The build id is advertised with the settings.
+	*
+	* @return bool False if the settings don't advertise the key.
+	*/
+	static bool										GetAttribute( const FOnlineSessionSettings& Settings, FName Key, FVariantData& OutValue );
+
+	/** Works out what must be written for the backend to match Desired. */
+	void											Diff( const FOnlineSessionSettings& Desired, FSessionSettingsDeltaEOS& OutDelta ) const;
+
+	/** Records a write of the delta Diff returned, as sent. */
+	void											Commit( const FOnlineSessionSettings& Desired, const FSessionSettingsDeltaEOS& Delta );
+
+	/** Forgets a write that failed, so the next Diff sends the same delta again. */
+	void											Invalidate( const FSessionSettingsDeltaEOS& Delta );
+
+	void											Empty();
+
+	/** @return SIZE_T Bytes allocated for the state held. */
+	SIZE_T											GetAllocatedSize() const;
+
+private:
+
+	/** @return bool True if a setting becomes a session attribute, rather than being kept locally. */
+	static bool										IsAdvertised( FName Key, const FOnlineSessionSetting& Setting );
+
+	/** @return uint64 Hash of the type and exact value. Never RemovedHash. */
+	static uint64									HashValue( const FVariantData& Value );
+
+	static int32									GetPermissionLevel( const FOnlineSessionSettings& Settings );
+
+	/** Marks a key the backend still holds, but that must be removed. */
+	static const uint64								RemovedHash = 0;
+
+	/** Hashes of the attribute values the backend holds, by key. */
+	TMap<FName, uint64>								AttributeHashes;
+
+	int32											WrittenMaxPlayers;
+
+	int32											WrittenPermissionLevel;
+
+	int32											WrittenJoinInProgress;
+};
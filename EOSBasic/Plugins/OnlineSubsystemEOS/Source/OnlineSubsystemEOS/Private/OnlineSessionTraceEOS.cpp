@@ -0,0 +1,201 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#include "OnlineSessionTraceEOS.h"
+
+// Engine Includes
+#include "Misc/ConfigCacheIni.h"
+
+
+FSessionLatencyHistogramEOS::FSessionLatencyHistogramEOS()
+	: Count( 0 )
+	, TotalSeconds( 0.0 )
+	, MaxSeconds( 0.0 )
+{
+	FMemory::Memzero( Buckets );
+}
+
+void FSessionLatencyHistogramEOS::Add( double Seconds )
+{
+	Seconds = FMath::Max( Seconds, 0.0 );
+
+	const uint32 Milliseconds = (uint32)FMath::Min( FMath::CeilToDouble( Seconds * 1000.0 ), (double)MAX_uint32 );
+	const int32 Bucket = FMath::Min( (int32)FMath::CeilLogTwo( FMath::Max( Milliseconds, 1u ) ), NumBuckets - 1 );
+
+	++Buckets[Bucket];
+	++Count;
+	TotalSeconds += Seconds;
+	MaxSeconds = FMath::Max( MaxSeconds, Seconds );
+}
+
+uint64 FSessionLatencyHistogramEOS::GetCount() const
+{
+	return Count;
+}
+
+double FSessionLatencyHistogramEOS::GetMeanSeconds() const
+{
+	return Count > 0 ? TotalSeconds / (double)Count : 0.0;
+}
+
+double FSessionLatencyHistogramEOS::GetMaxSeconds() const
+{
+	return MaxSeconds;
+}
+
+double FSessionLatencyHistogramEOS::GetPercentileSeconds( double Percentile ) const
+{
+	if( Count == 0 )
+	{
+		return 0.0;
+	}
+
+	const uint64 Rank = FMath::Max<uint64>( (uint64)FMath::CeilToDouble( ( Percentile / 100.0 ) * (double)Count ), 1 );
+	uint64 NumBelow = 0;
+
+	for( int32 Bucket = 0; Bucket < NumBuckets - 1; ++Bucket )
+	{
+		NumBelow += Buckets[Bucket];
+
+		if( NumBelow >= Rank )
+		{
+			return FMath::Min( (double)( 1u << Bucket ) / 1000.0, MaxSeconds );
+		}
+	}
+
+	// Beyond the last bound, the maximum is all there is to go on.
+	return MaxSeconds;
+}
+
+FString FSessionLatencyHistogramEOS::BucketsToString() const
+{
+	FString Result;
+
+	for( int32 Bucket = 0; Bucket < NumBuckets; ++Bucket )
+	{
+		if( Buckets[Bucket] == 0 )
+		{
+			continue;
+		}
+
+		if( Result.IsEmpty() == false )
+		{
+			Result += TEXT( ", " );
+		}
+
+		if( Bucket < NumBuckets - 1 )
+		{
+			Result += FString::Printf( TEXT( "<=%ums: %llu" ), 1u << Bucket, (unsigned long long)Buckets[Bucket] );
+		}
+		else
+		{
+			Result += FString::Printf( TEXT( ">%ums: %llu" ), 1u << ( Bucket - 1 ), (unsigned long long)Buckets[Bucket] );
+		}
+	}
+
+	return Result;
+}
+
+FString FSessionTraceEOS::ToString() const
+{
+	FString Result;
+
+	for( int32 TransitionIdx = 0; TransitionIdx < Transitions.Num(); ++TransitionIdx )
+	{
+		const FTransition& Transition = Transitions[TransitionIdx];
+
+		if( TransitionIdx == 0 )
+		{
+			Result = EOnlineSessionState::ToString( Transition.State );
+			continue;
+		}
+
+		Result += FString::Printf( TEXT( " -> %s @%.1fms (+%.1fms)" ), EOnlineSessionState::ToString( Transition.State ),
+								   ( Transition.Time - Transitions[0].Time ) * 1000.0, ( Transition.Time - Transitions[TransitionIdx - 1].Time ) * 1000.0 );
+	}
+
+	return Result;
+}
+
+FSessionTracerEOS::FSessionTracerEOS()
+	: MaxRecentTraces( 8 )
+{
+}
+
+void FSessionTracerEOS::Init()
+{
+	GConfig->GetInt( TEXT( "OnlineSubsystemEOS" ), TEXT( "SessionTraceHistory" ), MaxRecentTraces, GEngineIni );
+	MaxRecentTraces = FMath::Max( MaxRecentTraces, 0 );
+}
+
+void FSessionTracerEOS::BeginSession( FName SessionName, double Now )
+{
+	if( Traces.Contains( SessionName ) )
+	{
+		EndSession( SessionName, FString(), Now );
+	}
+
+	FSessionTraceEOS& Trace = Traces.Add( SessionName );
+	Trace.SessionName = SessionName;
+	Trace.Transitions.Emplace( EOnlineSessionState::NoSession, Now );
+}
+
+void FSessionTracerEOS::RecordTransition( FName SessionName, EOnlineSessionState::Type NewState, double Now )
+{
+	if( FSessionTraceEOS* Trace = Traces.Find( SessionName ) )
+	{
+		AddTransition( *Trace, NewState, Now );
+	}
+}
+
+void FSessionTracerEOS::EndSession( FName SessionName, const FString& SessionId, double Now )
+{
+	FSessionTraceEOS Trace;
+
+	if( Traces.RemoveAndCopyValue( SessionName, Trace ) == false )
+	{
+		return;
+	}
+
+	// Destroying -> NoSession is how long the backend took to destroy it.
+	Trace.SessionId = SessionId;
+	AddTransition( Trace, EOnlineSessionState::NoSession, Now );
+
+	if( MaxRecentTraces > 0 )
+	{
+		if( RecentTraces.Num() >= MaxRecentTraces )
+		{
+			RecentTraces.RemoveAt( 0, RecentTraces.Num() - MaxRecentTraces + 1, false );
+		}
+
+		RecentTraces.Add( MoveTemp( Trace ) );
+	}
+}
+
+const FSessionTraceEOS* FSessionTracerEOS::Find( FName SessionName ) const
+{
+	return Traces.Find( SessionName );
+}
+
+const TArray<FSessionTraceEOS>& FSessionTracerEOS::GetRecentTraces() const
+{
+	return RecentTraces;
+}
+
+const TMap<FString, FSessionLatencyHistogramEOS>& FSessionTracerEOS::GetHistograms() const
+{
+	return Histograms;
+}
+
+void FSessionTracerEOS::AddTransition( FSessionTraceEOS& Trace, EOnlineSessionState::Type NewState, double Now )
+{
+	const FSessionTraceEOS::FTransition& Previous = Trace.Transitions.Last();
+
+	if( Previous.State == NewState )
+	{
+		return;
+	}
+
+	Histograms.FindOrAdd( FString::Printf( TEXT( "%s -> %s" ), EOnlineSessionState::ToString( Previous.State ), EOnlineSessionState::ToString( NewState ) ) ).Add( Now - Previous.Time );
+
+	Trace.Transitions.Emplace( NewState, Now );
+}
@@ -0,0 +1,130 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "OnlineSubsystemTypes.h"
+
+
+/**
+ * Latency histogram with power of two millisecond buckets, from 1ms up to 32s and beyond. Fixed size, so
+ * every transition of every session can be recorded for as long as the process runs.
+ */
+class FSessionLatencyHistogramEOS
+{
+
+public:
+
+	FSessionLatencyHistogramEOS();
+
+	void											Add( double Seconds );
+
+	uint64											GetCount() const;
+
+	double											GetMeanSeconds() const;
+
+	double											GetMaxSeconds() const;
+
+	/**
+	* @param Percentile In [0,100].
+	* @return double Upper bound of the bucket the percentile falls in, in seconds. Never more than the maximum recorded.
+	*/
+	double											GetPercentileSeconds( double Percentile ) const;
+
+	/** @return FString The buckets that hold anything, e.g. "<=256ms: 3, <=512ms: 9". */
+	FString											BucketsToString() const;
+
+private:
+
+	static const int32								NumBuckets = 16;
+
+	/** Bucket i holds latencies up to 2^i ms. The last also holds everything longer. */
+	uint64											Buckets[NumBuckets];
+
+	uint64											Count;
+
+	double											TotalSeconds;
+
+	double											MaxSeconds;
+};
+
+/**
+ * Every state a session has been in, and when it got there.
+ */
+struct FSessionTraceEOS
+{
+	struct FTransition
+	{
+		EOnlineSessionState::Type					State;
+
+		/** FPlatformTime::Seconds() of the transition. */
+		double										Time;
+
+		FTransition( EOnlineSessionState::Type InState, double InTime )
+			: State( InState )
+			, Time( InTime )
+		{}
+	};
+
+	FName											SessionName;
+
+	/** The backend id of the session, recorded once it has ended. */
+	FString											SessionId;
+
+	/** Starts with NoSession, when the session was added. */
+	TArray<FTransition>								Transitions;
+
+	/** Appends each transition with the time since the session was added, and since the previous transition. */
+	FString											ToString() const;
+};
+
+/**
+ * Traces the state transitions of every session, and keeps a latency histogram per kind of transition
+ * across all of them, e.g. Creating -> Pending being how long the backend takes to create a session.
+ * The traces of the last SessionTraceHistory sessions removed are kept too.
+ *
+ * Game thread only.
+ */
+class FSessionTracerEOS
+{
+
+public:
+
+	FSessionTracerEOS();
+
+	/** Reads SessionTraceHistory from [OnlineSubsystemEOS] in the Engine ini. */
+	void											Init();
+
+	/** Starts tracing a session, ending the trace of any session it replaces. */
+	void											BeginSession( FName SessionName, double Now );
+
+	/** Records a session entering a state, unless it already is in it. */
+	void											RecordTransition( FName SessionName, EOnlineSessionState::Type NewState, double Now );
+
+	/** Ends a session's trace, keeping it among the recent ones. */
+	void											EndSession( FName SessionName, const FString& SessionId, double Now );
+
+	/** @return The trace of a current session, if traced. */
+	const FSessionTraceEOS*							Find( FName SessionName ) const;
+
+	/** @return The traces of recently removed sessions, oldest first. */
+	const TArray<FSessionTraceEOS>&					GetRecentTraces() const;
+
+	/** @return The latency of each kind of transition, as "From -> To", in first seen order. */
+	const TMap<FString, FSessionLatencyHistogramEOS>& GetHistograms() const;
+
+private:
+
+	/** Appends a transition to a trace, and its latency to the histogram of its kind. */
+	void											AddTransition( FSessionTraceEOS& Trace, EOnlineSessionState::Type NewState, double Now );
+
+	TMap<FName, FSessionTraceEOS>					Traces;
+
+	TArray<FSessionTraceEOS>						RecentTraces;
+
+	TMap<FString, FSessionLatencyHistogramEOS>		Histograms;
+
+	/** How many traces of removed sessions are kept. */
+	int32											MaxRecentTraces;
+};
@@ -5,10 +5,14 @@
 // UE4 Includes
 #include "Core.h"
 #include "UObject/ObjectMacros.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
 
 // OSS EOS Includes
 #include "OnlineIdentityInterfaceEOS.h"
+#include "OnlineIdentityTokenVerifierEOS.h"
 #include "OnlineSessionInterfaceEOS.h"
+#include "OnlineBulkLoginHarnessEOS.h"
+#include "OnlineSubsystemEOSArena.h"
 
 
 IOnlineSessionPtr FOnlineSubsystemEOS::GetSessionInterface() const
@@ -184,6 +188,11 @@ bool FOnlineSubsystemEOS::Shutdown()
 	FOnlineSubsystemImpl::Shutdown();
 
 	// Attempt to end any Async Processes.
+	if( BulkLoginHarness.IsValid() )
+	{
+		BulkLoginHarness->Cancel();
+		BulkLoginHarness = nullptr;
+	}
 
 #define DESTRUCT_INTERFACE(Interface) \
 	if( Interface.IsValid() ) \
@@ -220,6 +229,234 @@ bool FOnlineSubsystemEOS::Exec( class UWorld* InWorld, const TCHAR* Cmd, FOutput
 		return true;
 	}
 
+	if( FParse::Command( &Cmd, TEXT( "EOS" ) ) )
+	{
+		if( FParse::Command( &Cmd, TEXT( "BULKLOGIN" ) ) )
+		{
+			return HandleBulkLoginCommand( Cmd, Ar );
+		}
+
+		if( FParse::Command( &Cmd, TEXT( "IDTOKEN" ) ) )
+		{
+			return HandleIdTokenCommand( Cmd, Ar );
+		}
+
+		if( FParse::Command( &Cmd, TEXT( "SEARCHCACHE" ) ) )
+		{
+			return HandleSearchCacheCommand( Cmd, Ar );
+		}
+
+		if( FParse::Command( &Cmd, TEXT( "QOS" ) ) )
+		{
+			return HandleQosCommand( Cmd, Ar );
+		}
+
+		if( FParse::Command( &Cmd, TEXT( "MATCHMAKE" ) ) )
+		{
+			return HandleMatchmakeCommand( Cmd, Ar );
+		}
+	}
+
+	return false;
+}
+
+bool FOnlineSubsystemEOS::HandleBulkLoginCommand( const TCHAR* Cmd, FOutputDevice& Ar )
+{
+	if( FParse::Command( &Cmd, TEXT( "STATUS" ) ) )
+	{
+		Ar.Log( BulkLoginHarness.IsValid() ? *BulkLoginHarness->GetReport() : TEXT( "EOS Bulk Login: No run in progress." ) );
+		return true;
+	}
+
+	if( FParse::Command( &Cmd, TEXT( "CANCEL" ) ) )
+	{
+		if( BulkLoginHarness.IsValid() )
+		{
+			Ar.Log( *BulkLoginHarness->GetReport() );
+			BulkLoginHarness->Cancel();
+			BulkLoginHarness = nullptr;
+		}
+		return true;
+	}
+
+	if( BulkLoginHarness.IsValid() )
+	{
+		Ar.Log( TEXT( "EOS Bulk Login: A run is already in progress. Use EOS BULKLOGIN CANCEL to stop it." ) );
+		return true;
+	}
+
+	FBulkLoginConfigEOS Config;
+	FParse::Value( Cmd, TEXT( "COUNT=" ), Config.NumLogins );
+	FParse::Value( Cmd, TEXT( "CONCURRENCY=" ), Config.MaxConcurrent );
+	FParse::Value( Cmd, TEXT( "HOST=" ), Config.DevAuthHost );
+	FParse::Value( Cmd, TEXT( "PREFIX=" ), Config.CredentialPrefix );
+	FParse::Value( Cmd, TEXT( "LATENCYMS=" ), Config.MockLatencyMs );
+	FParse::Value( Cmd, TEXT( "FAILRATE=" ), Config.MockFailureRate );
+	FParse::Bool( Cmd, TEXT( "LOGOUT=" ), Config.bLogoutWhenDone );
+
+	FString ModeStr;
+	if( FParse::Value( Cmd, TEXT( "MODE=" ), ModeStr ) && ModeStr.Equals( TEXT( "DEV" ), ESearchCase::IgnoreCase ) )
+	{
+		Config.Mode = EEOSBulkLoginMode::DevAuth;
+	}
+
+	if( Config.Mode == EEOSBulkLoginMode::DevAuth && ( IsEOSInitialized() == false || IdentityInterface.IsValid() == false ) )
+	{
+		Ar.Log( TEXT( "EOS Bulk Login: DevAuth mode requires an initialized EOS SDK." ) );
+		return true;
+	}
+
+	BulkLoginHarness = MakeShared<FBulkLoginHarnessEOS>( IdentityInterface.Get(), PlatformHandle, Config );
+	BulkLoginHarness->Start();
+
+	return true;
+}
+
+bool FOnlineSubsystemEOS::HandleIdTokenCommand( const TCHAR* Cmd, FOutputDevice& Ar )
+{
+	if( IdentityInterface.IsValid() == false )
+	{
+		Ar.Log( TEXT( "EOS ID Token: No Identity Interface." ) );
+		return true;
+	}
+
+	TSharedPtr<FIdTokenVerifierEOS, ESPMode::ThreadSafe> Verifier = IdentityInterface->GetIdTokenVerifier();
+
+	if( FParse::Command( &Cmd, TEXT( "VERIFY" ) ) )
+	{
+		const FString Token = FParse::Token( Cmd, false );
+
+		FIdTokenClaimsEOS Claims;
+		const EIdTokenResultEOS Result = Verifier->VerifyToken( Token, Claims );
+
+		Ar.Logf( TEXT( "EOS ID Token: %s | Subject: %s | Issuer: %s | Key: %s | Expires: %lld" ),
+				 LexToString( Result ), *Claims.Subject, *Claims.Issuer, *Claims.KeyId, (long long)Claims.ExpiresAt );
+		return true;
+	}
+
+	if( FParse::Command( &Cmd, TEXT( "LOADKEYS" ) ) )
+	{
+		const FString FilePath = FParse::Token( Cmd, false );
+
+		FString ErrorStr;
+		if( Verifier->LoadSigningKeysFromFile( FilePath, ErrorStr ) == false )
+		{
+			Ar.Logf( TEXT( "EOS ID Token: Failed to load signing keys. %s" ), *ErrorStr );
+		}
+		return true;
+	}
+
+	if( FParse::Command( &Cmd, TEXT( "REFRESH" ) ) )
+	{
+		Verifier->RefreshSigningKeys();
+		return true;
+	}
+
+	Ar.Logf( TEXT( "EOS ID Token: %d signing keys loaded." ), Verifier->GetNumSigningKeys() );
+	return true;
+}
+
+bool FOnlineSubsystemEOS::HandleSearchCacheCommand( const TCHAR* Cmd, FOutputDevice& Ar )
+{
+	if( SessionInterface.IsValid() == false )
+	{
+		Ar.Log( TEXT( "EOS Search Cache: No Session Interface." ) );
+		return true;
+	}
+
+	if( FParse::Command( &Cmd, TEXT( "FLUSH" ) ) )
+	{
+		SessionInterface->FlushSearchCache();
+		return true;
+	}
+
+	const FSessionSearchCacheStatsEOS& Stats = SessionInterface->GetSearchCacheStats();
+
+	Ar.Logf( TEXT( "EOS Search Cache: Hits: %llu | Stale: %llu | Misses: %llu | Hit Rate: %.1f%% | Mean Age: %.1fs | Max Age: %.1fs" ),
+			 (unsigned long long)Stats.NumHits, (unsigned long long)Stats.NumStaleHits, (unsigned long long)Stats.NumMisses, Stats.GetHitRate() * 100.0f, Stats.GetMeanServedAgeSeconds(), Stats.MaxServedAgeSeconds );
+	Ar.Logf( TEXT( "EOS Search Cache: Revalidations: %llu | Rows Unchanged: %llu | Added: %llu | Changed: %llu | Removed: %llu | Churn: %.1f%%" ),
+			 (unsigned long long)Stats.NumRevalidations, (unsigned long long)Stats.NumRowsUnchanged, (unsigned long long)Stats.NumRowsAdded,
+			 (unsigned long long)Stats.NumRowsChanged, (unsigned long long)Stats.NumRowsRemoved, Stats.GetRowChurn() * 100.0f );
+	return true;
+}
+
+bool FOnlineSubsystemEOS::HandleQosCommand( const TCHAR* Cmd, FOutputDevice& Ar )
+{
+	if( SessionInterface.IsValid() == false )
+	{
+		Ar.Log( TEXT( "EOS QoS: No Session Interface." ) );
+		return true;
+	}
+
+	if( FParse::Command( &Cmd, TEXT( "RESPOND" ) ) )
+	{
+		int32 Port = FSessionQosResponderEOS::GetConfiguredPort();
+		FParse::Value( Cmd, TEXT( "PORT=" ), Port );
+
+		Ar.Logf( TEXT( "EOS QoS: Responder %s." ), SessionInterface->StartQosResponder( Port ) ? TEXT( "running" ) : TEXT( "failed to start" ) );
+		return true;
+	}
+
+	if( FParse::Command( &Cmd, TEXT( "PING" ) ) )
+	{
+		// Each argument is an ip:port to probe, e.g. a loopback responder.
+		TArray<FSessionQosTargetEOS> Targets;
+
+		FString Token;
+		while( FParse::Token( Cmd, Token, false ) )
+		{
+			FIPv4Endpoint Endpoint;
+			if( FIPv4Endpoint::Parse( Token, Endpoint ) )
+			{
+				Targets.Emplace( Token, Endpoint.ToInternetAddr() );
+			}
+			else
+			{
+				Ar.Logf( TEXT( "EOS QoS: Ignoring %s, expected ip:port." ), *Token );
+			}
+		}
+
+		SessionInterface->GetQosProber().Probe( Targets, FOnSessionQosCompleteEOS::CreateLambda( []( const TMap<FString, int32>& PingsInMs )
+		{
+			for( const TPair<FString, int32>& Ping : PingsInMs )
+			{
+				UE_LOG_ONLINE_SESSION( Log, TEXT( "EOS QoS: %s | %d ms" ), *Ping.Key, Ping.Value );
+			}
+		} ) );
+		return true;
+	}
+
+	return false;
+}
+
+bool FOnlineSubsystemEOS::HandleMatchmakeCommand( const TCHAR* Cmd, FOutputDevice& Ar )
+{
+	if( FParse::Command( &Cmd, TEXT( "BENCH" ) ) )
+	{
+		FMatchmakingBenchmarkConfigEOS Config;
+		FParse::Value( Cmd, TEXT( "PLAYERS=" ), Config.NumPlayers );
+		FParse::Value( Cmd, TEXT( "SESSIONS=" ), Config.NumSessions );
+		FParse::Value( Cmd, TEXT( "SKILLS=" ), Config.NumSkillBuckets );
+		FParse::Value( Cmd, TEXT( "SIZE=" ), Config.SessionSize );
+		FParse::Value( Cmd, TEXT( "SEED=" ), Config.Seed );
+
+		float ArrivalSeconds = (float)Config.ArrivalSeconds;
+		if( FParse::Value( Cmd, TEXT( "ARRIVAL=" ), ArrivalSeconds ) )
+		{
+			Config.ArrivalSeconds = FMath::Max( ArrivalSeconds, 0.0f );
+		}
+
+		Config.NumSkillBuckets = FMath::Max( Config.NumSkillBuckets, 1 );
+		Config.SessionSize = FMath::Max( Config.SessionSize, 2 );
+
+		// Runs on a simulated clock, with the tuning from config, so it completes straight away.
+		FMatchmakingParamsEOS Params;
+		Params.LoadConfig();
+
+		Ar.Log( *EOSMatchmakingBenchmark::Run( Params, Config ) );
+		return true;
+	}
+
 	return false;
 }
 
@@ -249,9 +486,31 @@ bool FOnlineSubsystemEOS::Tick( float DeltaTime )
 			return false;
 		}
 
+		// Coalesced session writes go out before the SDK ticks, so they are sent this frame.
+		if( SessionInterface.IsValid() )
+		{
+			SessionInterface->Tick( DeltaTime );
+		}
+
 		EOS_Platform_Tick( PlatformHandle );
 	}
 
+	// LAN sessions don't need EOS at all.
+	if( SessionInterface.IsValid() )
+	{
+		SessionInterface->TickLAN( DeltaTime );
+	}
+
+	if( IdentityInterface.IsValid() )
+	{
+		IdentityInterface->Tick( DeltaTime );
+	}
+
+	if( BulkLoginHarness.IsValid() && BulkLoginHarness->Tick( DeltaTime ) == false )
+	{
+		BulkLoginHarness = nullptr;
+	}
+
 	return true;
 }
 
@@ -306,8 +565,7 @@ bool FOnlineSubsystemEOS::GetEOSConfigOptions()
 
 bool FOnlineSubsystemEOS::InitializeSDK()
 {
-	FTCHARToUTF8 ProductNameStr( *ProductName );
-	FTCHARToUTF8 ProductVersionStr( *ProductVersion );
+	FEOSScratchArena Arena;
 
 	// Init EOS SDK
 	EOS_InitializeOptions SDKOptions;
@@ -315,8 +573,8 @@ bool FOnlineSubsystemEOS::InitializeSDK()
 	SDKOptions.AllocateMemoryFunction = nullptr;
 	SDKOptions.ReallocateMemoryFunction = nullptr;
 	SDKOptions.ReleaseMemoryFunction = nullptr;
-	SDKOptions.ProductName = ProductNameStr.Get();
-	SDKOptions.ProductVersion = ProductVersionStr.Get();
+	SDKOptions.ProductName = Arena.ToUTF8( ProductName );
+	SDKOptions.ProductVersion = Arena.ToUTF8( ProductVersion );
 	SDKOptions.Reserved = nullptr;
 	SDKOptions.SystemInitializeOptions = nullptr;
 	SDKOptions.OverrideThreadAffinity = nullptr;
@@ -363,40 +621,35 @@ bool FOnlineSubsystemEOS::CreatePlatformHandle()
 		}
 	}
 
-	std::string CacheDirUTF8( TCHAR_TO_UTF8( *TempPath ) );
-	PlatformOptions.CacheDirectory = CacheDirUTF8.c_str();
-
-	FTCHARToUTF8 ProductIdStr( *ProductId );
-	FTCHARToUTF8 SandboxIdStr( *SandboxId );
-	FTCHARToUTF8 DeploymentIdStr( *DeploymentId );
-
-	if( ProductIdStr.Length() == 0 )
+	if( ProductId.IsEmpty() )
 	{
 		UE_LOG_ONLINE( Warning, TEXT( "EOS SDK Product Id is invalid." ) );
 		return false;
 	}
 
-	if( SandboxIdStr.Length() == 0)
+	if( SandboxId.IsEmpty() )
 	{
 		UE_LOG_ONLINE( Warning, TEXT( "EOS SDK Sandbox Id is invalid." ) );
 		return false;
 	}
 
-	if( DeploymentIdStr.Length() == 0 )
+	if( DeploymentId.IsEmpty() )
 	{
 		UE_LOG_ONLINE( Warning, TEXT( "EOS SDK Deployment Id is invalid." ) );
 		return false;
 	}
 
-	PlatformOptions.ProductId = ProductIdStr.Get();
-	PlatformOptions.SandboxId = SandboxIdStr.Get();
-	PlatformOptions.DeploymentId = DeploymentIdStr.Get();
+	// All strings handed to the SDK live in the arena until EOS_Platform_Create returns.
+	FEOSScratchArena Arena;
+
+	PlatformOptions.CacheDirectory = Arena.ToUTF8( TempPath );
 
-	FTCHARToUTF8 ClientIdStr( *ClientId );
-	FTCHARToUTF8 ClientSecretStr( *ClientSecret );
+	PlatformOptions.ProductId = Arena.ToUTF8( ProductId );
+	PlatformOptions.SandboxId = Arena.ToUTF8( SandboxId );
+	PlatformOptions.DeploymentId = Arena.ToUTF8( DeploymentId );
 
-	PlatformOptions.ClientCredentials.ClientId = ClientIdStr.Get();
-	PlatformOptions.ClientCredentials.ClientSecret = ClientSecretStr.Get();
+	PlatformOptions.ClientCredentials.ClientId = Arena.ToUTF8( ClientId );
+	PlatformOptions.ClientCredentials.ClientSecret = Arena.ToUTF8( ClientSecret );
 
 	PlatformOptions.Reserved = NULL;
 
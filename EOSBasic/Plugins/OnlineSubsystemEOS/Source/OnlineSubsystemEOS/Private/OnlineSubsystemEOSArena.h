@@ -0,0 +1,152 @@
+// Copyright (C) Gaslight Games Ltd, 2019-2020
+
+#pragma once
+
+// Engine Includes
+#include "CoreMinimal.h"
+#include "Containers/StringConv.h"
+#include "HAL/UnrealMemory.h"
+
+
+/**
+ * Linear scratch allocator for marshalling data into EOS SDK option structs.
+ *
+ * Intended to live on the stack for the duration of a single SDK call: strings, option structs and
+ * attribute arrays are bump-allocated from the inline buffer and released together when the arena goes
+ * out of scope (or is Reset). The SDK copies everything it needs before the call returns, so nothing
+ * built here may be kept beyond that point.
+ *
+ * Only falls back to the heap when a single call needs more than InlineBytes of scratch space.
+ */
+template<uint32 InlineBytes>
+class TEOSScratchArena
+{
+
+public:
+
+	TEOSScratchArena()
+		: CurrentBlock( InlineBuffer )
+		, CurrentBlockSize( InlineBytes )
+		, CurrentOffset( 0 )
+	{
+	}
+
+	~TEOSScratchArena()
+	{
+		FreeOverflowBlocks();
+	}
+
+	/**
+	* Allocates raw, uninitialized memory from the arena.
+	*
+	* @param Size Number of bytes required.
+	* @param Alignment Required alignment, must be a power of two.
+	* @return void* The memory, valid until the arena is Reset or destroyed.
+	*/
+	void* Allocate( SIZE_T Size, SIZE_T Alignment )
+	{
+		SIZE_T AlignedOffset = Align( (UPTRINT)CurrentBlock + CurrentOffset, Alignment ) - (UPTRINT)CurrentBlock;
+
+		if( AlignedOffset + Size > CurrentBlockSize )
+		{
+			// Overflow: start a new heap block, large enough for this allocation.
+			const SIZE_T BlockSize = FMath::Max<SIZE_T>( Size + Alignment, (SIZE_T)OverflowBlockBytes );
+			CurrentBlock = (uint8*)FMemory::Malloc( BlockSize );
+			CurrentBlockSize = BlockSize;
+			OverflowBlocks.Add( CurrentBlock );
+
+			AlignedOffset = Align( (UPTRINT)CurrentBlock, Alignment ) - (UPTRINT)CurrentBlock;
+		}
+
+		CurrentOffset = AlignedOffset + Size;
+		return CurrentBlock + AlignedOffset;
+	}
+
+	/**
+	* Allocates a zeroed array of SDK structs (or any trivially constructible type).
+	*
+	* @param Count Number of elements.
+	* @return T* The first element, valid until the arena is Reset or destroyed.
+	*/
+	template<typename T>
+	T* Alloc( int32 Count = 1 )
+	{
+		static_assert( TIsTriviallyDestructible<T>::Value, "Arena allocations are never destructed." );
+
+		T* Result = (T*)Allocate( sizeof( T ) * FMath::Max( Count, 1 ), alignof( T ) );
+		FMemory::Memzero( Result, sizeof( T ) * FMath::Max( Count, 1 ) );
+		return Result;
+	}
+
+	/**
+	* Converts a string to null-terminated UTF-8 in the arena.
+	*
+	* @param Str The string to convert.
+	* @param Len Number of characters to convert, excluding any terminator.
+	* @return const char* The UTF-8 string, valid until the arena is Reset or destroyed.
+	*/
+	const char* ToUTF8( const TCHAR* Str, int32 Len )
+	{
+		const int32 ConvertedLen = ( Len > 0 ) ? FTCHARToUTF8_Convert::ConvertedLength( Str, Len ) : 0;
+
+		ANSICHAR* Dest = (ANSICHAR*)Allocate( ConvertedLen + 1, 1 );
+		if( ConvertedLen > 0 )
+		{
+			// The converter advances the pointer it is given, so hand it a cursor rather than Dest.
+			ANSICHAR* Cursor = Dest;
+			FTCHARToUTF8_Convert::Convert( Cursor, ConvertedLen, Str, Len );
+		}
+		Dest[ConvertedLen] = '\0';
+
+		return Dest;
+	}
+
+	const char* ToUTF8( const FString& Str )
+	{
+		return ToUTF8( *Str, Str.Len() );
+	}
+
+	/** Releases every allocation, keeping the inline buffer for reuse. */
+	void Reset()
+	{
+		FreeOverflowBlocks();
+
+		CurrentBlock = InlineBuffer;
+		CurrentBlockSize = InlineBytes;
+		CurrentOffset = 0;
+	}
+
+private:
+
+	/** Minimum size of a heap block, once the inline buffer is exhausted. */
+	enum { OverflowBlockBytes = 4096 };
+
+	void FreeOverflowBlocks()
+	{
+		for( uint8* Block : OverflowBlocks )
+		{
+			FMemory::Free( Block );
+		}
+		OverflowBlocks.Reset();
+	}
+
+	/** Hidden on purpose, pointers into the inline buffer would dangle. */
+	TEOSScratchArena( const TEOSScratchArena& ) = delete;
+	TEOSScratchArena& operator=( const TEOSScratchArena& ) = delete;
+
+	alignas( 16 ) uint8						InlineBuffer[InlineBytes];
+
+	/** The block currently being allocated from, either InlineBuffer or the last overflow block. */
+	uint8*									CurrentBlock;
+	SIZE_T									CurrentBlockSize;
+	SIZE_T									CurrentOffset;
+
+	/** Heap blocks allocated once the inline buffer ran out. */
+	TArray<uint8*, TInlineAllocator<4>>		OverflowBlocks;
+};
+
+/** Arena sized for a typical SDK call: a handful of ids, or a modest attribute list. */
+typedef TEOSScratchArena<1024> FEOSScratchArena;
+
+/** Arena sized for calls that marshal full session or lobby attribute sets. */
+typedef TEOSScratchArena<8192> FEOSLargeScratchArena;
@@ -10,6 +10,11 @@
 
 // EOS Includes
 #include "OnlineSubsystemEOS.h"
+#include "OnlineSubsystemEOSArena.h"
+
+// EOS SDK Includes
+#include "eos_sessions.h"
+#include "eos_lobby.h"
 
 
 /** Possible session states */
@@ -59,8 +64,98 @@ namespace EEOSSession
 	}
 }
 
+/** Size of the compact binary form of an Epic Account Id, whose string form is 32 hex characters. */
+#define EOS_EPICACCOUNTID_BINARY_SIZE 16
+
+/**
+ * Conversion between the string and binary forms of EOS account ids.
+ * Both directions are branch-free per character, so the compiler is free to vectorize them.
+ */
+namespace EOSAccountIdHex
+{
+	/** @return The value of a hex digit, or a value with bit 4 set if Char is not one. */
+	FORCEINLINE uint8 ToNibble( uint32 Char )
+	{
+		static constexpr uint8 NibbleTable[256] =
+		{
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		};
+
+		// Anything outside of 8 bits is flagged invalid without a branch.
+		return (uint8)( NibbleTable[Char & 0xFF] | ( ( Char > 0xFF ) << 4 ) );
+	}
+
+	/**
+	 * Decodes a hex string into bytes.
+	 *
+	 * @param Hex The hex characters, upper or lower case.
+	 * @param Len Number of characters, must be exactly twice NumBytes.
+	 * @param OutBytes Receives NumBytes bytes. Undefined on failure.
+	 * @param NumBytes Size of OutBytes.
+	 * @return bool True if every character was a hex digit.
+	 */
+	template<typename CharType>
+	FORCEINLINE bool Decode( const CharType* Hex, int32 Len, uint8* OutBytes, int32 NumBytes )
+	{
+		if( Hex == nullptr || Len != NumBytes * 2 )
+		{
+			return false;
+		}
+
+		// Accumulate invalid digits rather than bailing out early, keeping the loop free of branches.
+		uint8 Invalid = 0;
+		for( int32 ByteIdx = 0; ByteIdx < NumBytes; ++ByteIdx )
+		{
+			const uint8 High = ToNibble( (uint32)Hex[ByteIdx * 2] );
+			const uint8 Low = ToNibble( (uint32)Hex[ByteIdx * 2 + 1] );
+
+			Invalid |= (uint8)( High | Low );
+			OutBytes[ByteIdx] = (uint8)( ( High << 4 ) | ( Low & 0x0F ) );
+		}
+
+		return ( Invalid & 0x10 ) == 0;
+	}
+
+	/**
+	 * Encodes bytes as lower case hex, the form the SDK produces. No terminator is written.
+	 *
+	 * @param Bytes The bytes to encode.
+	 * @param NumBytes Number of bytes.
+	 * @param OutHex Receives NumBytes * 2 characters.
+	 */
+	template<typename CharType>
+	FORCEINLINE void Encode( const uint8* Bytes, int32 NumBytes, CharType* OutHex )
+	{
+		static constexpr ANSICHAR Digits[] = "0123456789abcdef";
+
+		for( int32 ByteIdx = 0; ByteIdx < NumBytes; ++ByteIdx )
+		{
+			OutHex[ByteIdx * 2] = (CharType)Digits[Bytes[ByteIdx] >> 4];
+			OutHex[ByteIdx * 2 + 1] = (CharType)Digits[Bytes[ByteIdx] & 0x0F];
+		}
+	}
+}
+
 /**
  * Epic Online Services specific implementation of the unique net id
+ *
+ * Holds both the SDK handle and the compact binary form of the id, which is what GetBytes() exposes,
+ * what is replicated and what equality and hashing use.
  */
 class FUniqueNetIdEOS : public FUniqueNetId
 {
@@ -70,10 +165,14 @@ PACKAGE_SCOPE:
 	/** The EOS SDK matching Account Id. */
 	EOS_EpicAccountId								EpicAccountId;
 
+	/** The binary form of EpicAccountId, all zero when invalid. */
+	uint8											AccountIdBytes[EOS_EPICACCOUNTID_BINARY_SIZE];
+
 	/** Hidden on purpose */
 	FUniqueNetIdEOS() :
 		EpicAccountId()
 	{
+		FMemory::Memzero( AccountIdBytes );
 	}
 
 	/**
@@ -84,6 +183,32 @@ PACKAGE_SCOPE:
 	explicit FUniqueNetIdEOS( const FUniqueNetIdEOS& Src )
 		: EpicAccountId( Src.EpicAccountId )
 	{
+		FMemory::Memcpy( AccountIdBytes, Src.AccountIdBytes, sizeof( AccountIdBytes ) );
+	}
+
+	/**
+	 * Constructs this object from the binary form of an id, without going through an FString.
+	 *
+	 * @param Bytes EOS_EPICACCOUNTID_BINARY_SIZE bytes, as returned by GetBytes()
+	 */
+	explicit FUniqueNetIdEOS( const uint8* Bytes )
+		: EpicAccountId()
+	{
+		FMemory::Memcpy( AccountIdBytes, Bytes, sizeof( AccountIdBytes ) );
+
+		// The SDK only creates handles from strings, so hand it a stack copy of the hex form.
+		ANSICHAR HexBuffer[EOS_EPICACCOUNTID_BINARY_SIZE * 2 + 1];
+		EOSAccountIdHex::Encode( AccountIdBytes, EOS_EPICACCOUNTID_BINARY_SIZE, HexBuffer );
+		HexBuffer[EOS_EPICACCOUNTID_BINARY_SIZE * 2] = '\0';
+
+		EpicAccountId = EOS_EpicAccountId_FromString( HexBuffer );
+	}
+
+	/** Updates the id in place, e.g. once a login completes. */
+	void SetAccountId( EOS_EpicAccountId InAccountId )
+	{
+		EpicAccountId = InAccountId;
+		UpdateAccountIdBytes();
 	}
 
 public:
@@ -91,6 +216,7 @@ public:
 	explicit FUniqueNetIdEOS( EOS_EpicAccountId InAccountId )
 		: EpicAccountId( InAccountId )
 	{
+		UpdateAccountIdBytes();
 	}
 
 	/**
@@ -101,6 +227,10 @@ public:
 	explicit FUniqueNetIdEOS( const FString& Str ) :
 		EpicAccountId( FUniqueNetIdEOS::FromString( *Str ) )
 	{
+		if( EOSAccountIdHex::Decode( *Str, Str.Len(), AccountIdBytes, EOS_EPICACCOUNTID_BINARY_SIZE ) == false )
+		{
+			FMemory::Memzero( AccountIdBytes );
+		}
 	}
 
 	virtual FName GetType() const override
@@ -116,7 +246,7 @@ public:
 	 */
 	virtual const uint8* GetBytes() const override
 	{
-		return (uint8*)&EpicAccountId;
+		return AccountIdBytes;
 	}
 
 	/**
@@ -126,7 +256,7 @@ public:
 	 */
 	virtual int32 GetSize() const override
 	{
-		return sizeof( EOS_EpicAccountId );
+		return EOS_EPICACCOUNTID_BINARY_SIZE;
 	}
 
 	/**
@@ -146,16 +276,17 @@ public:
 	 */
 	virtual FString ToString() const override
 	{
-		static char TempBuffer[EOS_EPICACCOUNTID_MAX_LENGTH];
-		int32_t TempBufferSize = sizeof( TempBuffer );
-		EOS_EpicAccountId_ToString( EpicAccountId, TempBuffer, &TempBufferSize );
-		FString returnValue( TempBuffer );
-		return returnValue;
+		TCHAR HexBuffer[EOS_EPICACCOUNTID_BINARY_SIZE * 2 + 1];
+		EOSAccountIdHex::Encode( AccountIdBytes, EOS_EPICACCOUNTID_BINARY_SIZE, HexBuffer );
+		HexBuffer[EOS_EPICACCOUNTID_BINARY_SIZE * 2] = TEXT( '\0' );
+
+		return FString( EOS_EPICACCOUNTID_BINARY_SIZE * 2, HexBuffer );
 	}
 
 	static EOS_EpicAccountId FromString( const FString& AccountId )
 	{
-		return EOS_EpicAccountId_FromString( TCHAR_TO_ANSI( *AccountId ) );
+		FEOSScratchArena Arena;
+		return EOS_EpicAccountId_FromString( Arena.ToUTF8( AccountId ) );
 	}
 
 	/**
@@ -177,7 +308,7 @@ public:
 	/** Needed for TMap::GetTypeHash() */
 	friend uint32 GetTypeHash( const FUniqueNetIdEOS& A )
 	{
-		return GetTypeHash( A.ToString() );
+		return FCrc::MemCrc32( A.AccountIdBytes, sizeof( A.AccountIdBytes ) );
 	}
 
 	/** global static instance of invalid (zero) id */
@@ -215,6 +346,29 @@ public:
 	//{
 	//	return Ar << UserId.ToString();
 	//}
+
+private:
+
+	/** Derives the binary form from the SDK handle. */
+	void UpdateAccountIdBytes()
+	{
+		FMemory::Memzero( AccountIdBytes );
+
+		if( EOS_EpicAccountId_IsValid( EpicAccountId ) == EOS_TRUE )
+		{
+			char HexBuffer[EOS_EPICACCOUNTID_MAX_LENGTH + 1];
+			int32_t HexBufferSize = sizeof( HexBuffer );
+
+			if( EOS_EpicAccountId_ToString( EpicAccountId, HexBuffer, &HexBufferSize ) == EOS_EResult::EOS_Success )
+			{
+				// HexBufferSize includes the terminator.
+				if( EOSAccountIdHex::Decode( HexBuffer, HexBufferSize - 1, AccountIdBytes, EOS_EPICACCOUNTID_BINARY_SIZE ) == false )
+				{
+					FMemory::Memzero( AccountIdBytes );
+				}
+			}
+		}
+	}
 };
 
 /** Data regarding preferred session connection methods */
@@ -230,6 +384,78 @@ enum class FEOSConnectionMethod : int8
 FString LexToString( const FEOSConnectionMethod Method );
 FEOSConnectionMethod ToConnectionMethod( const FString& InString );
 
+/**
+ * Owns the EOS_HSessionDetails of a search result, which the SDK needs in order to join it.
+ * Shared between every copy of the search result, and released with the last of them.
+ */
+class FSessionDetailsEOS
+{
+
+public:
+
+	explicit FSessionDetailsEOS( EOS_HSessionDetails InHandle )
+		: Handle( InHandle )
+	{
+	}
+
+	~FSessionDetailsEOS()
+	{
+		if( Handle != nullptr )
+		{
+			EOS_SessionDetails_Release( Handle );
+		}
+	}
+
+	EOS_HSessionDetails GetHandle() const
+	{
+		return Handle;
+	}
+
+private:
+
+	/** Hidden on purpose, the handle has a single owner */
+	FSessionDetailsEOS( const FSessionDetailsEOS& ) = delete;
+	FSessionDetailsEOS& operator=( const FSessionDetailsEOS& ) = delete;
+
+	EOS_HSessionDetails Handle;
+};
+
+/**
+ * Owns the EOS_HLobbyDetails of a lobby search result, which the SDK needs in order to join it.
+ * Shared between every copy of the search result, and released with the last of them.
+ */
+class FLobbyDetailsEOS
+{
+
+public:
+
+	explicit FLobbyDetailsEOS( EOS_HLobbyDetails InHandle )
+		: Handle( InHandle )
+	{
+	}
+
+	~FLobbyDetailsEOS()
+	{
+		if( Handle != nullptr )
+		{
+			EOS_LobbyDetails_Release( Handle );
+		}
+	}
+
+	EOS_HLobbyDetails GetHandle() const
+	{
+		return Handle;
+	}
+
+private:
+
+	/** Hidden on purpose, the handle has a single owner */
+	FLobbyDetailsEOS( const FLobbyDetailsEOS& ) = delete;
+	FLobbyDetailsEOS& operator=( const FLobbyDetailsEOS& ) = delete;
+
+	EOS_HLobbyDetails Handle;
+};
+
 /**
  * Implementation of session information
  */
@@ -253,18 +479,18 @@ PACKAGE_SCOPE:
 	/** Constructor for LAN sessions */
 	FOnlineSessionInfoEOS( EEOSSession::Type SessionType = EEOSSession::None );
 
-	/** Constructor for sessions that represent a Steam lobby or an advertised server session */
-	FOnlineSessionInfoEOS( EEOSSession::Type SessionType, const FUniqueNetIdEOS& InSessionId );
+	/** Constructor for sessions that represent an EOS lobby or an advertised server session */
+	FOnlineSessionInfoEOS( EEOSSession::Type SessionType, const FUniqueNetIdString& InSessionId );
 
 	/**
-	 * Initialize a Steam session info with the address of this machine
+	 * Initialize an EOS session info with the address of this machine
 	 */
-	void Init();
+	void Init( const FOnlineSubsystemEOS& Subsystem );
 
 	/**
-	 * Initialize a Steam session info with the address of this machine
+	 * Initialize an EOS session info with the address of this machine
 	 */
-	void InitLAN();
+	void InitLAN( const FOnlineSubsystemEOS& Subsystem );
 
 	/** Type of session this is, affects interpretation of id below */
 	EEOSSession::Type SessionType;
@@ -272,10 +498,31 @@ PACKAGE_SCOPE:
 	TSharedPtr<class FInternetAddr> HostAddr;
 	/** The Steam P2P address that the host is listening on (valid for GameServer/Lobby) */
 	TSharedPtr<class FInternetAddr> SteamP2PAddr;
-	/** Steam Lobby Id or Gameserver Id if applicable */
-	FUniqueNetIdEOS SessionId;
+	/** EOS Lobby Id or Session Id if applicable, as issued by the backend */
+	FUniqueNetIdString SessionId;
 	/** How this session should be connected to */
 	FEOSConnectionMethod ConnectionMethod;
+	/** The backend's details of a session found by a search, needed to join it */
+	TSharedPtr<FSessionDetailsEOS> SessionDetails;
+	/** The backend's details of a lobby found by a search, needed to join it */
+	TSharedPtr<FLobbyDetailsEOS> LobbyDetails;
+	/** The host's Product User Id, that P2P connections are addressed to (valid for GameServer/Lobby) */
+	FString P2PHostId;
+	/** The ip & port of the partner-hosted relay in front of the host, if it has one */
+	TSharedPtr<class FInternetAddr> PartnerAddr;
+	/** Measured round trip time of each connection method, MAX_QUERY_PING for those that did not answer */
+	TMap<FEOSConnectionMethod, int32> MethodPingsInMs;
+	/** Connect strings resolved so far for ConnectionMethod, by port type */
+	TMap<FName, FString> ConnectStrings;
+
+	/** Copies how to reach the host from another session info, e.g. the search result being joined */
+	void CopyConnectionInfo( const FOnlineSessionInfoEOS& Source );
+
+	/** @return bool True if this session advertises what it takes to connect using Method */
+	bool HasConnectionMethod( FEOSConnectionMethod Method ) const;
+
+	/** Switches to another connection method, forgetting connect strings resolved for the previous one */
+	void SetConnectionMethod( FEOSConnectionMethod Method );
 
 public:
 
@@ -300,7 +547,7 @@ public:
 			sizeof( EEOSSession::Type ) +
 			sizeof( TSharedPtr<class FInternetAddr> ) +
 			sizeof( TSharedPtr<class FInternetAddr> ) +
-			sizeof( FUniqueNetIdEOS ) +
+			sizeof( FUniqueNetIdString ) +
 			sizeof( FEOSConnectionMethod );
 	}
 
@@ -312,7 +559,8 @@ public:
 			//return SteamP2PAddr.IsValid() && SteamP2PAddr->IsValid() && SessionId.IsValid();
 		case EEOSSession::AdvertisedSessionHost:
 		case EEOSSession::AdvertisedSessionClient:
-			//return ( ( SteamP2PAddr.IsValid() && SteamP2PAddr->IsValid() ) || ( HostAddr.IsValid() && HostAddr->IsValid() ) ) && SessionId.IsValid();
+			// Valid once the backend has issued the session its id.
+			return SessionId.IsValid();
 		case EEOSSession::LANSession:
 		default:
 			// LAN case
@@ -12,6 +12,7 @@
 // Forward Declarations
 class FOnlineIdentityEOS;
 class FOnlineSessionEOS;
+class FBulkLoginHarnessEOS;
 
 /** Forward declarations of all interface classes */
 typedef TSharedPtr<FOnlineIdentityEOS, ESPMode::ThreadSafe> FOnlineIdentityEOSPtr;
@@ -99,6 +100,27 @@ protected:
 	// Attempt to Create a valid Platform Handle from the SDK
 	bool								CreatePlatformHandle();
 
+	/**
+	* Handles "EOS BULKLOGIN [COUNT=n] [CONCURRENCY=n] [MODE=DEV|MOCK] [HOST=host:port] [PREFIX=name]
+	* [LATENCYMS=n] [FAILRATE=f] [LOGOUT=0|1]", or "EOS BULKLOGIN STATUS|CANCEL".
+	*/
+	bool								HandleBulkLoginCommand( const TCHAR* Cmd, FOutputDevice& Ar );
+
+	/** Handles "EOS IDTOKEN [VERIFY token] [LOADKEYS path] [REFRESH]", with no argument reports the key count. */
+	bool								HandleIdTokenCommand( const TCHAR* Cmd, FOutputDevice& Ar );
+
+	/** Handles "EOS SEARCHCACHE [FLUSH]", with no argument reports the session search cache stats. */
+	bool								HandleSearchCacheCommand( const TCHAR* Cmd, FOutputDevice& Ar );
+
+	/** Handles "EOS QOS RESPOND [PORT=n]", or "EOS QOS PING ip:port [ip:port ...]" to measure the latency to responders. */
+	bool								HandleQosCommand( const TCHAR* Cmd, FOutputDevice& Ar );
+
+	/**
+	* Handles "EOS MATCHMAKE BENCH [PLAYERS=n] [SESSIONS=n] [ARRIVAL=s] [SKILLS=n] [SIZE=n] [SEED=n]", which reports
+	* time-to-match of the matchmaker against a simulated population.
+	*/
+	bool								HandleMatchmakeCommand( const TCHAR* Cmd, FOutputDevice& Ar );
+
 
 	/** The Product Name for the running game. */
 	FString								ProductName;
@@ -133,6 +155,9 @@ protected:
 
 	/// ---------------------------------------------------
 
+	/** The in-progress bulk login run, if any. */
+	TSharedPtr<FBulkLoginHarnessEOS>	BulkLoginHarness;
+
 PACKAGE_SCOPE :
 
 	/** Only the factory makes instances */
@@ -147,6 +172,7 @@ PACKAGE_SCOPE :
 		, ClientId( "" )
 		, ClientSecret( "" )
 		, IdentityInterface( nullptr )
+		, BulkLoginHarness( nullptr )
 		, bEOSInitialized( false )
 		, PlatformHandle( nullptr )
 	{}
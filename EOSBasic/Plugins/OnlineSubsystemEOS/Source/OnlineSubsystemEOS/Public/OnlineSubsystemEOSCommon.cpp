@@ -487,3 +487,16 @@ FString UEOSCommon::EOSResultToString( EOS_EResult Result )
 
 	return "Unknown";
 }
+
+FString UEOSCommon::ProductUserIdToString( EOS_ProductUserId ProductUserId )
+{
+	char Buffer[EOS_PRODUCTUSERID_MAX_LENGTH + 1];
+	int32_t BufferSize = sizeof( Buffer );
+
+	if( ProductUserId == nullptr || EOS_ProductUserId_ToString( ProductUserId, Buffer, &BufferSize ) != EOS_EResult::EOS_Success )
+	{
+		return FString();
+	}
+
+	return FString( UTF8_TO_TCHAR( Buffer ) );
+}
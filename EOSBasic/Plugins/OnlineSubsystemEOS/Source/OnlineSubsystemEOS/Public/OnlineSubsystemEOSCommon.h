@@ -131,4 +131,12 @@ public:
 	* @return FString result of the conversion.
 	*/
 	static FString					EOSResultToString( EOS_EResult Result );
+
+	/**
+	* Utility to return a Product User Id as a FString.
+	*
+	* @param ProductUserId The Product User Id to convert.
+	* @return FString The Id's string form, or empty if it is not valid.
+	*/
+	static FString					ProductUserIdToString( EOS_ProductUserId ProductUserId );
 };